@@ -0,0 +1,128 @@
+/**
+ * File: cracking_bench.cpp
+ * Author: Mark Minkoff
+ * Functionality: Benchmark of adaptive indexing (see cracker.h)
+ * Runs the same random selects on an INT and a FLOAT column, once scanning and once cracking
+ * (SET ADAPTIVE_INDEXING ON), and checks that both return the same rows. Two workloads:
+ *   selective  a < x or a > x selecting up to 1% of the rows, or a = x
+ *   ranges     lo <= a AND a < hi over up to 1% of the domain, two filters and a bitmap AND
+ *              like the WHERE clause evaluates them (each filter selects about half the rows)
+ * Build with -DCMAKE_BUILD_TYPE=Release, the kernels are not representative otherwise.
+ *
+ *   cracking_bench [rows] [queries]      (default 500000 rows, 1000 queries)
+ *
+ * */
+
+#include "column.h"
+
+#include <chrono>
+
+// A select is one or more filters whose rows are ANDed
+template <typename T>
+using Query = std::vector<std::pair<FilterOperator, T>>;
+
+typedef struct CrackingBenchResult {
+    double seconds;
+    std::vector<Bitmap> results;    // Rows selected by every query
+} CrackingBenchResult;
+
+/** Runs every query on 'column', cracking it if 'adaptive' */
+template <typename T>
+static CrackingBenchResult _bench(Column<T>& column, const std::vector<Query<T>>& queries, const bool adaptive)
+{
+    column.setAdaptive(false);
+    column.setAdaptive(adaptive);
+
+    CrackingBenchResult result;
+    result.results.reserve(queries.size());
+
+    const auto start = std::chrono::steady_clock::now();
+    for (auto& query : queries)
+    {
+        Bitmap rows = column.filterElements(query[0].first, query[0].second);
+        for (size_t f = 1; f < query.size(); ++f) rows &= column.filterElements(query[f].first, query[f].second);
+        result.results.push_back(std::move(rows));
+    }
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+/** Times the queries scanning and cracking, returns false if the results differ */
+template <typename T>
+static bool _compare(const char* workload, const char* type, Column<T>& column, const std::vector<Query<T>>& queries)
+{
+    const CrackingBenchResult scan = _bench(column, queries, false);
+    const CrackingBenchResult cracking = _bench(column, queries, true);
+    const ColumnStats stats = column.getStats();
+
+    size_t mismatches = 0;
+    for (size_t q = 0; q < queries.size(); ++q) {
+        if (scan.results[q].count() != cracking.results[q].count() || std::memcmp(scan.results[q].data(), cracking.results[q].data(), (column.size() + 63) / 64 * sizeof(uint64_t)) != 0) ++mismatches;
+    }
+
+    char line[160];
+    snprintf(line, sizeof(line), "%-10s %-6s scan     %9.3f s %9.1f us/query\n", workload, type, scan.seconds, scan.seconds / queries.size() * 1e6);
+    std::cout << line;
+    snprintf(line, sizeof(line), "%-10s %-6s cracking %9.3f s %9.1f us/query %7zu pieces  %.2fx%s\n", workload, type, cracking.seconds,
+        cracking.seconds / queries.size() * 1e6, stats.cracker_pieces, scan.seconds / cracking.seconds,
+        mismatches ? "  MISMATCH" : "");
+    std::cout << line;
+    if (mismatches) std::cout << mismatches << " of " << queries.size() << " queries returned different rows\n";
+
+    return !mismatches;
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t rows = argc > 1 ? std::max<size_t>(1, std::stoul(argv[1])) : 500000;
+    const size_t query_count = argc > 2 ? std::max<size_t>(1, std::stoul(argv[2])) : 1000;
+
+    // Uniform values in [0, domain), FLOAT values are the INT values / 7
+    const int domain = 1000000;
+    std::mt19937 gen(457);
+    std::uniform_int_distribution<int> values(0, domain - 1);
+    std::uniform_int_distribution<int> widths(1, domain / 100);
+    std::uniform_int_distribution<int> kinds(0, 2);
+
+    std::vector<int> int_data(rows);
+    std::vector<float> float_data(rows);
+    for (size_t i = 0; i < rows; ++i) {
+        int_data[i] = values(gen);
+        float_data[i] = int_data[i] / 7.0f;
+    }
+
+    std::vector<Query<int>> selective, ranges;
+    for (size_t q = 0; q < query_count; ++q)
+    {
+        const int width = widths(gen), kind = kinds(gen);
+        if (kind == 0) selective.push_back({ { FILTER_LT, width } });
+        else if (kind == 1) selective.push_back({ { FILTER_GT, domain - width } });
+        else selective.push_back({ { FILTER_EQ, int_data[values(gen) % rows] } });
+
+        const int lo = values(gen);
+        ranges.push_back({ { FILTER_GE, lo }, { FILTER_LT, lo + width } });
+    }
+
+    // The same selects on the FLOAT column
+    auto floats = [](const std::vector<Query<int>>& queries) {
+        std::vector<Query<float>> res;
+        for (auto& query : queries) {
+            res.emplace_back();
+            for (auto& filter : query) res.back().emplace_back(filter.first, filter.second / 7.0f);
+        }
+        return res;
+    };
+
+    Column<int> int_column("a", std::move(int_data));
+    Column<float> float_column("b", std::move(float_data));
+
+    std::cout << rows << " rows, " << query_count << " random selects per workload\n";
+
+    bool success = true;
+    success = _compare("selective", "INT", int_column, selective) && success;
+    success = _compare("selective", "FLOAT", float_column, floats(selective)) && success;
+    success = _compare("ranges", "INT", int_column, ranges) && success;
+    success = _compare("ranges", "FLOAT", float_column, floats(ranges)) && success;
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,103 @@
+/**
+ * File: filter_bench.cpp
+ * Author: Mark Minkoff
+ * Functionality: Microbenchmark of the filter kernels (see filter.h)
+ * Times filterInt, filterFloat and filterChar for every operator on every instruction set the
+ * cpu supports (AVX2, SSE4.2, scalar) and checks the bitmaps against the scalar kernels.
+ * Build with -DCMAKE_BUILD_TYPE=Release, the kernels are not representative otherwise.
+ *
+ *   filter_bench [elements] [repetitions]      (default 16777216 elements, 10 repetitions)
+ *
+ * */
+
+#include "filter.h"
+
+#include <chrono>
+
+static const FilterOperator OPERATORS[] = { FILTER_EQ, FILTER_NE, FILTER_LT, FILTER_LE, FILTER_GT, FILTER_GE };
+static const char* OPERATOR_NAMES[] = { "=", "!=", "<", "<=", ">", ">=" };
+
+static const FilterKernel KERNELS[] = { FILTER_AVX2, FILTER_SSE42, FILTER_SCALAR };
+static const char* KERNEL_NAMES[] = { "scalar", "sse4.2", "avx2" };
+
+// Best time of 'repetitions' runs of a kernel, in seconds
+template <typename T, typename Kernel>
+static double _time(Kernel kernel, const std::vector<T>& data, const FilterOperator op, const T val, std::vector<uint64_t>& out, const size_t repetitions)
+{
+    double best = 0;
+    for (size_t r = 0; r < repetitions; ++r)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        kernel(data.data(), data.size(), op, val, out.data());
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (!r || seconds < best) best = seconds;
+    }
+    return best;
+}
+
+// Times every operator of a kernel on every instruction set
+template <typename T, typename Kernel>
+static bool _bench(const char* type, Kernel kernel, const std::vector<T>& data, const T val, const size_t repetitions)
+{
+    const size_t words = (data.size() + 63) >> 6;
+    std::vector<uint64_t> expected(words), out(words);
+    bool success = true;
+
+    for (size_t o = 0; o < sizeof(OPERATORS) / sizeof(OPERATORS[0]); ++o)
+    {
+        // The scalar kernels are the reference
+        setFilterKernel(FILTER_SCALAR);
+        kernel(data.data(), data.size(), OPERATORS[o], val, expected.data());
+
+        for (const FilterKernel requested : KERNELS)
+        {
+            // Instruction sets the cpu does not support are skipped
+            if (setFilterKernel(requested) != requested) continue;
+
+            std::fill(out.begin(), out.end(), 0);
+            const double seconds = _time(kernel, data, OPERATORS[o], val, out, repetitions);
+            const bool match = out == expected;
+            success = success && match;
+
+            char line[160];
+            snprintf(line, sizeof(line), "%-6s %-3s %-7s %9.3f ms %9.1f Melem/s %7.2f GB/s%s\n",
+                type, OPERATOR_NAMES[o], KERNEL_NAMES[requested], seconds * 1e3,
+                data.size() / seconds / 1e6, data.size() * sizeof(T) / seconds / 1e9, match ? "" : "  MISMATCH");
+            std::cout << line;
+        }
+    }
+    return success;
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t elements = argc > 1 ? std::stoul(argv[1]) : (size_t)1 << 24;
+    const size_t repetitions = argc > 2 ? std::max<size_t>(1, std::stoul(argv[2])) : 10;
+
+    // Uniform values, the compared value is in the middle so ordering operators select half of the elements
+    std::mt19937 gen(457);
+    std::uniform_int_distribution<int> ints(0, 999);
+    std::uniform_real_distribution<float> floats(0.0f, 1000.0f);
+    std::uniform_int_distribution<int> letters(0, 51);
+
+    std::vector<int> int_data(elements);
+    std::vector<float> float_data(elements);
+    std::vector<char> char_data(elements);
+    for (size_t i = 0; i < elements; ++i)
+    {
+        int_data[i] = ints(gen);
+        float_data[i] = floats(gen);
+        const int letter = letters(gen);
+        char_data[i] = letter < 26 ? 'a' + letter : 'A' + letter - 26;
+    }
+
+    std::cout << elements << " elements, best of " << repetitions << " runs, cpu kernels: " << filterKernelName() << "\n";
+    std::cout << "type   op  kernel          time         rate      bandwidth\n";
+
+    bool success = true;
+    success = _bench("INT", filterInt, int_data, 500, repetitions) && success;
+    success = _bench("FLOAT", filterFloat, float_data, 500.0f, repetitions) && success;
+    success = _bench("CHAR", filterChar, char_data, 'm', repetitions) && success;
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+/**
+ * File: parse_bench.cpp
+ * Author: Mark Minkoff
+ * Functionality: Benchmark of the statement parser (see parser.h)
+ * Generates a script of INSERTs followed by SELECT/UPDATE pairs on one table and times parsing
+ * every statement (parseStatement only), then running the script end to end with a fresh client
+ * through runStatement, which parses every statement, and through execute, which reuses the
+ * statements cached by shape (see cache.h). The output goes to /dev/null.
+ * The database is written in the current directory, build with -DCMAKE_BUILD_TYPE=Release.
+ *
+ *   parse_bench [inserts] [pairs] [repetitions]      (default 100000 INSERTs, 300 SELECT/UPDATE pairs, best of 3)
+ *
+ * */
+
+#include "SQL.h"
+
+#include <chrono>
+#include <unistd.h>
+
+// Sends everything the client prints to /dev/null while it lives
+class QuietConsole
+{
+private:
+    std::ofstream null{ "/dev/null" };
+    std::streambuf* console;
+
+public:
+    QuietConsole() : console(std::cout.rdbuf(this->null.rdbuf())) {}
+    ~QuietConsole() { std::cout.rdbuf(this->console); }
+};
+
+/** The statements of the script, without their ';' */
+static std::vector<std::string> _script(const size_t inserts, const size_t pairs)
+{
+    std::mt19937 gen(457);
+    std::uniform_int_distribution<size_t> ids(0, std::max<size_t>(1, inserts) - 1);
+
+    std::vector<std::string> script;
+    script.reserve(inserts + 2 * pairs);
+    for (size_t i = 0; i < inserts; ++i) {
+        script.push_back("INSERT INTO product VALUES (" + std::to_string(i) + ", 'Gizmo " + std::to_string(i) + "', " + std::to_string(i % 1000) + ".99)");
+    }
+    for (size_t p = 0; p < pairs; ++p) {
+        const std::string id = std::to_string(ids(gen));
+        script.push_back("SELECT name, price FROM product WHERE id = " + id);
+        script.push_back("UPDATE product SET price = 1.5 WHERE id = " + id + " AND price > 0");
+    }
+    return script;
+}
+
+/** Runs the script with a fresh client in a new database, 'cached' goes through execute */
+static double _run(const std::vector<std::string>& script, const bool cached)
+{
+    static size_t runs = 0;
+    const std::string database = "d" + std::to_string(runs++);
+
+    QuietConsole quiet;
+    SQL sql(CLIENT_EMBEDDED);
+    sql.execute("CREATE DATABASE " + database);
+    sql.execute("USE " + database);
+    sql.execute("CREATE TABLE product (id INT, name VARCHAR(20), price FLOAT)");
+
+    const auto start = std::chrono::steady_clock::now();
+    for (auto& statement : script) {
+        if (cached) sql.execute(statement);
+        else sql.runStatement(statement);
+    }
+    std::cout.flush();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t inserts = argc > 1 ? std::stoul(argv[1]) : 100000;
+    const size_t pairs = argc > 2 ? std::stoul(argv[2]) : 300;
+    const size_t repetitions = argc > 3 ? std::max<size_t>(1, std::stoul(argv[3])) : 3;
+
+    const std::vector<std::string> script = _script(inserts, pairs);
+    size_t bytes = 0;
+    for (auto& statement : script) bytes += statement.size() + 2;
+
+    // Parsing only
+    const auto start = std::chrono::steady_clock::now();
+    size_t failed = 0;
+    for (auto& statement : script)
+    {
+        Statement parsed;
+        std::string error;
+        if (!parseStatement(statement, parsed, error)) ++failed;
+    }
+    const double parse = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const fs::path directory = fs::current_path() / ("parse_bench." + std::to_string(::getpid()));
+    fs::create_directories(directory);
+    fs::current_path(directory);
+
+    // The modes take turns so neither always runs on a fuller disk cache
+    double uncached = 0, cached = 0;
+    for (size_t r = 0; r < repetitions; ++r) {
+        const double seconds = _run(script, false);
+        uncached = r ? std::min(uncached, seconds) : seconds;
+        const double seconds_cached = _run(script, true);
+        cached = r ? std::min(cached, seconds_cached) : seconds_cached;
+    }
+
+    std::cout << inserts << " INSERTs and " << pairs << " SELECT/UPDATE pairs, " << script.size() << " statements, " << bytes / 1e6 << " MB, best of " << repetitions << " runs\n";
+    char line[160];
+    snprintf(line, sizeof(line), "parse only          %8.3f s %11.0f statements/s %7.1f MB/s%s\n", parse, script.size() / parse, bytes / parse / 1e6, failed ? "  FAILED" : "");
+    std::cout << line;
+    snprintf(line, sizeof(line), "script, parsed      %8.3f s %11.0f statements/s\n", uncached, script.size() / uncached);
+    std::cout << line;
+    snprintf(line, sizeof(line), "script, cached      %8.3f s %11.0f statements/s\n", cached, script.size() / cached);
+    std::cout << line;
+
+    fs::current_path(directory.parent_path());
+    std::error_code ec;
+    fs::remove_all(directory, ec);
+    return failed ? 1 : 0;
+}
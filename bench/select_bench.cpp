@@ -0,0 +1,99 @@
+/**
+ * File: select_bench.cpp
+ * Author: Mark Minkoff
+ * Functionality: Benchmark of SELECT * FROM {{ table_name }} (see Table::printAll)
+ * Creates INT tables of growing row counts and times a fresh client (as a new process would
+ * start) selecting every row, with the output going to /dev/null. The time per cell stays flat
+ * when SELECT * scales linearly with the row count.
+ * The tables are written in the current directory, build with -DCMAKE_BUILD_TYPE=Release.
+ *
+ *   select_bench [columns] [rows ...]      (default 10 columns, 1000 5000 20000 100000 rows)
+ *
+ * */
+
+#include "SQL.h"
+
+#include <chrono>
+#include <unistd.h>
+
+// Sends everything the client prints to /dev/null while it lives
+class QuietConsole
+{
+private:
+    std::ofstream null{ "/dev/null" };
+    std::streambuf* console;
+
+public:
+    QuietConsole() : console(std::cout.rdbuf(this->null.rdbuf())) {}
+    ~QuietConsole() { std::cout.rdbuf(this->console); }
+};
+
+/** Writes a csv file of 'rows' rows of 'columns' random INT values, with a header line */
+static void _writeCSV(const fs::path& path, const size_t columns, const size_t rows)
+{
+    std::mt19937 gen(457);
+    std::uniform_int_distribution<int> values(0, 999999);
+
+    std::ofstream file(path);
+    for (size_t c = 0; c < columns; ++c) file << (c ? "," : "") << "c" << c;
+    file << "\n";
+    for (size_t r = 0; r < rows; ++r) {
+        for (size_t c = 0; c < columns; ++c) file << (c ? "," : "") << values(gen);
+        file << "\n";
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t columns = argc > 1 ? std::max<size_t>(1, std::stoul(argv[1])) : 10;
+    std::vector<size_t> sizes;
+    for (int i = 2; i < argc; ++i) sizes.push_back(std::stoul(argv[i]));
+    if (sizes.empty()) sizes = { 1000, 5000, 20000, 100000 };
+
+    const fs::path directory = fs::current_path() / ("select_bench." + std::to_string(::getpid()));
+    fs::create_directories(directory);
+    fs::current_path(directory);
+
+    std::cout << columns << " INT columns, SELECT * by a fresh client, output to /dev/null\n";
+    std::cout << "     rows        time      rows/s     ns/cell\n";
+
+    for (size_t s = 0; s < sizes.size(); ++s)
+    {
+        const std::string table = "t" + std::to_string(s);
+        const fs::path csv = directory / (table + ".csv");
+        _writeCSV(csv, columns, sizes[s]);
+
+        // Create and fill the table, the client checkpoints it on exit
+        {
+            QuietConsole quiet;
+            SQL sql(CLIENT_EMBEDDED);
+            if (!s) sql.execute("CREATE DATABASE d");
+            sql.execute("USE d");
+
+            std::string create = "CREATE TABLE " + table + " (";
+            for (size_t c = 0; c < columns; ++c) create += (c ? ", c" : "c") + std::to_string(c) + " INT";
+            sql.execute(create + ")");
+            sql.execute("COPY " + table + " FROM '" + csv.string() + "' HEADER");
+        }
+
+        double seconds;
+        {
+            QuietConsole quiet;
+            const auto start = std::chrono::steady_clock::now();
+            SQL sql(CLIENT_EMBEDDED);
+            sql.execute("USE d");
+            sql.execute("SELECT * FROM " + table);
+            std::cout.flush();
+            seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
+        char line[160];
+        snprintf(line, sizeof(line), "%9zu %9.3f s %11.0f %11.1f\n", sizes[s], seconds, sizes[s] / seconds, seconds / (sizes[s] * columns) * 1e9);
+        std::cout << line;
+    }
+
+    fs::current_path(directory.parent_path());
+    std::error_code ec;
+    fs::remove_all(directory, ec);
+    return 0;
+}
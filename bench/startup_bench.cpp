@@ -0,0 +1,117 @@
+/**
+ * File: startup_bench.cpp
+ * Author: Mark Minkoff
+ * Functionality: Benchmark of loading a database at startup (see storage.h)
+ * Times a fresh client (as a new process would start) running USE on a database with one INT
+ * table, first from a legacy <table>.csv file (imported once into the binary format), then from
+ * the binary table files, and the first filter afterwards, which maps the column it reads.
+ * The database is written in the current directory, build with -DCMAKE_BUILD_TYPE=Release.
+ *
+ *   startup_bench [rows] [columns] [repetitions]      (default 20000 rows, 10 columns, 5 runs)
+ *
+ * */
+
+#include "SQL.h"
+
+#include <chrono>
+#include <unistd.h>
+
+// Sends everything the client prints to /dev/null while it lives
+class QuietConsole
+{
+private:
+    std::ofstream null{ "/dev/null" };
+    std::streambuf* console;
+
+public:
+    QuietConsole() : console(std::cout.rdbuf(this->null.rdbuf())) {}
+    ~QuietConsole() { std::cout.rdbuf(this->console); }
+};
+
+typedef struct StartupTimes {
+    double start;       // Client created (catalog read) and USE
+    double filter;      // First filter on a column after the start
+} StartupTimes;
+
+/** Starts a client, selects the database and filters one column */
+static StartupTimes _start()
+{
+    QuietConsole quiet;
+    StartupTimes times;
+
+    const auto start = std::chrono::steady_clock::now();
+    SQL sql(CLIENT_EMBEDDED);
+    sql.execute("USE d");
+    times.start = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const auto filter = std::chrono::steady_clock::now();
+    sql.execute("SELECT c0 FROM t WHERE c0 < 0");
+    times.filter = std::chrono::duration<double>(std::chrono::steady_clock::now() - filter).count();
+    return times;
+}
+
+static void _print(const char* name, const StartupTimes& times)
+{
+    char line[160];
+    snprintf(line, sizeof(line), "%-14s %9.4f s %9.4f s\n", name, times.start, times.filter);
+    std::cout << line;
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t rows = argc > 1 ? std::stoul(argv[1]) : 20000;
+    const size_t columns = argc > 2 ? std::max<size_t>(1, std::stoul(argv[2])) : 10;
+    const size_t repetitions = argc > 3 ? std::max<size_t>(1, std::stoul(argv[3])) : 5;
+
+    const fs::path directory = fs::current_path() / ("startup_bench." + std::to_string(::getpid()));
+    fs::create_directories(directory);
+    fs::current_path(directory);
+
+    // The table and its metadata file
+    {
+        QuietConsole quiet;
+        SQL sql(CLIENT_EMBEDDED);
+        sql.execute("CREATE DATABASE d");
+        sql.execute("USE d");
+
+        std::string create = "CREATE TABLE t (";
+        for (size_t c = 0; c < columns; ++c) create += (c ? ", c" : "c") + std::to_string(c) + " INT";
+        sql.execute(create + ")");
+    }
+
+    // Only a legacy csv file holds the rows, the table and column files are imported from it on the next start
+    const fs::path table_directory = directory / "storage" / "d" / "t";
+    for (const auto& entry : fs::directory_iterator(table_directory)) {
+        if (entry.path().extension() != ".txt") fs::remove(entry.path());
+    }
+    {
+        std::mt19937 gen(457);
+        std::uniform_int_distribution<int> values(0, 999999);
+
+        std::ofstream file(table_directory / "t.csv");
+        for (size_t c = 0; c < columns; ++c) file << (c ? "," : "") << "c" << c << " INT";
+        file << "\n";
+        for (size_t r = 0; r < rows; ++r) {
+            for (size_t c = 0; c < columns; ++c) file << (c ? "," : "") << values(gen);
+            file << "\n";
+        }
+    }
+
+    std::cout << rows << " x " << columns << " INT table, fresh client, best of " << repetitions << " binary starts\n";
+    std::cout << "load              start+USE  first filter\n";
+
+    _print("csv import", _start());
+
+    StartupTimes best = _start();
+    for (size_t r = 1; r < repetitions; ++r) {
+        const StartupTimes times = _start();
+        best.start = std::min(best.start, times.start);
+        best.filter = std::min(best.filter, times.filter);
+    }
+    _print("binary", best);
+
+    fs::current_path(directory.parent_path());
+    std::error_code ec;
+    fs::remove_all(directory, ec);
+    return 0;
+}
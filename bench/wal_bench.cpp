@@ -0,0 +1,108 @@
+/**
+ * File: wal_bench.cpp
+ * Author: Mark Minkoff
+ * Functionality: Commit benchmark of the write ahead log (see wal.h)
+ * Logs INSERT records from 1, 8 and 64 threads and reports the commit throughput and the p50 and
+ * p99 commit latency, once with group commit (WAL_SYNC FULL, the flusher syncs batches) and once
+ * with one fdatasync per record (WAL_SYNC NORMAL and a sync after every record).
+ * The log is written in the current directory, run it on the disk the databases live on.
+ *
+ *   wal_bench [records] [commit window]      (default 8192 records per run, 0 microseconds)
+ *
+ * */
+
+#include "wal.h"
+
+#include <chrono>
+#include <unistd.h>
+
+static const size_t THREADS[] = { 1, 8, 64 };
+
+typedef struct WalBenchResult {
+    double seconds;
+    std::vector<double> latencies;      // Microseconds from append to durable, per record
+    bool success;
+} WalBenchResult;
+
+/** Commits 'records' records from 'threads' threads, with group commit or a sync per record */
+static WalBenchResult _bench(const fs::path& directory, const size_t threads, const size_t records, const bool group, const uint64_t window)
+{
+    std::shared_ptr<WriteAheadLog> wal = WriteAheadLog::create(directory);
+    wal->setSyncPolicy(group ? WAL_SYNC_FULL : WAL_SYNC_NORMAL);
+    wal->setCommitWindow(window);
+    wal->setCheckpointSize(UINT64_MAX);
+
+    // A record the size of a small INSERT
+    const std::vector<std::string> fields = { "bench", "42", "3.14", "payload of the benchmark row" };
+
+    std::vector<std::vector<double>> latencies(threads);
+    std::vector<char> failed(threads, 0);
+    std::vector<std::thread> workers;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t t = 0; t < threads; ++t)
+    {
+        workers.emplace_back([&, t]() {
+            const size_t count = records / threads + (t < records % threads ? 1 : 0);
+            latencies[t].reserve(count);
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                const auto begin = std::chrono::steady_clock::now();
+                const uint64_t lsn = wal->append(WAL_INSERT, fields);
+                const bool durable = lsn && (group ? wal->commit(lsn) : wal->sync());
+                if (!durable) { failed[t] = 1; return; }
+                latencies[t].push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count());
+            }
+        });
+    }
+    for (auto& worker : workers) worker.join();
+
+    WalBenchResult result;
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result.success = std::find(failed.begin(), failed.end(), 1) == failed.end();
+    for (auto& thread : latencies) result.latencies.insert(result.latencies.end(), thread.begin(), thread.end());
+    std::sort(result.latencies.begin(), result.latencies.end());
+
+    // An emptied log is deleted with the log
+    wal->reset();
+    return result;
+}
+
+static double _percentile(const std::vector<double>& sorted, const double p)
+{
+    if (sorted.empty()) return 0;
+    return sorted[std::min(sorted.size() - 1, (size_t)(p * (sorted.size() - 1) + 0.5))];
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t records = argc > 1 ? std::max<size_t>(1, std::stoul(argv[1])) : 8192;
+    const uint64_t window = argc > 2 ? std::stoull(argv[2]) : 0;
+
+    const fs::path directory = fs::current_path() / ("wal_bench." + std::to_string(::getpid()));
+    fs::create_directories(directory);
+
+    std::cout << records << " records per run, commit window " << window << " us, log in " << directory.string() << "\n";
+    std::cout << "mode          threads   commits/s      p50 us      p99 us\n";
+
+    bool success = true;
+    for (const bool group : { true, false })
+    {
+        for (const size_t threads : THREADS)
+        {
+            const WalBenchResult result = _bench(directory, threads, records, group, window);
+            success = success && result.success;
+
+            char line[160];
+            snprintf(line, sizeof(line), "%-13s %7zu %11.0f %11.1f %11.1f%s\n",
+                group ? "group commit" : "fsync/record", threads, result.latencies.size() / result.seconds,
+                _percentile(result.latencies, 0.50), _percentile(result.latencies, 0.99), result.success ? "" : "  FAILED");
+            std::cout << line;
+        }
+    }
+
+    std::error_code ec;
+    fs::remove_all(directory, ec);
+    return success ? 0 : 1;
+}
@@ -6,10 +6,11 @@
  */
 #include "SQL.h"
 
+#include <chrono>
+
 SQL::SQL() : database_count(0)
 {
     this->process_id = _uuid(16);
-    initializeCommands();
     initializeTypes();
     readFilesystem();
     SQL_CLI();
@@ -26,14 +27,25 @@ SQL::SQL(std::string filePath)
     }
 
     this->process_id = _uuid(16);
-    initializeCommands();
     initializeTypes();
     readFilesystem();
     SQL_CLI();
 }
 
+SQL::SQL(ClientMode mode) : database_count(0)
+{
+    this->process_id = _uuid(16);
+    initializeTypes();
+    readFilesystem();
+    if (mode == CLIENT_INTERACTIVE) SQL_CLI();
+}
+
 SQL::~SQL()
 {
+    // Write every logged statement to the table files before exiting, they drop the deleted rows
+    this->compactor.stop();
+    for (auto& db : this->databases) db.second->checkpoint();
+
     fs::path p = fs::current_path();
     p += "/transactions/";
     p += this->process_id;
@@ -45,122 +57,181 @@ SQL::~SQL()
     std::cout << "-- All done.\n";
 }
 
-void SQL::initializeCommands()
-{
-    // Specify command count and reserve memory in the unordered map for them
-    std::size_t NUM_COMMANDS = 8;
-    this->commands.reserve(NUM_COMMANDS);
-
-    // Asign commands value pairs
-    std::pair<std::string, unsigned int> cmd0("CREATE", 0);
-    std::pair<std::string, unsigned int> cmd1("DROP",   1);
-    std::pair<std::string, unsigned int> cmd2("USE",    2);
-    std::pair<std::string, unsigned int> cmd3("ALTER",  3);
-    std::pair<std::string, unsigned int> cmd4("SELECT", 4);
-    std::pair<std::string, unsigned int> cmd5("INSERT", 5);
-    std::pair<std::string, unsigned int> cmd6("UPDATE", 6);
-    std::pair<std::string, unsigned int> cmd7("DELETE", 7);
-    std::pair<std::string, unsigned int> cmd8("BEGIN",  8);
-    std::pair<std::string, unsigned int> cmd9("CLEAR",  9);
-    std::pair<std::string, unsigned int> cmdA("COMMIT", 10);
-
-    // Insert commands into unordered map
-    this->commands.insert(cmd0);
-    this->commands.insert(cmd1);
-    this->commands.insert(cmd2);
-    this->commands.insert(cmd3);
-    this->commands.insert(cmd4);
-    this->commands.insert(cmd5);
-    this->commands.insert(cmd6);
-    this->commands.insert(cmd7);
-    this->commands.insert(cmd8);
-    this->commands.insert(cmd9);
-    this->commands.insert(cmdA);
-}
-
 void SQL::SQL_CLI()
 {
     // The user input
     std::string input;
 
-    // Replace multiple tabs and spaces with a single space
-    std::regex regx("[ \t]+");
-
-    // File input
-    if (!this->arguments.empty())
+    // Run statements until .exit or the end of the input
+    while (true)
     {
-        input = this->arguments.front();
+        // File input
+        if (!this->arguments.empty())
+        {
+            // Replace multiple tabs and spaces with a single space and trim spaces from beginning and end
+            input = _trim(_collapseSpaces(this->arguments.front()));
 
-        input = std::regex_replace(input, regx, std::string(" "));
+            this->arguments.pop();
 
-        // Trim spaces from beginning and end
-        input = _trim(input);
+            while(!this->arguments.empty() && input.back() != ';')
+            {
+                std::string temp = _trim(_collapseSpaces(this->arguments.front()));
 
-        this->arguments.pop();
+                input += ' ';
+                input += temp;
 
-        while(!this->arguments.empty() && input.back() != ';')
-        {
-            std::string temp = this->arguments.front();
+                this->arguments.pop();
+            }
+            
+            std::cout << input << "\n";
 
-            temp = std::regex_replace(temp, regx, std::string(" "));
+            if (input == ".exit") return;
 
-            // Trim spaces from beginning and end
-            temp = _trim(temp);
+            input.pop_back();
+        }
+        else 
+        {
+            // Request user input from console, stop at the end of the input
+            if (!std::getline(std::cin, input)) return;
 
-            input += ' ';
-            input += temp;
+            if (input == ".exit") return;
 
-            this->arguments.pop();
+            while (input.empty() || input.back() != ';') {
+                std::string temp; 
+                if (!std::getline(std::cin, temp)) return;
+                if (temp != ";") 
+                {
+                    input += ' ';
+                }
+                input += temp;
+            }
+
+            input.pop_back();
         }
-        
-        std::cout << input << "\n";
 
-        if (input == ".exit") return;
+        // Clean up input from unecessary spaces and tabs
+        input = _collapseSpaces(input);
+
+        // The exit condition for the CLI
+        if (_toUpper(input) == ".EXIT" || _toUpper(input) == "EXIT")
+        {
+            return;
+        }
 
-        input.pop_back();
+        this->execute(input);
     }
-    else 
+}
+
+bool SQL::execute(const std::string& input)
+{
+    // Tables are only compacted in the background between statements
+    std::unique_lock<std::recursive_mutex> statement_lock = this->lockStatements();
+
+    // Only INSERT, SELECT, UPDATE and DELETE are normalized
+    std::string normalized;
+    std::vector<std::string> values;
+    if (this->statement_cache.getCapacity() == 0 || !normalizeStatement(input, normalized, values)) return this->runStatement(input);
+
+    // Statements are cached per database, their tables are looked up in it
+    const std::string key = (this->dbSelected() ? this->database->getDatabaseName() : std::string()) + "\n" + normalized;
+
+    const CacheEntry* entry = this->statement_cache.find(key);
+    const bool cached = entry != nullptr;
+    if (entry && entry->statement)
     {
-        // Request user input from console
-        std::getline(std::cin, input);
+        // Bind the values of this statement, one that does not convert is reported by the statement as written
+        std::shared_ptr<PreparedStatement> statement = entry->statement;
+        bool bound = true;
+        for (size_t i = 0; i < values.size() && bound; ++i) bound = statement->bind(i, values[i], false);
 
-        if (input == ".exit") return;
+        if (bound)
+        {
+            this->statement_cache.hit();
+            return statement->execute();
+        }
+    }
+    this->statement_cache.miss();
 
-        while (input.back() != ';') {
-            std::string temp; 
-            std::getline(std::cin, temp);
-            if (temp != ";") 
-            {
-                input += ' ';
-            }
-            input += temp;
+    // Run the statement as written, its shape is prepared once it ran
+    const bool success = this->runStatement(input);
+    if (success && !cached) this->cacheStatement(key, normalized, values.size());
+
+    return success;
+}
+
+void SQL::cacheStatement(const std::string& key, const std::string& normalized, const size_t value_count)
+{
+    // The statement ran on the selected database, its shape resolves the same way unless the database was dropped
+    if (!this->dbSelected() || this->getDatabase(this->database->getDatabaseName()) != this->database) return;
+
+    try {
+        // Shapes that cannot be prepared (joins) are cached without a statement
+        Statement statement;
+        std::string error;
+        size_t parameter_count = 0;
+        std::shared_ptr<PreparedStatement> prepared;
+        if (parseStatement(normalized, statement, error, &parameter_count) && parameter_count == value_count)
+        {
+            prepared = std::make_shared<PreparedStatement>(this, normalized, std::move(statement), parameter_count);
+            if (!prepared->isDirect() || !prepared->resolve()) prepared = nullptr;
         }
 
-        input.pop_back();
+        this->statement_cache.insert(key, this->database->getDatabaseName(), prepared ? prepared->getTableName() : std::string(), prepared);
     }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+    }
+}
 
-    // Clean up input from unecessary spaces and tabs
-    input = std::regex_replace(input, regx, std::string(" "));
-
-    // Check if the user input has balanced parenthsis, if not issue some error
-    if (!_isBalancedParenthesis(input))
+bool SQL::runStatement(const std::string& input)
+{
+    // Parse the statement once, the handlers work on its syntax tree
+    Statement statement;
+    std::string error;
+    if (!parseStatement(input, statement, error))
     {
-        std::cout << "-- !Parenthsis are not balanced in input: " << input << "\n";
-        return SQL_CLI();
+        if (!error.empty()) std::cout << error << "\n";
+        return false;
     }
 
-    // The exit condition for the CLI
-    if (_toUpper(input) == ".EXIT" || _toUpper(input) == "EXIT")
+    return HANDLE_CMD(statement);
+}
+
+std::shared_ptr<PreparedStatement> SQL::prepare(const std::string& input)
+{
+    // The statement is resolved against tables the compactor thread may be compacting
+    std::unique_lock<std::recursive_mutex> statement_lock = this->lockStatements();
+
+    // The statement may end with its ';'
+    std::string text = _trim(_collapseSpaces(input));
+    if (!text.empty() && text.back() == ';') text = _trim(text.substr(0, text.size() - 1));
+
+    // Parse the statement once, the placeholders are numbered by the parser
+    Statement statement;
+    std::string error;
+    size_t parameter_count = 0;
+    if (!parseStatement(text, statement, error, &parameter_count))
     {
-        return;
+        if (!error.empty()) std::cout << error << "\n";
+        return nullptr;
     }
 
-    // Split the user input with a space delimeter
-    std::vector<std::string> args = _split(input, ' ');
+    try {
+        // Resolve against the current catalog
+        if (this->catalogChanged()) readFilesystem();
+
+        auto prepared = std::make_shared<PreparedStatement>(this, text, std::move(statement), parameter_count);
+        if (!prepared->resolve()) return nullptr;
 
-    HANDLE_CMD(args);
+        return prepared;
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+    }
 
-    return SQL_CLI();
+    return nullptr;
 }
 
 bool SQL::dbSelected()
@@ -172,30 +243,10 @@ bool SQL::dbSelected()
     return false;
 }
 
-bool SQL::createDatabase(const std::vector<std::string>& args)
+bool SQL::createDatabase(const CreateDatabaseStatement& statement)
 {
-    const unsigned int argn = args.size();
-
-    // Maximum number of arguments for CREATE DATABASE command is three
-    const unsigned int max_argn = 3;
-
-    // Check if the number of argument supplied is less than the argument required
-    if (argn < max_argn) { std::cout << "-- [CMD - CREATE - ERROR] -> Supplied argument count (" << argn << ") does not match required argument count (" << max_argn << ")\n"; return false; }
-
-    const std::string command_name  = _toUpper(args[0]);
-    const std::string database      = _toUpper(args[1]);
-    const std::string database_name = args[2];
-
-    // Check that the arguments are correct
-    if (command_name != "CREATE" || database != "DATABASE") 
-    { 
-        std::cout << "-- !Programmer error in SQL::createTable. Contact admin :(\n";
-        return false;
-    }
+    const std::string& database_name = statement.database_name;
 
-    // Check if there are more supplied arguments than required
-    if (argn > max_argn) { errorUnknownArguments(args, command_name, max_argn); return false; }
-    
     // Check that the database has not been created, if so return.
     if(dbExists(database_name)) 
     {   
@@ -224,6 +275,9 @@ bool SQL::createDatabase(const std::vector<std::string>& args)
         return false;
     }
     
+    // Tell other processes to reload the catalog
+    this->touchCatalog();
+
     std::cout << "-- Database " << database_name << " created.\n";
     return true;
 }
@@ -245,25 +299,9 @@ bool SQL::createDatabase(const std::string name, const fs::path& path, const fs:
     return true;
 }
 
-bool SQL::dropDatabase(const std::vector<std::string>& args)
+bool SQL::dropDatabase(const DropDatabaseStatement& statement)
 {
-    const unsigned int argn = args.size();
-    const unsigned int max_argn = 3;
-
-    if (argn < max_argn) { std::cout << "-- [CMD - DROP - ERROR] -> Supplied argument count (" << argn << ") does not match required argument count (" << max_argn << ")\n"; return false; }
-
-    const std::string command_name  = _toUpper(args[0]);
-    const std::string database      = _toUpper(args[1]);
-    const std::string database_name = args[2];
-
-    // Check that the arguments are correct
-    if (command_name != "DROP" || database != "DATABASE") 
-    {
-        std::cout << "-- !Programmer error in SQL::dropTable. Contact admin :(\n";
-        return false;
-    }
-
-    if (argn > max_argn) { errorUnknownArguments(args, command_name, max_argn); return false; }
+    const std::string& database_name = statement.database_name;
 
     // Check that the database has not been created, if so return.
     if(!dbExists(database_name)) 
@@ -275,6 +313,7 @@ bool SQL::dropDatabase(const std::vector<std::string>& args)
     {
         this->databases.erase(database_name);
         decrementDatabaseCount();
+        this->statement_cache.invalidate(database_name);
     }
     catch(const std::exception& e)
     {
@@ -282,93 +321,54 @@ bool SQL::dropDatabase(const std::vector<std::string>& args)
         return false;
     }
     
+    // Tell other processes to reload the catalog
+    this->touchCatalog();
+
     std::cout << "Database " << database_name << " deleted.\n";
     return true;
 }
 
-bool SQL::createTable(const std::vector<std::string>& args)
+bool SQL::createTable(const CreateTableStatement& statement)
 {
-    const unsigned int argn = args.size();
-
-    const std::string command = _toUpper(args[0]);
-    const std::string table = _toUpper(args[1]);
-    const std::string table_name = args[2];
-    std::vector<std::pair<std::string, std::string>> columns;
+    const std::string& table_name = statement.table_name;
 
-    if (command != "CREATE" || table != "TABLE")
-    {
-        std::cout << "-- !Programmer error in SQL::createTable. Contact admin :(\n";
-        return false;
-    }
-    
     if (!dbSelected())
     {
         std::cout << "-- !Failed to create table " << table_name << " because no database is selected.\n";
         return false;
     }
 
-    // Find first instance of character ( in table_name
-    size_t found = table_name.find_first_of('(');
-
-    // If character ( is found, rearange arguments
-    if (found != std::string::npos) {
-        // Get the first parameter
-        std::string first_param = table_name.substr(found, std::string::npos);
-
-        // Erase the first parameter from table_name
-        const_cast<std::vector<std::string>&>(args)[2].erase(args[2].begin() + found, args[2].end());
-
-        // Insert the first parameter after table_name in the vector
-        const_cast<std::vector<std::string>&>(args).insert(args.begin() + 3, first_param);
-
-        // Update the table name
-        const_cast<std::string&>(table_name) = args[2];
-    }
-
     if (this->database->tableExists(table_name))
     {
         std::cout << "-- !Failed to create table " << table_name << " because it already exists.\n";
         return false;
     }
 
-    // Check if column names+types need to be parsed
-    if (argn > 3)
+    // If there are columns, preform type checking
+    if (statement.columns.size())
     {
-        std::vector<std::string> tableArgs(args.begin() + 3, args.end());
-        columns = parseTableColumns(tableArgs);
-        
-        // If there are columns, preform type checking
-        if (columns.size())
+        std::vector<std::string> types;
+        for (auto& col : statement.columns)
         {
-            std::vector<std::string> types;
-            for (auto& col : columns)
-            {
-                types.emplace_back(std::get<1>(col));
-            }
-            if (!checkTypes(types)) return false;
+            types.emplace_back(std::get<1>(col));
         }
+        if (!checkTypes(types)) return false;
     }
 
-    this->database->createTable(table_name, columns);
+    this->database->createTable(table_name, statement.columns);
+    this->statement_cache.invalidate(this->database->getDatabaseName(), table_name);
+
+    // Tell other processes to reload the catalog
+    this->touchCatalog();
 
     std::cout << "-- Table " << table_name << " created.\n";
 
     return true;
 }
 
-bool SQL::dropTable(const std::vector<std::string>& args)
+bool SQL::dropTable(const DropTableStatement& statement)
 {
-    const unsigned int argn = args.size();
-
-    const std::string command = _toUpper(args[0]);
-    const std::string table = _toUpper(args[1]);
-    const std::string table_name = args[2];
-
-    if (command != "DROP" || table != "TABLE")
-    {
-        std::cout << "-- !Programmer error in SQL::dropTable. Contact admin :(\n";
-        return false;
-    }
+    const std::string& table_name = statement.table_name;
 
     if (!dbSelected())
     {
@@ -383,49 +383,77 @@ bool SQL::dropTable(const std::vector<std::string>& args)
     }
 
     this->database->dropTable(table_name);
+    this->statement_cache.invalidate(this->database->getDatabaseName(), table_name);
 
-    std::cout << "--Table " << table_name << " deleted.\n";
+    // Tell other processes to reload the catalog
+    this->touchCatalog();
 
-    return true;
-}
-
-bool SQL::useDatabase(std::shared_ptr<Database> db)
-{
-    if (db == nullptr) return false;
-
-    this->database = db;
-
-    std::cout << "-- Using database " << db->getDatabaseName() << ".\n";
+    std::cout << "--Table " << table_name << " deleted.\n";
 
     return true;
 }
 
-bool SQL::useDatabase(const std::vector<std::string>& args)
+bool SQL::createIndex(const CreateIndexStatement& statement)
 {
-    const unsigned int argn = args.size();
+    const std::string& index_name = statement.index_name;
 
-    // Check for unexpected argument(s)
-    if (argn > 2)
+    if (!dbSelected())
     {
-        errorUnknownArguments(args, "USE", 2); // Handle unknown argument(s) error.
+        std::cout << "-- !Failed to create index " << index_name << " because no database is selected.\n";
         return false;
     }
 
-    if (_toUpper(args[0]) != "USE")
+    // Indexes are hash indexes unless USING names another type
+    IndexType type = INDEX_HASH;
+    if (!statement.index_type.empty() && !indexType(statement.index_type, type))
     {
-        std::cout << "-- !Programmer error in SQL::useDatabase, contact administrator.\n";
+        std::cout << "-- !Unknown index type. Use USING HASH, USING BTREE or USING ART\n";
         return false;
     }
 
-    const std::string database_name = args[1];
+    if (!this->database->createIndex(index_name, statement.table_name, statement.column_name, type)) return false;
+
+    // Tell other processes to reload the catalog
+    this->touchCatalog();
 
-    // Check if provided database_name is empty
-    if (database_name.size() == 0) 
+    std::cout << "-- Index " << index_name << " created.\n";
+
+    return true;
+}
+
+bool SQL::dropIndex(const DropIndexStatement& statement)
+{
+    if (!dbSelected())
     {
-        std::cout << "-- !SQL::useDatabase provided empty database_name.\n";
+        std::cout << "-- !Failed to drop index " << statement.index_name << " because no database is selected.\n";
         return false;
     }
 
+    if (!this->database->dropIndex(statement.index_name)) return false;
+
+    // Tell other processes to reload the catalog
+    this->touchCatalog();
+
+    std::cout << "-- Index " << statement.index_name << " deleted.\n";
+
+    return true;
+}
+
+bool SQL::useDatabase(std::shared_ptr<Database> db)
+{
+    if (db == nullptr) return false;
+
+    this->database = db;
+
+    std::cout << "-- Using database " << db->getDatabaseName() << ".\n";
+
+    return true;
+}
+
+bool SQL::useDatabase(const UseStatement& statement)
+{
+    const std::string& database_name = statement.database_name;
+
     // Check if the database exists - if not it's an error.
     if (!dbExists(database_name))
     {
@@ -439,85 +467,39 @@ bool SQL::useDatabase(const std::vector<std::string>& args)
     return useDatabase(db);
 }
 
-bool SQL::HANDLE_CMD(std::vector<std::string> args)
+bool SQL::HANDLE_CMD(const Statement& statement)
 {
     try {
-        readFilesystem();
-
-        // Grab the commands from the provided arguments
-        std::string command = _toUpper(args[0]);
-
-        // Check if command exists, if it doesn't return 0
-        if (!cmdExists(command)) {
-            std::cout << "-- Command " << command << " does not exist.\n";
-            return 0;
-        }
-
-        unsigned int command_id = cmdId(command);
-
-        if (command_id == 0)     // CREATE COMMAND HANDLER
-        {
-            const std::string create_type = _toUpper(args[1]);
-            if (create_type == "DATABASE") return createDatabase(args);
-            else if (create_type == "TABLE") return createTable(args);
-            else {
-                std::cout << create_type << " is not a valid argument of command CREATE.\n";
-                return false;
-            }
-        }
-        else if (command_id == 1) // DROP COMMAND HANDLER
-        {
-            const std::string drop_type = _toUpper(args[1]);
-            if (drop_type == "DATABASE") return dropDatabase(args);
-            else if (drop_type == "TABLE") return dropTable(args);
-            else 
-            { 
-                std::cout << drop_type << " is not a valid argument of command DROP.\n";
-                return false;
-            }
-        }
-        else if (command_id == 2) // USE COMMAND HANDLER
-        {
-            return useDatabase(args);
-        }
-        else if (command_id == 3) // ALTER COMMAND HANDLER
-        {
-            return alterTable(args);
-        }
-        else if (command_id == 4) // SELECT COMMAND HANDLER
-        {
-            return selectTable(args);
-        }
-        else if (command_id == 5) // INSERT COMMAND HANDLER
-        {
-            const std::string insert_type = _toUpper(args[1]);
-            if (insert_type == "INTO") return insertInto(args);
-            else {
-                std::cout << "-- Invalid insert specifier: " << insert_type << "\n";
-                return false;
-            }
-        }
-        else if (command_id == 6) // UPDATE COMMAND HANDLER
-        {
-            return updateTable(args);
-        }
-        else if (command_id == 7) // DELETE COMMAND HANDLER
-        {
-            return deleteFromTable(args);
-        }
-        else if (command_id == 8) // TRANSACTION COMMAND HANDLER
-        {
-            return beginTransaction(args);
-        }
-        else if (command_id == 9)
+        // The in-memory catalog is authoritative, it is only reloaded when another process changed it.
+        // Tables are read again when another process checkpointed them.
+        if (this->catalogChanged()) readFilesystem();
+        if (this->database) this->database->refresh();
+
+        if (auto s = std::get_if<CreateDatabaseStatement>(&statement)) return createDatabase(*s);
+        else if (auto s = std::get_if<CreateTableStatement>(&statement)) return createTable(*s);
+        else if (auto s = std::get_if<CreateIndexStatement>(&statement)) return createIndex(*s);
+        else if (auto s = std::get_if<DropDatabaseStatement>(&statement)) return dropDatabase(*s);
+        else if (auto s = std::get_if<DropTableStatement>(&statement)) return dropTable(*s);
+        else if (auto s = std::get_if<DropIndexStatement>(&statement)) return dropIndex(*s);
+        else if (auto s = std::get_if<UseStatement>(&statement)) return useDatabase(*s);
+        else if (auto s = std::get_if<AlterTableStatement>(&statement)) return alterTable(*s);
+        else if (auto s = std::get_if<CompactTableStatement>(&statement)) return compactTable(*s);
+        else if (auto s = std::get_if<SelectStatement>(&statement)) return selectTable(*s);
+        else if (auto s = std::get_if<JoinStatement>(&statement)) return selectAllQuery(*s);
+        else if (auto s = std::get_if<InsertStatement>(&statement)) return insertInto(*s);
+        else if (auto s = std::get_if<UpdateStatement>(&statement)) return updateTable(*s);
+        else if (auto s = std::get_if<DeleteStatement>(&statement)) return deleteFromTable(*s);
+        else if (auto s = std::get_if<CopyFromStatement>(&statement)) return copyFrom(*s);
+        else if (auto s = std::get_if<CopyToStatement>(&statement)) return copyTo(*s);
+        else if (auto s = std::get_if<BeginStatement>(&statement)) return beginTransaction(*s);
+        else if (auto s = std::get_if<CommitStatement>(&statement)) return commit(*s);
+        else if (auto s = std::get_if<ShowStatement>(&statement)) return show(*s);
+        else if (auto s = std::get_if<SetStatement>(&statement)) return set(*s);
+        else if (std::get_if<ClearStatement>(&statement))
         {
             system("clear");
             return true;
         }
-        else if (command_id == 10)
-        {
-            return commit(args);
-        }
     }
     catch(const std::exception& e)
     {
@@ -532,28 +514,6 @@ bool SQL::dbExists(const std::string& database_name)
     return this->databases.count(database_name);
 }
 
-bool SQL::cmdExists(const std::string& cmd)
-{
-    return (bool)this->commands.count(cmd);
-}
-
-unsigned int SQL::cmdId(const std::string& cmd)
-{
-    return this->commands.at(cmd);
-}
-
-void SQL::errorUnknownArguments(const std::vector<std::string>& args, const std::string& cmd, unsigned int index)
-{
-    unsigned int argn = args.size();
-    if (index > argn) return;
-    std::cout << "-- [CMD-" << cmd << " - ERROR] -> Unknown Argument(s): {";
-    for (; index < args.size(); index++) {
-        std::cout << args[index];
-        if (index < args.size()-1) std::cout << ", ";
-    }
-    std::cout << "}\n";
-}
-
 std::shared_ptr<Database> SQL::getDatabase(const std::string& database_name)
 {
     if (!dbExists(database_name))
@@ -564,214 +524,44 @@ std::shared_ptr<Database> SQL::getDatabase(const std::string& database_name)
     return this->databases.at(database_name);
 }
 
-std::vector<std::pair<std::string, std::string>> SQL::parseTableColumns(std::vector<std::string> columns)
+bool SQL::selectTable(const SelectStatement& statement)
 {
-    unsigned int num_columns = columns.size();
-
-    // Check if column arguments were provided.
-    if (!num_columns)
-    {
-        // If not, return an empty column list
-        std::cout << "-- !column arguments for CREATE TABLE do not exist\n";
-        return std::vector<std::pair<std::string, std::string>>();
-    }
-
-    // Check if only two column arguments were provided
-    if (num_columns == 2)
-    {
-        std::vector<std::pair<std::string, std::string>> res;
-        std::string tempName = columns[0];
-        std::string tempType = columns[1];
-        unsigned int tempTypeSize = tempType.size();
-        if (tempName[0] == '(') {
-            columns[0].erase(columns[0].begin());
-        }
-        if (tempType.back() == ')' && (tempType[tempTypeSize - 2] == ')') && (!isdigit(tempType[tempTypeSize - 2])))
-        {
-            tempType.pop_back(); // maybe
-        }
-
-        res.emplace_back(std::make_pair(tempName, tempType));
-        return res;
-    }
-
-    if ((num_columns % 2) != 0)
-    {
-        std::cout << "-- !Number of column arguments for CREATE TABLE are not even\n";
-        // This means that the user inputed a missing name/type for column arguments
-        return std::vector<std::pair<std::string, std::string>>();
-    }
-
-    // Check that the column arguments start and end with paranthesis
-    if (! (columns[0][0] == '(') || ! (columns[num_columns-1].back() == ')'))
-    {
-        std::cout << "-- !Column arguments for CREATE TABLE are not wrapped with ()\n";
-        return std::vector<std::pair<std::string, std::string>>();
-    }
-    
-    // Delete the wrapped parenthesis
-    columns[num_columns-1].pop_back();      // Last character of last string
-    columns[0].erase(columns[0].begin());   // First character of first string
-
-    std::string tempName;
-    std::string tempType;
-    std::vector<std::pair<std::string, std::string>> res;
-    for (unsigned int index = 0; index < num_columns; ++index)
-    {
-        if (tempName.size() && tempType.size())
-        {
-            res.emplace_back(std::make_pair(tempName, tempType));
-            tempName.clear(); tempType.clear();
-        }
-
-        if (index % 2) // 1, 3, 5, ...
-        {
-            tempType = columns[index];
-            if (index < num_columns-1 && tempType.back() != ',')
-            {
-                std::cout << "-- !CREATE table error: Missing ',' after datatype " << tempType << ".\n";
-                return std::vector<std::pair<std::string, std::string>>();
-            }
-            else if(columns.back() != tempType){
-                tempType.pop_back();
-            }
-        }
-        else // 0, 2, 4, 6
-        {
-            tempName = columns[index];
-        }
-    }
-    if (tempName.size() && tempType.size())
-    {
-        res.emplace_back(std::make_pair(tempName, tempType));
-    }
-
-    return res;
-}
-
-bool SQL::selectTable(const std::vector<std::string>& args)
-{
-    const unsigned int argn = args.size();
-
-    if (argn < 4) { std::cout << "-- !Invalid number of arguments for command SELECT\n"; return 0; }
-
-    const std::string command = _toUpper(args[0]);
-    if (command != "SELECT") { std::cout << "-- !Programmer error in SQL::selectTable.\n";  return false; }
-
-    std::string table_name;
+    const std::string& table_name = statement.table_name;
 
-    if (args[1] == "*")
-    {
-        std::string from = _toUpper(args[2]);
-        if (from != "FROM") { std::cout << "-- !Unknown argument from command SELECT *: " << from << ". Did you mean FROM?\n"; return false; }
-
-        if (argn == 4) {
-            table_name = args[3];
-
-            // Handle the SELECT * FROM {{ table_name }}; command
-            return this->selectAllFromTable(table_name);
-        }
-        
-        return this->selectAllQuery(args);
-    }
-    
-    std::vector<std::string> columns_to_search;
+    // Handle the SELECT * FROM {{ table_name }}; command
+    if (!statement.where) return this->selectAllFromTable(table_name);
 
-    size_t index = 1;
-    while (index < argn - 1 && _toUpper(args[index]) != "FROM")
-    {
-        columns_to_search.emplace_back(args[index]);
-        if (columns_to_search[index - 1].back() == ',')  {
-            columns_to_search[index - 1].pop_back();
-        }
-        ++index;
-    }
-
-    if (columns_to_search.empty()) { std::cout << "-- !Failed to query any tables. Did you for get the add column names after the SELECT statement?\n"; return false; }
-
-    const std::string from = _toUpper(args[index++]);
-    if (from != "FROM") { std::cout << "-- Unknown command " << from << ". Did you mean FROM?\n"; return false; }
-
-    table_name = args[index++];
     // If the table does NOT exist, alert the user and return false
-    if (!this->database->tableExists(table_name)) { std::cout << "-- !Failed to update table " << table_name << " because it does not exist.\n"; return false; }
-
-    const std::string where = _toUpper(args[index++]);
-    if (where != "WHERE") { std::cout << "--!Failed to query table " << table_name << ". Unknown argument " << where << ". Did you mean 'WHERE'?\n"; return false; }
-
-    const std::string column_to_query = args[index++];
-    const std::string opr = args[index++];
-
-    // If this is NOT a valid operator, return false
-    if (!_isValidOperator(opr)) { std::cout << "-- !Failed to query tables because the operator " << opr << " is not supported. Did you mean '='?\n"; return false; }
-
-    const std::string value_to_query = args[index];
+    if (!this->dbSelected() || !this->database->tableExists(table_name)) { std::cout << "-- !Failed to update table " << table_name << " because it does not exist.\n"; return false; }
 
     std::shared_ptr<Table> table = this->database->getTable(table_name);
 
-    return table->selectColumns(columns_to_search, column_to_query, value_to_query, opr);
+    return table->selectColumns(statement.columns, *statement.where);
 }
 
-bool SQL::selectAllQuery(const std::vector<std::string>& args)
+bool SQL::selectAllQuery(const JoinStatement& statement)
 {
-    const std::string select = _toUpper(args[0]);
-    const std::string all = _toUpper(args[1]);
-    const std::string from = _toUpper(args[2]);
-
-    // Ensure we are handeling the correct arguments
-    if (select != "SELECT" || all != "*" || from != "FROM") {
-        std::cout << "-- !Programmer error in SQL::selectAllQuery.\n";  return false;
-    }
-
-    // Parse all words between 'from' and ('on' or 'where')
-    std::vector<std::string> table_clause;
-    size_t index = 3;
-    while (index < args.size() && (_toUpper(args[index]) != "ON" && _toUpper(args[index]) != "WHERE")) {
-        table_clause.emplace_back(args[index++]);
-    }
-
-    if (table_clause.size() < 4 || table_clause.size() == 5) { std::cout << "== !Incorrect table clause for SELECT * FROM\n"; return false; }
-
-    if (table_clause[1].back() == ',') table_clause[1].pop_back();
-
-    // Initilize table_name table_nickname containers
-    std::pair<std::string, std::string> table_1 = std::make_pair(table_clause[0], table_clause[1]);
-    std::pair<std::string, std::string> table_2 = std::make_pair(table_clause[table_clause.size() - 2], table_clause[table_clause.size() - 1]);
-
-    // Set the selection parameters
-    short int join = 0;
-    bool left = true, right = false, inner = true;
-
-    index = 2;
-    if (_toUpper(table_clause[index]) == "RIGHT") { left = false; right = true; }
-    else if (_toUpper(table_clause[index] == "FULL")) { right = true; }
-    if (_toUpper(table_clause[index]) == "OUTER" || _toUpper(table_clause[index + 1]) == "OUTER") { inner = false; }
-
-    // Get the index of the 'WHERE' or 'ON' keyword
-    index = 0;
-    while (index < args.size() && _toUpper(args[index]) != "ON" && _toUpper(args[index]) != "WHERE") ++index;
-    if (index >= args.size() - 1) { std::cout << "-- !Query failed. Missing 'WHERE' or 'ON' token\n"; return false; }
+    if (!this->dbSelected()) { std::cout << "-- Database not selected\n"; return false; }
 
-    // Collect the query statement
-    std::vector<std::string> query_statement;
-    while (index < args.size()) query_statement.emplace_back(args[index++]);
+    // The query statement: {WHERE|ON} alias.column operator alias.column
+    const std::vector<std::string> query_statement = { statement.keyword, statement.column1, statement.op, statement.column2 };
 
     return this->database->queryTables(
-        table_1, 
-        table_2,
-        std::make_pair(left, right),
-        inner,
+        statement.table1, 
+        statement.table2,
+        std::make_pair(statement.left, statement.right),
+        statement.inner,
         query_statement
     );
 }
 
 bool SQL::selectAllFromTable(const std::string& table_name)
 {
+    if (!this->dbSelected() || !this->database->tableExists(table_name)) { std::cout << "-- !Failed to query table " << table_name << " because it does not exist.\n"; return false; }
+
     try {
         std::shared_ptr<Table> table = this->database->getTable(table_name);
 
-        readCSV(table, table->getPath());
-
         return table->printAll();
     }
     catch(const std::exception& e)
@@ -782,30 +572,21 @@ bool SQL::selectAllFromTable(const std::string& table_name)
     return false;
 }
 
-bool SQL::alterTable(const std::vector<std::string>& args)
+bool SQL::alterTable(const AlterTableStatement& statement)
 {
-    const unsigned int argn = args.size();
-    const std::string command = args[0];
-    const std::string table = args[1];
-    const std::string table_name = args[2];
-    const std::string alter_type = args[3];
-
-    std::vector<std::string> tableArgs(args.begin() + 4, args.end());
-    std::vector<std::pair<std::string, std::string>> columns = parseTableColumns(tableArgs);
-
-    if (command != "ALTER" || table != "TABLE")
-    {
-        std::cout << "-- !Programmer error in SQL::alterTable. Contact admin :(\n";
-        return false;
-    }
+    const std::string& table_name = statement.table_name;
 
-    if (!database->tableExists(table_name))
+    if (!dbSelected() || !database->tableExists(table_name))
     {
         std::cout << "-- !Could not modify table " << table_name << " because it did not exist.\n";
         return false;
     }
 
-    this->database->addColumnsToTable(table_name, columns);
+    this->database->addColumnsToTable(table_name, statement.columns);
+    this->statement_cache.invalidate(this->database->getDatabaseName(), table_name);
+
+    // Tell other processes to reload the catalog
+    this->touchCatalog();
 
     std::cout << "-- Table " << table_name << " modified.\n";
     return true;
@@ -888,18 +669,8 @@ bool SQL::checkTypes(std::vector<std::string> types)
     return true;
 }
 
-bool SQL::insertInto(const std::vector<std::string>& args)
+bool SQL::insertInto(const InsertStatement& statement)
 {
-    const std::string command = _toUpper(args[0]);
-    const std::string command_type = _toUpper(args[1]);
-
-    // Make sure we are handling the correct command
-    if (command != "INSERT" && command_type != "INTO")
-    {
-        std::cout << "-- Programmer error in insertInto :(\n";
-        return 0;
-    }
-
     // Ensure a database is selected
     if (!dbSelected())
     {
@@ -907,7 +678,7 @@ bool SQL::insertInto(const std::vector<std::string>& args)
         return false;
     }
 
-    const std::string table_name = args[2];
+    const std::string& table_name = statement.table_name;
 
     // Ensure table exists in the selected database
     const bool table_exists = this->database->tableExists(table_name);
@@ -917,94 +688,31 @@ bool SQL::insertInto(const std::vector<std::string>& args)
         return false;
     }
 
-    // Create a sub vector of just the parameters
-    std::vector<std::string> paramsVec = _subVector(args, args.begin() + 3, args.end());
-
-    // Join the parameters as a string with space as delimeter
-    std::string paramsString = _join(paramsVec, std::string(" "));
-
-    // Replace multiple tabs and spaces with a single space
-    std::regex regx("[ \t]+");
-    paramsString = std::regex_replace(paramsString, regx, std::string(""));
+    // Get a pointer to the table we want to insert into
+    std::shared_ptr<Table> table = this->database->getTable(table_name);
 
-    // Ensure the user specified correct formatting
-    std::string values = _toUpper(std::string(paramsString.begin(), paramsString.begin() + 7));
-    if (values != "VALUES(" || paramsString.back() != ')') 
+    // Return the insertRow function in table, several rows are inserted as one batch
+    if (statement.row_count > 1)
     {
-        std::cout << "-- INSERT INTO parameters not formatted correctly. Correct format is VALUES(x, y, z, ...)\n";
-        return false;
+        if (!table->insertRows(statement.values, statement.row_count, true)) return false;
+        std::cout << "-- " << statement.row_count << " new records inserted.\n";
     }
+    else
+    {
+        bool success = table->insertRow(statement.values, true);
 
-    // Parse the parameters we want to insert: parse format =  x,y,z,...
-    std::string paramsParsed = std::string(paramsString.begin() + 7, paramsString.end() - 1);
-
-    // Isolate the parameters without their delimeters
-    std::vector<std::string> isolatedParams = isolateParams(paramsParsed);
-
-    // Get a pointer to the table we want to insert into
-    std::shared_ptr<Table> table = this->database->getTable(table_name);
-
-    // Return the insertRow function in table
-    bool success = table->insertRow(isolatedParams, true);
+        if (!success) return false;
 
-    if (!success) return false;
+        std::cout << "-- 1 new record inserted.\n"; 
+    }
 
-    std::cout << "-- 1 new record inserted.\n"; 
+    this->database->autoCheckpoint();
 
     return true;
 }
 
-std::vector<std::string> SQL::isolateParams(std::string params, char delim)
-{
-    // Initialize an empty vector container of strings for each parameter in params
-    std::vector<std::string> container((size_t)1, std::string(""));
-
-    // Initialize index to track each position of the container to insert characters into
-    size_t index = 0;
-
-    // Initialize stack to track if we are parsing quotes and therefore a varchar
-    std::stack<char> quotes;
-
-    // Iterate over every character of params, and parse each parameter
-    for (auto& c : params) 
-    {
-        // The comma is a delimeter, so it marks the start of the next parameter unless we are parsing a varchar
-        if (c == delim && quotes.empty()) 
-        {
-            ++index;
-            container.emplace_back(std::string(""));
-        }
-        // Parsing the character " so insert into stack if applicable 
-        else if (c == 34) 
-        { 
-            if (!quotes.empty() && quotes.top() == 34) quotes.pop();
-            else if (quotes.empty() && (container[index].empty())) quotes.push(34);
-            else container[index] += c;
-        }
-        // Parsing the character ' so insert into stack if applicable 
-        else if (c == 39) 
-        {
-            if (!quotes.empty() && quotes.top() == 39) quotes.pop();
-            else if (quotes.empty() && (container[index].empty())) quotes.push(39); 
-            else container[index] += c;
-        }
-        // Valid character is appended into the container at index
-        else {
-            container[index] += c;
-        }
-    }
-
-    return container;
-}
-
-bool SQL::updateTable(const std::vector<std::string>& args)
+bool SQL::updateTable(const UpdateStatement& statement)
 {
-    // Grab the command
-    const std::string command = _toUpper(args[0]);
-
-    // The function handles the UPDATE {{ table_name }} SET .. command.
-    if (command != "UPDATE") { std::cout << "-- Programmer error in updateTable\n"; return false; }
-
     // If the database has NOT been selected, alert the user and return false.
     if (!dbSelected()) { std::cout << "-- Database not selected\n"; return false; }
 
@@ -1012,67 +720,14 @@ bool SQL::updateTable(const std::vector<std::string>& args)
     const DatabaseMetadata db_md = this->readDatabaseMetadata(this->database->getPathMetadata());
     this->database->applyMetadata(db_md);
 
-    // Grab the table name
-    const std::string table_name = args[1];
+    const std::string& table_name = statement.table_name;
 
     // If the table does NOT exist, alert the user and return false
     if (!this->database->tableExists(table_name)) { std::cout << "-- !Failed to update table " << table_name << " because it does not exist.\n"; return false; }
 
-    // Grab the SET keyword
-    const std::string set = _toUpper(args[2]);
-
-    // Only the SET keyword is allowed for the UPDATE {{ table_name }} command.
-    // If the argument is not SET alert the user and return false
-    if (set != "SET") { std::cout << "-- Unknown command " << set << ". Did you mean SET?\n"; return false; }
-
-    // Get the name of the column we want to update
-    const std::string column_to_update = args[3];
-
     // Fetch the table ptr
     std::shared_ptr<Table> table = this->database->getTable(table_name);
 
-    // Get the first operator, this should always be '='
-    const std::string op1 = args[4];
-    
-    // If the operator is NOT '=' alert the user and return false.
-    if (op1 != "=") { std::cout << "-- !Failed to update table " << table_name << " because the first operator " << op1 << " is not supported. Did you mean '='?\n"; return false; }
-
-    // Get the value we want to update
-    std::string value_to_update = args[5];
-
-    // If the first and last characer are single or doubles quotes, erase and the first and last character
-    if (value_to_update.size() > 2 && 
-        ((value_to_update[0] == 39 && value_to_update.back() == 39) || (value_to_update[0] == 34 && value_to_update.back() == 34))
-    ) 
-    {
-        value_to_update = value_to_update.substr(1, value_to_update.size() - 2);
-    }
-
-    // Get the query parameter 'WHERE', we expect this to always be included
-    const std::string where = _toUpper(args[6]);
-
-    if (where != "WHERE") { std::cout << "--!Failed to update table " << table_name << ". Unknown argument " << where << ". Did you mean 'WHERE'?\n"; return false; }
-
-    // Get the name of the column we want to search
-    const std::string column_to_search = args[7];
-
-    // Get the second operator
-    const std::string op2 = args[8];
-
-    // If this is NOT a valid operator, return false
-    if (!_isValidOperator(op2)) { std::cout << "-- !Failed to update table " << table_name << " because the second operator " << op2 << " is not supported. Did you mean '='?\n"; return false; }
-
-    // Get the value we want to search for
-    std::string value_to_search = args[9];
-
-    // If the first and last characer are single or doubles quotes, erase and the first and last character
-    if (value_to_search.size() > 2 && 
-        ((value_to_search[0] == 39 && value_to_search.back() == 39) || (value_to_search[0] == 34 && value_to_search.back() == 34))
-    ) 
-    {
-        value_to_search = value_to_search.substr(1, value_to_search.size() - 2);
-    }
-
     const TableMetadata t_md = this->readTableMetadata(table->getPathMetadata());
     table->applyMetadata(t_md);
 
@@ -1098,8 +753,9 @@ bool SQL::updateTable(const std::vector<std::string>& args)
             p += table_name; p += ".txt";
             std::ofstream transaction_file(p, std::ofstream::out | std::ofstream::ate );
             
-            std::string command = _join(args, " ");
-            command += ";";
+            // The statement is run again at COMMIT
+            std::string command = "UPDATE " + table_name + " SET " + statement.column_name + " = " + quoteValue(statement.value);
+            command += " WHERE " + predicateText(*statement.where) + ";";
 
             transaction_file << command << "\n";
 
@@ -1112,80 +768,220 @@ bool SQL::updateTable(const std::vector<std::string>& args)
     }
 
     // Query the table to update based on these parameters
-    bool success = table->updateColumnSet(column_to_update, column_to_search, value_to_update, value_to_search, op2, mode);
-    table->writeMetadata();
-    table->writeCSV();
+    bool success = table->updateColumnSet(statement.column_name, statement.value, *statement.where, mode);
+    this->database->autoCheckpoint();
 
     return success;
 }
 
-bool SQL::deleteFromTable(const std::vector<std::string>& args)
+bool SQL::deleteFromTable(const DeleteStatement& statement)
 {
-    // Get the command from the arguments
-    const std::string command = _toUpper(args[0]);
+    const std::string& table_name = statement.table_name;
 
-    // The function handles the DELETE {{ table_name }} FROM .. command. 
-    if (command != "DELETE") { std::cout << "-- Programmer error in deleteFromTable\n"; return false; }
+    // If the table does NOT exist, alert the user and return false
+    if (!this->dbSelected() || !this->database->tableExists(table_name)) { std::cout << "-- !Failed to update table " << table_name << " because it does not exist.\n"; return false; }
 
-    // Get the 'FROM' keyword
-    const std::string from = _toUpper(args[1]);
-    
-    // Only the FROM keyword is allowed for the DELETE FROM {{ table_name }} command.
-    // If the argument is not FROM alert the user and return false
-    if (from != "FROM") { std::cout << "-- Unknown command " << from << ". Did you mean FROM?\n"; return false; }
+    // Fetch the table ptr
+    std::shared_ptr<Table> table = this->database->getTable(table_name);
 
-    // Grab the table name
-    const std::string table_name = args[2];
-    
-    // If the table does NOT exist, alert the user and return false
-    if (!this->database->tableExists(table_name)) { std::cout << "-- !Failed to update table " << table_name << " because it does not exist.\n"; return false; }
+    bool success = table->deleteFromTable(*statement.where);
+    this->autoCompact(this->database, table);
+    this->database->autoCheckpoint();
+
+    return success;
+}
+
+bool SQL::copyFrom(const CopyFromStatement& statement)
+{
+    const std::string& table_name = statement.table_name;
+
+    if (!this->dbSelected() || !this->database->tableExists(table_name)) { std::cout << "-- !Failed to copy into table " << table_name << " because it does not exist.\n"; return false; }
+
+    const fs::path path(statement.path);
+    if (!fs::is_regular_file(path)) { std::cout << "-- !Failed to copy into table " << table_name << " because file " << statement.path << " does not exist.\n"; return false; }
+
+    const auto start = std::chrono::steady_clock::now();
+
+    // Stream the file into the table
+    std::shared_ptr<Table> table = this->database->getTable(table_name);
+    CSVLoader loader(table);
+    CopyStats stats;
+    if (!loader.load(path, statement.header, true, stats)) { std::cout << "-- !Failed to copy file " << statement.path << " into table " << table_name << "\n"; return false; }
+
+    // The rows are not logged, the checkpoint stores them in the column files
+    if (stats.rows && !this->database->checkpoint()) return false;
 
-    // Get the 'WHERE' keyword
-    const std::string where = _toUpper(args[3]);
-    if (where != "WHERE") { std::cout << "-- Unknown command " << where << ". Did you mean WHERE?\n"; return false; }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double megabytes = stats.bytes / 1e6;
 
-    // Grab the name of the column we want to search
-    const std::string column_to_search = args[4];
+    char rate[64];
+    snprintf(rate, sizeof(rate), "%.1f MB at %.1f MB/s", megabytes, seconds > 0 ? megabytes / seconds : 0.0);
+    std::cout << "-- " << stats.rows << " rows copied into table " << table_name << ", " << rate << ".\n";
+    if (stats.rejected) std::cout << "-- !" << stats.rejected << " lines rejected, the first at line " << stats.first_rejected << ".\n";
 
-    // Grab the operator we want to preform the search on
-    const std::string opr = args[5];
+    return true;
+}
 
-    // If this is NOT a valid operator, return false
-    if (!_isValidOperator(opr)) { std::cout << "-- !Failed to delete from table " << table_name << " because the second operator " << opr << " is not supported. Did you mean '='?\n"; return false; }
+bool SQL::copyTo(const CopyToStatement& statement)
+{
+    const std::string& table_name = statement.table_name;
 
-    // Grab the value we want to search for
-    std::string value_to_search = args[6];
+    if (!this->dbSelected() || !this->database->tableExists(table_name)) { std::cout << "-- !Failed to copy table " << table_name << " because it does not exist.\n"; return false; }
 
-    // If the first and last characer are single or doubles quotes, erase and the first and last character
-    if (value_to_search.size() > 2 && 
-        ((value_to_search[0] == 39 && value_to_search.back() == 39) || (value_to_search[0] == 34 && value_to_search.back() == 34))
-    ) 
+    // Files are csv files unless FORMAT names another format
+    ExportFormat format = EXPORT_CSV;
+    if (!statement.format.empty() && !exportFormat(statement.format, format))
     {
-        value_to_search = value_to_search.substr(1, value_to_search.size() - 2);
+        std::cout << "-- !Unknown file format. Use FORMAT CSV, FORMAT BINARY or FORMAT JSONL\n";
+        return false;
     }
+    if (statement.header && format != EXPORT_CSV) { std::cout << "-- !HEADER is only written to csv files.\n"; return false; }
+
+    const auto start = std::chrono::steady_clock::now();
 
-    // Fetch the table ptr
     std::shared_ptr<Table> table = this->database->getTable(table_name);
+    if (statement.where && !table->resolvePredicate(*statement.where)) return false;
+
+    // Stream the rows into the file
+    TableExporter exporter(table, format);
+    ExportStats stats;
+    if (!exporter.write(statement.path, statement.where.get(), statement.header, stats)) { std::cout << "-- !Failed to copy table " << table_name << " to file " << statement.path << "\n"; return false; }
 
-    return table->deleteFromTable(column_to_search, value_to_search, opr);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    const double megabytes = stats.bytes / 1e6;
+
+    char rate[64];
+    snprintf(rate, sizeof(rate), "%.1f MB at %.1f MB/s", megabytes, seconds > 0 ? megabytes / seconds : 0.0);
+    std::cout << "-- " << stats.rows << " rows copied from table " << table_name << " (" << exportFormatName(format) << "), " << rate << ".\n";
+
+    return true;
+}
+
+void SQL::autoCompact(std::shared_ptr<Database> db, std::shared_ptr<Table> table)
+{
+    if (!table->needsCompaction()) return;
+
+    // Otherwise the deleted rows are removed by COMPACT TABLE or the next checkpoint
+    if (db->getCompaction() == COMPACTION_AUTO) table->compact();
+    else if (db->getCompaction() == COMPACTION_BACKGROUND) this->compactor.schedule(table);
 }
 
-bool SQL::beginTransaction(const std::vector<std::string>& args)
+bool SQL::compactTable(const CompactTableStatement& statement)
 {
-    unsigned int n = args.size();
-    const std::string begin = _toUpper(args[0]);
-    const std::string transaction = _toUpper(args[1]);
+    const std::string& table_name = statement.table_name;
 
-    if (begin != "BEGIN" || transaction != "TRANSACTION") {
-        std::cout << "Programmer error in beginTransaction - returning\n";
+    if (!dbSelected())
+    {
+        std::cout << "-- !Failed to compact table " << table_name << " because no database is selected.\n";
         return false;
     }
 
-    if (n > 2) {
-        errorUnknownArguments(args, "BEGIN TRANSACTION", 2);
+    if (!this->database->tableExists(table_name))
+    {
+        std::cout << "-- !Failed to compact table " << table_name << " because it does not exist.\n";
         return false;
     }
 
+    // The column files are rewritten without the rows at the next checkpoint
+    const size_t count = this->database->getTable(table_name)->compact();
+    std::cout << "-- Table " << table_name << " compacted, " << count << " deleted rows removed.\n";
+
+    return true;
+}
+
+bool SQL::show(const ShowStatement& statement)
+{
+    const std::string& show_type = statement.what;
+
+    // The statement cache belongs to the client, not to a database
+    if (show_type == "CACHE")
+    {
+        std::cout << "-- statements | capacity | hits | misses\n";
+        std::cout << "-- " << this->statement_cache.size() << " | " << this->statement_cache.getCapacity() << " | " << this->statement_cache.getHits() << " | " << this->statement_cache.getMisses() << "\n";
+        return true;
+    }
+
+    if (!this->dbSelected()) { std::cout << "-- Database not selected\n"; return false; }
+
+    if (show_type == "TABLES") return this->database->printTables();
+    if (show_type == "INDEXES") return this->database->printIndexes();
+    if (show_type == "STATS") return this->database->printStats();
+
+    std::cout << "-- " << show_type << " is not a valid argument of command SHOW.\n";
+    return false;
+}
+
+bool SQL::set(const SetStatement& statement)
+{
+    const std::string& setting = statement.setting;
+    const std::string& value = statement.value;
+
+    // The statement cache belongs to the client, not to a database
+    if (setting == "STATEMENT_CACHE")
+    {
+        if (value.empty() || !std::all_of(value.begin(), value.end(), ::isdigit)) { std::cout << "-- !STATEMENT_CACHE expects a number of statements\n"; return false; }
+
+        this->statement_cache.setCapacity(std::stoull(value));
+        std::cout << "-- STATEMENT_CACHE set to " << this->statement_cache.getCapacity() << " statements.\n";
+        return true;
+    }
+
+    if (!this->dbSelected()) { std::cout << "-- Database not selected\n"; return false; }
+
+    std::shared_ptr<WriteAheadLog> wal = this->database->getWal();
+
+    if (setting == "WAL_SYNC")
+    {
+        WalSyncPolicy policy;
+        if (!walSyncPolicy(value, policy)) { std::cout << "-- !Unknown WAL_SYNC policy " << value << ". Use OFF, NORMAL or FULL\n"; return false; }
+
+        wal->setSyncPolicy(policy);
+        std::cout << "-- WAL_SYNC set to " << walSyncPolicyName(policy) << ".\n";
+        return true;
+    }
+    else if (setting == "WAL_CHECKPOINT")
+    {
+        if (value.empty() || !std::all_of(value.begin(), value.end(), ::isdigit)) { std::cout << "-- !WAL_CHECKPOINT expects a size in bytes\n"; return false; }
+
+        wal->setCheckpointSize(std::stoull(value));
+        std::cout << "-- WAL_CHECKPOINT set to " << wal->getCheckpointSize() << " bytes.\n";
+        return true;
+    }
+    else if (setting == "WAL_COMMIT_WINDOW")
+    {
+        if (value.empty() || !std::all_of(value.begin(), value.end(), ::isdigit)) { std::cout << "-- !WAL_COMMIT_WINDOW expects a time in microseconds\n"; return false; }
+
+        wal->setCommitWindow(std::stoull(value));
+        std::cout << "-- WAL_COMMIT_WINDOW set to " << wal->getCommitWindow() << " microseconds.\n";
+        return true;
+    }
+    else if (setting == "ADAPTIVE_INDEXING")
+    {
+        const std::string mode = _toUpper(value);
+        if (mode != "ON" && mode != "OFF") { std::cout << "-- !Unknown ADAPTIVE_INDEXING mode " << value << ". Use ON or OFF\n"; return false; }
+
+        this->database->setAdaptiveIndexing(mode == "ON");
+        std::cout << "-- ADAPTIVE_INDEXING set to " << mode << ".\n";
+        return true;
+    }
+    else if (setting == "COMPACTION")
+    {
+        const std::string mode = _toUpper(value);
+        if (mode == "MANUAL") this->database->setCompaction(COMPACTION_MANUAL);
+        else if (mode == "AUTO") this->database->setCompaction(COMPACTION_AUTO);
+        else if (mode == "BACKGROUND") this->database->setCompaction(COMPACTION_BACKGROUND);
+        else { std::cout << "-- !Unknown COMPACTION mode " << value << ". Use MANUAL, AUTO or BACKGROUND\n"; return false; }
+
+        std::cout << "-- COMPACTION set to " << mode << ".\n";
+        return true;
+    }
+
+    std::cout << "-- " << setting << " is not a valid argument of command SET.\n";
+    return false;
+}
+
+bool SQL::beginTransaction(const BeginStatement&)
+{
     if (!this->dbSelected()) {
         std::cout << "-- Database not selected\n";
         return false;
@@ -1212,6 +1008,11 @@ bool SQL::readFilesystem()
     fs::path storage_path = fs::current_path();
     storage_path += "/storage/";
 
+    // Remember the catalog generation being loaded, a change made during the walk triggers another reload
+    this->catalog_time = this->catalogTime();
+    ++this->schema_version;
+    this->statement_cache.clear();
+
     // If the storage directory does NOT exist, create it and return.
     if (!fs::exists(storage_path)) {
         fs::create_directories(storage_path);
@@ -1234,8 +1035,8 @@ bool SQL::readFilesystem()
             {
                 const DatabaseMetadata db_md = this->readDatabaseMetadata(metadata_path);
                 
-                // Create the daatabase and if successful, continue
-                if (createDatabase(db_name, path, metadata_path)) {
+                // Create the daatabase unless it is already in the catalog, and if successful, continue
+                if (dbExists(db_name) || createDatabase(db_name, path, metadata_path)) {
 
                     // Get a pointer to the database and set the transaction mode
                     auto db = this->getDatabase(db_name);
@@ -1259,23 +1060,38 @@ bool SQL::readFilesystem()
                             {
                                 auto table = db->getTable(table_metadata.table_name);
                                 table->setLocked(table_metadata.locked);
-                                fs::path csv_path = table_path; csv_path += "/"; csv_path += table_name; csv_path += ".csv";
                             }
 
-                            // Create the table, and if successful, continue
-                            else if (db->createTable(table_metadata.table_name, table_metadata.column_meta_data)) 
+                            else
                             {
-                                // Get a pointer to the table and set the locked state
-                                auto table = db->getTable(table_metadata.table_name);
-                                table->setLocked(table_metadata.locked);
-
-                                // Get the path of the csv file
+                                // Tables written before the binary format only have a csv file
+                                fs::path tbl_path = table_path; tbl_path += "/"; tbl_path += table_name; tbl_path += ".tbl";
                                 fs::path csv_path = table_path; csv_path += "/"; csv_path += table_name; csv_path += ".csv";
-
-                                this->readCSV(table, csv_path);
+                                const bool legacy = !fs::exists(tbl_path) && fs::exists(csv_path);
+
+                                // Create the table, and if successful, continue
+                                if (db->createTable(table_metadata.table_name, table_metadata.column_meta_data))
+                                {
+                                    // Get a pointer to the table and set the locked state
+                                    auto table = db->getTable(table_metadata.table_name);
+                                    table->setLocked(table_metadata.locked);
+
+                                    // Import a legacy csv file once, afterwards the table is opened cold and its
+                                    // column files are mapped when it is first used
+                                    if (legacy) {
+                                        this->readCSV(table, csv_path);
+                                        table->writeBinary();
+                                    }
+                                    else table->open();
+
+                                    table->writeMetadata();
+                                }
                             }
                         }
                     }
+
+                    // Replay the statements logged after the last checkpoint
+                    db->recover();
                 }
             }              
         }
@@ -1285,6 +1101,49 @@ bool SQL::readFilesystem()
     return true;
 }
 
+fs::path SQL::catalogPath()
+{
+    fs::path p = fs::current_path();
+    p += "/storage/catalog.gen";
+    return p;
+}
+
+fs::file_time_type SQL::catalogTime()
+{
+    std::error_code ec;
+    const fs::file_time_type time = fs::last_write_time(this->catalogPath(), ec);
+    return ec ? fs::file_time_type::min() : time;
+}
+
+bool SQL::catalogChanged()
+{
+    return this->catalogTime() != this->catalog_time;
+}
+
+void SQL::touchCatalog()
+{
+    const fs::path path = this->catalogPath();
+
+    // A reload from a change made by another process must not be skipped
+    const bool changed = this->catalogChanged();
+
+    // Prepared statements are resolved again
+    ++this->schema_version;
+
+    // Increment the generation counter, rewriting the file updates its modification time
+    uint64_t generation = 0;
+    {
+        std::ifstream in(path, std::ifstream::in);
+        in >> generation;
+    }
+    {
+        std::ofstream out(path, std::ofstream::out | std::ofstream::trunc);
+        out << generation + 1 << "\n";
+    }
+
+    if (!changed) this->catalog_time = this->catalogTime();
+}
+
 const DatabaseMetadata SQL::readDatabaseMetadata(const fs::path& path)
 {
     if (fs::exists(path))
@@ -1396,61 +1255,20 @@ bool SQL::readCSV(std::shared_ptr<Table> table, const fs::path& path)
     if (fs::exists(path) && fs::is_regular_file(path))
     {
 
-        unsigned int row_count = table->getRowCount();
-
-        for(size_t i = 0; i < row_count; i++) {
-            table->deleteRow(0);
-        }
-
-        // Open an input stream
-        std::ifstream csv_file(path, std::ifstream::in);
-
-        // Initialize a string container
-        std::string line;
-
-        // Do nothing with the first line (the first line are headers)
-        std::getline(csv_file, line);
+        // Drop the rows currently held in memory, they are replaced by the file contents
+        table->clearRows();
 
-        std::vector<std::vector<std::string>> rows;
-
-        // Iterate over every line in the csv
-        while (std::getline(csv_file, line)) 
-        {
-            // Split the line by commas, spltting columns by a vector of (name, type)
-            rows.emplace_back( _split(line, ','));
-        }
-
-        for (auto& row : rows) {
-            // Insert the row into the table
-            try {
-                table->insertRow(row, false);
-            }
-            catch(const std::exception& e) {
-                // Do nothing with exception and continue
-            }
-        }
-        // True for success
-        return true;                                
+        // Stream the file into the table, the first line holds the headers and rows that do not convert are skipped
+        CSVLoader loader(table);
+        CopyStats stats;
+        return loader.load(path, true, false, stats);
     }
     // False for failure
     return false;
 }
 
-bool SQL::commit(const std::vector<std::string>& args)
+bool SQL::commit(const CommitStatement&)
 {
-    unsigned int n = args.size();
-    const std::string commit = _toUpper(args[0]);
-
-    if (commit != "COMMIT") {
-        std::cout << "Programmer error in commit - returning\n";
-        return false;
-    }
-
-    if (n > 1) {
-        errorUnknownArguments(args, "COMMIT", 1);
-        return false;
-    }
-
     if (!this->dbSelected()) {
         std::cout << "-- Database not selected\n";
         return false;
@@ -1487,9 +1305,10 @@ bool SQL::commit(const std::vector<std::string>& args)
 
             std::string line;
             while (std::getline(command_file, line)) {
-                std::vector<std::string> args = _split(line, ' ');
-                if (!args.empty()) {
-                    HANDLE_CMD(args);
+                // Every line is one statement ending with ';'
+                if (!line.empty() && line.back() == ';') line.pop_back();
+                if (!line.empty()) {
+                    this->execute(line);
                 }   
             }
 
@@ -1504,6 +1323,10 @@ bool SQL::commit(const std::vector<std::string>& args)
     }
 
     fs::remove_all(p);
+
+    // Make the committed statements durable and visible to other processes
+    this->database->checkpoint();
+
     std::cout << "Transaction commited.\n";
 
     return true;
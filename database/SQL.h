@@ -9,6 +9,19 @@
 
 #include "include.h"
 #include "database.h"
+#include "parser.h"
+#include "prepared.h"
+#include "cache.h"
+#include "compactor.h"
+#include "loader.h"
+#include "exporter.h"
+
+// How statements reach the client
+enum ClientMode
+{
+    CLIENT_INTERACTIVE = 0,     // Statements are read from the console until .exit
+    CLIENT_EMBEDDED             // Statements are run by execute and prepare, the console is not read
+};
 
 class SQL
 {
@@ -18,10 +31,9 @@ public:
      * */
     SQL();
     SQL(std::string);
+    SQL(ClientMode mode);
     ~SQL();
 
-    void initializeCommands();
-
     /**
      *  SQL_CLI
      * * The active command line interface
@@ -30,16 +42,35 @@ public:
     void SQL_CLI();
 
     
-    /**  Handles the command given by the user
-     * @param vector<string> args
+    /**  Runs one statement (without its ';'), from the statement cache if a statement of the same
+     *  shape was run before
+     * @param string input
      * @return bool */
-    bool HANDLE_CMD(std::vector<std::string> args);
+    bool execute(const std::string& input);
+
+    /**  Parses and runs one statement (without its ';')
+     * @param string input
+     * @return bool */
+    bool runStatement(const std::string& input);
+
+    /**  Prepares the normalized text of a statement that ran and caches it (see cache.h) */
+    void cacheStatement(const std::string& key, const std::string& normalized, const size_t value_count);
+
+    /**  The statement cache of the client */
+    StatementCache& getStatementCache() { return this->statement_cache; }
 
-    /** Checks if a command exists */
-    bool cmdExists(const std::string& cmd);
+    /**  Locks out the compactor thread while a statement runs (see compactor.h), execute and prepare take it */
+    std::unique_lock<std::recursive_mutex> lockStatements() { return std::unique_lock<std::recursive_mutex>(this->statement_mutex); }
 
-    /** Gets the ID of a command */
-    unsigned int cmdId(const std::string& cmd);
+    /**  Parses a statement (with ? placeholders for values) and resolves it against the catalog
+     * @param string input
+     * @return the prepared statement, nullptr if it is invalid (the error is printed) */
+    std::shared_ptr<PreparedStatement> prepare(const std::string& input);
+
+    /**  Handles the statement given by the user
+     * @param Statement statement
+     * @return bool */
+    bool HANDLE_CMD(const Statement& statement);
 
     /**  Check if a database is selected
      *  Returns true if a database is selected */
@@ -48,35 +79,61 @@ public:
     /**  Return a shared pointer to a database */
     std::shared_ptr<Database> getDatabase(const std::string& database_name);
 
+    /**  Return a shared pointer to the selected database (nullptr if none is selected) */
+    std::shared_ptr<Database> getSelectedDatabase() { return this->database; }
+
+    /**  Version of the catalog, it changes whenever a database, table or index is created, dropped
+     *  or altered, or the catalog is read again (prepared statements are resolved again) */
+    uint64_t getSchemaVersion() { return this->schema_version; }
+
     /**  Creates a database and maps it*/
-    bool createDatabase(const std::vector<std::string>& args);
+    bool createDatabase(const CreateDatabaseStatement& statement);
     bool createDatabase(const std::string name, const fs::path& path, const fs::path& path_metadata);
 
     /**  Drops a database*/
-    bool dropDatabase(const std::vector<std::string>& args);
+    bool dropDatabase(const DropDatabaseStatement& statement);
 
     /**  Creates a table (if a db is selected) and maps it*/
-    bool createTable(const std::vector<std::string>& args);
+    bool createTable(const CreateTableStatement& statement);
+
+    /**  Handles the CREATE INDEX {{ index_name }} ON {{ table_name }}({{ column }}) [USING HASH|BTREE|ART] command */
+    bool createIndex(const CreateIndexStatement& statement);
+
+    /**  Handles the DROP INDEX {{ index_name }} command */
+    bool dropIndex(const DropIndexStatement& statement);
 
     /**  Outputs data from a table  */
-    bool selectTable(const std::vector<std::string>& args);
+    bool selectTable(const SelectStatement& statement);
     bool selectAllFromTable(const std::string& table_name);
-    bool selectAllQuery(const std::vector<std::string>& args);
+    bool selectAllQuery(const JoinStatement& statement);
 
     /**  Change a table in some way  */
-    bool alterTable(const std::vector<std::string>& args);
-
-    /**  Parse table column parameters for creating a table */
-    static std::vector<std::pair<std::string, std::string>> parseTableColumns(std::vector<std::string> columns);
+    bool alterTable(const AlterTableStatement& statement);
 
     /**  Drops a table (if a db is selected) and maps it*/
-    bool dropTable(const std::vector<std::string>& args);
+    bool dropTable(const DropTableStatement& statement);
+
+    /**  Handles the COMPACT TABLE {{ table_name }} command, the deleted rows are removed from the columns */
+    bool compactTable(const CompactTableStatement& statement);
+
+    /**  Compacts a table of 'db' that holds enough deleted rows after a DELETE, right away or on the
+     *  compactor thread depending on SET COMPACTION */
+    void autoCompact(std::shared_ptr<Database> db, std::shared_ptr<Table> table);
     
     /**  Sets the selected database*/
     bool useDatabase(std::shared_ptr<Database> db = nullptr);
-    bool useDatabase(const std::vector<std::string>& args);
+    bool useDatabase(const UseStatement& statement);
+
+    bool commit(const CommitStatement& statement);
 
-    bool commit(const std::vector<std::string>& args);
+    /**  Handles the SHOW TABLES, SHOW INDEXES, SHOW STATS and SHOW CACHE commands */
+    bool show(const ShowStatement& statement);
+
+    /**  Handles the SET WAL_SYNC {OFF|NORMAL|FULL}, SET WAL_CHECKPOINT {{ bytes }}, SET WAL_COMMIT_WINDOW {{ microseconds }}
+     *  (settings of the write ahead log of the selected database), SET ADAPTIVE_INDEXING {ON|OFF},
+     *  SET COMPACTION {MANUAL|AUTO|BACKGROUND} and SET STATEMENT_CACHE {{ entries }} (0 turns the
+     *  statement cache off) commands */
+    bool set(const SetStatement& statement);
 
     /** Initialized supported column types */
     void initializeTypes();
@@ -90,18 +147,21 @@ public:
     bool dbExists(const std::string& database_name);
     
     /** Handles the INSERT INTO command */
-    bool insertInto(const std::vector<std::string>& args);
-
-    /** Parses a params string x,y,z,... and puts them in a string vector container*/
-    std::vector<std::string> isolateParams(std::string params, char delim = ',');
+    bool insertInto(const InsertStatement& statement);
 
     /** Handles the UPDATE {{ table_name }} command */
-    bool updateTable(const std::vector<std::string>& args);
+    bool updateTable(const UpdateStatement& statement);
 
     /** Handles the DELETE FROM {{ table_name }} command */
-    bool deleteFromTable(const std::vector<std::string>& args);
+    bool deleteFromTable(const DeleteStatement& statement);
+
+    /** Handles the COPY {{ table_name }} FROM {{ path }} command, the rows are appended by a CSVLoader */
+    bool copyFrom(const CopyFromStatement& statement);
 
-    bool beginTransaction(const std::vector<std::string>& args);
+    /** Handles the COPY {{ table_name }} TO {{ path }} [FORMAT ...] [HEADER] [WHERE ...] command, the rows are written by a TableExporter */
+    bool copyTo(const CopyToStatement& statement);
+
+    bool beginTransaction(const BeginStatement& statement);
 
     // database_count getters/mutators
     unsigned int getDatabaseCount() { return this->database_count; }
@@ -109,10 +169,21 @@ public:
     void decrementDatabaseCount() { this->database_count--; }
     void setDatabaseCount(unsigned int cnt) { this->database_count = cnt; }
 
-    void errorUnknownArguments(const std::vector<std::string>& args, const std::string& cmd, unsigned int index = 0);
-
     bool readFilesystem();
 
+    // Path of the catalog generation file (storage/catalog.gen). Its modification time changes
+    // whenever a process creates, drops or alters a database or table.
+    fs::path catalogPath();
+
+    // Modification time of the catalog generation file (min if it does not exist)
+    fs::file_time_type catalogTime();
+
+    // True if another process changed the catalog since it was last loaded
+    bool catalogChanged();
+
+    // Increments the catalog generation after this process changed the catalog
+    void touchCatalog();
+
     // Reads a database metadata file
     const DatabaseMetadata readDatabaseMetadata(const fs::path& path);
 
@@ -124,13 +195,17 @@ public:
 
 private:
     std::unordered_map<std::string, std::shared_ptr<Database>> databases;   // Database Storage <database_name, database*>
-    std::unordered_map<std::string, unsigned int> commands;                 // Command Storage <command_name, command_id>
     std::unordered_map<std::string, unsigned int> types;                    // Supported column Types <type_name, id>
     std::shared_ptr<Database> database;                                     // The selected database
     unsigned int database_count;                                            // The number of stored databases
     std::queue<std::string> arguments;
     std::string process_id;
     std::queue<std::string> transactionArguments;
+    fs::file_time_type catalog_time;                                        // Catalog generation the databases were loaded from
+    uint64_t schema_version = 0;                                            // Incremented by every change of the catalog
+    StatementCache statement_cache;                                         // Prepared statements by normalized text
+    std::recursive_mutex statement_mutex;                                   // Held while a statement runs
+    Compactor compactor{ this->statement_mutex };                           // Compacts tables between statements (SET COMPACTION BACKGROUND)
 };
 
 #endif
@@ -0,0 +1,84 @@
+/**
+ * File: bitmap.cpp
+ * Author: Mark Minkoff
+ * Functionality: Function definitions for file bitmap.h
+ *
+ * */
+
+#include "bitmap.h"
+
+Bitmap::Bitmap(const size_t size, const bool value) : words((size + 63) >> 6, value ? ~(uint64_t)0 : 0), bits(size)
+{
+    // Rows past the end of the bitmap are always unset
+    if (value && (size & 63)) this->words.back() &= ((uint64_t)1 << (size & 63)) - 1;
+}
+
+void Bitmap::resize(const size_t size, const bool value)
+{
+    const size_t old_bits = this->bits;
+
+    this->words.resize((size + 63) >> 6, value ? ~(uint64_t)0 : 0);
+    this->bits = size;
+
+    // Set the new rows that share a word with the old last row
+    if (value && size > old_bits) {
+        for (size_t row = old_bits; row < size && (row & 63); ++row) this->set(row);
+    }
+
+    // Clear the bits past the end of the bitmap
+    if (size & 63) this->words.back() &= ((uint64_t)1 << (size & 63)) - 1;
+}
+
+Bitmap& Bitmap::flip()
+{
+    for (auto& word : this->words) word = ~word;
+    if (this->bits & 63) this->words.back() &= ((uint64_t)1 << (this->bits & 63)) - 1;
+    return *this;
+}
+
+Bitmap& Bitmap::operator&=(const Bitmap& other)
+{
+    const size_t n = std::min(this->words.size(), other.words.size());
+    for (size_t w = 0; w < n; ++w) this->words[w] &= other.words[w];
+
+    // Rows the other bitmap does not cover are unset
+    for (size_t w = n; w < this->words.size(); ++w) this->words[w] = 0;
+    return *this;
+}
+
+Bitmap& Bitmap::operator|=(const Bitmap& other)
+{
+    const size_t n = std::min(this->words.size(), other.words.size());
+    for (size_t w = 0; w < n; ++w) this->words[w] |= other.words[w];
+    return *this;
+}
+
+Bitmap& Bitmap::operator-=(const Bitmap& other)
+{
+    const size_t n = std::min(this->words.size(), other.words.size());
+    for (size_t w = 0; w < n; ++w) this->words[w] &= ~other.words[w];
+    return *this;
+}
+
+size_t Bitmap::count() const
+{
+    size_t res = 0;
+    for (auto word : this->words) res += __builtin_popcountll(word);
+    return res;
+}
+
+bool Bitmap::any() const
+{
+    for (auto word : this->words) {
+        if (word) return true;
+    }
+    return false;
+}
+
+std::vector<size_t> Bitmap::toSelection() const
+{
+    std::vector<size_t> res;
+    res.reserve(this->count());
+    this->forEach([&res](size_t row) { res.emplace_back(row); });
+    return res;
+}
@@ -0,0 +1,102 @@
+/**
+ * File: bitmap.h
+ * Author: Mark Minkoff
+ * Functionality: Function declarations for file bitmap.cpp
+ * A dense bitmap of row indices used as the result of column filters.
+ *
+ * */
+
+#ifndef BITMAP_H_
+#define BITMAP_H_
+
+#include "include.h"
+
+class Bitmap
+{
+private:
+    std::vector<uint64_t> words;    // 64 rows per word, bit i of word w is row (w * 64 + i)
+    size_t bits;                    // Number of rows covered by the bitmap
+
+public:
+    // ---------------------------
+    // ---- Constructors
+    // ---------------------------
+
+    /** Creates a bitmap of 'size' rows with every row set to 'value' */
+    Bitmap(const size_t size = 0, const bool value = false);
+
+    // ---------------------------
+    // ---- Mutator Functions
+    // ---------------------------
+
+    void set(const size_t row) { this->words[row >> 6] |= (uint64_t)1 << (row & 63); }
+    void reset(const size_t row) { this->words[row >> 6] &= ~((uint64_t)1 << (row & 63)); }
+
+    /** Grows or shrinks the bitmap, new rows are set to 'value' */
+    void resize(const size_t size, const bool value = false);
+
+    /** Inverts every row of the bitmap */
+    Bitmap& flip();
+
+    Bitmap& operator&=(const Bitmap& other);
+    Bitmap& operator|=(const Bitmap& other);
+
+    /** Unsets the rows set in the other bitmap */
+    Bitmap& operator-=(const Bitmap& other);
+
+    // ---------------------------
+    // ---- Getter Functions
+    // ---------------------------
+
+    bool test(const size_t row) const { return (this->words[row >> 6] >> (row & 63)) & 1; }
+    size_t size() const { return this->bits; }
+
+    /** Number of set rows */
+    size_t count() const;
+    bool any() const;
+    bool none() const { return !this->any(); }
+
+    uint64_t* data() { return this->words.data(); }
+    const uint64_t* data() const { return this->words.data(); }
+    size_t wordCount() const { return this->words.size(); }
+
+    /** Returns the set rows as a sorted selection vector */
+    std::vector<size_t> toSelection() const;
+
+    // ---------------------------
+    // ---- Helper Functions
+    // ---------------------------
+
+    /** Calls fn(row) for every set row in ascending order */
+    template <typename Fn>
+    void forEach(Fn fn) const
+    {
+        for (size_t w = 0; w < this->words.size(); ++w)
+        {
+            uint64_t word = this->words[w];
+            while (word)
+            {
+                fn((w << 6) + __builtin_ctzll(word));
+                word &= word - 1;
+            }
+        }
+    }
+
+    /** Calls fn(row) for every set row in descending order */
+    template <typename Fn>
+    void forEachReverse(Fn fn) const
+    {
+        for (size_t w = this->words.size(); w-- > 0;)
+        {
+            uint64_t word = this->words[w];
+            while (word)
+            {
+                const unsigned int bit = 63 - __builtin_clzll(word);
+                fn((w << 6) + bit);
+                word &= ~((uint64_t)1 << bit);
+            }
+        }
+    }
+};
+
+#endif // BITMAP_H_
@@ -0,0 +1,61 @@
+/**
+ * File: cache.cpp
+ * Author: Mark Minkoff
+ * Functionality: Function definitions for file cache.h
+ *
+ * */
+
+#include "cache.h"
+
+const CacheEntry* StatementCache::find(const std::string& key)
+{
+    auto found = this->lookup.find(key);
+    if (found == this->lookup.end()) return nullptr;
+
+    // Move the entry to the front, the iterators stay valid
+    this->entries.splice(this->entries.begin(), this->entries, found->second);
+    return &*found->second;
+}
+
+void StatementCache::insert(const std::string& key, const std::string& database_name, const std::string& table_name, std::shared_ptr<PreparedStatement> statement)
+{
+    if (this->capacity == 0) return;
+
+    // Replace an entry of the same key
+    auto found = this->lookup.find(key);
+    if (found != this->lookup.end())
+    {
+        this->entries.erase(found->second);
+        this->lookup.erase(found);
+    }
+
+    this->entries.push_front({ key, database_name, table_name, std::move(statement) });
+    this->lookup[key] = this->entries.begin();
+
+    // Evict the least recently used entries
+    this->setCapacity(this->capacity);
+}
+
+void StatementCache::invalidate(const std::string& database_name, const std::string& table_name)
+{
+    const _NameEqual equal;
+    for (auto it = this->entries.begin(); it != this->entries.end();)
+    {
+        if (it->database_name == database_name && (table_name.empty() || equal(it->table_name, table_name)))
+        {
+            this->lookup.erase(it->key);
+            it = this->entries.erase(it);
+        }
+        else ++it;
+    }
+}
+
+void StatementCache::setCapacity(const size_t capacity)
+{
+    this->capacity = capacity;
+    while (this->entries.size() > this->capacity)
+    {
+        this->lookup.erase(this->entries.back().key);
+        this->entries.pop_back();
+    }
+}
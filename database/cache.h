@@ -0,0 +1,70 @@
+/**
+ * File: cache.h
+ * Author: Mark Minkoff
+ * Functionality: Function declarations for file cache.cpp
+ * Statement cache of the client. INSERT, SELECT, UPDATE and DELETE statements are normalized
+ * (see normalizeStatement in parser.h): their values are replaced by ? placeholders, so every
+ * statement of the same shape has the same text. The cache maps the normalized text to the
+ * statement prepared from it (see prepared.h), the values of each statement are bound to it.
+ * The least recently used statement is evicted once the cache is full.
+ *
+ * Statements are dropped when their table is created, dropped or altered, or the catalog is
+ * read again. Shapes that cannot be prepared (joins) are cached without a statement so they
+ * are not prepared again.
+ *
+ * */
+
+#ifndef CACHE_H_
+#define CACHE_H_
+
+#include "include.h"
+#include "prepared.h"
+
+// Statements cached unless SET STATEMENT_CACHE changes it
+const size_t STATEMENT_CACHE_SIZE = 256;
+
+typedef struct CacheEntry {
+    std::string key;                                // Database name and normalized text
+    std::string database_name;
+    std::string table_name;
+    std::shared_ptr<PreparedStatement> statement;   // nullptr if the shape is run as is
+} CacheEntry;
+
+class StatementCache
+{
+private:
+    std::list<CacheEntry> entries;                                                  // Most recently used first
+    std::unordered_map<std::string, std::list<CacheEntry>::iterator> lookup;        // Entry of every key
+    size_t capacity;                                                                // Maximum number of entries, 0 disables the cache
+    uint64_t hits;                                                                  // Statements run from a cached statement
+    uint64_t misses;                                                                // Statements that were not cached or cannot be prepared
+
+public:
+    StatementCache(const size_t capacity = STATEMENT_CACHE_SIZE) : capacity(capacity), hits(0), misses(0) {}
+
+    /** Returns the entry of a key and marks it as the most recently used, nullptr if it is not cached */
+    const CacheEntry* find(const std::string& key);
+
+    /** Caches a statement (nullptr for a shape that is run as is), evicting the least recently used entry if the cache is full */
+    void insert(const std::string& key, const std::string& database_name, const std::string& table_name, std::shared_ptr<PreparedStatement> statement);
+
+    /** Drops the statements on a table, or on every table of the database if 'table_name' is empty */
+    void invalidate(const std::string& database_name, const std::string& table_name = std::string());
+
+    /** Drops every statement */
+    void clear() { this->entries.clear(); this->lookup.clear(); }
+
+    /** Changes the number of entries, evicting the least recently used ones */
+    void setCapacity(const size_t capacity);
+
+    void hit() { ++this->hits; }
+    void miss() { ++this->misses; }
+
+    // Getters
+    size_t size() const { return this->entries.size(); }
+    size_t getCapacity() const { return this->capacity; }
+    uint64_t getHits() const { return this->hits; }
+    uint64_t getMisses() const { return this->misses; }
+};
+
+#endif // CACHE_H_
@@ -6,6 +6,10 @@
  * */
 
 #include "column.h"
+#include "filter.h"
+#include "index.h"
+#include "cracker.h"
+#include "zonemap.h"
 
 template<> Column<int>::Column(std::string column, std::vector<int> elements)
 {
@@ -36,11 +40,191 @@ template<> Column<std::string>::Column(std::string column, std::vector<std::stri
     this->CHAR_MAX = max;
 }
 
+template <class T>
+std::shared_ptr<ColumnIndex<T>> Column<T>::findIndex(const FilterOperator op) const
+{
+    for (auto& index : this->indexes) {
+        if (index->supports(op)) return index;
+    }
+    return nullptr;
+}
+
+template <class T>
+std::shared_ptr<CrackerIndex<T>> Column<T>::findCracker(const FilterOperator op)
+{
+    if constexpr (crackable)
+    {
+        if (!this->adaptive || !CrackerIndex<T>::supports(op)) return nullptr;
+
+        if (!this->cracker) {
+            this->cracker = std::make_shared<CrackerIndex<T>>();
+            this->cracker->build(this->getElements());
+        }
+        return this->cracker;
+    }
+    return nullptr;
+}
+
+template <class T>
+void Column<T>::indexRow(const size_t row)
+{
+    for (auto& index : this->indexes) index->insert(this->getElements(), row);
+
+    // Rows are only indexed after an insert or an update, which dropped the cracker column
+    if constexpr (crackable) {
+        if (this->cracker) this->cracker->insert(this->getElement(row), row);
+    }
+}
+
+template <class T>
+void Column<T>::unindexRow(const size_t row)
+{
+    for (auto& index : this->indexes) index->remove(this->getElements(), row);
+    this->cracker.reset();
+}
+
+template <class T>
+void Column<T>::unindexRows(const Bitmap& rows)
+{
+    for (auto& index : this->indexes) index->eraseRows(this->getElements(), rows);
+    this->cracker.reset();
+}
+
+template <class T>
+std::shared_ptr<ZoneMap<T>> Column<T>::zoneMap()
+{
+    if constexpr (zoned)
+    {
+        if (!this->zones || this->zones->rowCount() != this->size()) {
+            this->zones = std::make_shared<ZoneMap<T>>();
+            this->zones->build(this->getElements());
+        }
+        return this->zones;
+    }
+    return nullptr;
+}
+
+template <class T>
+void Column<T>::zoneAppended()
+{
+    if constexpr (zoned) {
+        if (this->zones) this->zones->append(this->getElements());
+    }
+}
+
+template <class T>
+void Column<T>::zoneUpdated(const Bitmap& rows)
+{
+    if constexpr (zoned) {
+        if (this->zones) this->zones->refresh(this->getElements(), rows);
+    }
+}
+
+template <class T>
+void Column<T>::zoneShifted(const size_t row)
+{
+    if constexpr (zoned) {
+        if (!this->zones) return;
+        this->zones->truncate(row);
+        this->zones->append(this->getElements());
+    }
+}
+
+// True if block 'block' holds a candidate row (every block does without candidates)
+static bool _hasCandidate(const Bitmap* candidates, const size_t block)
+{
+    if (!candidates) return true;
+
+    const size_t words = ZONE_BLOCK_ROWS / 64;
+    const size_t end = std::min(candidates->wordCount(), (block + 1) * words);
+    for (size_t w = block * words; w < end; ++w) {
+        if (candidates->data()[w]) return true;
+    }
+    return false;
+}
+
+// Runs 'kernel' over every run of blocks whose zone can hold a match and that hold a
+// candidate row. The bits of skipped blocks stay clear in 'res'.
+template <class T, typename Kernel>
+static void _filterBlocks(const ColumnView<T>& elements, const ZoneMap<T>& zones, const FilterOperator op, const T& val, const Bitmap* candidates, Bitmap& res, size_t& scanned, size_t& skipped, Kernel kernel)
+{
+    auto scan = [&](const size_t block) { return zones.mayMatch(block, op, val) && _hasCandidate(candidates, block); };
+
+    const size_t blocks = zones.blockCount();
+    size_t block = 0;
+    while (block < blocks)
+    {
+        if (!scan(block)) { ++skipped; ++block; continue; }
+
+        // Extend the run over the blocks after it that are scanned as well
+        size_t end = block + 1;
+        while (end < blocks && scan(end)) ++end;
+
+        const size_t first = block * ZONE_BLOCK_ROWS;
+        const size_t last = std::min(elements.size(), end * ZONE_BLOCK_ROWS);
+        kernel(elements.data() + first, last - first, op, val, res.data() + first / 64);
+
+        scanned += end - block;
+        block = end;
+    }
+}
+
+template <class T>
+ColumnStats Column<T>::getStats() const
+{
+    ColumnStats stats = {};
+    stats.blocks_scanned = this->blocks_scanned;
+    stats.blocks_skipped = this->blocks_skipped;
+    if constexpr (crackable) {
+        if (this->cracker) {
+            stats.cracker_pieces = this->cracker->pieceCount();
+            stats.cracker_queries = this->cracker->queryCount();
+        }
+    }
+    return stats;
+}
+
+template <class T>
+bool Column<T>::dropIndex(const std::string& name)
+{
+    for (auto it = this->indexes.begin(); it != this->indexes.end(); ++it)
+    {
+        if ((*it)->getName() == name) {
+            this->indexes.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+template <class T>
+std::shared_ptr<ColumnIndex<T>> Column<T>::getIndex(const std::string& name) const
+{
+    for (auto& index : this->indexes) {
+        if (index->getName() == name) return index;
+    }
+    return nullptr;
+}
+
+template <class T>
+bool Column<T>::sortedRows(std::vector<size_t>& rows) const
+{
+    for (auto& index : this->indexes) {
+        if (index->sortedRows(rows)) return true;
+    }
+    return false;
+}
+
 template<> bool Column<int>::insertElement(int el)
 {
+    // Mapped elements are copied into memory before they are modified
+    this->materialize();
+
     try 
     {
         this->elements.emplace_back(el);
+        this->indexRow(this->elements.size() - 1);
+        this->zoneAppended();
     }
     catch(const std::exception& e)
     {
@@ -52,9 +236,14 @@ template<> bool Column<int>::insertElement(int el)
 
 template<> bool Column<float>::insertElement(float el)
 {
+    // Mapped elements are copied into memory before they are modified
+    this->materialize();
+
     try 
     {
         this->elements.emplace_back(el);
+        this->indexRow(this->elements.size() - 1);
+        this->zoneAppended();
     }
     catch(const std::exception& e)
     {
@@ -66,9 +255,14 @@ template<> bool Column<float>::insertElement(float el)
 
 template<> bool Column<char>::insertElement(char el)
 {
+    // Mapped elements are copied into memory before they are modified
+    this->materialize();
+
     try 
     {
         this->elements.emplace_back(el);
+        this->indexRow(this->elements.size() - 1);
+        this->zoneAppended();
     }
     catch(const std::exception& e)
     {
@@ -83,6 +277,7 @@ template<> bool Column<std::string>::insertElement(std::string el)
     try 
     {
         this->elements.emplace_back(el);
+        this->indexRow(this->elements.size() - 1);
     }
     catch(const std::exception& e)
     {
@@ -92,262 +287,218 @@ template<> bool Column<std::string>::insertElement(std::string el)
     return true;
 }
 
-template<> std::unordered_set<size_t> Column<int>::filterElements(const std::string& op, int val)
+template <class T>
+bool Column<T>::insertElements(std::vector<T>&& elements)
 {
-    std::unordered_set<size_t> res;
-    size_t index = 0;
+    // Mapped elements are copied into memory once for the whole batch
+    this->materialize();
 
-    if (op == "=") {
-        for (auto& e : this->elements) {
-            if (e == val) {
-                res.insert(index);
-            }
-            index++;
-        }
-    }
-    else if (op == "!=") 
+    try
     {
-        for (auto& e : this->elements) {
-            if (e != val) {
-                res.insert(index);
-            }
-            index++;
-        }
-    }
-    else if (op == ">") 
-    {
-        for (auto& e : this->elements) {
-            if (e > val) {
-                res.insert(index);
-            }
-            index++;
-        }
+        // A range insert grows the storage geometrically like push_back, repeated batches stay linear
+        const size_t first = this->elements.size();
+        this->elements.insert(this->elements.end(), std::make_move_iterator(elements.begin()), std::make_move_iterator(elements.end()));
+
+        // The indexes take the rows one by one, the zone map summarizes the new blocks once
+        for (size_t row = first; row < this->elements.size(); ++row) this->indexRow(row);
+        this->zoneAppended();
     }
-    else if (op == ">=") 
+    catch(const std::exception& e)
     {
-        for (auto& e : this->elements) {
-            if (e >= val) {
-                res.insert(index);
-            }
-            index++;
-        }
+        std::cerr << e.what() << "\n";
+        return false;
     }
-    else if (op == "<") 
-    {
-        for (auto& e : this->elements) {
-            if (e < val) {
-                res.insert(index);
-            }
-            index++;
-        }
+    return true;
+}
+
+template bool Column<int>::insertElements(std::vector<int>&&);
+template bool Column<float>::insertElements(std::vector<float>&&);
+template bool Column<char>::insertElements(std::vector<char>&&);
+template bool Column<std::string>::insertElements(std::vector<std::string>&&);
+
+template<> Bitmap Column<int>::filterElements(const FilterOperator op, int val, const Bitmap* candidates)
+{
+    // Answer from an index when one supports the operator
+    if (auto index = this->findIndex(op)) {
+        Bitmap res(this->size());
+        index->lookup(this->getElements(), op, val, res);
+        return res;
     }
-    else if (op == "<=") 
-    {
-        for (auto& e : this->elements) {
-            if (e <= val) {
-                res.insert(index);
-            }
-            index++;
-        }
+
+    // Adaptive columns crack their copy on the bound instead of scanning
+    if (auto cracker = this->findCracker(op)) {
+        Bitmap res(this->size());
+        cracker->lookup(op, val, res);
+        return res;
     }
 
+    // The elements may be memory mapped, scan them in place
+    const ColumnView<int> elements = this->getElements();
+    Bitmap res(elements.size());
+
+    // Compare the elements of every block that can match and holds a candidate with the
+    // vectorized kernel, unknown operators match nothing
+    _filterBlocks(elements, *this->zoneMap(), op, val, candidates, res, this->blocks_scanned, this->blocks_skipped, filterInt);
+
     return res;
 }
 
-template<> std::unordered_set<size_t> Column<float>::filterElements(const std::string& op, float val)
+template<> Bitmap Column<float>::filterElements(const FilterOperator op, float val, const Bitmap* candidates)
 {
-    std::unordered_set<size_t> res;
-    size_t index = 0;
-
-    if (op == "=") {
-        for (auto& e : this->elements) {
-            if (e == val) {
-                res.insert(index);
-            }
-            index++;
-        }
-    }
-    else if (op == "!=") 
-    {
-        for (auto& e : this->elements) {
-            if (e != val) {
-                res.insert(index);
-            }
-            index++;
-        }
-    }
-    else if (op == ">") 
-    {
-        for (auto& e : this->elements) {
-            if (e > val) {
-                res.insert(index);
-            }
-            index++;
-        }
-    }
-    else if (op == ">=") 
-    {
-        for (auto& e : this->elements) {
-            if (e >= val) {
-                res.insert(index);
-            }
-            index++;
-        }
-    }
-    else if (op == "<") 
-    {
-        for (auto& e : this->elements) {
-            if (e < val) {
-                res.insert(index);
-            }
-            index++;
-        }
+    // Answer from an index when one supports the operator
+    if (auto index = this->findIndex(op)) {
+        Bitmap res(this->size());
+        index->lookup(this->getElements(), op, val, res);
+        return res;
     }
-    else if (op == "<=") 
-    {
-        for (auto& e : this->elements) {
-            if (e <= val) {
-                res.insert(index);
-            }
-            index++;
-        }
+
+    // Adaptive columns crack their copy on the bound instead of scanning
+    if (auto cracker = this->findCracker(op)) {
+        Bitmap res(this->size());
+        cracker->lookup(op, val, res);
+        return res;
     }
 
+    // The elements may be memory mapped, scan them in place
+    const ColumnView<float> elements = this->getElements();
+    Bitmap res(elements.size());
+
+    // Compare the elements of every block that can match and holds a candidate with the
+    // vectorized kernel, unknown operators match nothing
+    _filterBlocks(elements, *this->zoneMap(), op, val, candidates, res, this->blocks_scanned, this->blocks_skipped, filterFloat);
+
     return res;
 }
 
-template<> std::unordered_set<size_t> Column<char>::filterElements(const std::string& op, char val)
+template<> Bitmap Column<char>::filterElements(const FilterOperator op, char val, const Bitmap* candidates)
 {
-    std::unordered_set<size_t> res;
-    size_t index = 0;
-
-    if (op == "=") {
-        for (auto& e : this->elements) {
-            if (e == val) {
-                res.insert(index);
-            }
-            index++;
-        }
-    }
-    else if (op == "!=") 
-    {
-        for (auto& e : this->elements) {
-            if (e != val) {
-                res.insert(index);
-            }
-            index++;
-        }
-    }
-    else if (op == ">") 
-    {
-        for (auto& e : this->elements) {
-            if (_toUpper(e) > _toUpper(val)) {
-                res.insert(index);
-            }
-            index++;
-        }
-    }
-    else if (op == ">=") 
-    {
-        for (auto& e : this->elements) {
-            if (_toUpper(e) >= _toUpper(val)) {
-                res.insert(index);
-            }
-            index++;
-        }
-    }
-    else if (op == "<") 
-    {
-        for (auto& e : this->elements) {
-            if (_toUpper(e) < _toUpper(val)) {
-                res.insert(index);
-            }
-            index++;
-        }
-    }
-    else if (op == "<=") 
-    {
-        for (auto& e : this->elements) {
-            if (_toUpper(e) <= _toUpper(val)) {
-                res.insert(index);
-            }
-            index++;
-        }
+    // Answer from an index when one supports the operator
+    if (auto index = this->findIndex(op)) {
+        Bitmap res(this->size());
+        index->lookup(this->getElements(), op, val, res);
+        return res;
     }
 
+    // The elements may be memory mapped, scan them in place
+    const ColumnView<char> elements = this->getElements();
+    Bitmap res(elements.size());
+
+    // Compare the elements of every block that can match and holds a candidate with the
+    // vectorized kernel, unknown operators match nothing
+    _filterBlocks(elements, *this->zoneMap(), op, val, candidates, res, this->blocks_scanned, this->blocks_skipped, filterChar);
+
     return res;
 }
 
-template<> std::unordered_set<size_t> Column<std::string>::filterElements(const std::string& op, std::string val)
+template<> Bitmap Column<std::string>::filterElements(const FilterOperator op, std::string val, const Bitmap* candidates)
 {
-    std::unordered_set<size_t> res;
-    size_t index = 0;
-
-    if (op == "=") {
-        for (auto& e : this->elements) {
-            if (e.compare(val) == 0) 
-            {
-                res.insert(index);
-            }
-            index++;
-        }
+    // Answer from an index when one supports the operator
+    if (auto index = this->findIndex(op)) {
+        Bitmap res(this->size());
+        index->lookup(this->getElements(), op, val, res);
+        return res;
     }
-    else if (op == "!=") 
-    {
-        for (auto& e : this->elements) {
-            if (e.compare(val) != 0) {
-                res.insert(index);
-            }
-            index++;
+
+    Bitmap res(this->elements.size());
+
+    // Compare every element, or only the candidate rows
+    auto scan = [&](auto matches) {
+        for (size_t index = 0; index < this->elements.size(); ++index)
+        {
+            if (candidates && !candidates->test(index)) continue;
+            if (matches(this->elements[index])) res.set(index);
         }
-    }
-    else if (op == ">") 
-    {
-        for (auto& e : this->elements) 
+    };
+
+    const std::string upper = _toUpper(val);
+
+    switch (op)
+    {
+        case FILTER_EQ:
+            scan([&](const std::string& e) { return e.compare(val) == 0; });
+            break;
+        case FILTER_NE:
+            scan([&](const std::string& e) { return e.compare(val) != 0; });
+            break;
+        case FILTER_GT:
+            scan([&](const std::string& e) { return _toUpper(e).compare(upper) > 0; });
+            break;
+        case FILTER_GE:
+            scan([&](const std::string& e) { return (e.compare(val) == 0) || _toUpper(e).compare(upper) > 0; });
+            break;
+        case FILTER_LT:
+            scan([&](const std::string& e) { return _toUpper(e).compare(upper) < 0; });
+            break;
+        case FILTER_LE:
+            scan([&](const std::string& e) { return (e.compare(val) == 0) || _toUpper(e).compare(upper) < 0; });
+            break;
+        case FILTER_LIKE:
         {
-            if (_toUpper(e).compare(_toUpper(val)) > 0 ) 
-            {
-                res.insert(index);
-            }
-            index++;
+            // Case insensitive, a trailing % matches any suffix
+            std::string text;
+            const bool prefix = _likePattern(val, text);
+            scan([&](const std::string& e) {
+                const std::string element = _toUpper(e);
+                return prefix ? element.compare(0, text.size(), text) == 0 : element == text;
+            });
+            break;
         }
+        default:
+            break;
     }
-    else if (op == ">=") 
+
+    return res;
+}
+
+template <class T>
+void Column<T>::estimateFilter(const FilterOperator op, const T& val, double& selectivity, double& cost)
+{
+    // Without statistics equality and LIKE keep a tenth of the rows, ranges a third
+    switch (op)
     {
-        for (auto& e : this->elements) {
-            if ((e.compare(val) == 0) || _toUpper(e).compare(_toUpper(val)) > 0) 
-            {
-                res.insert(index);
-            }
-            index++;
-        }
+        case FILTER_EQ:
+        case FILTER_LIKE:    selectivity = 0.1; break;
+        case FILTER_NE:      selectivity = 0.9; break;
+        case FILTER_INVALID: selectivity = 0.0; break;
+        default:             selectivity = 1.0 / 3; break;
     }
-    else if (op == "<") 
-    {
-        for (auto& e : this->elements) {
-            if (_toUpper(e).compare(_toUpper(val)) < 0) 
-            {
-                res.insert(index);
-            }
-            index++;
-        }
+
+    // Hash and radix tree indexes know the number of distinct keys, an index lookup
+    // costs in proportion to the rows it returns
+    if (auto index = this->findIndex(op)) {
+        if (op == FILTER_EQ && index->getType() != INDEX_BTREE && index->keyCount()) selectivity = 1.0 / index->keyCount();
+        cost = selectivity;
+        return;
     }
-    else if (op == "<=") 
+
+    // VARCHAR elements are compared one by one, fixed width elements by the vectorized kernels
+    double fraction = 1.0;
+    if constexpr (zoned)
     {
-        for (auto& e : this->elements) {
-            if ((e.compare(val) == 0) || _toUpper(e).compare(_toUpper(val)) < 0) 
-            {
-                res.insert(index);
-            }
-            index++;
+        // Only the blocks whose zone can match are scanned and can hold matching rows
+        std::shared_ptr<ZoneMap<T>> zones = this->zoneMap();
+        if (zones->blockCount())
+        {
+            size_t blocks = 0;
+            for (size_t block = 0; block < zones->blockCount(); ++block) blocks += zones->mayMatch(block, op, val);
+            fraction = (double)blocks / zones->blockCount();
+            selectivity = std::min(selectivity, fraction);
         }
+        cost = fraction;
     }
+    else cost = 8 * fraction;
 
-    return res;
+    // A cracked column only reorganizes the piece holding the bound
+    if constexpr (crackable) {
+        if (this->adaptive && this->cracker && CrackerIndex<T>::supports(op)) cost = selectivity;
+    }
 }
 
-template <> size_t Column<int>::updateElementsOnIndex(const std::unordered_set<size_t>& indices, const int& val)
+template <> size_t Column<int>::updateElementsOnIndex(const Bitmap& indices, const int& val)
 {
+    // Mapped elements are copied into memory before they are modified
+    this->materialize();
+
     // Set a maximum range for updating elements
     size_t max_size = this->elements.size();
 
@@ -355,21 +506,29 @@ template <> size_t Column<int>::updateElementsOnIndex(const std::unordered_set<s
     size_t count = 0;
 
     // Iterate over all indecies we want to update
-    for (auto index : indices)
+    indices.forEach([&](size_t index)
     {
         // If the index is in range, update to given value and increment count
         if (index < max_size) {
+            this->unindexRow(index);
             this->elements[index] = val;
+            this->indexRow(index);
             ++count;
         }
-    }
+    });
+
+    // The blocks holding updated rows are summarized again
+    this->zoneUpdated(indices);
 
     // Return the result
     return count;
 }
 
-template <> size_t Column<float>::updateElementsOnIndex(const std::unordered_set<size_t>& indices, const float& val)
+template <> size_t Column<float>::updateElementsOnIndex(const Bitmap& indices, const float& val)
 {
+    // Mapped elements are copied into memory before they are modified
+    this->materialize();
+
     // Set a maximum range for updating elements
     size_t max_size = this->elements.size();
 
@@ -377,21 +536,29 @@ template <> size_t Column<float>::updateElementsOnIndex(const std::unordered_set
     size_t count = 0;
 
     // Iterate over all indecies we want to update
-    for (auto index : indices)
+    indices.forEach([&](size_t index)
     {
         // If the index is in range, update to given value and increment count
         if (index < max_size) {
+            this->unindexRow(index);
             this->elements[index] = val;
+            this->indexRow(index);
             ++count;
         }
-    }
+    });
+
+    // The blocks holding updated rows are summarized again
+    this->zoneUpdated(indices);
 
     // Return the result
     return count;
 }
 
-template <> size_t Column<char>::updateElementsOnIndex(const std::unordered_set<size_t>& indices, const char& val)
+template <> size_t Column<char>::updateElementsOnIndex(const Bitmap& indices, const char& val)
 {
+    // Mapped elements are copied into memory before they are modified
+    this->materialize();
+
     // Set a maximum range for updating elements
     size_t max_size = this->elements.size();
 
@@ -399,20 +566,25 @@ template <> size_t Column<char>::updateElementsOnIndex(const std::unordered_set<
     size_t count = 0;
 
     // Iterate over all indecies we want to update
-    for (auto index : indices)
+    indices.forEach([&](size_t index)
     {
         // If the index is in range, update to given value and increment count
         if (index < max_size) {
+            this->unindexRow(index);
             this->elements[index] = val;
+            this->indexRow(index);
             ++count;
         }
-    }
+    });
+
+    // The blocks holding updated rows are summarized again
+    this->zoneUpdated(indices);
 
     // Return the result
     return count;
 }
 
-template <> size_t Column<std::string>::updateElementsOnIndex(const std::unordered_set<size_t>& indices, const std::string& val)
+template <> size_t Column<std::string>::updateElementsOnIndex(const Bitmap& indices, const std::string& val)
 {
     // Set a maximum range for updating elements
     size_t max_size = this->elements.size();
@@ -421,14 +593,16 @@ template <> size_t Column<std::string>::updateElementsOnIndex(const std::unorder
     size_t count = 0;
 
     // Iterate over all indecies we want to update
-    for (auto index : indices)
+    indices.forEach([&](size_t index)
     {
         // If the index is in range, update to given value and increment count
         if (index < max_size) {
+            this->unindexRow(index);
             this->elements[index] = val;
+            this->indexRow(index);
             ++count;
         }
-    }
+    });
 
     // Return the result
     return count;
@@ -436,13 +610,26 @@ template <> size_t Column<std::string>::updateElementsOnIndex(const std::unorder
 
 template <> bool Column<int>::deleteElement(const size_t index)
 {
+    // Mapped elements are copied into memory before they are modified
+    this->materialize();
+
     try 
     {
+        // The indexes drop the row and renumber the rows after it
+        if (!this->indexes.empty() || this->cracker) {
+            Bitmap rows(this->elements.size());
+            rows.set(index);
+            this->unindexRows(rows);
+        }
+
         // Get an iterator to the position we want to delete
         std::vector<int>::const_iterator e = this->elements.begin() + index;
 
         // Erase that element
         this->elements.erase(e);
+
+        // The rows after it moved down one position
+        this->zoneShifted(index);
     }
     catch(const std::exception& e)
     {
@@ -455,13 +642,26 @@ template <> bool Column<int>::deleteElement(const size_t index)
 
 template <> bool Column<float>::deleteElement(const size_t index)
 {
+    // Mapped elements are copied into memory before they are modified
+    this->materialize();
+
     try 
     {
+        // The indexes drop the row and renumber the rows after it
+        if (!this->indexes.empty() || this->cracker) {
+            Bitmap rows(this->elements.size());
+            rows.set(index);
+            this->unindexRows(rows);
+        }
+
         // Get an iterator to the position we want to delete
         std::vector<float>::const_iterator e = this->elements.begin() + index;
 
         // Erase that element
         this->elements.erase(e);
+
+        // The rows after it moved down one position
+        this->zoneShifted(index);
     }
     catch(const std::exception& e)
     {
@@ -474,13 +674,26 @@ template <> bool Column<float>::deleteElement(const size_t index)
 
 template <> bool Column<char>::deleteElement(const size_t index)
 {
+    // Mapped elements are copied into memory before they are modified
+    this->materialize();
+
     try 
     {
+        // The indexes drop the row and renumber the rows after it
+        if (!this->indexes.empty() || this->cracker) {
+            Bitmap rows(this->elements.size());
+            rows.set(index);
+            this->unindexRows(rows);
+        }
+
         // Get an iterator to the position we want to delete
         std::vector<char>::const_iterator e = this->elements.begin() + index;
 
         // Erase that element
         this->elements.erase(e);
+
+        // The rows after it moved down one position
+        this->zoneShifted(index);
     }
     catch(const std::exception& e)
     {
@@ -495,6 +708,13 @@ template <> bool Column<std::string>::deleteElement(const size_t index)
 {
     try 
     {
+        // The indexes drop the row and renumber the rows after it
+        if (!this->indexes.empty() || this->cracker) {
+            Bitmap rows(this->elements.size());
+            rows.set(index);
+            this->unindexRows(rows);
+        }
+
         // Get an iterator to the position we want to delete
         std::vector<std::string>::const_iterator e = this->elements.begin() + index;
 
@@ -509,3 +729,66 @@ template <> bool Column<std::string>::deleteElement(const size_t index)
 
     return true;
 }
+
+template <class T>
+size_t Column<T>::deleteElements(const Bitmap& rows)
+{
+    // Mapped elements are copied into memory before they are modified
+    this->materialize();
+
+    // The indexes drop the rows while their keys are still in place
+    this->unindexRows(rows);
+
+    // Move every kept element down over the deleted ones in a single pass
+    size_t kept = 0;
+    for (size_t i = 0; i < this->elements.size(); ++i)
+    {
+        if (i < rows.size() && rows.test(i)) continue;
+        if (kept != i) this->elements[kept] = std::move(this->elements[i]);
+        ++kept;
+    }
+
+    // The first moved element is at the first deleted row
+    size_t first = 0;
+    while (first < kept && first < rows.size() && !rows.test(first)) ++first;
+
+    const size_t removed = this->elements.size() - kept;
+    this->elements.erase(this->elements.begin() + kept, this->elements.end());
+    if (removed) this->zoneShifted(first);
+    return removed;
+}
+
+template size_t Column<int>::deleteElements(const Bitmap&);
+template size_t Column<float>::deleteElements(const Bitmap&);
+template size_t Column<char>::deleteElements(const Bitmap&);
+template size_t Column<std::string>::deleteElements(const Bitmap&);
+
+template bool Column<int>::dropIndex(const std::string&);
+template bool Column<float>::dropIndex(const std::string&);
+template bool Column<char>::dropIndex(const std::string&);
+template bool Column<std::string>::dropIndex(const std::string&);
+
+template std::shared_ptr<ColumnIndex<int>> Column<int>::getIndex(const std::string&) const;
+template std::shared_ptr<ColumnIndex<float>> Column<float>::getIndex(const std::string&) const;
+template std::shared_ptr<ColumnIndex<char>> Column<char>::getIndex(const std::string&) const;
+template std::shared_ptr<ColumnIndex<std::string>> Column<std::string>::getIndex(const std::string&) const;
+
+template std::shared_ptr<ZoneMap<int>> Column<int>::zoneMap();
+template std::shared_ptr<ZoneMap<float>> Column<float>::zoneMap();
+template std::shared_ptr<ZoneMap<char>> Column<char>::zoneMap();
+template std::shared_ptr<ZoneMap<std::string>> Column<std::string>::zoneMap();
+
+template void Column<int>::estimateFilter(const FilterOperator, const int&, double&, double&);
+template void Column<float>::estimateFilter(const FilterOperator, const float&, double&, double&);
+template void Column<char>::estimateFilter(const FilterOperator, const char&, double&, double&);
+template void Column<std::string>::estimateFilter(const FilterOperator, const std::string&, double&, double&);
+
+template ColumnStats Column<int>::getStats() const;
+template ColumnStats Column<float>::getStats() const;
+template ColumnStats Column<char>::getStats() const;
+template ColumnStats Column<std::string>::getStats() const;
+
+template bool Column<int>::sortedRows(std::vector<size_t>&) const;
+template bool Column<float>::sortedRows(std::vector<size_t>&) const;
+template bool Column<char>::sortedRows(std::vector<size_t>&) const;
+template bool Column<std::string>::sortedRows(std::vector<size_t>&) const;
@@ -9,6 +9,49 @@
 #define COLUMN_H_
 
 #include "include.h"
+#include "bitmap.h"
+#include "filter.h"
+
+class MappedFile;
+
+template <class T>
+class ColumnIndex;
+
+template <class T>
+class CrackerIndex;
+
+template <class T>
+class ZoneMap;
+
+/** Statistics of a column (SHOW STATS) */
+typedef struct ColumnStats {
+    size_t blocks_scanned;      // Blocks the filter kernels ran over
+    size_t blocks_skipped;      // Blocks skipped by their zone
+    size_t cracker_pieces;      // Pieces of the cracker column, 0 without one
+    size_t cracker_queries;     // Filters answered by the cracker column
+} ColumnStats;
+
+/** Read-only view over contiguous column elements.
+ *  The view does not own the elements and is invalidated by any mutation of its column. */
+template <class T>
+class ColumnView
+{
+private:
+    const T* first;     // First element
+    size_t count;       // Number of elements
+
+public:
+    typedef T value_type;
+
+    ColumnView(const T* first = nullptr, size_t count = 0) : first(first), count(count) {}
+
+    const T& operator[](size_t index) const { return this->first[index]; }
+    const T* begin() const { return this->first; }
+    const T* end() const { return this->first + this->count; }
+    const T* data() const { return this->first; }
+    size_t size() const { return this->count; }
+    bool empty() const { return this->count == 0; }
+};
 
 template <class T>
 class Column
@@ -20,7 +63,37 @@ private:
     std::vector<T> elements;        // Container for elements
     size_t CHAR_MAX;                // Used for VARCHAR types
 
+    // Read-only file mapping backing the elements of a cold column (INT, FLOAT, CHAR).
+    // While it is set 'elements' is empty and reads go straight to the mapped memory.
+    std::shared_ptr<MappedFile> mapping;
+    const T* mapped = nullptr;
+    size_t mapped_count = 0;
+
+    // Secondary indexes over the elements (CREATE INDEX), kept up to date by every mutation.
+    // Replacing all elements drops them, the table attaches them again.
+    std::vector<std::shared_ptr<ColumnIndex<T>>> indexes;
+
+    // Adaptive index (SET ADAPTIVE_INDEXING ON) of INT and FLOAT columns, created by the first
+    // range filter and partitioned further by every filter after it. Dropped by any change
+    // other than an insert.
+    std::shared_ptr<CrackerIndex<T>> cracker;
+    bool adaptive = false;
+
+    // Min/max of every block of INT, FLOAT and CHAR columns (see zonemap.h), built by the first
+    // filter or read with the column files, and kept up to date by every mutation
+    std::shared_ptr<ZoneMap<T>> zones;
+    size_t blocks_scanned = 0;
+    size_t blocks_skipped = 0;
+
 public:
+    typedef T value_type;
+
+    // Only INT and FLOAT columns are cracked, CHAR and VARCHAR compare case-insensitively
+    static constexpr bool crackable = std::is_same<T, int>::value || std::is_same<T, float>::value;
+
+    // VARCHAR columns have no zone map
+    static constexpr bool zoned = !std::is_same<T, std::string>::value;
+
     // ---------------------------
     // ---- Constructors
     // ---------------------------
@@ -44,24 +117,129 @@ public:
     // Inserts an element
     bool insertElement(T);
 
+    // Appends a batch of elements, the mapping is copied and the storage grown once
+    bool insertElements(std::vector<T>&& elements);
+
     // Deletes an element at some specified row
     bool deleteElement(const size_t);
 
+    // Deletes the elements of every row set in the bitmap, returns the number deleted
+    size_t deleteElements(const Bitmap&);
+
+    // Deletes every element
+    void clearElements() { this->unmapElements(); this->indexes.clear(); this->cracker.reset(); this->zones.reset(); this->elements.clear(); }
+
+    // Replaces every element (used when loading a column file)
+    void setElements(std::vector<T>&& elements) { this->unmapElements(); this->indexes.clear(); this->cracker.reset(); this->zones.reset(); this->elements = std::move(elements); }
+
+    /** Backs the column by 'count' elements of a read-only file mapping, nothing is copied */
+    void mapElements(std::shared_ptr<MappedFile> mapping, const T* first, const size_t count)
+    {
+        this->elements = std::vector<T>();
+        this->indexes.clear();
+        this->cracker.reset();
+        this->zones.reset();
+        this->mapping = std::move(mapping);
+        this->mapped = first;
+        this->mapped_count = count;
+    }
+
+    /** Copies mapped elements into memory so they can be modified */
+    void materialize()
+    {
+        if (!this->mapping) return;
+        this->elements.assign(this->mapped, this->mapped + this->mapped_count);
+        this->unmapElements();
+    }
+
     // ---------------------------
     // ---- Getter Functions
     // ---------------------------
 
     std::string getName() {return this->column_name;}
     unsigned int getDataType() {return this->data_type;}
-    std::vector<T> getElements() {return this->elements;}
+    ColumnView<T> getElements() const {
+        if (this->mapping) return ColumnView<T>(this->mapped, this->mapped_count);
+        return ColumnView<T>(this->elements.data(), this->elements.size());
+    }
+    const T& getElement(const size_t row) const {return this->mapping ? this->mapped[row] : this->elements[row];}
+    size_t size() const {return this->mapping ? this->mapped_count : this->elements.size();}
+    bool isMapped() const {return this->mapping != nullptr;}
     size_t getCharMax() {return this->CHAR_MAX;}
 
     // ---------------------------
     // ---- Helper Functions
     // ---------------------------
 
-    std::unordered_set<size_t> filterElements(const std::string& op, T val);
-    size_t updateElementsOnIndex(const std::unordered_set<size_t>&, const T&);
+    /** Returns a bitmap of the rows whose element satisfies 'element op val'. With 'candidates'
+     *  only those rows need to be right, scans skip the blocks (or rows) without a candidate. */
+    Bitmap filterElements(const FilterOperator op, T val, const Bitmap* candidates = nullptr);
+
+    /** Estimates the fraction of rows satisfying 'element op val' and the relative cost of
+     *  filtering them (1 for a scan of every block of a fixed width column) from the indexes
+     *  and the zone map */
+    void estimateFilter(const FilterOperator op, const T& val, double& selectivity, double& cost);
+
+    /** Sets every row selected by the bitmap to 'val', returns the number of rows updated */
+    size_t updateElementsOnIndex(const Bitmap&, const T&);
+
+    // ---------------------------
+    // ---- Index Functions
+    // ---------------------------
+
+    /** Adds an index built over the current elements */
+    void addIndex(std::shared_ptr<ColumnIndex<T>> index) { this->indexes.emplace_back(std::move(index)); }
+
+    /** Removes an index, returns false if the column has no index of that name */
+    bool dropIndex(const std::string& name);
+
+    /** Returns the index of that name, nullptr if there is none */
+    std::shared_ptr<ColumnIndex<T>> getIndex(const std::string& name) const;
+
+    /** Fills 'rows' with every row in key order if an index keeps the rows ordered, false otherwise */
+    bool sortedRows(std::vector<size_t>& rows) const;
+
+    /** Turns adaptive indexing of the column on or off, turning it off drops the cracker column */
+    void setAdaptive(const bool adaptive) { this->adaptive = adaptive; if (!adaptive) this->cracker.reset(); }
+    bool isAdaptive() const { return this->adaptive; }
+
+    /** Statistics of the column */
+    ColumnStats getStats() const;
+
+    // ---------------------------
+    // ---- Zone Map Functions
+    // ---------------------------
+
+    /** Returns the zone map, summarizing the elements first if it is missing (nullptr for VARCHAR) */
+    std::shared_ptr<ZoneMap<T>> zoneMap();
+
+    /** Uses a zone map read from the column files, it must cover the current elements */
+    void setZoneMap(std::shared_ptr<ZoneMap<T>> zones) { this->zones = std::move(zones); }
+
+private:
+    /** Returns an index that answers 'op', nullptr if there is none */
+    std::shared_ptr<ColumnIndex<T>> findIndex(const FilterOperator op) const;
+
+    /** Returns the cracker column if the column is adaptive and 'op' is a range or equality filter,
+     *  copying the elements into it on first use. nullptr otherwise. */
+    std::shared_ptr<CrackerIndex<T>> findCracker(const FilterOperator op);
+
+    // Index maintenance, called around every change of the elements
+    void indexRow(const size_t row);
+    void unindexRow(const size_t row);
+    void unindexRows(const Bitmap& rows);
+
+    // Zone map maintenance, called after rows were appended, updated, or removed from 'row' on
+    void zoneAppended();
+    void zoneUpdated(const Bitmap& rows);
+    void zoneShifted(const size_t row);
+
+    void unmapElements()
+    {
+        this->mapping.reset();
+        this->mapped = nullptr;
+        this->mapped_count = 0;
+    }
 };
 
 #endif // COLUMN_H_
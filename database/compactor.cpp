@@ -0,0 +1,62 @@
+/**
+ * File: compactor.cpp
+ * Author: Mark Minkoff
+ * Functionality: Function definitions for file compactor.h
+ *
+ * */
+
+#include "compactor.h"
+
+Compactor::Compactor(std::recursive_mutex& statements) : statements(statements), stopping(false) {}
+
+Compactor::~Compactor()
+{
+    this->stop();
+}
+
+void Compactor::schedule(std::shared_ptr<Table> table)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    if (this->stopping) return;
+
+    for (auto& queued : this->tables) {
+        if (queued.lock() == table) return;
+    }
+    this->tables.emplace_back(table);
+
+    if (!this->worker.joinable()) this->worker = std::thread(&Compactor::compactLoop, this);
+    this->queued.notify_one();
+}
+
+void Compactor::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+        this->tables.clear();
+    }
+    this->queued.notify_all();
+    if (this->worker.joinable()) this->worker.join();
+}
+
+void Compactor::compactLoop()
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (true)
+    {
+        this->queued.wait(lock, [this] { return !this->tables.empty() || this->stopping; });
+        if (this->stopping) return;
+
+        std::shared_ptr<Table> table = this->tables.front().lock();
+        this->tables.pop_front();
+        if (!table) continue;
+
+        // Compact between statements, a checkpoint may have compacted the table meanwhile
+        lock.unlock();
+        {
+            std::lock_guard<std::recursive_mutex> statement(this->statements);
+            if (table->needsCompaction()) table->compact();
+        }
+        lock.lock();
+    }
+}
@@ -0,0 +1,54 @@
+/**
+ * File: compactor.h
+ * Author: Mark Minkoff
+ * Functionality: Function declarations for file compactor.cpp
+ * Background compaction of the tables of a client (SET COMPACTION BACKGROUND). DELETE only
+ * marks rows as deleted (see Table::deleteWhere); once a table holds enough deleted rows it
+ * is scheduled here and a worker thread removes them from its columns (Table::compact).
+ *
+ * The tables are not thread safe, so the worker takes the statement mutex of the client,
+ * which the client holds while it runs a statement: a table is compacted between statements,
+ * e.g. while the client waits for input. Tables still queued when the client exits are
+ * compacted by their checkpoint.
+ *
+ * */
+
+#ifndef COMPACTOR_H_
+#define COMPACTOR_H_
+
+#include "include.h"
+#include "table.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+class Compactor
+{
+private:
+    std::recursive_mutex& statements;           // Held by the client while it runs a statement
+    std::mutex mutex;                           // Guards everything below
+    std::condition_variable queued;             // Wakes the worker
+    std::thread worker;                         // Started on the first scheduled table
+    bool stopping;                              // The worker exits without compacting the queued tables
+    std::deque<std::weak_ptr<Table>> tables;    // Tables waiting to be compacted, dropped tables expire
+
+    /** Worker thread: compacts the scheduled tables in order */
+    void compactLoop();
+
+public:
+    Compactor(std::recursive_mutex& statements);
+    ~Compactor();
+
+    Compactor(const Compactor&) = delete;
+    Compactor& operator=(const Compactor&) = delete;
+
+    /** Queues a table for compaction unless it is already queued */
+    void schedule(std::shared_ptr<Table> table);
+
+    /** Stops the worker, called before the tables are checkpointed (never while holding the statement mutex) */
+    void stop();
+};
+
+#endif // COMPACTOR_H_
@@ -0,0 +1,107 @@
+/**
+ * File: cracker.cpp
+ * Author: Mark Minkoff
+ * Functionality: Function definitions for file cracker.h
+ *
+ * */
+
+#include "cracker.h"
+
+template <class T>
+bool CrackerIndex<T>::supports(const FilterOperator op)
+{
+    return op == FILTER_EQ || op == FILTER_LT || op == FILTER_LE || op == FILTER_GT || op == FILTER_GE;
+}
+
+template <class T>
+void CrackerIndex<T>::build(const ColumnView<T>& elements)
+{
+    this->entries.clear();
+    this->cuts.clear();
+    this->entries.reserve(elements.size());
+
+    for (size_t row = 0; row < elements.size(); ++row)
+    {
+        const T& value = elements[row];
+        if (value != value) continue;
+        this->entries.push_back({ value, (uint32_t)row });
+    }
+}
+
+template <class T>
+size_t CrackerIndex<T>::crack(const Cut& cut)
+{
+    // The bound was cracked on before
+    auto next = this->cuts.lower_bound(cut);
+    if (next != this->cuts.end() && next->first == cut) return next->second;
+
+    // The piece holding the cut lies between its neighbouring cuts
+    size_t lo = next == this->cuts.begin() ? 0 : std::prev(next)->second;
+    size_t hi = next == this->cuts.end() ? this->entries.size() : next->second;
+
+    // Partition the piece: the entries before the cut move to its front, the rest to its back
+    Entry* e = this->entries.data();
+    while (true)
+    {
+        while (lo < hi && before(e[lo].value, cut)) ++lo;
+        while (lo < hi && !before(e[hi - 1].value, cut)) --hi;
+        if (lo >= hi) break;
+
+        std::swap(e[lo], e[hi - 1]);
+        ++lo; --hi;
+    }
+
+    this->cuts.emplace_hint(next, cut, lo);
+    return lo;
+}
+
+template <class T>
+void CrackerIndex<T>::insert(const T& value, const size_t row)
+{
+    if (value != value) return;
+
+    // The new slot starts at the end of the last piece. Walking the cuts from the last one,
+    // every piece after the entry's own moves its first entry into the slot and the slot
+    // takes its place, so each piece shifts one position to the right.
+    size_t slot = this->entries.size();
+    this->entries.emplace_back();
+
+    for (auto cut = this->cuts.rbegin(); cut != this->cuts.rend() && before(value, cut->first); ++cut)
+    {
+        const size_t first = cut->second;
+        if (first != slot) this->entries[slot] = this->entries[first];
+        slot = first;
+        cut->second = first + 1;
+    }
+
+    this->entries[slot] = { value, (uint32_t)row };
+}
+
+template <class T>
+void CrackerIndex<T>::lookup(const FilterOperator op, const T& val, Bitmap& res)
+{
+    this->queries++;
+
+    // NaN is not equal to, less or greater than anything
+    if (val != val) return;
+
+    // Range [first, last) of the cracker column holding the matches
+    size_t first = 0, last = this->entries.size();
+    switch (op)
+    {
+        case FILTER_EQ:
+            first = this->crack(Cut(val, false));
+            last = this->crack(Cut(val, true));
+            break;
+        case FILTER_LT: last = this->crack(Cut(val, false)); break;
+        case FILTER_LE: last = this->crack(Cut(val, true)); break;
+        case FILTER_GT: first = this->crack(Cut(val, true)); break;
+        case FILTER_GE: first = this->crack(Cut(val, false)); break;
+        default: return;
+    }
+
+    for (size_t i = first; i < last; ++i) res.set(this->entries[i].row);
+}
+
+template class CrackerIndex<int>;
+template class CrackerIndex<float>;
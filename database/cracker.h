@@ -0,0 +1,70 @@
+/**
+ * File: cracker.h
+ * Author: Mark Minkoff
+ * Functionality: Function declarations for file cracker.cpp
+ * Adaptive indexing (database cracking) of INT and FLOAT columns. With SET ADAPTIVE_INDEXING ON
+ * the first range filter on a column copies it into a cracker column of (value, row) entries.
+ * Every filter then partitions only the piece holding its bound, so the column gets closer to
+ * sorted with each query and later filters touch fewer entries.
+ *
+ * A cut (value, inclusive) records the position of the first entry that is not < value
+ * (not <= value when inclusive). Cuts are ordered, so the entries between two cuts form a
+ * piece whose values lie between their bounds.
+ *
+ * The cracker is kept in memory only. Appended rows are rippled into their piece, updates and
+ * deletes drop the cracker and the next filter copies the column again.
+ *
+ * */
+
+#ifndef CRACKER_H_
+#define CRACKER_H_
+
+#include "include.h"
+#include "bitmap.h"
+#include "column.h"
+#include "filter.h"
+
+template <class T>
+class CrackerIndex
+{
+private:
+    typedef struct Entry {
+        T value;                // Element of the column
+        uint32_t row;           // Row holding it
+    } Entry;
+
+    typedef std::pair<T, bool> Cut;     // Bound value, true if the values equal to it are before the cut
+
+    std::vector<Entry> entries;         // Cracker column, every piece is contiguous
+    std::map<Cut, size_t> cuts;         // Position of every cut
+    size_t queries;                     // Filters answered
+
+    /** True if 'value' is before 'cut' */
+    static bool before(const T& value, const Cut& cut) { return cut.second ? value <= cut.first : value < cut.first; }
+
+    /** Returns the position of 'cut', partitioning the piece holding it if it is new */
+    size_t crack(const Cut& cut);
+
+public:
+    CrackerIndex() : queries(0) {}
+
+    /** True if lookup() answers 'op' */
+    static bool supports(const FilterOperator op);
+
+    /** Copies every element into the cracker column, NaN (which matches no supported operator) is left out */
+    void build(const ColumnView<T>& elements);
+
+    /** Adds 'row' holding 'value' at the end of the column, moving one entry per piece after its own */
+    void insert(const T& value, const size_t row);
+
+    /** Sets every row whose element satisfies 'element op val' in 'res', cracking the column on 'val' */
+    void lookup(const FilterOperator op, const T& val, Bitmap& res);
+
+    /** Number of pieces the column is cracked into */
+    size_t pieceCount() const { return this->cuts.size() + 1; }
+
+    /** Number of filters answered */
+    size_t queryCount() const { return this->queries; }
+};
+
+#endif // CRACKER_H_
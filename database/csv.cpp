@@ -0,0 +1,193 @@
+/**
+ * File: csv.cpp
+ * Author: Mark Minkoff
+ * Functionality: Function definitions for file csv.h
+ *
+ * */
+
+#include "csv.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define CSV_X86
+#include <immintrin.h>
+#endif
+
+/** Appends the separators of one block from its quote, comma and line break masks. 'quoted' is all
+ *  ones if the previous block ended inside a quoted value and is updated for the next block. */
+static inline void _blockSeparators(const uint64_t quotes, const uint64_t commas, const uint64_t breaks, uint64_t& quoted, const size_t base, std::vector<uint32_t>& separators)
+{
+    // Bit i of the prefix XOR of the quotes is set inside a quoted value (its opening quote included)
+    uint64_t inside = quotes;
+    inside ^= inside << 1;
+    inside ^= inside << 2;
+    inside ^= inside << 4;
+    inside ^= inside << 8;
+    inside ^= inside << 16;
+    inside ^= inside << 32;
+    inside ^= quoted;
+    quoted = (uint64_t)((int64_t)inside >> 63);
+
+    uint64_t bits = (commas | breaks) & ~inside;
+    const size_t count = separators.size();
+    separators.resize(count + __builtin_popcountll(bits));
+
+    uint32_t* out = separators.data() + count;
+    while (bits)
+    {
+        *out++ = (uint32_t)(base + __builtin_ctzll(bits));
+        bits &= bits - 1;
+    }
+}
+
+// ---------------------------
+// ---- Scalar Kernel
+// ---------------------------
+
+static void _separatorsScalar(const char* data, const size_t blocks, uint64_t& quoted, const size_t base, std::vector<uint32_t>& separators)
+{
+    for (size_t b = 0; b < blocks; ++b)
+    {
+        const char* block = data + (b << 6);
+        uint64_t quotes = 0, commas = 0, breaks = 0;
+        for (unsigned int i = 0; i < 64; ++i)
+        {
+            quotes |= (uint64_t)(block[i] == '"') << i;
+            commas |= (uint64_t)(block[i] == ',') << i;
+            breaks |= (uint64_t)(block[i] == '\n') << i;
+        }
+        _blockSeparators(quotes, commas, breaks, quoted, base + (b << 6), separators);
+    }
+}
+
+#ifdef CSV_X86
+
+// ---------------------------
+// ---- AVX2 Kernel
+// ---------------------------
+// A block is two 32 byte vectors, each comparison gives 32 bits of a mask.
+
+__attribute__((target("avx2")))
+static void _separatorsAVX2(const char* data, const size_t blocks, uint64_t& quoted, const size_t base, std::vector<uint32_t>& separators)
+{
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i line = _mm256_set1_epi8('\n');
+
+    for (size_t b = 0; b < blocks; ++b)
+    {
+        const char* block = data + (b << 6);
+        const __m256i lo = _mm256_loadu_si256((const __m256i*)block);
+        const __m256i hi = _mm256_loadu_si256((const __m256i*)(block + 32));
+
+        const uint64_t quotes = (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, quote)) | ((uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, quote)) << 32);
+        const uint64_t commas = (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, comma)) | ((uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, comma)) << 32);
+        const uint64_t breaks = (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, line)) | ((uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, line)) << 32);
+
+        _blockSeparators(quotes, commas, breaks, quoted, base + (b << 6), separators);
+    }
+}
+
+// ---------------------------
+// ---- SSE2 Kernel
+// ---------------------------
+
+/** Mask of the bytes of a 64 byte block equal to 'c' */
+__attribute__((target("sse2")))
+static inline uint64_t _maskSSE2(const char* block, const __m128i c)
+{
+    uint64_t bits = 0;
+    for (unsigned int k = 0; k < 4; ++k)
+    {
+        const __m128i a = _mm_loadu_si128((const __m128i*)(block + (k << 4)));
+        bits |= (uint64_t)(uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(a, c)) << (k << 4);
+    }
+    return bits;
+}
+
+__attribute__((target("sse2")))
+static void _separatorsSSE2(const char* data, const size_t blocks, uint64_t& quoted, const size_t base, std::vector<uint32_t>& separators)
+{
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i line = _mm_set1_epi8('\n');
+
+    for (size_t b = 0; b < blocks; ++b)
+    {
+        const char* block = data + (b << 6);
+        _blockSeparators(_maskSSE2(block, quote), _maskSSE2(block, comma), _maskSSE2(block, line), quoted, base + (b << 6), separators);
+    }
+}
+
+#endif // CSV_X86
+
+// ---------------------------
+// ---- Runtime Dispatch
+// ---------------------------
+
+// Instruction set of the tokenizer: 2 = AVX2, 1 = SSE2, 0 = scalar
+static unsigned int _csvISA()
+{
+    static const unsigned int isa = []() -> unsigned int
+    {
+#ifdef CSV_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return 2;
+        if (__builtin_cpu_supports("sse2")) return 1;
+#endif
+        return 0;
+    }();
+    return isa;
+}
+
+void csvSeparators(std::string_view text, std::vector<uint32_t>& separators)
+{
+    const size_t blocks = text.size() >> 6;
+    uint64_t quoted = 0;
+
+#ifdef CSV_X86
+    if (_csvISA() == 2) _separatorsAVX2(text.data(), blocks, quoted, 0, separators);
+    else if (_csvISA() == 1) _separatorsSSE2(text.data(), blocks, quoted, 0, separators);
+    else
+#endif
+    _separatorsScalar(text.data(), blocks, quoted, 0, separators);
+
+    // The last bytes are scanned as a block padded with zeros
+    const size_t rest = text.size() - (blocks << 6);
+    if (rest)
+    {
+        char block[64] = {};
+        memcpy(block, text.data() + (blocks << 6), rest);
+        _separatorsScalar(block, 1, quoted, blocks << 6, separators);
+    }
+}
+
+std::string_view csvUnquote(std::string_view field, std::string& scratch)
+{
+    if (field.size() < 2 || field.front() != '"' || field.back() != '"') return field;
+    field = field.substr(1, field.size() - 2);
+
+    size_t quote = field.find('"');
+    if (quote == std::string_view::npos) return field;
+
+    // Quotes inside the value are written twice, keep one of each pair
+    scratch.clear();
+    size_t start = 0;
+    while (quote != std::string_view::npos)
+    {
+        scratch.append(field.substr(start, quote + 1 - start));
+        start = quote + 2;
+        quote = start < field.size() ? field.find('"', start) : std::string_view::npos;
+    }
+    if (start < field.size()) scratch.append(field.substr(start));
+    return scratch;
+}
+
+const char* csvKernelName()
+{
+    switch (_csvISA())
+    {
+        case 2: return "avx2";
+        case 1: return "sse2";
+        default: return "scalar";
+    }
+}
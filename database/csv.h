@@ -0,0 +1,31 @@
+/**
+ * File: csv.h
+ * Author: Mark Minkoff
+ * Functionality: Function declarations for file csv.cpp
+ * Vectorized csv tokenizer used by the csv import (see loader.h). The text is scanned in
+ * 64 byte blocks: each block gives a bitmask of its quotes, commas and line breaks, the
+ * quoted regions are the prefix XOR of the quote mask (carried from block to block), and the
+ * commas and line breaks outside them are the field separators.
+ * AVX2 and SSE2 kernels are selected at runtime, with a portable scalar fallback.
+ *
+ * Values follow RFC 4180: a value in double quotes may hold commas, line breaks and quotes
+ * written twice (""). Quotes in the middle of an unquoted value are not supported.
+ *
+ * */
+
+#ifndef CSV_H_
+#define CSV_H_
+
+#include "include.h"
+
+/** Appends the offsets of the commas and line breaks outside quoted values of 'text' to 'separators', in order.
+ *  The offsets are 32 bit, 'text' is a chunk of a file under 4 GiB. */
+void csvSeparators(std::string_view text, std::vector<uint32_t>& separators);
+
+/** A value without its quotes, "" read as ". 'scratch' holds the value if it had escaped quotes. */
+std::string_view csvUnquote(std::string_view field, std::string& scratch);
+
+/** Name of the instruction set the tokenizer runs on ("avx2", "sse2" or "scalar") */
+const char* csvKernelName();
+
+#endif // CSV_H_
@@ -7,29 +7,102 @@
 
 #include "database.h"
 
-Database::Database(const std::string& database, const fs::path& path, const fs::path& path_metadata) : database_name(database), path(path), path_metadata(path_metadata), transaction_mode(false) {
-    this->writeMetadata();
+/** Equi-join two key vectors with a hash join.
+ *  The hash table is built over the smaller input and probed with the larger one.
+ *  Every row of 'left' gets an entry in the result so outer joins can detect misses. */
+template <typename T>
+static std::unordered_map<size_t, std::vector<size_t>> _hashJoin(const ColumnView<T>& left, const ColumnView<T>& right)
+{
+    // Initialize resulting container with an empty match list for every left row
+    std::unordered_map<size_t, std::vector<size_t>> res;
+    res.reserve(left.size());
+    for (size_t i = 0; i < left.size(); ++i) res.emplace(i, std::vector<size_t>());
+
+    if (left.size() <= right.size())
+    {
+        // Build on the left input
+        std::unordered_map<T, std::vector<size_t>> build;
+        build.reserve(left.size());
+        for (size_t i = 0; i < left.size(); ++i) build[left[i]].emplace_back(i);
+
+        // Probe with the right input, rows are visited in order so match lists stay sorted
+        for (size_t j = 0; j < right.size(); ++j)
+        {
+            auto found = build.find(right[j]);
+            if (found == build.end()) continue;
+            for (size_t i : found->second) res[i].emplace_back(j);
+        }
+    }
+    else
+    {
+        // Build on the right input
+        std::unordered_map<T, std::vector<size_t>> build;
+        build.reserve(right.size());
+        for (size_t j = 0; j < right.size(); ++j) build[right[j]].emplace_back(j);
+
+        // Probe with the left input
+        for (size_t i = 0; i < left.size(); ++i)
+        {
+            auto found = build.find(left[i]);
+            if (found != build.end()) res[i] = found->second;
+        }
+    }
+
+    return res;
 }
 
-Database::Database() : database_name("undefined") {}
+/** Returns the operator that gives the same result when its operands are swapped */
+static std::string _flipOperator(const std::string& op)
+{
+    if (op == "<")  return ">";
+    if (op == "<=") return ">=";
+    if (op == ">")  return "<";
+    if (op == ">=") return "<=";
+    return op;
+}
 
-Database::~Database() {}
+/** True for a NaN key, it compares false with every key so it matches no range operator and has no
+ *  place in a sorted order */
+template <typename Key>
+static bool _isNaN(const Key& key)
+{
+    if constexpr (std::is_floating_point<Key>::value) return std::isnan(key);
+    else return false;
+}
 
-bool Database::tableExists(const std::string& table_name)
+/** Collects the rows of the right input that were never matched (used for full outer joins).
+ *  Deleted rows of either input are skipped, they stay in the columns until their table is compacted. */
+static std::unordered_map<size_t, std::vector<size_t>> _unmatchedRows(const std::unordered_map<size_t, std::vector<size_t>>& mapping, std::shared_ptr<Table> left, std::shared_ptr<Table> right)
 {
-    bool count = this->tables.count(table_name);
+    const size_t right_size = right->getRowCount();
 
-    if (count) return count; 
+    std::vector<bool> matched(right_size, false);
+    for (auto& m : mapping) {
+        if (left->isDeleted(m.first)) continue;
+        for (size_t r : m.second) matched[r] = true;
+    }
 
-    // Iterate over all tables if there any match
-    std::string capital_table_name = _toUpper(table_name);
-    for (std::pair<std::string, std::shared_ptr<Table>> table : this->tables ) 
-    {
-        if (_toUpper(std::get<0>(table)) == capital_table_name) {
-            return true;
-        }
+    std::unordered_map<size_t, std::vector<size_t>> res;
+    for (size_t r = 0; r < right_size; ++r) {
+        if (!matched[r] && !right->isDeleted(r)) res.emplace(r, std::vector<size_t>());
     }
-    return false;
+    return res;
+}
+
+Database::Database(const std::string& database, const fs::path& path, const fs::path& path_metadata) : database_name(database), path(path), path_metadata(path_metadata), transaction_mode(false), recovered(false), adaptive(false), compaction(COMPACTION_AUTO) {
+    // Every process logs to a log of its own, logs left behind by other processes are replayed by recover
+    this->wal = WriteAheadLog::create(path);
+    this->writeMetadata();
+}
+
+Database::Database() : database_name("undefined"), recovered(false), adaptive(false), compaction(COMPACTION_AUTO) {}
+
+Database::~Database() {}
+
+bool Database::tableExists(const std::string& table_name)
+{
+    // Table names are hashed and compared case-insensitively
+    return this->tables.count(table_name);
 }
 
 bool Database::createTable(std::string table_name, std::vector<std::pair<std::string, std::string>> columns)
@@ -38,35 +111,25 @@ bool Database::createTable(std::string table_name, std::vector<std::pair<std::st
 
     table_path += "/"; table_path += table_name; 
 
-    if (!fs::exists(table_path))
-    {
-        fs::create_directories(table_path);
-
-        table_path += "/"; table_path += table_name; table_metadata_path = table_path;
-        table_path += ".csv";
-        table_metadata_path += ".txt";
+    if (!fs::exists(table_path)) fs::create_directories(table_path);
 
-        // Create and open the table file
-        std::ofstream table_file(table_path, std::ofstream::out);
+    table_path += "/"; table_path += table_name; table_metadata_path = table_path;
+    table_path += ".tbl";
+    table_metadata_path += ".txt";
 
-        for (auto& c : columns) {
-            table_file << c.first << ' ' << c.second << ',';
-        }
+    // Create a new table
+    std::shared_ptr<Table> new_table = std::make_shared<Table>(table_name, columns, table_path, table_metadata_path);
 
-        // Insert new line
-        table_file << '\n';
+    // Statements on this table go to the database log
+    new_table->setWal(this->wal);
+    new_table->setAdaptiveIndexing(this->adaptive);
 
-        // Close the file stream
-        table_file.close();
-    } else {
-        table_path += "/"; table_path += table_name; table_metadata_path = table_path;
-        table_path += ".csv";
-        table_metadata_path += ".txt";
+    // A new table starts out with an empty table file and empty column files that contain the whole log
+    if (!fs::exists(table_path)) {
+        if (this->wal) new_table->setCheckpoint(this->wal->getLogId(), this->wal->lastLsn());
+        new_table->writeBinary();
     }
 
-    // Create a new table
-    std::shared_ptr<Table> new_table = std::make_shared<Table>(table_name, columns, table_path, table_metadata_path);
-
     // Insert the table into memory
     this->tables.insert(std::make_pair(table_name, new_table));
 
@@ -82,50 +145,283 @@ bool Database::dropTable(const std::string& table_name)
 {
     if (tableExists(table_name))
     {
-        this->tables.erase(table_name);
-        fs::remove( this->tables.at(table_name)->getPath() );
+        // Empty the log first, it must not hold statements on a table that no longer exists
+        this->checkpoint();
+
+        std::shared_ptr<Table> table = this->getTable(table_name);
+        this->tables.erase(table->getTable());
+
+        // Remove the table directory with the table, metadata and column files
+        fs::remove_all( table->getPath().parent_path() );
         return true;
     }
     return false;
 }
 
-bool Database::printTableColumnInfo(const std::string& table_name)
+std::shared_ptr<Table> Database::indexTable(const std::string& index_name)
 {
-    if (tableExists(table_name)) {
-        std::shared_ptr<Table> table = getTable(table_name);
-        
-        return true;
+    for (auto& table : this->tables) {
+        if (table.second->hasIndex(index_name)) return table.second;
+    }
+    return nullptr;
+}
+
+bool Database::createIndex(const std::string& index_name, const std::string& table_name, const std::string& column_name, const IndexType type)
+{
+    std::shared_ptr<Table> table = this->getTable(table_name);
+    if (!table) {
+        std::cout << "-- !Table " << table_name << " does not exist.\n";
+        return false;
+    }
+
+    if (this->indexTable(index_name)) {
+        std::cout << "-- !Index " << index_name << " already exists.\n";
+        return false;
+    }
+
+    // The index is built over the rows in the table files, so they must hold every logged change.
+    // The lock stays held while the table file is written, a checkpoint of another process would replace it.
+    FileLock lock(this->path / "checkpoint.lock");
+    if (!lock.isLocked() || !this->checkpointTables() || !table->refresh()) return false;
+
+    return table->createIndex(index_name, column_name, type);
+}
+
+bool Database::dropIndex(const std::string& index_name)
+{
+    std::shared_ptr<Table> table = this->indexTable(index_name);
+    if (!table) {
+        std::cout << "-- !Index " << index_name << " does not exist.\n";
+        return false;
+    }
+
+    // Unlogged changes to the table are written before its file is rewritten
+    FileLock lock(this->path / "checkpoint.lock");
+    if (!lock.isLocked() || !this->checkpointTables() || !table->refresh()) return false;
+
+    return table->dropIndex(index_name);
+}
+
+bool Database::checkpoint()
+{
+    if (!this->wal) return true;
+
+    // One process at a time writes the table files of the database
+    FileLock lock(this->path / "checkpoint.lock");
+    if (!lock.isLocked()) return false;
+
+    return this->checkpointTables();
+}
+
+bool Database::checkpointTables()
+{
+    if (!this->wal) return true;
+
+    const uint64_t lsn = this->wal->lastLsn();
+    const bool sync = this->wal->getSyncPolicy() != WAL_SYNC_OFF;
+
+    // Statements of processes that exited without a checkpoint go to the table files first
+    bool success = this->recoverLogs();
+
+    // Every table must hold its changes before the log can be emptied
+    for (auto& table : this->tables) {
+        success = table.second->checkpoint(this->wal->getLogId(), lsn, sync) && success;
     }
 
-    // Iterate over all tables if there any match
-    std::string capital_table_name = _toUpper(table_name);
-    for (std::pair<std::string, std::shared_ptr<Table>> table : this->tables ) 
+    // Keep the log if a table could not be written, it is replayed on the next start
+    if (!success) return false;
+    return this->wal->reset();
+}
+
+bool Database::refresh()
+{
+    bool success = true;
+    for (auto& table : this->tables) success = table.second->refresh() && success;
+    return success;
+}
+
+bool Database::autoCheckpoint()
+{
+    if (!this->wal || this->wal->size() < this->wal->getCheckpointSize()) return true;
+    return this->checkpoint();
+}
+
+bool Database::recover()
+{
+    if (this->recovered || !this->wal) return true;
+    this->recovered = true;
+
+    // The logs of other processes are replayed at the checkpoint
+    return this->checkpoint();
+}
+
+/** Opens the files of a table apart from the table held by the database, with the columns described in
+ *  its table file. 'known' is the table of that name held by the database, nullptr if there is none. */
+static std::shared_ptr<Table> _openTableFiles(const fs::path& directory, const std::string& table_name, std::shared_ptr<Table> known)
+{
+    fs::path table_path = directory / table_name / table_name;
+    fs::path metadata_path = table_path;
+    table_path += ".tbl";
+    metadata_path += ".txt";
+
+    std::vector<ColumnDescriptor> descriptors;
+    std::vector<IndexDescriptor> indexes;
+    TableCommit commit;
+    if (!fs::exists(table_path) || !readTableFile(table_path, descriptors, indexes, commit)) return nullptr;
+
+    std::vector<std::pair<std::string, std::string>> columns;
+    for (auto& descriptor : descriptors)
+    {
+        std::string type = "INT";
+        if (descriptor.data_type == STORAGE_FLOAT) type = "FLOAT";
+        else if (descriptor.data_type == STORAGE_CHAR) type = "CHAR";
+        else if (descriptor.data_type == STORAGE_VARCHAR) type = "VARCHAR(" + std::to_string(descriptor.char_max) + ")";
+        columns.emplace_back(descriptor.name, type);
+    }
+
+    std::shared_ptr<Table> table = std::make_shared<Table>(table_name, columns, table_path, metadata_path);
+    if (known) table->setLocked(known->getLocked());
+    if (!table->open()) return nullptr;
+    return table;
+}
+
+bool Database::recoverLogs()
+{
+    bool success = true;
+
+    for (const fs::path& log_path : WriteAheadLog::logPaths(this->path))
     {
-        if (_toUpper(std::get<0>(table)) == capital_table_name) {
-            
-            return true;
+        if (log_path == this->wal->getPath()) continue;
+
+        // Logs of processes that still run are locked
+        std::shared_ptr<WriteAheadLog> log = WriteAheadLog::claim(log_path);
+        if (!log) continue;
+
+        std::vector<WalRecord> records;
+        if (!log->readRecords(records)) { success = false; continue; }
+
+        // The records are applied to the committed files, apart from the tables of this process
+        std::unordered_map<std::string, std::shared_ptr<Table>, _NameHash, _NameEqual> tables;
+        size_t replayed = 0;
+        bool replay_failed = false;
+
+        for (auto& record : records)
+        {
+            if (record.fields.empty()) continue;
+
+            auto found = tables.find(record.fields[0]);
+            if (found == tables.end()) {
+                std::shared_ptr<Table> known = this->tableExists(record.fields[0]) ? this->getTable(record.fields[0]) : nullptr;
+                found = tables.emplace(record.fields[0], _openTableFiles(this->path, record.fields[0], known)).first;
+            }
+
+            // The table was dropped since
+            std::shared_ptr<Table> table = found->second;
+            if (!table) continue;
+
+            // A checkpoint of that process already wrote this statement to the table files
+            if (table->getCheckpointLog() == log->getLogId() && record.lsn <= table->getCheckpointLsn()) continue;
+
+            if (table->replayRecord(record)) ++replayed;
+        }
+
+        const bool sync = this->wal->getSyncPolicy() != WAL_SYNC_OFF;
+        for (auto& table : tables) {
+            if (table.second && !table.second->checkpoint(log->getLogId(), log->lastLsn(), sync)) replay_failed = true;
         }
+
+        // The log stays until every table holds its statements
+        if (replay_failed || !log->remove()) { success = false; continue; }
+
+        if (replayed) std::cout << "-- Recovered " << replayed << " logged statements in database " << this->database_name << "\n";
     }
 
-    return false;
+    return success;
 }
 
-std::shared_ptr<Table> Database::getTable(const std::string& table_name)
+bool Database::printTables()
 {
-    if (this->tables.count(table_name)) {
-        return this->tables.at(table_name);
+    // Print the tables in name order
+    std::vector<std::shared_ptr<Table>> tables;
+    for (auto& table : this->tables) tables.emplace_back(table.second);
+    std::sort(tables.begin(), tables.end(), [](auto& a, auto& b) { return a->getTable() < b->getTable(); });
+
+    static const char* states[] = { "cold", "mapped", "hot" };
+
+    // Deleted rows are counted until the table is compacted
+    std::cout << "-- table | rows | deleted | state\n";
+    for (auto& table : tables) {
+        std::cout << "-- " << table->getTable() << " | " << table->liveRowCount() << " | " << table->deletedRowCount() << " | " << states[table->getState()] << "\n";
     }
 
-    // Iterate over all tables if there any match
-    std::string capital_table_name = _toUpper(table_name);
-    for (std::pair<std::string, std::shared_ptr<Table>> table : this->tables ) 
+    return true;
+}
+
+bool Database::printIndexes()
+{
+    // Print the indexes in name order
+    std::vector<std::tuple<std::string, std::string, std::string, std::string>> indexes;
+    for (auto& table : this->tables)
     {
-        if (_toUpper(std::get<0>(table)) == capital_table_name) {
-            return std::get<1>(table);
+        std::vector<std::pair<std::string, std::string>> columns = table.second->getMetaData();
+        for (auto& index : table.second->getIndexes()) {
+            indexes.emplace_back(index.name, table.second->getTable(), columns[index.column].first, indexTypeName((IndexType)index.type));
         }
     }
+    std::sort(indexes.begin(), indexes.end());
 
-    return nullptr;
+    std::cout << "-- index | table | column | type\n";
+    for (auto& index : indexes) {
+        std::cout << "-- " << std::get<0>(index) << " | " << std::get<1>(index) << " | " << std::get<2>(index) << " | " << std::get<3>(index) << "\n";
+    }
+
+    return true;
+}
+
+bool Database::printStats()
+{
+    // Print the tables in name order, their columns in column order
+    std::vector<std::shared_ptr<Table>> tables;
+    for (auto& table : this->tables) tables.emplace_back(table.second);
+    std::sort(tables.begin(), tables.end(), [](auto& a, auto& b) { return a->getTable() < b->getTable(); });
+
+    std::cout << "-- table | column | blocks scanned | blocks skipped | cracker pieces | cracker queries\n";
+    for (auto& table : tables)
+    {
+        std::vector<std::pair<std::string, std::string>> columns = table->getMetaData();
+        std::vector<ColumnStats> stats = table->columnStats();
+        for (size_t i = 0; i < stats.size() && i < columns.size(); ++i) {
+            std::cout << "-- " << table->getTable() << " | " << columns[i].first << " | " << stats[i].blocks_scanned << " | " << stats[i].blocks_skipped << " | " << stats[i].cracker_pieces << " | " << stats[i].cracker_queries << "\n";
+        }
+    }
+
+    return true;
+}
+
+void Database::setAdaptiveIndexing(const bool adaptive)
+{
+    this->adaptive = adaptive;
+    for (auto& table : this->tables) table.second->setAdaptiveIndexing(adaptive);
+}
+
+bool Database::printTableColumnInfo(const std::string& table_name)
+{
+    if (tableExists(table_name)) {
+        std::shared_ptr<Table> table = getTable(table_name);
+        
+        return true;
+    }
+
+    return false;
+}
+
+std::shared_ptr<Table> Database::getTable(const std::string& table_name)
+{
+    // Table names are hashed and compared case-insensitively
+    auto found = this->tables.find(table_name);
+    if (found == this->tables.end()) return nullptr;
+
+    return found->second;
 }
 
 bool Database::addColumnsToTable(const std::string& table_name, std::vector<std::pair<std::string, std::string>> columns)
@@ -182,6 +478,50 @@ bool Database::queryTables (
     // If the columns are NOT the same data type, do nothing and return false.
     if (column1_data_type != column2_data_type) { std::cout << "-- !Failed to query tables. Columns are not the same data type.\n"; return false; }
 
+    // Report the join algorithm: equi-joins are hashed on the smaller input, range joins are
+    // sort-merged and everything else is a nested loop
+    if (opr == "=") {
+        std::shared_ptr<Table> build = (table1_ptr->getRowCount() <= table2_ptr->getRowCount()) ? table1_ptr : table2_ptr;
+        std::cout << "-- Join algorithm: hash join (build side " << build->getTable() << ")\n";
+    }
+    else if (_isRangeOperator(opr)) {
+        std::cout << "-- Join algorithm: sort-merge band join\n";
+    }
+    else {
+        std::cout << "-- Join algorithm: nested loop\n";
+    }
+
+    if (_isRangeOperator(opr))
+    {
+        // A right join is a left join with the inputs (and the operator) swapped
+        const bool right_join = !lr_val.first && lr_val.second;
+        const bool full_join = lr_val.first && lr_val.second;
+
+        std::shared_ptr<Table> left = right_join ? table2_ptr : table1_ptr;
+        std::shared_ptr<Table> right = right_join ? table1_ptr : table2_ptr;
+        const std::string left_column = right_join ? table_select2[1] : table_select1[1];
+        const std::string right_column = right_join ? table_select1[1] : table_select2[1];
+        const std::string op = right_join ? _flipOperator(opr) : opr;
+
+        // CHAR and VARCHAR columns are ordered case insensitively
+        if (column1_data_type == 0) {
+            return this->bandJoin(left, right, left->selectColumnInt(left_column), right->selectColumnInt(right_column),
+                op, [](const int& e) { return e; }, full_join, inner);
+        }
+        else if (column1_data_type == 1) {
+            return this->bandJoin(left, right, left->selectColumnFloat(left_column), right->selectColumnFloat(right_column),
+                op, [](const float& e) { return e; }, full_join, inner);
+        }
+        else if (column1_data_type == 2) {
+            return this->bandJoin(left, right, left->selectColumnChar(left_column), right->selectColumnChar(right_column),
+                op, [](const char& e) { return _toUpper(e); }, full_join, inner);
+        }
+        else if (column1_data_type == 3) {
+            return this->bandJoin(left, right, left->selectColumnString(left_column), right->selectColumnString(right_column),
+                op, [](const std::string& e) { return _toUpper(e); }, full_join, inner);
+        }
+    }
+
     if (column1_data_type == 0) {
         auto column1 = table1_ptr->selectColumnInt(table_select1[1]);
         auto column2 = table2_ptr->selectColumnInt(table_select2[1]);
@@ -205,8 +545,7 @@ bool Database::queryTables (
         else if (lr_val.first && lr_val.second)
         {
             mapping1 = queryColumnsInt(column1, column2, opr);
-            mapping2 = queryColumnsInt(column2, column1, opr);
-            
+            mapping2 = _unmatchedRows(mapping1, table1_ptr, table2_ptr);
             this->printQuery(table1_ptr, table2_ptr, mapping1, mapping2, inner);
         }        
     }
@@ -233,7 +572,7 @@ bool Database::queryTables (
         else if (lr_val.first && lr_val.second)
         {
             mapping1 = queryColumnsFloat(column1, column2, opr);
-            mapping2 = queryColumnsFloat(column2, column1, opr);
+            mapping2 = _unmatchedRows(mapping1, table1_ptr, table2_ptr);
             this->printQuery(table1_ptr, table2_ptr, mapping1, mapping2, inner);
         }
     }
@@ -260,7 +599,7 @@ bool Database::queryTables (
         else if (lr_val.first && lr_val.second)
         {
             mapping1 = queryColumnsChar(column1, column2, opr);
-            mapping2 = queryColumnsChar(column2, column1, opr);
+            mapping2 = _unmatchedRows(mapping1, table1_ptr, table2_ptr);
             this->printQuery(table1_ptr, table2_ptr, mapping1, mapping2, inner);
         }
     }
@@ -287,7 +626,7 @@ bool Database::queryTables (
         else if (lr_val.first && lr_val.second)
         {
             mapping1 = queryColumnsString(column1, column2, opr);
-            mapping2 = queryColumnsString(column2, column1, opr);
+            mapping2 = _unmatchedRows(mapping1, table1_ptr, table2_ptr);
             this->printQuery(table1_ptr, table2_ptr, mapping1, mapping2, inner);
         }
     }
@@ -311,27 +650,12 @@ std::unordered_map<size_t, std::vector<size_t>> Database::queryColumnsInt(
     // If operator is not valid or columns are null or left and right flags are both false, return an empty result.
     if(!_isValidOperator(op) || !col1 || !col2) return res;
 
-    std::vector<int> elements1 = col1->getElements();
-    std::vector<int> elements2 = col2->getElements();
+    // Read the elements in place
+    auto elements1 = col1->getElements();
+    auto elements2 = col2->getElements();
 
     if (op == "=") { // Equality operator
-        // Iterate over every element in the first column.
-        for (size_t i = 0; i < elements1.size(); ++i) 
-        {
-            // If an element from the first column has NOT been mapped, map it.
-            if (!res.count(i)) res.insert( std::make_pair(i, std::vector<size_t>()) );
-
-            // Iterate over every element in the second column.
-            for (size_t j = 0; j < elements2.size(); j++) 
-            {
-                // Perform check
-                if (elements1[i] == elements2[j]) 
-                {
-                    // Store matching row
-                    res.at(i).emplace_back(j);
-                }
-            }
-        }
+        res = _hashJoin(elements1, elements2);
     }
     else if (op == "!=") { // Inequality operator
         // Iterate over every element in the first column.
@@ -441,30 +765,15 @@ std::unordered_map<size_t, std::vector<size_t>> Database::queryColumnsFloat(
     // Initialize resulting container
     std::unordered_map<size_t, std::vector<size_t>> res;
 
-    std::vector<float> elements1 = col1->getElements();
-    std::vector<float> elements2 = col2->getElements();
-
     // If operator is not valid or columns are null or left and right flags are both false, return an empty result.
     if(!_isValidOperator(op) || !col1 || !col2) return res;
 
-    if (op == "=") { // Equality operator
-        // Iterate over every element in the first column.
-        for (size_t i = 0; i < elements1.size(); ++i) 
-        {
-            // If an element from the first column has NOT been mapped, map it.
-            if (!res.count(i)) res.insert( std::make_pair(i, std::vector<size_t>()) );
+    // Read the elements in place
+    auto elements1 = col1->getElements();
+    auto elements2 = col2->getElements();
 
-            // Iterate over every element in the second column.
-            for (size_t j = 0; j < elements2.size(); j++) 
-            {
-                // Perform check
-                if (elements1[i] == elements2[j]) 
-                {
-                    // Store matching row
-                    res.at(i).emplace_back(j);
-                }
-            }
-        }
+    if (op == "=") { // Equality operator
+        res = _hashJoin(elements1, elements2);
     }
     else if (op == "!=") { // Inequality operator
         // Iterate over every element in the first column.
@@ -574,30 +883,15 @@ std::unordered_map<size_t, std::vector<size_t>> Database::queryColumnsChar(
     // Initialize resulting container
     std::unordered_map<size_t, std::vector<size_t>> res;
 
-    std::vector<char> elements1 = col1->getElements();
-    std::vector<char> elements2 = col2->getElements();
-
     // If operator is not valid or columns are null or left and right flags are both false, return an empty result.
     if(!_isValidOperator(op) || !col1 || !col2) return res;
 
-    if (op == "=") { // Equality operator
-        // Iterate over every element in the first column.
-        for (size_t i = 0; i < elements1.size(); ++i) 
-        {
-            // If an element from the first column has NOT been mapped, map it.
-            if (!res.count(i)) res.insert( std::make_pair(i, std::vector<size_t>()) );
+    // Read the elements in place
+    auto elements1 = col1->getElements();
+    auto elements2 = col2->getElements();
 
-            // Iterate over every element in the second column.
-            for (size_t j = 0; j < elements2.size(); j++) 
-            {
-                // Perform check
-                if (elements1[i] == elements2[j]) 
-                {
-                    // Store matching row
-                    res.at(i).emplace_back(j);
-                }
-            }
-        }
+    if (op == "=") { // Equality operator
+        res = _hashJoin(elements1, elements2);
     }
     else if (op == "!=") { // Inequality operator
         // Iterate over every element in the first column.
@@ -704,8 +998,6 @@ std::unordered_map<size_t, std::vector<size_t>> Database::queryColumnsString(
     const std::string& op
 )
 {
-    std::vector<std::string> elements1 = col1->getElements();
-    std::vector<std::string> elements2 = col2->getElements();
 
     // Initialize resulting container
     std::unordered_map<size_t, std::vector<size_t>> res;
@@ -713,24 +1005,12 @@ std::unordered_map<size_t, std::vector<size_t>> Database::queryColumnsString(
     // If operator is not valid or columns are null or left and right flags are both false, return an empty result.
     if(!_isValidOperator(op) || !col1 || !col2) return res;
 
-    if (op == "=") { // Equality operator
-        // Iterate over every element in the first column.
-        for (size_t i = 0; i < elements1.size(); ++i) 
-        {
-            // If an element from the first column has NOT been mapped, map it.
-            if (!res.count(i)) res.insert( std::make_pair(i, std::vector<size_t>()) );
+    // Read the elements in place
+    auto elements1 = col1->getElements();
+    auto elements2 = col2->getElements();
 
-            // Iterate over every element in the second column.
-            for (size_t j = 0; j < elements2.size(); j++) 
-            {
-                // Perform check 
-                if (elements1[i].compare(elements2[j]) == 0)
-                {
-                    // Store matching row
-                    res.at(i).emplace_back(j);
-                }
-            }
-        }
+    if (op == "=") { // Equality operator
+        res = _hashJoin(elements1, elements2);
     }
     else if (op == "!=") { // Inequality operator
         // Iterate over every element in the first column.
@@ -831,13 +1111,132 @@ std::unordered_map<size_t, std::vector<size_t>> Database::queryColumnsString(
     return res;
 }
 
-bool Database::printQuery(
-        std::shared_ptr<Table> table1, 
+template <typename T, typename KeyFn>
+bool Database::bandJoin(
+        std::shared_ptr<Table> table1,
         std::shared_ptr<Table> table2,
-        std::unordered_map<size_t, std::vector<size_t>> map1,
-        std::unordered_map<size_t, std::vector<size_t>> map2,
-        bool inner
+        std::shared_ptr<Column<T>> column1,
+        std::shared_ptr<Column<T>> column2,
+        const std::string& op,
+        KeyFn key,
+        const bool full,
+        const bool inner
     )
+{
+    if (!_isRangeOperator(op)) return false;
+
+    const ColumnView<T> elements1 = column1->getElements();
+    const ColumnView<T> elements2 = column2->getElements();
+
+    using Key = typename std::decay<decltype(key(elements1[0]))>::type;
+
+    // Compute the ordering key of every element once
+    std::vector<Key> keys1, keys2;
+    keys1.reserve(elements1.size());
+    keys2.reserve(elements2.size());
+    for (auto& e : elements1) keys1.emplace_back(key(e));
+    for (auto& e : elements2) keys2.emplace_back(key(e));
+
+    // NaN keys match nothing and break the ordering, their rows are left out of the walk below.
+    // A B+tree index holds them last.
+    auto nan1 = [&keys1](size_t row) { return _isNaN(keys1[row]); };
+    auto nan2 = [&keys2](size_t row) { return _isNaN(keys2[row]); };
+
+    // Sort the row numbers of both inputs by key, ties keep their row order.
+    // A B+tree index already holds the rows in that order.
+    std::vector<size_t> order1, order2;
+    if (!column1->sortedRows(order1)) {
+        order1.resize(elements1.size());
+        std::iota(order1.begin(), order1.end(), 0);
+        order1.erase(std::remove_if(order1.begin(), order1.end(), nan1), order1.end());
+        std::stable_sort(order1.begin(), order1.end(), [&keys1](size_t a, size_t b) { return keys1[a] < keys1[b]; });
+    }
+    else order1.erase(std::remove_if(order1.begin(), order1.end(), nan1), order1.end());
+
+    if (!column2->sortedRows(order2)) {
+        order2.resize(elements2.size());
+        std::iota(order2.begin(), order2.end(), 0);
+        order2.erase(std::remove_if(order2.begin(), order2.end(), nan2), order2.end());
+        std::stable_sort(order2.begin(), order2.end(), [&keys2](size_t a, size_t b) { return keys2[a] < keys2[b]; });
+    }
+    else order2.erase(std::remove_if(order2.begin(), order2.end(), nan2), order2.end());
+
+    // Deleted rows stay in the columns until their table is compacted
+    if (table1->deletedRowCount()) order1.erase(std::remove_if(order1.begin(), order1.end(), [&](size_t row) { return table1->isDeleted(row); }), order1.end());
+    if (table2->deletedRowCount()) order2.erase(std::remove_if(order2.begin(), order2.end(), [&](size_t row) { return table2->isDeleted(row); }), order2.end());
+
+    // For '<' and '<=' the matches of a row lie above its key, for '>' and '>=' below it.
+    // '<=' and '>=' additionally match exactly equal elements inside the run of equal keys.
+    const bool above = (op == "<" || op == "<=");
+    const bool ties = (op == "<=" || op == ">=");
+
+    std::vector<bool> matched2(full ? elements2.size() : 0, false);
+
+    this->printQueryHeader(table1, table2);
+
+    auto emit = [&](size_t row1, size_t row2) {
+        std::cout << "-- ";
+        table1->printRow(row1);
+        table2->printRow(row2);
+        std::cout << "\n";
+        if (full) matched2[row2] = true;
+    };
+
+    // [lo, hi) is the run of keys in the sorted second input equal to the current key.
+    // The first input is visited in key order, so both bounds only move forward.
+    const size_t n2 = order2.size();
+    size_t lo = 0, hi = 0;
+    for (size_t row1 : order1)
+    {
+        const Key& k = keys1[row1];
+        while (lo < n2 && keys2[order2[lo]] < k) ++lo;
+        if (hi < lo) hi = lo;
+        while (hi < n2 && !(k < keys2[order2[hi]])) ++hi;
+
+        bool found = false;
+        if (ties) {
+            for (size_t p = lo; p < hi; ++p) {
+                if (elements1[row1] == elements2[order2[p]]) { emit(row1, order2[p]); found = true; }
+            }
+        }
+        if (above) {
+            for (size_t p = hi; p < n2; ++p) { emit(row1, order2[p]); found = true; }
+        }
+        else {
+            for (size_t p = 0; p < lo; ++p) { emit(row1, order2[p]); found = true; }
+        }
+
+        // Outer joins print rows without a match
+        if (!found && !inner) {
+            std::cout << "-- ";
+            table1->printRow(row1);
+            std::cout << "\n";
+        }
+    }
+
+    // Outer joins print the rows with a NaN key as rows without a match, the second input's through matched2
+    if (!inner) {
+        for (size_t row1 = 0; row1 < keys1.size(); ++row1) {
+            if (!nan1(row1) || table1->isDeleted(row1)) continue;
+            std::cout << "-- ";
+            table1->printRow(row1);
+            std::cout << "\n";
+        }
+    }
+
+    if (full && !inner) {
+        for (size_t row2 = 0; row2 < matched2.size(); ++row2) {
+            if (matched2[row2] || table2->isDeleted(row2)) continue;
+            std::cout << "-- ";
+            table2->printRow(row2);
+            std::cout << "\n";
+        }
+    }
+
+    return true;
+}
+
+void Database::printQueryHeader(std::shared_ptr<Table> table1, std::shared_ptr<Table> table2)
 {
     auto meta1 = table1->getMetaData();
     auto meta2 = table2->getMetaData();
@@ -856,19 +1255,36 @@ bool Database::printQuery(
         if (counter != (meta1.size() - 1)) std::cout << " | ";
         counter++;
     }
+    std::cout << "\n";
+}
+
+bool Database::printQuery(
+        std::shared_ptr<Table> table1, 
+        std::shared_ptr<Table> table2,
+        std::unordered_map<size_t, std::vector<size_t>> map1,
+        std::unordered_map<size_t, std::vector<size_t>> map2,
+        bool inner
+    )
+{
+    this->printQueryHeader(table1, table2);
 
     // Initialize a container for rows with no matches (used for outer joins)
     std::vector<size_t> no_match;
 
-    std::cout << "\n";
+    // Deleted rows stay in the columns until their table is compacted, they are not joined
     for (auto& m : map1) {
+        if (table1->isDeleted(m.first)) continue;
+
+        bool found = false;
         for (auto& r: m.second) {
+            if (table2->isDeleted(r)) continue;
             std::cout << "-- ";
             table1->printRow(m.first);
             table2->printRow(r);
             std::cout << "\n";
+            found = true;
         }
-        if (m.second.empty()) no_match.emplace_back(m.first);
+        if (!found) no_match.emplace_back(m.first);
     }
     if (!inner) {
         for (auto& r : no_match) {
@@ -878,19 +1294,25 @@ bool Database::printQuery(
         }
         no_match.clear();
     }
+    // map2 is keyed by rows of table2 (used for the right side of full joins)
     for (auto& m : map2) {
+        if (table2->isDeleted(m.first)) continue;
+
+        bool found = false;
         for (auto& r: m.second) {
+            if (table1->isDeleted(r)) continue;
             std::cout << "-- ";
-            table1->printRow(m.first);
-            table2->printRow(r);
+            table1->printRow(r);
+            table2->printRow(m.first);
             std::cout << "\n";
+            found = true;
         }
-        if (m.second.empty()) no_match.emplace_back(m.first);
+        if (!found) no_match.emplace_back(m.first);
     }
     if (!inner) {
         for (auto& r : no_match) {
             std::cout << "-- ";
-            table1->printRow(r);
+            table2->printRow(r);
             std::cout << "\n";
         }
     }
@@ -902,7 +1324,9 @@ bool Database::writeMetadata()
 {
     const fs::path path = this->getPathMetadata();
 
-    std::ofstream metadata_file(path, std::ofstream::out | std::ofstream::trunc);
+    // Other processes read the file while it is written, they see the old or the new one
+    const fs::path tmp = processTempPath(path);
+    std::ofstream metadata_file(tmp, std::ofstream::out | std::ofstream::trunc);
 
     try {
         metadata_file << "database_name: " << this->getDatabaseName() << "\n";
@@ -931,14 +1355,16 @@ bool Database::writeMetadata()
         metadata_file.close();
     }
 
-    return true;
+    return replaceFile(tmp, path);
 }
 
 bool Database::writeMetadata(const DatabaseMetadata& md )
 {
     const fs::path path = md.path_metadata;
 
-    std::ofstream metadata_file(path, std::ofstream::out | std::ofstream::trunc);
+    // Other processes read the file while it is written, they see the old or the new one
+    const fs::path tmp = processTempPath(path);
+    std::ofstream metadata_file(tmp, std::ofstream::out | std::ofstream::trunc);
 
     try {
         metadata_file << "database_name: " << md.database_name << "\n";
@@ -966,7 +1392,7 @@ bool Database::writeMetadata(const DatabaseMetadata& md )
         metadata_file.close();
     }
 
-    return true;
+    return replaceFile(tmp, path);
 }
 
 const DatabaseMetadata Database::readMetadata()
@@ -1011,7 +1437,7 @@ void Database::applyMetadata(const DatabaseMetadata& md )
 {
     this->setDatabaseName(md.database_name);
     this->setPath(md.path);
-    this->setPath(md.path_metadata);
+    this->setPathMetadata(md.path_metadata);
 }
 
 const DatabaseMetadata Database::getMetadata()
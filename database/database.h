@@ -9,14 +9,30 @@
 
 #include "include.h"
 #include "table.h"
+
+// When the deleted rows of a table are removed from its columns (SET COMPACTION), they always are at a checkpoint
+enum CompactionMode
+{
+    COMPACTION_MANUAL = 0,      // Only by COMPACT TABLE
+    COMPACTION_AUTO,            // By the DELETE statement that deletes enough rows (see Table::needsCompaction)
+    COMPACTION_BACKGROUND       // By the compactor thread of the client between statements (see compactor.h)
+};
+
 class Database
 {
 private:
     std::string database_name;                                      // Database Name
-    std::unordered_map<std::string, std::shared_ptr<Table>> tables; // Tables within the Database
+    std::unordered_map<std::string, std::shared_ptr<Table>, _NameHash, _NameEqual> tables; // Tables within the Database (by case-insensitive name)
     fs::path path;                                                  // The path to the database folder
     fs::path path_metadata;
     bool transaction_mode;
+    std::shared_ptr<WriteAheadLog> wal;                             // Log of the INSERT, UPDATE and DELETE statements
+    bool recovered;                                                 // The logs of exited processes have been replayed
+    bool adaptive;                                                  // Range filters crack INT and FLOAT columns (SET ADAPTIVE_INDEXING)
+    CompactionMode compaction;                                      // When deleted rows are removed from the columns (SET COMPACTION)
+
+    /** Checkpoints every table, called with the checkpoint lock held */
+    bool checkpointTables();
 
 public:
     Database();
@@ -25,6 +41,15 @@ public:
     
     bool createTable(std::string table_name, std::vector<std::pair<std::string, std::string>> columns);
     bool dropTable(const std::string& table_name);
+    /** Creates index 'index_name' on a column of a table, index names are unique within the database */
+    bool createIndex(const std::string& index_name, const std::string& table_name, const std::string& column_name, const IndexType type);
+
+    /** Drops the index of that name from the table holding it */
+    bool dropIndex(const std::string& index_name);
+
+    /** Returns the table holding an index, nullptr if no table has it */
+    std::shared_ptr<Table> indexTable(const std::string& index_name);
+
     bool addColumnsToTable(const std::string& table_name, std::vector<std::pair<std::string, std::string>> columns);
 
     bool queryTables(
@@ -51,6 +76,34 @@ public:
      * */
     bool printTableColumnInfo(const std::string& table_name);
 
+    /**
+     *  Print every table with its row count and whether it is cold, mapped or hot
+     * 
+     * @return bool (true if success)
+     * */
+    bool printTables();
+
+    /**
+     *  Print every index with its table, column and type
+     * 
+     * @return bool (true if success)
+     * */
+    bool printIndexes();
+
+    /**
+     *  Print the statistics of every column of every table
+     * 
+     * @return bool (true if success)
+     * */
+    bool printStats();
+
+    /** Turns adaptive indexing of the INT and FLOAT columns of every table on or off */
+    void setAdaptiveIndexing(const bool adaptive);
+    bool getAdaptiveIndexing() { return this->adaptive; }
+
+    void setCompaction(const CompactionMode mode) { this->compaction = mode; }
+    CompactionMode getCompaction() { return this->compaction; }
+
     /**  Get the name of the database
      * 
      * @return string 
@@ -85,14 +138,34 @@ public:
         const std::string& op
     );
 
+    /**  Sort-merge band join for the range operators (<, <=, >, >=)
+     *  Rows are streamed to the output as they are matched instead of being collected in a mapping.
+     *  'key' gives the ordering key of an element (e.g. the upper case form of strings).
+     *  A column with a B+tree index is read in index order instead of being sorted.
+     *  If 'full' is set, rows of table2 without a match are printed for outer joins. */
+    template <typename T, typename KeyFn>
+    bool bandJoin(
+        std::shared_ptr<Table> table1,
+        std::shared_ptr<Table> table2,
+        std::shared_ptr<Column<T>> column1,
+        std::shared_ptr<Column<T>> column2,
+        const std::string& op,
+        KeyFn key,
+        const bool full,
+        const bool inner
+    );
+
     bool printQuery(
-        std::shared_ptr<Table> table1, 
+        std::shared_ptr<Table> table1,
         std::shared_ptr<Table> table2,
         std::unordered_map<size_t, std::vector<size_t>> map1,
         std::unordered_map<size_t, std::vector<size_t>> map2,
         bool inner
     );
 
+    /**  Prints the column meta data of two joined tables */
+    void printQueryHeader(std::shared_ptr<Table> table1, std::shared_ptr<Table> table2);
+
     bool setTransaction(bool val) {
         this->transaction_mode = val;
         this->writeMetadata();
@@ -121,6 +194,25 @@ public:
         return this->path_metadata;
     }
 
+    std::shared_ptr<WriteAheadLog> getWal() { return this->wal; }
+
+    /** Writes every table changed since the last checkpoint to its files and empties the log */
+    bool checkpoint();
+
+    /** Reads the tables other processes checkpointed since they were read again (see Table::refresh),
+     *  before a statement runs */
+    bool refresh();
+
+    /** Checkpoints once the log has grown past its checkpoint size */
+    bool autoCheckpoint();
+
+    /** Replays the logs of processes that exited without a checkpoint, once after the database is loaded */
+    bool recover();
+
+    /** Replays every unlocked log of another process (see WriteAheadLog::claim) into the table files
+     *  and deletes it, called with the checkpoint lock held */
+    bool recoverLogs();
+
     // Write private variables to files system
     bool writeMetadata();
     bool writeMetadata(const DatabaseMetadata& md );
@@ -134,7 +226,7 @@ public:
     // Get metadata from memory
     const DatabaseMetadata getMetadata();
 
-    std::unordered_map<std::string, std::shared_ptr<Table>> getTables() {
+    const std::unordered_map<std::string, std::shared_ptr<Table>, _NameHash, _NameEqual>& getTables() {
         return this->tables;
     }
 };
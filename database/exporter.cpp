@@ -0,0 +1,448 @@
+/**
+ * File: exporter.cpp
+ * Author: Mark Minkoff
+ * Functionality: Function definitions for file exporter.h
+ *
+ * */
+
+#include "exporter.h"
+
+// Pointer to 'bytes' free bytes after the first 'size' bytes of an output buffer, it grows geometrically
+static inline char* _reserve(std::string& text, const size_t size, const size_t bytes)
+{
+    if (size + bytes > text.size()) text.resize(std::max(text.size() * 2, size + bytes));
+    return &text[size];
+}
+
+// ---------------------------
+// ---- CSV Values
+// ---------------------------
+// Every value is written after reserving the most bytes it can take (_csvBound)
+
+static inline size_t _csvBound(const int&) { return 11; }
+static inline size_t _csvBound(const float&) { return 32; }
+static inline size_t _csvBound(const char&) { return 4; }
+static inline size_t _csvBound(const std::string& value) { return 2 * value.size() + 2; }
+
+static inline char* _csvValue(char* out, const int value)
+{
+    return std::to_chars(out, out + 11, value).ptr;
+}
+
+static inline char* _csvValue(char* out, const float value)
+{
+    // Shortest text that reads back as the same float
+    return std::to_chars(out, out + 32, value).ptr;
+}
+
+static inline char* _csvValue(char* out, const char value)
+{
+    // An empty CHAR is an empty value
+    if (value == '\0') return out;
+    if (value != ',' && value != '"' && value != '\n' && value != '\r') { *out++ = value; return out; }
+
+    *out++ = '"';
+    *out++ = value;
+    if (value == '"') *out++ = '"';
+    *out++ = '"';
+    return out;
+}
+
+static inline char* _csvValue(char* out, const std::string& value)
+{
+    // Copied as is unless it holds a comma, a quote or a line break
+    bool quote = false;
+    for (const char c : value) quote |= c == ',' || c == '"' || c == '\n' || c == '\r';
+    if (!quote)
+    {
+        memcpy(out, value.data(), value.size());
+        return out + value.size();
+    }
+
+    // Quoted, the quotes inside the value are written twice
+    *out++ = '"';
+    for (const char c : value)
+    {
+        *out++ = c;
+        if (c == '"') *out++ = '"';
+    }
+    *out++ = '"';
+    return out;
+}
+
+// ---------------------------
+// ---- JSON Values
+// ---------------------------
+
+static inline size_t _jsonBound(const int&) { return 11; }
+static inline size_t _jsonBound(const float&) { return 32; }
+static inline size_t _jsonBound(const char&) { return 8; }
+static inline size_t _jsonBound(const std::string& value) { return 6 * value.size() + 2; }
+
+// Writes a character of a JSON string, escaped if it has to be
+static inline char* _jsonChar(char* out, const char c)
+{
+    static const char hex[] = "0123456789abcdef";
+    switch (c)
+    {
+        case '"': *out++ = '\\'; *out++ = '"'; return out;
+        case '\\': *out++ = '\\'; *out++ = '\\'; return out;
+        case '\n': *out++ = '\\'; *out++ = 'n'; return out;
+        case '\r': *out++ = '\\'; *out++ = 'r'; return out;
+        case '\t': *out++ = '\\'; *out++ = 't'; return out;
+    }
+    if ((unsigned char)c >= 0x20) { *out++ = c; return out; }
+
+    // Other control characters are written as \u00XX
+    memcpy(out, "\\u00", 4);
+    out[4] = hex[(unsigned char)c >> 4];
+    out[5] = hex[c & 15];
+    return out + 6;
+}
+
+static inline char* _jsonValue(char* out, const int value)
+{
+    return std::to_chars(out, out + 11, value).ptr;
+}
+
+static inline char* _jsonValue(char* out, const float value)
+{
+    // JSON has no infinity or NaN
+    if (!std::isfinite(value)) { memcpy(out, "null", 4); return out + 4; }
+    return std::to_chars(out, out + 32, value).ptr;
+}
+
+static inline char* _jsonValue(char* out, const char value)
+{
+    *out++ = '"';
+    if (value != '\0') out = _jsonChar(out, value);
+    *out++ = '"';
+    return out;
+}
+
+static inline char* _jsonValue(char* out, const std::string& value)
+{
+    *out++ = '"';
+    for (const char c : value) out = _jsonChar(out, c);
+    *out++ = '"';
+    return out;
+}
+
+// Appends the raw bytes of a value to an output buffer
+template <typename T>
+static inline void _appendRaw(std::string& text, size_t& size, const T& value)
+{
+    memcpy(_reserve(text, size, sizeof(T)), &value, sizeof(T));
+    size += sizeof(T);
+}
+
+TableExporter::TableExporter(std::shared_ptr<Table> table, const ExportFormat format) :
+    table(table),
+    format(format),
+    selection(nullptr),
+    row_count(0),
+    finished(false)
+{
+    // JSON objects name every value: {"column": value, "column": value}
+    if (format != EXPORT_JSONL) return;
+
+    for (auto& column : table->getMetaData())
+    {
+        std::string key(this->keys.empty() ? "{" : ",");
+        std::string name(_jsonBound(column.first), '\0');
+        name.resize(_jsonValue(&name[0], column.first) - &name[0]);
+        this->keys.push_back(key + name + ":");
+    }
+}
+
+bool TableExporter::write(const fs::path& path, const Predicate* where, const bool header, ExportStats& stats)
+{
+    // Map the column files if the table is cold, mapped columns are read in place
+    if (!this->table->load()) return false;
+
+    this->views = this->table->columnViews();
+    this->row_count = this->table->getRowCount();
+
+    // Only the selected rows are written, deleted rows stay in the columns until compaction
+    Bitmap rows;
+    this->selection = nullptr;
+    if (where)
+    {
+        if (!this->table->filterRows(*where, rows)) return false;
+        this->selection = &rows;
+    }
+    else if (this->table->deletedRowCount())
+    {
+        this->table->liveRows(rows);
+        this->selection = &rows;
+    }
+    stats.rows = this->selection ? this->selection->count() : this->row_count;
+
+    std::ofstream file(path, std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+    if (!file.is_open()) return false;
+
+    std::string text;
+    if (this->format == EXPORT_BINARY || header)
+    {
+        this->formatHeader(text, stats.rows);
+        file.write(text.data(), text.size());
+        stats.bytes += text.size();
+    }
+
+    const size_t workers = std::max<size_t>(1, std::min<size_t>(EXPORT_MAX_WORKERS, std::thread::hardware_concurrency()));
+    this->finished = false;
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < workers; ++i) threads.emplace_back(&TableExporter::formatLoop, this);
+
+    // Blocks in row order, at most two per worker are formatted ahead of the writes
+    std::deque<std::shared_ptr<Block>> blocks;
+    std::vector<std::string> spare;             // Output buffers of the written blocks
+    size_t next = 0;                            // First row of the next block
+    bool success = (bool)file;
+
+    while (true)
+    {
+        while (next < this->row_count && blocks.size() < 2 * workers)
+        {
+            std::shared_ptr<Block> block = std::make_shared<Block>();
+            block->first = next;
+            next += EXPORT_BLOCK_ROWS;
+
+            // Reuse the buffer of a written block
+            if (!spare.empty()) { block->text.swap(spare.back()); spare.pop_back(); }
+
+            blocks.push_back(block);
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->pending.push_back(block);
+            }
+            this->queued.notify_one();
+        }
+        if (blocks.empty()) break;
+
+        // Write the next block in row order once it is formatted
+        std::shared_ptr<Block> block = blocks.front();
+        blocks.pop_front();
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->formatted.wait(lock, [&block] { return block->formatted; });
+        }
+
+        // Stop queueing blocks if the file cannot be written, the blocks in flight are only waited for
+        if (success && block->size)
+        {
+            file.write(block->text.data(), block->size);
+            stats.bytes += block->size;
+            if (!file) {
+                success = false;
+                next = this->row_count;
+            }
+        }
+        spare.push_back(std::move(block->text));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->finished = true;
+    }
+    this->queued.notify_all();
+    for (auto& thread : threads) thread.join();
+
+    file.close();
+    if (success && file) return true;
+
+    // Do not leave part of the rows behind (in a regular file, the path may name a device)
+    std::error_code ec;
+    if (fs::is_regular_file(path, ec)) fs::remove(path, ec);
+    return false;
+}
+
+void TableExporter::formatHeader(std::string& text, const size_t rows)
+{
+    auto columns = this->table->getMetaData();
+
+    // Column names separated by commas
+    if (this->format != EXPORT_BINARY)
+    {
+        size_t size = 0;
+        for (size_t i = 0; i < columns.size(); ++i)
+        {
+            char* out = _reserve(text, size, _csvBound(columns[i].first) + 2);
+            if (i) *out++ = ',';
+            out = _csvValue(out, columns[i].first);
+            size = out - &text[0];
+        }
+        text.resize(size);
+        text += '\n';
+        return;
+    }
+
+    // ExportFileHeader, then the type, size and name of every column
+    ExportFileHeader file_header{};
+    memcpy(file_header.magic, "SQLEXPRT", 8);
+    file_header.version = STORAGE_VERSION;
+    file_header.column_count = (uint32_t)columns.size();
+    file_header.row_count = rows;
+
+    size_t size = 0;
+    _appendRaw(text, size, file_header);
+    for (size_t i = 0; i < columns.size(); ++i)
+    {
+        std::shared_ptr<Column<std::string>> varchar = this->table->selectColumnString(columns[i].first);
+
+        // The alternatives of ColumnElements are in StorageType order
+        _appendRaw(text, size, (uint32_t)this->views[i].index());
+        _appendRaw(text, size, (uint32_t)(varchar ? varchar->getCharMax() : 0));
+        _appendRaw(text, size, (uint32_t)columns[i].first.size());
+        memcpy(_reserve(text, size, columns[i].first.size()), columns[i].first.data(), columns[i].first.size());
+        size += columns[i].first.size();
+    }
+    text.resize(size);
+}
+
+void TableExporter::formatLoop()
+{
+    // Reused for every block formatted by this worker
+    std::vector<size_t> rows;
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (true)
+    {
+        this->queued.wait(lock, [this] { return !this->pending.empty() || this->finished; });
+        if (this->pending.empty()) return;
+
+        std::shared_ptr<Block> block = this->pending.front();
+        this->pending.pop_front();
+
+        lock.unlock();
+        this->formatBlock(*block, rows);
+        lock.lock();
+
+        block->formatted = true;
+        this->formatted.notify_all();
+    }
+}
+
+void TableExporter::formatBlock(Block& block, std::vector<size_t>& rows)
+{
+    const size_t first = block.first;
+    const size_t last = std::min(first + EXPORT_BLOCK_ROWS, this->row_count);
+
+    // Selected rows of the block, in row order
+    rows.clear();
+    if (this->selection)
+    {
+        const uint64_t* words = this->selection->data();
+        for (size_t w = first >> 6; w < (last + 63) >> 6; ++w)
+        {
+            uint64_t word = words[w];
+            while (word)
+            {
+                rows.push_back((w << 6) + __builtin_ctzll(word));
+                word &= word - 1;
+            }
+        }
+    }
+    else
+    {
+        rows.resize(last - first);
+        std::iota(rows.begin(), rows.end(), first);
+    }
+
+    block.size = 0;
+    if (rows.empty()) return;
+
+    std::string& text = block.text;
+    size_t size = 0;
+
+    if (this->format == EXPORT_BINARY)
+    {
+        /*  Row count, then every column of the block: fixed
+            width elements as they are stored (copied in one
+            piece without a selection), VARCHAR lengths then
+            the bytes of the values. **/
+        _appendRaw(text, size, (uint32_t)rows.size());
+        for (auto& view : this->views)
+        {
+            std::visit([&](auto& elements) {
+                typedef typename std::decay_t<decltype(elements)>::value_type T;
+                if constexpr (std::is_same<T, std::string>::value)
+                {
+                    for (size_t row : rows) _appendRaw(text, size, (uint32_t)elements[row].size());
+                    for (size_t row : rows)
+                    {
+                        memcpy(_reserve(text, size, elements[row].size()), elements[row].data(), elements[row].size());
+                        size += elements[row].size();
+                    }
+                }
+                else if (!this->selection)
+                {
+                    memcpy(_reserve(text, size, rows.size() * sizeof(T)), elements.data() + first, rows.size() * sizeof(T));
+                    size += rows.size() * sizeof(T);
+                }
+                else
+                {
+                    T* out = reinterpret_cast<T*>(_reserve(text, size, rows.size() * sizeof(T)));
+                    for (size_t row : rows) memcpy(out++, &elements[row], sizeof(T));
+                    size += rows.size() * sizeof(T);
+                }
+            }, view);
+        }
+        block.size = size;
+        return;
+    }
+
+    const size_t column_count = this->views.size();
+    const bool csv = this->format == EXPORT_CSV;
+
+    for (size_t row : rows)
+    {
+        for (size_t col_index = 0; col_index < column_count; ++col_index)
+        {
+            std::visit([&](auto& elements) {
+                const auto& value = elements[row];
+                if (csv)
+                {
+                    char* out = _reserve(text, size, _csvBound(value) + 3);
+                    char* start = out;
+                    if (col_index) *out++ = ',';
+                    out = _csvValue(out, value);
+
+                    // A line holding only an empty value would be an empty line, which is skipped when read
+                    if (column_count == 1 && out == start) { *out++ = '"'; *out++ = '"'; }
+                    size = out - &text[0];
+                }
+                else
+                {
+                    const std::string& key = this->keys[col_index];
+                    char* out = _reserve(text, size, key.size() + _jsonBound(value));
+                    memcpy(out, key.data(), key.size());
+                    size = _jsonValue(out + key.size(), value) - &text[0];
+                }
+            }, this->views[col_index]);
+        }
+
+        char* out = _reserve(text, size, 2);
+        if (!csv) *out++ = '}';
+        *out++ = '\n';
+        size = out - &text[0];
+    }
+    block.size = size;
+}
+
+bool exportFormat(const std::string& name, ExportFormat& format)
+{
+    const std::string upper = _toUpper(name);
+    if (upper == "CSV") format = EXPORT_CSV;
+    else if (upper == "BINARY") format = EXPORT_BINARY;
+    else if (upper == "JSONL") format = EXPORT_JSONL;
+    else return false;
+    return true;
+}
+
+const char* exportFormatName(const ExportFormat format)
+{
+    static const char* names[] = { "CSV", "BINARY", "JSONL" };
+    return names[format];
+}
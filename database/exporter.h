@@ -0,0 +1,113 @@
+/**
+ * File: exporter.h
+ * Author: Mark Minkoff
+ * Functionality: Function declarations for file exporter.cpp
+ * Streaming export of a table (COPY t TO 'file' [FORMAT ...] [WHERE ...]). The rows are read
+ * straight from the column storage (mapped columns are not copied into memory) in blocks of
+ * EXPORT_BLOCK_ROWS table rows. A pool of worker threads formats the blocks into reusable output
+ * buffers (std::to_chars for INT and FLOAT) and the buffers are written to the file in row
+ * order, one write per block, so the memory used is bounded by the blocks in flight whatever
+ * the size of the table.
+ *
+ *   CSV      One line per row, values separated by commas. A value holding a comma, a quote or a
+ *            line break is written in double quotes with its quotes written twice (RFC 4180),
+ *            so the file reads back with COPY t FROM. HEADER writes the column names first.
+ *   JSONL    One JSON object per row: {"column": value, ...}. CHAR and VARCHAR values are
+ *            strings, FLOAT values that are not finite are null.
+ *   BINARY   An ExportFileHeader, then every column as its StorageType, VARCHAR size, name
+ *            length and name (uint32, uint32, uint32, bytes), then blocks of rows: a uint32
+ *            row count and every column of the block one after the other. INT, FLOAT and CHAR
+ *            columns are their raw elements, VARCHAR columns the uint32 length of every value
+ *            followed by the bytes of the values. Numbers are little endian.
+ *
+ * */
+
+#ifndef EXPORTER_H_
+#define EXPORTER_H_
+
+#include "include.h"
+#include "table.h"
+#include "storage.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+const size_t EXPORT_BLOCK_ROWS = 1 << 16;     // Table rows formatted per block (a multiple of 64)
+const size_t EXPORT_MAX_WORKERS = 8;          // Formatting threads, at most one per hardware thread
+
+// Format of the exported file (COPY ... FORMAT)
+enum ExportFormat
+{
+    EXPORT_CSV = 0,
+    EXPORT_BINARY,
+    EXPORT_JSONL
+};
+
+typedef struct ExportFileHeader {
+    char magic[8];              // "SQLEXPRT"
+    uint32_t version;           // STORAGE_VERSION
+    uint32_t column_count;      // Number of column descriptions following the header
+    uint64_t row_count;         // Number of rows in the blocks
+    uint64_t reserved[5];
+} ExportFileHeader;
+
+static_assert(sizeof(ExportFileHeader) == 64, "ExportFileHeader must be 64 bytes");
+
+typedef struct ExportStats {
+    size_t rows = 0;            // Rows written to the file
+    uint64_t bytes = 0;         // Bytes written to the file
+} ExportStats;
+
+class TableExporter
+{
+private:
+    // Table rows [first, first + EXPORT_BLOCK_ROWS) and the bytes formatted from them
+    typedef struct Block {
+        size_t first = 0;
+        std::string text;           // Output buffer, reused by later blocks once written
+        size_t size = 0;            // Bytes of 'text' in use
+        bool formatted = false;
+    } Block;
+
+    std::shared_ptr<Table> table;
+    ExportFormat format;
+    std::vector<ColumnElements> views;      // Elements of every column (see Table::columnViews)
+    std::vector<std::string> keys;          // JSONL: the text before the value of every column
+    const Bitmap* selection;                // Rows to write, nullptr for every row
+    size_t row_count;                       // Rows of the table
+
+    std::mutex mutex;                       // Guards everything below
+    std::condition_variable queued;         // Wakes the workers
+    std::condition_variable formatted;      // Wakes the writer
+    std::deque<std::shared_ptr<Block>> pending;     // Blocks waiting for a worker
+    bool finished;                                  // Every block has been written, the workers exit
+
+    /** Worker thread: formats the pending blocks */
+    void formatLoop();
+
+    /** Formats the selected rows of a block, 'rows' is a buffer of the worker */
+    void formatBlock(Block& block, std::vector<size_t>& rows);
+
+    /** Writes the header of a binary file holding 'rows' rows, or the column names of a csv file */
+    void formatHeader(std::string& text, const size_t rows);
+
+public:
+    TableExporter(std::shared_ptr<Table> table, const ExportFormat format);
+
+    TableExporter(const TableExporter&) = delete;
+    TableExporter& operator=(const TableExporter&) = delete;
+
+    /** Writes the rows satisfying a resolved predicate (every row if nullptr, deleted rows never) to 'path',
+     *  after the column names for a csv file with 'header'. False if the file cannot be written. */
+    bool write(const fs::path& path, const Predicate* where, const bool header, ExportStats& stats);
+};
+
+/** Converts CSV, BINARY or JSONL to an export format, returns false if unknown */
+bool exportFormat(const std::string& name, ExportFormat& format);
+
+/** Name of an export format */
+const char* exportFormatName(const ExportFormat format);
+
+#endif // EXPORTER_H_
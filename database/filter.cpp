@@ -0,0 +1,358 @@
+/**
+ * File: filter.cpp
+ * Author: Mark Minkoff
+ * Functionality: Function definitions for file filter.h
+ *
+ * */
+
+#include "filter.h"
+
+#include <atomic>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define FILTER_X86
+#include <immintrin.h>
+#endif
+
+FilterOperator filterOperator(const std::string& op)
+{
+    if (op == "=")  return FILTER_EQ;
+    if (op == "!=") return FILTER_NE;
+    if (op == "<")  return FILTER_LT;
+    if (op == "<=") return FILTER_LE;
+    if (op == ">")  return FILTER_GT;
+    if (op == ">=") return FILTER_GE;
+    if (_toUpper(op) == "LIKE") return FILTER_LIKE;
+    return FILTER_INVALID;
+}
+
+// ---------------------------
+// ---- Scalar Kernels
+// ---------------------------
+
+/** Packs cmp(element) for n elements into bitmap words */
+template <typename T, typename Cmp>
+static void _packScalar(const T* data, const size_t n, uint64_t* out, Cmp cmp)
+{
+    for (size_t w = 0; (w << 6) < n; ++w)
+    {
+        const size_t begin = w << 6;
+        const size_t end = std::min(n, begin + 64);
+
+        uint64_t bits = 0;
+        for (size_t i = begin; i < end; ++i) bits |= (uint64_t)cmp(data[i]) << (i - begin);
+        out[w] = bits;
+    }
+}
+
+template <typename T>
+static void _filterScalar(const T* data, const size_t n, const FilterOperator op, const T val, uint64_t* out)
+{
+    switch (op)
+    {
+        case FILTER_EQ: _packScalar(data, n, out, [val](const T& e) { return e == val; }); break;
+        case FILTER_NE: _packScalar(data, n, out, [val](const T& e) { return e != val; }); break;
+        case FILTER_LT: _packScalar(data, n, out, [val](const T& e) { return e <  val; }); break;
+        case FILTER_LE: _packScalar(data, n, out, [val](const T& e) { return e <= val; }); break;
+        case FILTER_GT: _packScalar(data, n, out, [val](const T& e) { return e >  val; }); break;
+        case FILTER_GE: _packScalar(data, n, out, [val](const T& e) { return e >= val; }); break;
+        default: break;
+    }
+}
+
+static void _filterCharScalar(const char* data, const size_t n, const FilterOperator op, const char val, uint64_t* out)
+{
+    // Ordering is case insensitive, equality is not
+    const char up = _toUpper(val);
+    switch (op)
+    {
+        case FILTER_EQ: _packScalar(data, n, out, [val](const char& e) { return e == val; }); break;
+        case FILTER_NE: _packScalar(data, n, out, [val](const char& e) { return e != val; }); break;
+        case FILTER_LT: _packScalar(data, n, out, [up](const char& e) { return _toUpper(e) <  up; }); break;
+        case FILTER_LE: _packScalar(data, n, out, [up](const char& e) { return _toUpper(e) <= up; }); break;
+        case FILTER_GT: _packScalar(data, n, out, [up](const char& e) { return _toUpper(e) >  up; }); break;
+        case FILTER_GE: _packScalar(data, n, out, [up](const char& e) { return _toUpper(e) >= up; }); break;
+        default: break;
+    }
+}
+
+#ifdef FILTER_X86
+
+// ---------------------------
+// ---- AVX2 Kernels
+// ---------------------------
+// Each bitmap word covers 64 elements. NE, LE and GE are computed as the complements of EQ, GT and LT.
+
+__attribute__((target("avx2")))
+static void _filterIntAVX2(const int* data, const size_t n, const FilterOperator op, const int val, uint64_t* out)
+{
+    const __m256i v = _mm256_set1_epi32(val);
+    const bool negate = (op == FILTER_NE || op == FILTER_LE || op == FILTER_GE);
+    const size_t words = n >> 6;
+
+    for (size_t w = 0; w < words; ++w)
+    {
+        const int* block = data + (w << 6);
+        uint64_t bits = 0;
+        for (unsigned int k = 0; k < 8; ++k)
+        {
+            const __m256i a = _mm256_loadu_si256((const __m256i*)(block + (k << 3)));
+            __m256i m;
+            if (op == FILTER_EQ || op == FILTER_NE) m = _mm256_cmpeq_epi32(a, v);
+            else if (op == FILTER_GT || op == FILTER_LE) m = _mm256_cmpgt_epi32(a, v);
+            else m = _mm256_cmpgt_epi32(v, a);
+            bits |= (uint64_t)(uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(m)) << (k << 3);
+        }
+        out[w] = negate ? ~bits : bits;
+    }
+
+    _filterScalar(data + (words << 6), n - (words << 6), op, val, out + words);
+}
+
+// Float comparisons are not complemented so NaN behaves as in C++ (only != is true)
+template <int PREDICATE>
+__attribute__((target("avx2")))
+static void _filterFloatAVX2Predicate(const float* data, const size_t words, const float val, uint64_t* out)
+{
+    const __m256 v = _mm256_set1_ps(val);
+
+    for (size_t w = 0; w < words; ++w)
+    {
+        const float* block = data + (w << 6);
+        uint64_t bits = 0;
+        for (unsigned int k = 0; k < 8; ++k)
+        {
+            const __m256 m = _mm256_cmp_ps(_mm256_loadu_ps(block + (k << 3)), v, PREDICATE);
+            bits |= (uint64_t)(uint32_t)_mm256_movemask_ps(m) << (k << 3);
+        }
+        out[w] = bits;
+    }
+}
+
+__attribute__((target("avx2")))
+static void _filterFloatAVX2(const float* data, const size_t n, const FilterOperator op, const float val, uint64_t* out)
+{
+    const size_t words = n >> 6;
+
+    switch (op)
+    {
+        case FILTER_EQ: _filterFloatAVX2Predicate<_CMP_EQ_OQ>(data, words, val, out); break;
+        case FILTER_NE: _filterFloatAVX2Predicate<_CMP_NEQ_UQ>(data, words, val, out); break;
+        case FILTER_LT: _filterFloatAVX2Predicate<_CMP_LT_OQ>(data, words, val, out); break;
+        case FILTER_LE: _filterFloatAVX2Predicate<_CMP_LE_OQ>(data, words, val, out); break;
+        case FILTER_GT: _filterFloatAVX2Predicate<_CMP_GT_OQ>(data, words, val, out); break;
+        case FILTER_GE: _filterFloatAVX2Predicate<_CMP_GE_OQ>(data, words, val, out); break;
+        default: break;
+    }
+
+    _filterScalar(data + (words << 6), n - (words << 6), op, val, out + words);
+}
+
+__attribute__((target("avx2")))
+static void _filterCharAVX2(const char* data, const size_t n, const FilterOperator op, const char val, uint64_t* out)
+{
+    // Ordering operators compare upper case characters
+    const bool ordering = (op != FILTER_EQ && op != FILTER_NE);
+    const bool negate = (op == FILTER_NE || op == FILTER_LE || op == FILTER_GE);
+    const __m256i v = _mm256_set1_epi8(ordering ? _toUpper(val) : val);
+    const __m256i before_a = _mm256_set1_epi8('a' - 1);
+    const __m256i after_z = _mm256_set1_epi8('z' + 1);
+    const __m256i case_bit = _mm256_set1_epi8(32);
+    const size_t words = n >> 6;
+
+    for (size_t w = 0; w < words; ++w)
+    {
+        const char* block = data + (w << 6);
+        uint64_t bits = 0;
+        for (unsigned int k = 0; k < 2; ++k)
+        {
+            __m256i a = _mm256_loadu_si256((const __m256i*)(block + (k << 5)));
+            if (ordering)
+            {
+                // Subtract 32 from every character in 'a'..'z'
+                const __m256i lower = _mm256_and_si256(_mm256_cmpgt_epi8(a, before_a), _mm256_cmpgt_epi8(after_z, a));
+                a = _mm256_sub_epi8(a, _mm256_and_si256(lower, case_bit));
+            }
+            __m256i m;
+            if (!ordering) m = _mm256_cmpeq_epi8(a, v);
+            else if (op == FILTER_GT || op == FILTER_LE) m = _mm256_cmpgt_epi8(a, v);
+            else m = _mm256_cmpgt_epi8(v, a);
+            bits |= (uint64_t)(uint32_t)_mm256_movemask_epi8(m) << (k << 5);
+        }
+        out[w] = negate ? ~bits : bits;
+    }
+
+    _filterCharScalar(data + (words << 6), n - (words << 6), op, val, out + words);
+}
+
+// ---------------------------
+// ---- SSE4.2 Kernels
+// ---------------------------
+
+__attribute__((target("sse4.2")))
+static void _filterIntSSE(const int* data, const size_t n, const FilterOperator op, const int val, uint64_t* out)
+{
+    const __m128i v = _mm_set1_epi32(val);
+    const bool negate = (op == FILTER_NE || op == FILTER_LE || op == FILTER_GE);
+    const size_t words = n >> 6;
+
+    for (size_t w = 0; w < words; ++w)
+    {
+        const int* block = data + (w << 6);
+        uint64_t bits = 0;
+        for (unsigned int k = 0; k < 16; ++k)
+        {
+            const __m128i a = _mm_loadu_si128((const __m128i*)(block + (k << 2)));
+            __m128i m;
+            if (op == FILTER_EQ || op == FILTER_NE) m = _mm_cmpeq_epi32(a, v);
+            else if (op == FILTER_GT || op == FILTER_LE) m = _mm_cmpgt_epi32(a, v);
+            else m = _mm_cmpgt_epi32(v, a);
+            bits |= (uint64_t)(uint32_t)_mm_movemask_ps(_mm_castsi128_ps(m)) << (k << 2);
+        }
+        out[w] = negate ? ~bits : bits;
+    }
+
+    _filterScalar(data + (words << 6), n - (words << 6), op, val, out + words);
+}
+
+__attribute__((target("sse4.2")))
+static void _filterFloatSSE(const float* data, const size_t n, const FilterOperator op, const float val, uint64_t* out)
+{
+    const __m128 v = _mm_set1_ps(val);
+    const size_t words = n >> 6;
+
+    for (size_t w = 0; w < words; ++w)
+    {
+        const float* block = data + (w << 6);
+        uint64_t bits = 0;
+        for (unsigned int k = 0; k < 16; ++k)
+        {
+            const __m128 a = _mm_loadu_ps(block + (k << 2));
+            __m128 m;
+            switch (op)
+            {
+                case FILTER_EQ: m = _mm_cmpeq_ps(a, v); break;
+                case FILTER_NE: m = _mm_cmpneq_ps(a, v); break;
+                case FILTER_LT: m = _mm_cmplt_ps(a, v); break;
+                case FILTER_LE: m = _mm_cmple_ps(a, v); break;
+                case FILTER_GT: m = _mm_cmpgt_ps(a, v); break;
+                default:        m = _mm_cmpge_ps(a, v); break;
+            }
+            bits |= (uint64_t)(uint32_t)_mm_movemask_ps(m) << (k << 2);
+        }
+        out[w] = bits;
+    }
+
+    _filterScalar(data + (words << 6), n - (words << 6), op, val, out + words);
+}
+
+__attribute__((target("sse4.2")))
+static void _filterCharSSE(const char* data, const size_t n, const FilterOperator op, const char val, uint64_t* out)
+{
+    const bool ordering = (op != FILTER_EQ && op != FILTER_NE);
+    const bool negate = (op == FILTER_NE || op == FILTER_LE || op == FILTER_GE);
+    const __m128i v = _mm_set1_epi8(ordering ? _toUpper(val) : val);
+    const __m128i before_a = _mm_set1_epi8('a' - 1);
+    const __m128i after_z = _mm_set1_epi8('z' + 1);
+    const __m128i case_bit = _mm_set1_epi8(32);
+    const size_t words = n >> 6;
+
+    for (size_t w = 0; w < words; ++w)
+    {
+        const char* block = data + (w << 6);
+        uint64_t bits = 0;
+        for (unsigned int k = 0; k < 4; ++k)
+        {
+            __m128i a = _mm_loadu_si128((const __m128i*)(block + (k << 4)));
+            if (ordering)
+            {
+                const __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(a, before_a), _mm_cmpgt_epi8(after_z, a));
+                a = _mm_sub_epi8(a, _mm_and_si128(lower, case_bit));
+            }
+            __m128i m;
+            if (!ordering) m = _mm_cmpeq_epi8(a, v);
+            else if (op == FILTER_GT || op == FILTER_LE) m = _mm_cmpgt_epi8(a, v);
+            else m = _mm_cmpgt_epi8(v, a);
+            bits |= (uint64_t)(uint32_t)_mm_movemask_epi8(m) << (k << 4);
+        }
+        out[w] = negate ? ~bits : bits;
+    }
+
+    _filterCharScalar(data + (words << 6), n - (words << 6), op, val, out + words);
+}
+
+#endif // FILTER_X86
+
+// ---------------------------
+// ---- Runtime Dispatch
+// ---------------------------
+
+// Best instruction set of the cpu
+static FilterKernel _cpuKernel()
+{
+    static const FilterKernel kernel = []() -> FilterKernel
+    {
+#ifdef FILTER_X86
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return FILTER_AVX2;
+        if (__builtin_cpu_supports("sse4.2")) return FILTER_SSE42;
+#endif
+        return FILTER_SCALAR;
+    }();
+    return kernel;
+}
+
+// Instruction set of the kernels, the best one of the cpu unless setFilterKernel chose a slower one
+static std::atomic<unsigned int> _filter_kernel(_cpuKernel());
+
+static inline unsigned int _filterISA() { return _filter_kernel.load(std::memory_order_relaxed); }
+
+void filterInt(const int* data, const size_t n, const FilterOperator op, const int val, uint64_t* out)
+{
+    // LIKE only applies to VARCHAR, it matches nothing here
+    if (op == FILTER_INVALID || op == FILTER_LIKE) return;
+#ifdef FILTER_X86
+    if (_filterISA() == FILTER_AVX2) return _filterIntAVX2(data, n, op, val, out);
+    if (_filterISA() == FILTER_SSE42) return _filterIntSSE(data, n, op, val, out);
+#endif
+    _filterScalar(data, n, op, val, out);
+}
+
+void filterFloat(const float* data, const size_t n, const FilterOperator op, const float val, uint64_t* out)
+{
+    // LIKE only applies to VARCHAR, it matches nothing here
+    if (op == FILTER_INVALID || op == FILTER_LIKE) return;
+#ifdef FILTER_X86
+    if (_filterISA() == FILTER_AVX2) return _filterFloatAVX2(data, n, op, val, out);
+    if (_filterISA() == FILTER_SSE42) return _filterFloatSSE(data, n, op, val, out);
+#endif
+    _filterScalar(data, n, op, val, out);
+}
+
+void filterChar(const char* data, const size_t n, const FilterOperator op, const char val, uint64_t* out)
+{
+    // LIKE only applies to VARCHAR, it matches nothing here
+    if (op == FILTER_INVALID || op == FILTER_LIKE) return;
+#ifdef FILTER_X86
+    if (_filterISA() == FILTER_AVX2) return _filterCharAVX2(data, n, op, val, out);
+    if (_filterISA() == FILTER_SSE42) return _filterCharSSE(data, n, op, val, out);
+#endif
+    _filterCharScalar(data, n, op, val, out);
+}
+
+const char* filterKernelName()
+{
+    switch (_filterISA())
+    {
+        case FILTER_AVX2: return "avx2";
+        case FILTER_SSE42: return "sse4.2";
+        default: return "scalar";
+    }
+}
+
+FilterKernel setFilterKernel(const FilterKernel kernel)
+{
+    const FilterKernel selected = std::min(kernel, _cpuKernel());
+    _filter_kernel.store(selected, std::memory_order_relaxed);
+    return selected;
+}
@@ -0,0 +1,57 @@
+/**
+ * File: filter.h
+ * Author: Mark Minkoff
+ * Functionality: Function declarations for file filter.cpp
+ * Vectorized comparison kernels used by Column<T>::filterElements.
+ * Each kernel compares n elements against a value and writes one bit per
+ * element into 'out' (ceil(n / 64) words, bit i of word w is element w * 64 + i).
+ * AVX2 and SSE4.2 kernels are selected at runtime, with a portable scalar fallback.
+ *
+ * */
+
+#ifndef FILTER_H_
+#define FILTER_H_
+
+#include "include.h"
+
+// Operators understood by the filter kernels
+enum FilterOperator
+{
+    FILTER_EQ = 0,  // =
+    FILTER_NE,      // !=
+    FILTER_LT,      // <
+    FILTER_LE,      // <=
+    FILTER_GT,      // >
+    FILTER_GE,      // >=
+    FILTER_LIKE,    // LIKE, VARCHAR only: case insensitive, a trailing % matches any suffix
+    FILTER_INVALID
+};
+
+// Instruction sets of the filter kernels
+enum FilterKernel
+{
+    FILTER_SCALAR = 0,
+    FILTER_SSE42,
+    FILTER_AVX2
+};
+
+/** Converts an SQL operator to a filter operator (FILTER_INVALID if unknown) */
+FilterOperator filterOperator(const std::string& op);
+
+/** Compares INT elements with 'val' */
+void filterInt(const int* data, const size_t n, const FilterOperator op, const int val, uint64_t* out);
+
+/** Compares FLOAT elements with 'val' */
+void filterFloat(const float* data, const size_t n, const FilterOperator op, const float val, uint64_t* out);
+
+/** Compares CHAR elements with 'val'. Ordering operators compare the upper case form of both sides. */
+void filterChar(const char* data, const size_t n, const FilterOperator op, const char val, uint64_t* out);
+
+/** Name of the instruction set the kernels run on ("avx2", "sse4.2" or "scalar") */
+const char* filterKernelName();
+
+/** Runs the kernels on 'kernel' or on the best instruction set of the cpu if it does not support it,
+ *  returns the instruction set selected. Used to compare the kernels (see bench/filter_bench.cpp). */
+FilterKernel setFilterKernel(const FilterKernel kernel);
+
+#endif // FILTER_H_
@@ -10,17 +10,22 @@
 #define INCLUDE_H_
 
 #include <algorithm>
+#include <charconv>
 #include <cmath>
 #include <ctype.h>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <iterator>
 #include <iostream>
+#include <list>
 #include <memory>
 #include <numeric>
 #include <map>
 #include <queue>
 #include <random>
-#include <regex>
 #include <sstream>
 #include <string>
 #include <stack>
@@ -147,6 +152,29 @@ static std::string _trim(std::string source)
     return _trimEnd(_trimStart(source));
 }
 
+/** Replaces every run of spaces and tabs outside of quoted strings with a single space */
+static std::string _collapseSpaces(const std::string& source)
+{
+    std::string res;
+    res.reserve(source.size());
+
+    // The quote character of the string being copied, 0 outside of strings
+    char quote = 0;
+    for (const char& c : source)
+    {
+        if (quote) { if (c == quote) quote = 0; }
+        else if (c == '\'' || c == '"') quote = c;
+        else if (c == ' ' || c == '\t')
+        {
+            if (!res.empty() && res.back() == ' ') continue;
+            res += ' ';
+            continue;
+        }
+        res += c;
+    }
+    return res;
+}
+
 /** Checks if an operator is valid */
 static bool _isValidOperator(const std::string& op)
 {
@@ -158,11 +186,27 @@ static bool _isValidOperator(const std::string& op)
         op == "<"  || 
         op == "<=" || 
         op == ">"  || 
-        op == ">="
+        op == ">=" ||
+        _toUpper(op) == "LIKE"
     ) return true;
     return false;
 }
 
+/** Splits a LIKE pattern into the upper case text it matches. Only a trailing % is a wildcard:
+ *  returns true if the pattern matches every string starting with 'text', false if it matches 'text' whole. */
+static bool _likePattern(const std::string& pattern, std::string& text)
+{
+    const bool prefix = !pattern.empty() && pattern.back() == '%';
+    text = _toUpper(prefix ? pattern.substr(0, pattern.size() - 1) : pattern);
+    return prefix;
+}
+
+/** Checks if an operator is one of the ordering operators (<, <=, >, >=) */
+static bool _isRangeOperator(const std::string& op)
+{
+    return op == "<" || op == "<=" || op == ">" || op == ">=";
+}
+
 // Converts a character to uppercase
 static char _toUpper(const char& c)
 {
@@ -175,6 +219,35 @@ static char _toUpper(const char& c)
     return res;
 }
 
+/** Case-insensitive hash of a table or column name (hashes the upper case characters
+ *  without building an upper case copy) */
+struct _NameHash
+{
+    size_t operator()(const std::string& name) const
+    {
+        // FNV-1a
+        size_t hash = 14695981039346656037ULL;
+        for (const char& c : name) {
+            hash ^= (unsigned char)_toUpper(c);
+            hash *= 1099511628211ULL;
+        }
+        return hash;
+    }
+};
+
+/** Case-insensitive equality of two table or column names */
+struct _NameEqual
+{
+    bool operator()(const std::string& a, const std::string& b) const
+    {
+        if (a.size() != b.size()) return false;
+        for (size_t i = 0; i < a.size(); ++i) {
+            if (_toUpper(a[i]) != _toUpper(b[i])) return false;
+        }
+        return true;
+    }
+};
+
 /**  * Split a string by a delimiter and return a vector of strings
  * @param string The string being split
  * @param char The delimiter to split by
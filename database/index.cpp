@@ -0,0 +1,1312 @@
+/**
+ * File: index.cpp
+ * Author: Mark Minkoff
+ * Functionality: Function definitions for file index.h
+ *
+ * */
+
+#include "index.h"
+
+static const char INDEX_MAGIC[8] = {'S', 'Q', 'L', 'I', 'N', 'D', 'E', 'X'};
+static const uint32_t INDEX_VERSION = 1;
+
+// Smallest bucket array of a hash index
+static const size_t HASH_MIN_BUCKETS = 16;
+
+// Finalizer of splitmix64, spreads the bits of a key over the whole hash
+static uint64_t _mix(uint64_t x)
+{
+    x ^= x >> 30; x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27; x *= 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Hashes are written to the index files, so they must not depend on the standard library
+static uint64_t _hashKey(const int& key) { return _mix((uint32_t)key); }
+static uint64_t _hashKey(const float& key) { uint32_t bits; std::memcpy(&bits, &key, sizeof(bits)); return _mix(bits); }
+static uint64_t _hashKey(const char& key) { return _mix((uint8_t)key); }
+static uint64_t _hashKey(const std::string& key)
+{
+    // FNV-1a
+    uint64_t hash = 14695981039346656037ULL;
+    for (const char& c : key) {
+        hash ^= (uint8_t)c;
+        hash *= 1099511628211ULL;
+    }
+    return _mix(hash);
+}
+
+// Storage type of the indexed column (see storage.h)
+template <class T> static uint32_t _dataType();
+template <> uint32_t _dataType<int>()         { return 0; }
+template <> uint32_t _dataType<float>()       { return 1; }
+template <> uint32_t _dataType<char>()        { return 2; }
+template <> uint32_t _dataType<std::string>() { return 3; }
+
+// Header of an index file
+static IndexFileHeader _indexHeader(const IndexType type, const uint32_t data_type, const uint64_t rows, const uint64_t checkpoint_lsn, const uint64_t slots, const uint64_t keys)
+{
+    IndexFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+    header.version = INDEX_VERSION;
+    header.index_type = type;
+    header.data_type = data_type;
+    header.row_count = rows;
+    header.checkpoint_lsn = checkpoint_lsn;
+    header.slot_count = slots;
+    header.key_count = keys;
+    return header;
+}
+
+// Reads the header of an index file, false unless it was written at the checkpoint of the table files
+static bool _readIndexHeader(std::ifstream& file, const IndexType type, const uint32_t data_type, const size_t rows, const uint64_t checkpoint_lsn, IndexFileHeader& header)
+{
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+
+    return std::memcmp(header.magic, INDEX_MAGIC, sizeof(header.magic)) == 0 && header.version == INDEX_VERSION &&
+        header.index_type == (uint32_t)type && header.data_type == data_type &&
+        header.row_count == rows && header.checkpoint_lsn == checkpoint_lsn;
+}
+
+// Closes an index file written to 'tmp' and moves it over 'path'
+static bool _replaceIndexFile(std::ofstream& file, const fs::path& tmp, const fs::path& path)
+{
+    file.close();
+    if (!file) { std::cout << "-- !Failed to write " << tmp.string() << "\n"; return false; }
+
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec) { std::cout << "-- !Failed to replace " << path.string() << ": " << ec.message() << "\n"; return false; }
+    return true;
+}
+
+template <class T>
+size_t HashIndex<T>::find(const ColumnView<T>& elements, const uint64_t hash, const T& key) const
+{
+    if (this->buckets.empty()) return 0;
+
+    const size_t mask = this->buckets.size() - 1;
+    for (size_t position = hash & mask; ; position = (position + 1) & mask)
+    {
+        const Bucket& bucket = this->buckets[position];
+        if (bucket.head == INDEX_NO_ROW) return this->buckets.size();
+        if (bucket.hash == hash && elements[bucket.head] == key) return position;
+    }
+}
+
+template <class T>
+void HashIndex<T>::grow()
+{
+    std::vector<Bucket> old = std::move(this->buckets);
+    this->buckets.assign(std::max(HASH_MIN_BUCKETS, old.size() * 2), Bucket{ 0, INDEX_NO_ROW, 0 });
+
+    // Keys are distinct, every bucket goes to the first free slot of its probe sequence
+    const size_t mask = this->buckets.size() - 1;
+    for (const Bucket& bucket : old)
+    {
+        if (bucket.head == INDEX_NO_ROW) continue;
+
+        size_t position = bucket.hash & mask;
+        while (this->buckets[position].head != INDEX_NO_ROW) position = (position + 1) & mask;
+        this->buckets[position] = bucket;
+    }
+}
+
+template <class T>
+void HashIndex<T>::removeBucket(size_t position)
+{
+    const size_t mask = this->buckets.size() - 1;
+
+    // Move later buckets of the probe run into the hole unless their home slot lies after it
+    size_t hole = position;
+    for (size_t i = (position + 1) & mask; this->buckets[i].head != INDEX_NO_ROW; i = (i + 1) & mask)
+    {
+        const size_t home = this->buckets[i].hash & mask;
+        const bool reachable = (hole <= i) ? (hole < home && home <= i) : (hole < home || home <= i);
+        if (!reachable) {
+            this->buckets[hole] = this->buckets[i];
+            hole = i;
+        }
+    }
+
+    this->buckets[hole] = Bucket{ 0, INDEX_NO_ROW, 0 };
+    this->keys--;
+}
+
+template <class T>
+void HashIndex<T>::build(const ColumnView<T>& elements)
+{
+    this->buckets.clear();
+    this->keys = 0;
+    this->next.assign(elements.size(), INDEX_NO_ROW);
+    this->prev.assign(elements.size(), INDEX_NO_ROW);
+
+    for (size_t row = 0; row < elements.size(); ++row) this->insert(elements, row);
+}
+
+template <class T>
+void HashIndex<T>::insert(const ColumnView<T>& elements, const size_t row)
+{
+    if (row >= this->next.size()) {
+        this->next.resize(row + 1, INDEX_NO_ROW);
+        this->prev.resize(row + 1, INDEX_NO_ROW);
+    }
+
+    // Keep the table at most half full
+    if ((this->keys + 1) * 2 > this->buckets.size()) this->grow();
+
+    const T& key = elements[row];
+    const uint64_t hash = _hashKey(key);
+    const size_t mask = this->buckets.size() - 1;
+
+    size_t position = hash & mask;
+    while (true)
+    {
+        Bucket& bucket = this->buckets[position];
+
+        // First row with this key
+        if (bucket.head == INDEX_NO_ROW) {
+            bucket = Bucket{ hash, (uint32_t)row, 1 };
+            this->next[row] = this->prev[row] = INDEX_NO_ROW;
+            this->keys++;
+            return;
+        }
+
+        // Link the row in front of the rows holding the same key
+        if (bucket.hash == hash && elements[bucket.head] == key) {
+            this->next[row] = bucket.head;
+            this->prev[row] = INDEX_NO_ROW;
+            this->prev[bucket.head] = (uint32_t)row;
+            bucket.head = (uint32_t)row;
+            bucket.count++;
+            return;
+        }
+
+        position = (position + 1) & mask;
+    }
+}
+
+template <class T>
+void HashIndex<T>::remove(const ColumnView<T>& elements, const size_t row)
+{
+    if (row >= this->next.size()) return;
+
+    const size_t position = this->find(elements, _hashKey(elements[row]), elements[row]);
+    if (position >= this->buckets.size()) return;
+
+    // Unlink the row from the chain of its key
+    Bucket& bucket = this->buckets[position];
+    const uint32_t before = this->prev[row], after = this->next[row];
+    if (before != INDEX_NO_ROW) this->next[before] = after;
+    else bucket.head = after;
+    if (after != INDEX_NO_ROW) this->prev[after] = before;
+
+    this->next[row] = this->prev[row] = INDEX_NO_ROW;
+    bucket.count--;
+
+    if (bucket.head == INDEX_NO_ROW) this->removeBucket(position);
+}
+
+template <class T>
+void HashIndex<T>::eraseRows(const ColumnView<T>& elements, const Bitmap& rows)
+{
+    // Unlink the deleted rows while their keys are still in the column
+    rows.forEach([&](size_t row) { this->remove(elements, row); });
+
+    // New number of every remaining row: its position minus the rows deleted before it
+    std::vector<uint32_t> renumber(this->next.size(), INDEX_NO_ROW);
+    size_t removed = 0;
+    for (size_t row = 0; row < this->next.size(); ++row)
+    {
+        if (row < rows.size() && rows.test(row)) ++removed;
+        else renumber[row] = (uint32_t)(row - removed);
+    }
+
+    auto renumbered = [&](const uint32_t row) { return row == INDEX_NO_ROW ? INDEX_NO_ROW : renumber[row]; };
+
+    // Compact the chains in place, a row only ever moves down
+    for (size_t row = 0; row < this->next.size(); ++row)
+    {
+        if (renumber[row] == INDEX_NO_ROW) continue;
+        this->next[renumber[row]] = renumbered(this->next[row]);
+        this->prev[renumber[row]] = renumbered(this->prev[row]);
+    }
+    this->next.resize(this->next.size() - removed);
+    this->prev.resize(this->prev.size() - removed);
+
+    for (Bucket& bucket : this->buckets) {
+        if (bucket.head != INDEX_NO_ROW) bucket.head = renumber[bucket.head];
+    }
+}
+
+template <class T>
+void HashIndex<T>::lookup(const ColumnView<T>& elements, const FilterOperator op, const T& val, Bitmap& res) const
+{
+    if (op != FILTER_EQ) return;
+
+    const size_t position = this->find(elements, _hashKey(val), val);
+    if (position >= this->buckets.size()) return;
+
+    for (uint32_t row = this->buckets[position].head; row != INDEX_NO_ROW; row = this->next[row]) res.set(row);
+}
+
+template <class T>
+bool HashIndex<T>::write(const fs::path& path, const uint64_t checkpoint_lsn) const
+{
+    fs::path tmp = path; tmp += ".tmp";
+    std::ofstream file(tmp, std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+    if (!file.is_open()) { std::cout << "-- !Failed to open " << tmp.string() << "\n"; return false; }
+
+    const IndexFileHeader header = _indexHeader(INDEX_HASH, _dataType<T>(), this->next.size(), checkpoint_lsn, this->buckets.size(), this->keys);
+
+    // Header, buckets, next chain, previous chain
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(this->buckets.data()), this->buckets.size() * sizeof(Bucket));
+    file.write(reinterpret_cast<const char*>(this->next.data()), this->next.size() * sizeof(uint32_t));
+    file.write(reinterpret_cast<const char*>(this->prev.data()), this->prev.size() * sizeof(uint32_t));
+
+    return _replaceIndexFile(file, tmp, path);
+}
+
+template <class T>
+bool HashIndex<T>::read(const fs::path& path, const size_t rows, const uint64_t checkpoint_lsn)
+{
+    std::ifstream file(path, std::ifstream::in | std::ifstream::binary);
+    if (!file.is_open()) return false;
+
+    // Only an index written at the checkpoint of the table files can be used
+    IndexFileHeader header;
+    if (!_readIndexHeader(file, INDEX_HASH, _dataType<T>(), rows, checkpoint_lsn, header)) return false;
+
+    // The bucket array must be a power of two
+    if (header.slot_count & (header.slot_count - 1)) return false;
+
+    std::vector<Bucket> buckets(header.slot_count);
+    std::vector<uint32_t> next(rows), prev(rows);
+    file.read(reinterpret_cast<char*>(buckets.data()), buckets.size() * sizeof(Bucket));
+    file.read(reinterpret_cast<char*>(next.data()), next.size() * sizeof(uint32_t));
+    file.read(reinterpret_cast<char*>(prev.data()), prev.size() * sizeof(uint32_t));
+    if (!file) return false;
+
+    this->buckets = std::move(buckets);
+    this->next = std::move(next);
+    this->prev = std::move(prev);
+    this->keys = header.key_count;
+    return true;
+}
+
+// Order of B+tree keys. CHAR keys are ordered by their upper case form like the ordering
+// operators, NaN sorts after every other FLOAT.
+static bool _keyLess(const int& a, const int& b) { return a < b; }
+static bool _keyLess(const float& a, const float& b) { return a < b || (a == a && b != b); }
+static bool _keyLess(const char& a, const char& b) { return _toUpper(a) < _toUpper(b); }
+
+// Order of B+tree entries: key, then row
+template <class T>
+static bool _entryLess(const T& a, const uint32_t row_a, const T& b, const uint32_t row_b)
+{
+    if (_keyLess(a, b)) return true;
+    if (_keyLess(b, a)) return false;
+    return row_a < row_b;
+}
+
+// The comparison the filter kernels make between an element and the value (see filter.h)
+template <class T>
+static bool _keyMatches(const FilterOperator op, const T& e, const T& val)
+{
+    switch (op)
+    {
+        case FILTER_EQ: return e == val;
+        case FILTER_LT: return e <  val;
+        case FILTER_LE: return e <= val;
+        case FILTER_GT: return e >  val;
+        case FILTER_GE: return e >= val;
+        default: return false;
+    }
+}
+
+static bool _keyMatches(const FilterOperator op, const char& e, const char& val)
+{
+    // Ordering is case insensitive, equality is not
+    if (op == FILTER_EQ) return e == val;
+    return _keyMatches<char>(op, _toUpper(e), _toUpper(val));
+}
+
+template <class T>
+uint32_t BTreeIndex<T>::findLeaf(const T& key, const uint32_t row, std::vector<std::pair<uint32_t, uint32_t>>* path) const
+{
+    uint32_t node = this->root;
+    for (uint32_t level = this->height; level > 0; --level)
+    {
+        const Inner& inner = this->inners[node];
+
+        // Follow the child after the last separator not greater than the entry
+        uint32_t lo = 0, hi = inner.count;
+        while (lo < hi)
+        {
+            const uint32_t mid = (lo + hi) / 2;
+            if (_entryLess(key, row, inner.keys[mid], inner.rows[mid])) hi = mid;
+            else lo = mid + 1;
+        }
+
+        if (path) path->emplace_back(node, lo);
+        node = inner.children[lo];
+    }
+    return node;
+}
+
+template <class T>
+size_t BTreeIndex<T>::leafPosition(const Leaf& leaf, const T& key, const uint32_t row) const
+{
+    size_t lo = 0, hi = leaf.count;
+    while (lo < hi)
+    {
+        const size_t mid = (lo + hi) / 2;
+        if (_entryLess(leaf.keys[mid], leaf.rows[mid], key, row)) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+template <class T>
+void BTreeIndex<T>::insertSeparator(std::vector<std::pair<uint32_t, uint32_t>>& path, T key, uint32_t row, uint32_t child)
+{
+    while (!path.empty())
+    {
+        const uint32_t node = path.back().first;
+        const uint32_t position = path.back().second;
+        path.pop_back();
+
+        Inner* inner = &this->inners[node];
+
+        // The separator goes before 'position', the new child right after the child that split
+        if (inner->count < INNER_SLOTS)
+        {
+            for (uint32_t i = inner->count; i > position; --i) {
+                inner->keys[i] = inner->keys[i - 1];
+                inner->rows[i] = inner->rows[i - 1];
+                inner->children[i + 1] = inner->children[i];
+            }
+            inner->keys[position] = key;
+            inner->rows[position] = row;
+            inner->children[position + 1] = child;
+            inner->count++;
+            return;
+        }
+
+        // Split the full node, the middle separator moves up to the parent
+        T keys[INNER_SLOTS + 1];
+        uint32_t rows[INNER_SLOTS + 1], children[INNER_SLOTS + 2];
+        for (uint32_t i = 0, j = 0; i <= INNER_SLOTS; ++i)
+        {
+            if (i == position) { keys[i] = key; rows[i] = row; continue; }
+            keys[i] = inner->keys[j];
+            rows[i] = inner->rows[j++];
+        }
+        for (uint32_t i = 0, j = 0; i <= INNER_SLOTS + 1; ++i) {
+            children[i] = (i == position + 1) ? child : inner->children[j++];
+        }
+
+        const uint32_t right_node = (uint32_t)this->inners.size();
+        this->inners.emplace_back();
+        inner = &this->inners[node];
+        Inner& right = this->inners[right_node];
+
+        const size_t split = (INNER_SLOTS + 1) / 2;
+        inner->count = split;
+        std::copy(keys, keys + split, inner->keys);
+        std::copy(rows, rows + split, inner->rows);
+        std::copy(children, children + split + 1, inner->children);
+
+        right.count = INNER_SLOTS - split;
+        std::copy(keys + split + 1, keys + INNER_SLOTS + 1, right.keys);
+        std::copy(rows + split + 1, rows + INNER_SLOTS + 1, right.rows);
+        std::copy(children + split + 1, children + INNER_SLOTS + 2, right.children);
+
+        key = keys[split];
+        row = rows[split];
+        child = right_node;
+    }
+
+    // The root split, a new root holds both halves
+    const uint32_t new_root = (uint32_t)this->inners.size();
+    this->inners.emplace_back();
+    Inner& top = this->inners[new_root];
+    top.keys[0] = key;
+    top.rows[0] = row;
+    top.children[0] = this->root;
+    top.children[1] = child;
+    top.count = 1;
+
+    this->root = new_root;
+    this->height++;
+}
+
+template <class T>
+void BTreeIndex<T>::bulkLoad(const std::vector<std::pair<T, uint32_t>>& sorted)
+{
+    this->leaves.clear();
+    this->inners.clear();
+    this->entries = sorted.size();
+    this->height = 0;
+    this->first = 0;
+
+    // Fill the leaves in order, an empty tree is one empty leaf
+    const size_t leaf_count = std::max<size_t>(1, (sorted.size() + LEAF_SLOTS - 1) / LEAF_SLOTS);
+    this->leaves.resize(leaf_count);
+    for (size_t i = 0; i < sorted.size(); ++i)
+    {
+        Leaf& leaf = this->leaves[i / LEAF_SLOTS];
+        leaf.keys[leaf.count] = sorted[i].first;
+        leaf.rows[leaf.count++] = sorted[i].second;
+    }
+    for (size_t i = 0; i < leaf_count; ++i) this->leaves[i].next = (i + 1 < leaf_count) ? (uint32_t)(i + 1) : INDEX_NO_ROW;
+
+    // Smallest entry under every node of the current level, the separators of the level above
+    std::vector<uint32_t> level(leaf_count);
+    std::vector<std::pair<T, uint32_t>> smallest(leaf_count);
+    for (size_t i = 0; i < leaf_count; ++i)
+    {
+        level[i] = (uint32_t)i;
+        if (i * LEAF_SLOTS < sorted.size()) smallest[i] = sorted[i * LEAF_SLOTS];
+    }
+
+    // Build the inner levels bottom up
+    while (level.size() > 1)
+    {
+        std::vector<uint32_t> parents;
+        std::vector<std::pair<T, uint32_t>> parent_smallest;
+
+        for (size_t i = 0; i < level.size(); i += INNER_SLOTS + 1)
+        {
+            const size_t end = std::min(level.size(), i + INNER_SLOTS + 1);
+
+            parents.push_back((uint32_t)this->inners.size());
+            parent_smallest.push_back(smallest[i]);
+
+            this->inners.emplace_back();
+            Inner& inner = this->inners.back();
+            inner.children[0] = level[i];
+            for (size_t c = i + 1; c < end; ++c)
+            {
+                inner.keys[inner.count] = smallest[c].first;
+                inner.rows[inner.count] = smallest[c].second;
+                inner.children[++inner.count] = level[c];
+            }
+        }
+
+        level.swap(parents);
+        smallest.swap(parent_smallest);
+        this->height++;
+    }
+
+    this->root = level[0];
+}
+
+template <class T>
+void BTreeIndex<T>::build(const ColumnView<T>& elements)
+{
+    std::vector<std::pair<T, uint32_t>> sorted;
+    sorted.reserve(elements.size());
+    for (size_t row = 0; row < elements.size(); ++row) sorted.emplace_back(elements[row], (uint32_t)row);
+
+    std::sort(sorted.begin(), sorted.end(), [](const std::pair<T, uint32_t>& a, const std::pair<T, uint32_t>& b) {
+        return _entryLess(a.first, a.second, b.first, b.second);
+    });
+
+    this->bulkLoad(sorted);
+}
+
+template <class T>
+void BTreeIndex<T>::insert(const ColumnView<T>& elements, const size_t row)
+{
+    if (this->leaves.empty()) this->bulkLoad({});
+
+    const T key = elements[row];
+    std::vector<std::pair<uint32_t, uint32_t>> path;
+    const uint32_t node = this->findLeaf(key, (uint32_t)row, &path);
+
+    Leaf* leaf = &this->leaves[node];
+    const size_t position = this->leafPosition(*leaf, key, (uint32_t)row);
+    this->entries++;
+
+    if (leaf->count < LEAF_SLOTS)
+    {
+        for (size_t i = leaf->count; i > position; --i) {
+            leaf->keys[i] = leaf->keys[i - 1];
+            leaf->rows[i] = leaf->rows[i - 1];
+        }
+        leaf->keys[position] = key;
+        leaf->rows[position] = (uint32_t)row;
+        leaf->count++;
+        return;
+    }
+
+    // Split the full leaf
+    T keys[LEAF_SLOTS + 1];
+    uint32_t rows[LEAF_SLOTS + 1];
+    std::copy(leaf->keys, leaf->keys + position, keys);
+    std::copy(leaf->rows, leaf->rows + position, rows);
+    keys[position] = key;
+    rows[position] = (uint32_t)row;
+    std::copy(leaf->keys + position, leaf->keys + LEAF_SLOTS, keys + position + 1);
+    std::copy(leaf->rows + position, leaf->rows + LEAF_SLOTS, rows + position + 1);
+
+    // Appending after the last entry keeps the left leaf full, so ascending keys pack the leaves
+    const size_t split = (position == LEAF_SLOTS && leaf->next == INDEX_NO_ROW) ? LEAF_SLOTS : (LEAF_SLOTS + 1) / 2;
+
+    const uint32_t right_node = (uint32_t)this->leaves.size();
+    this->leaves.emplace_back();
+    leaf = &this->leaves[node];
+    Leaf& right = this->leaves[right_node];
+
+    leaf->count = split;
+    std::copy(keys, keys + split, leaf->keys);
+    std::copy(rows, rows + split, leaf->rows);
+
+    right.count = LEAF_SLOTS + 1 - split;
+    std::copy(keys + split, keys + LEAF_SLOTS + 1, right.keys);
+    std::copy(rows + split, rows + LEAF_SLOTS + 1, right.rows);
+
+    right.next = leaf->next;
+    leaf->next = right_node;
+
+    this->insertSeparator(path, right.keys[0], right.rows[0], right_node);
+}
+
+template <class T>
+void BTreeIndex<T>::remove(const ColumnView<T>& elements, const size_t row)
+{
+    if (this->leaves.empty()) return;
+
+    const T& key = elements[row];
+    Leaf& leaf = this->leaves[this->findLeaf(key, (uint32_t)row, nullptr)];
+    const size_t position = this->leafPosition(leaf, key, (uint32_t)row);
+    if (position >= leaf.count || leaf.rows[position] != row) return;
+
+    // Leaves are not merged, an underfull leaf is packed again by the next rebuild
+    for (size_t i = position + 1; i < leaf.count; ++i) {
+        leaf.keys[i - 1] = leaf.keys[i];
+        leaf.rows[i - 1] = leaf.rows[i];
+    }
+    leaf.count--;
+    this->entries--;
+}
+
+template <class T>
+void BTreeIndex<T>::eraseRows(const ColumnView<T>& elements, const Bitmap& rows)
+{
+    // New number of every remaining row: its position minus the rows deleted before it
+    std::vector<uint32_t> renumber(elements.size(), INDEX_NO_ROW);
+    size_t removed = 0;
+    for (size_t row = 0; row < elements.size(); ++row)
+    {
+        if (row < rows.size() && rows.test(row)) ++removed;
+        else renumber[row] = (uint32_t)(row - removed);
+    }
+
+    // Renumbering keeps the order of the rows, the remaining entries stay sorted
+    std::vector<std::pair<T, uint32_t>> sorted;
+    sorted.reserve(this->entries);
+    for (uint32_t node = this->leaves.empty() ? INDEX_NO_ROW : this->first; node != INDEX_NO_ROW; node = this->leaves[node].next)
+    {
+        const Leaf& leaf = this->leaves[node];
+        for (size_t i = 0; i < leaf.count; ++i) {
+            if (leaf.rows[i] < renumber.size() && renumber[leaf.rows[i]] != INDEX_NO_ROW) sorted.emplace_back(leaf.keys[i], renumber[leaf.rows[i]]);
+        }
+    }
+
+    this->bulkLoad(sorted);
+}
+
+template <class T>
+void BTreeIndex<T>::lookup(const ColumnView<T>&, const FilterOperator op, const T& val, Bitmap& res) const
+{
+    if (this->leaves.empty() || !this->supports(op)) return;
+
+    // '<' and '<=' start at the smallest key. Equal keys are ordered by row, so (val, 0) comes
+    // before all of them and (val, INDEX_NO_ROW) after.
+    uint32_t node = this->first;
+    size_t position = 0;
+    if (op != FILTER_LT && op != FILTER_LE)
+    {
+        const uint32_t row = (op == FILTER_GT) ? INDEX_NO_ROW : 0;
+        node = this->findLeaf(val, row, nullptr);
+        position = this->leafPosition(this->leaves[node], val, row);
+    }
+
+    // '=', '<' and '<=' stop after the keys equal to 'val'
+    const bool bounded = (op == FILTER_EQ || op == FILTER_LT || op == FILTER_LE);
+
+    for (; node != INDEX_NO_ROW; node = this->leaves[node].next, position = 0)
+    {
+        const Leaf& leaf = this->leaves[node];
+        for (; position < leaf.count; ++position)
+        {
+            if (bounded && _keyLess(val, leaf.keys[position])) return;
+            if (_keyMatches(op, leaf.keys[position], val)) res.set(leaf.rows[position]);
+        }
+    }
+}
+
+template <class T>
+bool BTreeIndex<T>::sortedRows(std::vector<size_t>& rows) const
+{
+    rows.clear();
+    rows.reserve(this->entries);
+
+    for (uint32_t node = this->leaves.empty() ? INDEX_NO_ROW : this->first; node != INDEX_NO_ROW; node = this->leaves[node].next)
+    {
+        const Leaf& leaf = this->leaves[node];
+        rows.insert(rows.end(), leaf.rows, leaf.rows + leaf.count);
+    }
+    return true;
+}
+
+template <class T>
+bool BTreeIndex<T>::write(const fs::path& path, const uint64_t checkpoint_lsn) const
+{
+    fs::path tmp = path; tmp += ".tmp";
+    std::ofstream file(tmp, std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+    if (!file.is_open()) { std::cout << "-- !Failed to open " << tmp.string() << "\n"; return false; }
+
+    const IndexFileHeader header = _indexHeader(INDEX_BTREE, _dataType<T>(), this->entries, checkpoint_lsn, this->leaves.size() + this->inners.size(), this->entries);
+    const Meta meta = { this->root, this->height, this->first, (uint32_t)this->leaves.size(), (uint32_t)this->inners.size(), 0 };
+
+    // Header, tree positions, leaves, inner nodes
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(&meta), sizeof(meta));
+    file.write(reinterpret_cast<const char*>(this->leaves.data()), this->leaves.size() * sizeof(Leaf));
+    file.write(reinterpret_cast<const char*>(this->inners.data()), this->inners.size() * sizeof(Inner));
+
+    return _replaceIndexFile(file, tmp, path);
+}
+
+template <class T>
+bool BTreeIndex<T>::read(const fs::path& path, const size_t rows, const uint64_t checkpoint_lsn)
+{
+    std::ifstream file(path, std::ifstream::in | std::ifstream::binary);
+    if (!file.is_open()) return false;
+
+    // Only an index written at the checkpoint of the table files can be used
+    IndexFileHeader header;
+    if (!_readIndexHeader(file, INDEX_BTREE, _dataType<T>(), rows, checkpoint_lsn, header)) return false;
+
+    Meta meta;
+    if (!file.read(reinterpret_cast<char*>(&meta), sizeof(meta))) return false;
+    if (meta.leaf_count == 0 || (uint64_t)meta.leaf_count + meta.inner_count != header.slot_count || header.key_count != rows ||
+        meta.first >= meta.leaf_count || meta.root >= (meta.height ? meta.inner_count : meta.leaf_count)) return false;
+
+    std::vector<Leaf> leaves(meta.leaf_count);
+    std::vector<Inner> inners(meta.inner_count);
+    file.read(reinterpret_cast<char*>(leaves.data()), leaves.size() * sizeof(Leaf));
+    file.read(reinterpret_cast<char*>(inners.data()), inners.size() * sizeof(Inner));
+    if (!file) return false;
+
+    // Every position in the file must stay inside the tree
+    for (const Leaf& leaf : leaves) {
+        if (leaf.count > LEAF_SLOTS || (leaf.next != INDEX_NO_ROW && leaf.next >= meta.leaf_count)) return false;
+    }
+    for (const Inner& inner : inners)
+    {
+        if (inner.count > INNER_SLOTS) return false;
+        for (size_t i = 0; i <= inner.count; ++i) {
+            if (inner.children[i] >= std::max(meta.leaf_count, meta.inner_count)) return false;
+        }
+    }
+
+    this->leaves = std::move(leaves);
+    this->inners = std::move(inners);
+    this->root = meta.root;
+    this->height = meta.height;
+    this->first = meta.first;
+    this->entries = header.key_count;
+    return true;
+}
+
+std::string ArtIndex::toKey(const std::string& element)
+{
+    std::string key = _toUpper(element);
+    key.push_back('\0');
+    return key;
+}
+
+std::unique_ptr<ArtIndex::Node>* ArtIndex::findChild(Node* node, const uint8_t byte)
+{
+    switch (node->type)
+    {
+        case ART_NODE4: {
+            Node4* n = static_cast<Node4*>(node);
+            for (uint16_t i = 0; i < n->count; ++i) if (n->keys[i] == byte) return &n->children[i];
+            return nullptr;
+        }
+        case ART_NODE16: {
+            Node16* n = static_cast<Node16*>(node);
+            for (uint16_t i = 0; i < n->count; ++i) if (n->keys[i] == byte) return &n->children[i];
+            return nullptr;
+        }
+        case ART_NODE48: {
+            Node48* n = static_cast<Node48*>(node);
+            return n->index[byte] ? &n->children[n->index[byte] - 1] : nullptr;
+        }
+        case ART_NODE256: {
+            Node256* n = static_cast<Node256*>(node);
+            return n->children[byte] ? &n->children[byte] : nullptr;
+        }
+        default:
+            return nullptr;
+    }
+}
+
+// Inserts a child into the sorted arrays of a Node4 or Node16 with room for it
+template <class N>
+static void _insertSorted(N* node, const uint8_t byte, std::unique_ptr<typename std::remove_reference<decltype(*node->children[0])>::type> child)
+{
+    uint16_t position = 0;
+    while (position < node->count && node->keys[position] < byte) ++position;
+    for (uint16_t i = node->count; i > position; --i) {
+        node->keys[i] = node->keys[i - 1];
+        node->children[i] = std::move(node->children[i - 1]);
+    }
+    node->keys[position] = byte;
+    node->children[position] = std::move(child);
+    node->count++;
+}
+
+void ArtIndex::addChild(std::unique_ptr<Node>& ref, const uint8_t byte, std::unique_ptr<Node> child)
+{
+    Node* node = ref.get();
+    switch (node->type)
+    {
+        case ART_NODE4: {
+            Node4* n = static_cast<Node4*>(node);
+            if (n->count < 4) return _insertSorted(n, byte, std::move(child));
+
+            // Grow to 16 children
+            std::unique_ptr<Node16> grown(new Node16());
+            grown->prefix = std::move(n->prefix);
+            grown->count = n->count;
+            for (uint16_t i = 0; i < n->count; ++i) {
+                grown->keys[i] = n->keys[i];
+                grown->children[i] = std::move(n->children[i]);
+            }
+            ref = std::move(grown);
+            return addChild(ref, byte, std::move(child));
+        }
+        case ART_NODE16: {
+            Node16* n = static_cast<Node16*>(node);
+            if (n->count < 16) return _insertSorted(n, byte, std::move(child));
+
+            // Grow to 48 children
+            std::unique_ptr<Node48> grown(new Node48());
+            grown->prefix = std::move(n->prefix);
+            grown->count = n->count;
+            for (uint16_t i = 0; i < n->count; ++i) {
+                grown->index[n->keys[i]] = (uint8_t)(i + 1);
+                grown->children[i] = std::move(n->children[i]);
+            }
+            ref = std::move(grown);
+            return addChild(ref, byte, std::move(child));
+        }
+        case ART_NODE48: {
+            Node48* n = static_cast<Node48*>(node);
+            if (n->count < 48)
+            {
+                uint8_t slot = 0;
+                while (n->children[slot]) ++slot;
+                n->children[slot] = std::move(child);
+                n->index[byte] = (uint8_t)(slot + 1);
+                n->count++;
+                return;
+            }
+
+            // Grow to 256 children
+            std::unique_ptr<Node256> grown(new Node256());
+            grown->prefix = std::move(n->prefix);
+            grown->count = n->count;
+            for (unsigned int b = 0; b < 256; ++b) {
+                if (n->index[b]) grown->children[b] = std::move(n->children[n->index[b] - 1]);
+            }
+            ref = std::move(grown);
+            return addChild(ref, byte, std::move(child));
+        }
+        case ART_NODE256: {
+            Node256* n = static_cast<Node256*>(node);
+            n->children[byte] = std::move(child);
+            n->count++;
+            return;
+        }
+        default:
+            return;
+    }
+}
+
+void ArtIndex::removeChild(std::unique_ptr<Node>& ref, const uint8_t byte)
+{
+    Node* node = ref.get();
+    switch (node->type)
+    {
+        case ART_NODE4:
+        case ART_NODE16: {
+            uint8_t* keys = node->type == ART_NODE4 ? static_cast<Node4*>(node)->keys : static_cast<Node16*>(node)->keys;
+            std::unique_ptr<Node>* children = node->type == ART_NODE4 ? static_cast<Node4*>(node)->children : static_cast<Node16*>(node)->children;
+
+            uint16_t position = 0;
+            while (position < node->count && keys[position] != byte) ++position;
+            if (position == node->count) return;
+
+            for (uint16_t i = position + 1; i < node->count; ++i) {
+                keys[i - 1] = keys[i];
+                children[i - 1] = std::move(children[i]);
+            }
+            children[node->count - 1].reset();
+            node->count--;
+            break;
+        }
+        case ART_NODE48: {
+            Node48* n = static_cast<Node48*>(node);
+            if (!n->index[byte]) return;
+            n->children[n->index[byte] - 1].reset();
+            n->index[byte] = 0;
+            n->count--;
+            break;
+        }
+        case ART_NODE256: {
+            Node256* n = static_cast<Node256*>(node);
+            if (!n->children[byte]) return;
+            n->children[byte].reset();
+            n->count--;
+            break;
+        }
+        default:
+            return;
+    }
+
+    if (node->count == 0) { ref.reset(); return; }
+
+    // A Node4 left with one child is replaced by it, the child takes over the compressed path.
+    // Larger nodes are not shrunk.
+    if (node->type == ART_NODE4 && node->count == 1)
+    {
+        Node4* n = static_cast<Node4*>(node);
+        std::unique_ptr<Node> child = std::move(n->children[0]);
+        if (child->type != ART_LEAF) child->prefix = n->prefix + (char)n->keys[0] + child->prefix;
+        ref = std::move(child);
+    }
+}
+
+template <class Fn>
+void ArtIndex::forEachChild(const Node* node, Fn fn)
+{
+    switch (node->type)
+    {
+        case ART_NODE4: {
+            const Node4* n = static_cast<const Node4*>(node);
+            for (uint16_t i = 0; i < n->count; ++i) fn(n->keys[i], n->children[i].get());
+            break;
+        }
+        case ART_NODE16: {
+            const Node16* n = static_cast<const Node16*>(node);
+            for (uint16_t i = 0; i < n->count; ++i) fn(n->keys[i], n->children[i].get());
+            break;
+        }
+        case ART_NODE48: {
+            const Node48* n = static_cast<const Node48*>(node);
+            for (unsigned int b = 0; b < 256; ++b) if (n->index[b]) fn((uint8_t)b, n->children[n->index[b] - 1].get());
+            break;
+        }
+        case ART_NODE256: {
+            const Node256* n = static_cast<const Node256*>(node);
+            for (unsigned int b = 0; b < 256; ++b) if (n->children[b]) fn((uint8_t)b, n->children[b].get());
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+template <class Fn>
+void ArtIndex::walk(const Node* node, Fn& fn)
+{
+    if (node->type == ART_LEAF) { fn(static_cast<const Leaf*>(node)); return; }
+    forEachChild(node, [&fn](uint8_t, const Node* child) { walk(child, fn); });
+}
+
+template <class Fn>
+void ArtIndex::walkFrom(const Node* node, size_t depth, const std::string& bound, Fn& fn)
+{
+    if (node->type == ART_LEAF)
+    {
+        const Leaf* leaf = static_cast<const Leaf*>(node);
+        if (leaf->key.compare(bound) >= 0) fn(leaf);
+        return;
+    }
+
+    // Every key below a path greater than the bound is greater, below a smaller path smaller.
+    // Paths hold no 0 byte, so they differ from the bound before its end.
+    const int order = node->prefix.compare(0, std::string::npos, bound, depth, node->prefix.size());
+    if (order > 0) { walk(node, fn); return; }
+    if (order < 0) return;
+
+    depth += node->prefix.size();
+    const uint8_t next = (uint8_t)bound[depth];
+    forEachChild(node, [&](uint8_t byte, const Node* child) {
+        if (byte > next) walk(child, fn);
+        else if (byte == next) walkFrom(child, depth + 1, bound, fn);
+    });
+}
+
+template <class Fn>
+void ArtIndex::walkBelow(const Node* node, size_t depth, const std::string& bound, Fn& fn)
+{
+    if (node->type == ART_LEAF)
+    {
+        const Leaf* leaf = static_cast<const Leaf*>(node);
+        if (leaf->key.compare(bound) < 0) fn(leaf);
+        return;
+    }
+
+    const int order = node->prefix.compare(0, std::string::npos, bound, depth, node->prefix.size());
+    if (order < 0) { walk(node, fn); return; }
+    if (order > 0) return;
+
+    depth += node->prefix.size();
+    const uint8_t next = (uint8_t)bound[depth];
+    forEachChild(node, [&](uint8_t byte, const Node* child) {
+        if (byte < next) walk(child, fn);
+        else if (byte == next) walkBelow(child, depth + 1, bound, fn);
+    });
+}
+
+template <class Fn>
+void ArtIndex::walkPrefix(const Node* node, size_t depth, const std::string& prefix, Fn& fn)
+{
+    if (node->type == ART_LEAF)
+    {
+        const Leaf* leaf = static_cast<const Leaf*>(node);
+        if (leaf->key.compare(0, prefix.size(), prefix) == 0) fn(leaf);
+        return;
+    }
+
+    // The path must match the rest of the prefix as far as they both go
+    const size_t length = std::min(node->prefix.size(), prefix.size() - depth);
+    if (node->prefix.compare(0, length, prefix, depth, length) != 0) return;
+
+    depth += node->prefix.size();
+    if (depth >= prefix.size()) { walk(node, fn); return; }
+
+    std::unique_ptr<Node>* child = findChild(const_cast<Node*>(node), (uint8_t)prefix[depth]);
+    if (child) walkPrefix(child->get(), depth + 1, prefix, fn);
+}
+
+ArtIndex::Leaf* ArtIndex::findLeaf(const std::string& key) const
+{
+    Node* node = this->root.get();
+    size_t depth = 0;
+
+    while (node)
+    {
+        if (node->type == ART_LEAF) {
+            Leaf* leaf = static_cast<Leaf*>(node);
+            return leaf->key == key ? leaf : nullptr;
+        }
+
+        if (key.compare(depth, node->prefix.size(), node->prefix) != 0) return nullptr;
+        depth += node->prefix.size();
+        if (depth >= key.size()) return nullptr;
+
+        std::unique_ptr<Node>* child = findChild(node, (uint8_t)key[depth++]);
+        node = child ? child->get() : nullptr;
+    }
+    return nullptr;
+}
+
+void ArtIndex::insertLeaf(std::unique_ptr<Node>& ref, std::unique_ptr<Leaf> leaf, size_t depth)
+{
+    Node* node = ref.get();
+    if (!node) { ref = std::move(leaf); return; }
+
+    const std::string& key = leaf->key;
+
+    // Two leaves: a new node branches where their keys differ (the 0 bytes end them apart)
+    if (node->type == ART_LEAF)
+    {
+        const std::string& other = static_cast<Leaf*>(node)->key;
+        size_t common = depth;
+        while (other[common] == key[common]) ++common;
+
+        std::unique_ptr<Node> branch(new Node4());
+        branch->prefix = key.substr(depth, common - depth);
+        const uint8_t other_byte = (uint8_t)other[common], key_byte = (uint8_t)key[common];
+        addChild(branch, other_byte, std::move(ref));
+        addChild(branch, key_byte, std::move(leaf));
+        ref = std::move(branch);
+        return;
+    }
+
+    // The key leaves the compressed path: a new node branches where they differ
+    size_t matched = 0;
+    while (matched < node->prefix.size() && node->prefix[matched] == key[depth + matched]) ++matched;
+    if (matched < node->prefix.size())
+    {
+        std::unique_ptr<Node> branch(new Node4());
+        branch->prefix = node->prefix.substr(0, matched);
+        const uint8_t node_byte = (uint8_t)node->prefix[matched];
+        node->prefix.erase(0, matched + 1);
+
+        const uint8_t key_byte = (uint8_t)key[depth + matched];
+        addChild(branch, node_byte, std::move(ref));
+        addChild(branch, key_byte, std::move(leaf));
+        ref = std::move(branch);
+        return;
+    }
+
+    depth += node->prefix.size();
+    std::unique_ptr<Node>* child = findChild(node, (uint8_t)key[depth]);
+    if (child) insertLeaf(*child, std::move(leaf), depth + 1);
+    else addChild(ref, (uint8_t)key[depth], std::move(leaf));
+}
+
+bool ArtIndex::eraseLeaf(std::unique_ptr<Node>& ref, const std::string& key, size_t depth)
+{
+    Node* node = ref.get();
+    if (!node) return false;
+
+    if (node->type == ART_LEAF)
+    {
+        if (static_cast<Leaf*>(node)->key != key) return false;
+        ref.reset();
+        return true;
+    }
+
+    if (key.compare(depth, node->prefix.size(), node->prefix) != 0) return false;
+    depth += node->prefix.size();
+    if (depth >= key.size()) return false;
+
+    const uint8_t byte = (uint8_t)key[depth];
+    std::unique_ptr<Node>* child = findChild(node, byte);
+    if (!child || !this->eraseLeaf(*child, key, depth + 1)) return false;
+
+    if (!*child) removeChild(ref, byte);
+    return true;
+}
+
+void ArtIndex::insertKey(const std::string& key, const uint32_t row)
+{
+    this->row_count++;
+
+    if (Leaf* leaf = this->findLeaf(key)) {
+        leaf->rows.insert(std::lower_bound(leaf->rows.begin(), leaf->rows.end(), row), row);
+        return;
+    }
+
+    std::unique_ptr<Leaf> leaf(new Leaf());
+    leaf->key = key;
+    leaf->rows.push_back(row);
+    this->insertLeaf(this->root, std::move(leaf), 0);
+    this->leaves++;
+}
+
+void ArtIndex::build(const ColumnView<std::string>& elements)
+{
+    this->root.reset();
+    this->leaves = this->row_count = 0;
+
+    for (size_t row = 0; row < elements.size(); ++row) this->insertKey(toKey(elements[row]), (uint32_t)row);
+}
+
+void ArtIndex::insert(const ColumnView<std::string>& elements, const size_t row)
+{
+    this->insertKey(toKey(elements[row]), (uint32_t)row);
+}
+
+void ArtIndex::remove(const ColumnView<std::string>& elements, const size_t row)
+{
+    const std::string key = toKey(elements[row]);
+    Leaf* leaf = this->findLeaf(key);
+    if (!leaf) return;
+
+    auto it = std::lower_bound(leaf->rows.begin(), leaf->rows.end(), (uint32_t)row);
+    if (it == leaf->rows.end() || *it != row) return;
+
+    leaf->rows.erase(it);
+    this->row_count--;
+
+    // The last row of a key takes its leaf with it
+    if (leaf->rows.empty() && this->eraseLeaf(this->root, key, 0)) this->leaves--;
+}
+
+void ArtIndex::eraseRows(const ColumnView<std::string>& elements, const Bitmap& rows)
+{
+    if (!this->root) return;
+
+    // New number of every remaining row: its position minus the rows deleted before it
+    std::vector<uint32_t> renumber(elements.size(), INDEX_NO_ROW);
+    size_t removed = 0;
+    for (size_t row = 0; row < elements.size(); ++row)
+    {
+        if (row < rows.size() && rows.test(row)) ++removed;
+        else renumber[row] = (uint32_t)(row - removed);
+    }
+
+    // Renumber the rows of every leaf in place, renumbering keeps them ascending
+    std::vector<std::string> emptied;
+    auto compact = [&](const Leaf* leaf)
+    {
+        std::vector<uint32_t>& leaf_rows = const_cast<Leaf*>(leaf)->rows;
+        size_t kept = 0;
+        for (uint32_t row : leaf_rows) {
+            if (row < renumber.size() && renumber[row] != INDEX_NO_ROW) leaf_rows[kept++] = renumber[row];
+        }
+        this->row_count -= leaf_rows.size() - kept;
+        leaf_rows.resize(kept);
+        if (kept == 0) emptied.push_back(leaf->key);
+    };
+    walk(this->root.get(), compact);
+
+    for (auto& key : emptied) {
+        if (this->eraseLeaf(this->root, key, 0)) this->leaves--;
+    }
+}
+
+void ArtIndex::lookup(const ColumnView<std::string>& elements, const FilterOperator op, const std::string& val, Bitmap& res) const
+{
+    if (!this->root) return;
+
+    auto every = [&res](const Leaf* leaf) { for (uint32_t row : leaf->rows) res.set(row); };
+    auto exact = [&](const Leaf* leaf) { for (uint32_t row : leaf->rows) if (elements[row] == val) res.set(row); };
+
+    if (op == FILTER_LIKE)
+    {
+        std::string text;
+        if (_likePattern(val, text)) walkPrefix(this->root.get(), 0, text, every);
+        else if (const Leaf* leaf = this->findLeaf(toKey(text))) every(leaf);
+        return;
+    }
+
+    // '<=' and '>=' also match the elements exactly equal to 'val', which share its leaf
+    const std::string key = toKey(val);
+    const Leaf* equal = this->findLeaf(key);
+    auto greater = [&](const Leaf* leaf) { if (leaf != equal) every(leaf); };
+
+    switch (op)
+    {
+        case FILTER_EQ: if (equal) exact(equal); break;
+        case FILTER_LT: walkBelow(this->root.get(), 0, key, every); break;
+        case FILTER_LE: walkBelow(this->root.get(), 0, key, every); if (equal) exact(equal); break;
+        case FILTER_GT: walkFrom(this->root.get(), 0, key, greater); break;
+        case FILTER_GE: walkFrom(this->root.get(), 0, key, greater); if (equal) exact(equal); break;
+        default: break;
+    }
+}
+
+bool ArtIndex::write(const fs::path& path, const uint64_t checkpoint_lsn) const
+{
+    fs::path tmp = path; tmp += ".tmp";
+    std::ofstream file(tmp, std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+    if (!file.is_open()) { std::cout << "-- !Failed to open " << tmp.string() << "\n"; return false; }
+
+    const IndexFileHeader header = _indexHeader(INDEX_ART, _dataType<std::string>(), this->row_count, checkpoint_lsn, this->leaves, this->leaves);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // Every leaf in key order: key length, key (without its 0 byte), row count, rows
+    auto write_leaf = [&file](const Leaf* leaf)
+    {
+        const uint32_t key_length = (uint32_t)leaf->key.size() - 1, rows = (uint32_t)leaf->rows.size();
+        file.write(reinterpret_cast<const char*>(&key_length), sizeof(key_length));
+        file.write(leaf->key.data(), key_length);
+        file.write(reinterpret_cast<const char*>(&rows), sizeof(rows));
+        file.write(reinterpret_cast<const char*>(leaf->rows.data()), rows * sizeof(uint32_t));
+    };
+    if (this->root) walk(this->root.get(), write_leaf);
+
+    return _replaceIndexFile(file, tmp, path);
+}
+
+bool ArtIndex::read(const fs::path& path, const size_t rows, const uint64_t checkpoint_lsn)
+{
+    std::ifstream file(path, std::ifstream::in | std::ifstream::binary);
+    if (!file.is_open()) return false;
+
+    // Only an index written at the checkpoint of the table files can be used
+    IndexFileHeader header;
+    if (!_readIndexHeader(file, INDEX_ART, _dataType<std::string>(), rows, checkpoint_lsn, header)) return false;
+
+    // The leaves come in key order, the tree is built again from them
+    ArtIndex tree(this->name);
+    for (uint64_t i = 0; i < header.key_count; ++i)
+    {
+        uint32_t key_length = 0, count = 0;
+        if (!file.read(reinterpret_cast<char*>(&key_length), sizeof(key_length)) || key_length >= (1u << 20)) return false;
+
+        std::unique_ptr<Leaf> leaf(new Leaf());
+        leaf->key.resize(key_length);
+        if (!file.read(&leaf->key[0], key_length)) return false;
+        leaf->key.push_back('\0');
+
+        if (!file.read(reinterpret_cast<char*>(&count), sizeof(count)) || count == 0 || tree.row_count + count > rows) return false;
+        leaf->rows.resize(count);
+        if (!file.read(reinterpret_cast<char*>(leaf->rows.data()), count * sizeof(uint32_t))) return false;
+        for (uint32_t row : leaf->rows) if (row >= rows) return false;
+
+        // Keys are distinct and ascending
+        if (tree.leaves && tree.findLeaf(leaf->key)) return false;
+
+        tree.row_count += count;
+        tree.insertLeaf(tree.root, std::move(leaf), 0);
+        tree.leaves++;
+    }
+    if (tree.row_count != rows) return false;
+
+    this->root = std::move(tree.root);
+    this->leaves = tree.leaves;
+    this->row_count = tree.row_count;
+    return true;
+}
+
+template <class T>
+std::shared_ptr<ColumnIndex<T>> makeIndex(const std::string& name, const IndexType type)
+{
+    // FLOAT columns are not hashed, equality on floats is rarely what a lookup wants
+    if (type == INDEX_HASH && !std::is_same<T, float>::value) return std::make_shared<HashIndex<T>>(name);
+
+    // VARCHAR keys are not fixed width and do not fit in B+tree nodes, they go in a radix tree
+    if constexpr (!std::is_same<T, std::string>::value) {
+        if (type == INDEX_BTREE) return std::make_shared<BTreeIndex<T>>(name);
+    }
+    else {
+        if (type == INDEX_ART) return std::make_shared<ArtIndex>(name);
+    }
+    return nullptr;
+}
+
+bool indexType(const std::string& name, IndexType& type)
+{
+    const std::string upper = _toUpper(name);
+    if (upper == "HASH") type = INDEX_HASH;
+    else if (upper == "BTREE") type = INDEX_BTREE;
+    else if (upper == "ART") type = INDEX_ART;
+    else return false;
+    return true;
+}
+
+const char* indexTypeName(const IndexType type)
+{
+    static const char* names[] = { "HASH", "BTREE", "ART" };
+    return names[type];
+}
+
+template class HashIndex<int>;
+template class HashIndex<float>;
+template class HashIndex<char>;
+template class HashIndex<std::string>;
+
+template class BTreeIndex<int>;
+template class BTreeIndex<float>;
+template class BTreeIndex<char>;
+
+template std::shared_ptr<ColumnIndex<int>> makeIndex(const std::string&, const IndexType);
+template std::shared_ptr<ColumnIndex<float>> makeIndex(const std::string&, const IndexType);
+template std::shared_ptr<ColumnIndex<char>> makeIndex(const std::string&, const IndexType);
+template std::shared_ptr<ColumnIndex<std::string>> makeIndex(const std::string&, const IndexType);
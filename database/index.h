@@ -0,0 +1,330 @@
+/**
+ * File: index.h
+ * Author: Mark Minkoff
+ * Functionality: Function declarations for file index.cpp
+ * Secondary indexes over one column of a table (CREATE INDEX). An index is owned by its
+ * Column<T>, which keeps it up to date on every insert, update and delete and answers
+ * filterElements from it when the index supports the operator.
+ *
+ * Indexes store row numbers, which are positions in the column, so deleting rows renumbers
+ * every row after them. Keys are not copied into the index, they are compared against the
+ * column elements the caller passes in.
+ *
+ * Every index is written to <table>.<index name>.idx at checkpoints:
+ *
+ *   IndexFileHeader (64 bytes) followed by the index data
+ *
+ * An index file is only used when its row count and checkpoint LSN match the table file,
+ * otherwise the index is rebuilt from the column.
+ *
+ * */
+
+#ifndef INDEX_H_
+#define INDEX_H_
+
+#include "include.h"
+#include "bitmap.h"
+#include "column.h"
+#include "filter.h"
+
+enum IndexType
+{
+    INDEX_HASH = 0,     // Equality lookups on INT, CHAR and VARCHAR columns
+    INDEX_BTREE,        // Equality and range lookups on INT, FLOAT and CHAR columns, rows in key order
+    INDEX_ART           // Equality, range and LIKE prefix lookups on VARCHAR columns
+};
+
+// Row number marking the end of a chain or an empty slot
+const uint32_t INDEX_NO_ROW = UINT32_MAX;
+
+typedef struct IndexFileHeader {
+    char magic[8];              // "SQLINDEX"
+    uint32_t version;
+    uint32_t index_type;        // IndexType
+    uint32_t data_type;         // StorageType of the indexed column
+    uint32_t reserved0;
+    uint64_t row_count;         // Rows covered by the index
+    uint64_t checkpoint_lsn;    // Checkpoint of the table the index was written at
+    uint64_t slot_count;        // Size of the index structure (hash buckets, B+tree nodes)
+    uint64_t key_count;         // Keys held (see ColumnIndex::keyCount)
+    uint64_t reserved[1];
+} IndexFileHeader;
+
+static_assert(sizeof(IndexFileHeader) == 64, "IndexFileHeader must be 64 bytes");
+
+/** Interface of every index type */
+template <class T>
+class ColumnIndex
+{
+protected:
+    std::string name;
+
+public:
+    ColumnIndex(const std::string& name) : name(name) {}
+    virtual ~ColumnIndex() {}
+
+    const std::string& getName() const { return this->name; }
+    virtual IndexType getType() const = 0;
+
+    /** True if lookup() answers 'op' */
+    virtual bool supports(const FilterOperator op) const = 0;
+
+    /** Number of keys held: distinct keys of a hash index or radix tree, entries of a B+tree */
+    virtual size_t keyCount() const = 0;
+
+    /** Fills the vector with every row in key order (ties in row order), false if the index is unordered */
+    virtual bool sortedRows(std::vector<size_t>&) const { return false; }
+
+    /** Replaces the contents with every row of 'elements' */
+    virtual void build(const ColumnView<T>& elements) = 0;
+
+    /** Adds 'row', keyed by elements[row]. Rows are appended in order or re-added after remove(). */
+    virtual void insert(const ColumnView<T>& elements, const size_t row) = 0;
+
+    /** Removes 'row' while elements[row] still holds its key (before the row is updated) */
+    virtual void remove(const ColumnView<T>& elements, const size_t row) = 0;
+
+    /** Removes the rows set in 'rows' and renumbers the rows after them ('elements' still holds every row) */
+    virtual void eraseRows(const ColumnView<T>& elements, const Bitmap& rows) = 0;
+
+    /** Sets every row whose element satisfies 'element op val' in 'res' */
+    virtual void lookup(const ColumnView<T>& elements, const FilterOperator op, const T& val, Bitmap& res) const = 0;
+
+    /** Writes the index file */
+    virtual bool write(const fs::path& path, const uint64_t checkpoint_lsn) const = 0;
+
+    /** Reads the index file, false if it is missing or does not cover 'rows' rows at 'checkpoint_lsn' */
+    virtual bool read(const fs::path& path, const size_t rows, const uint64_t checkpoint_lsn) = 0;
+};
+
+/** Hash index: an open addressing table (linear probing) with one bucket per distinct key
+ *  pointing at a doubly linked chain of the rows holding the key. The chains are stored as
+ *  two arrays indexed by row, so a row is linked and unlinked in constant time. */
+template <class T>
+class HashIndex : public ColumnIndex<T>
+{
+private:
+    typedef struct Bucket {
+        uint64_t hash;          // Hash of the key
+        uint32_t head;          // First row holding the key, INDEX_NO_ROW if the bucket is empty
+        uint32_t count;         // Rows holding the key
+    } Bucket;
+
+    std::vector<Bucket> buckets;    // Power of two size, at most half full
+    std::vector<uint32_t> next;     // Next row with the same key
+    std::vector<uint32_t> prev;     // Previous row with the same key
+    size_t keys;                    // Occupied buckets
+
+    /** Position of the bucket holding 'key', buckets.size() if there is none */
+    size_t find(const ColumnView<T>& elements, const uint64_t hash, const T& key) const;
+
+    /** Doubles the bucket array */
+    void grow();
+
+    /** Empties a bucket, shifting back the buckets probed after it */
+    void removeBucket(size_t position);
+
+public:
+    HashIndex(const std::string& name) : ColumnIndex<T>(name), keys(0) {}
+
+    IndexType getType() const override { return INDEX_HASH; }
+    bool supports(const FilterOperator op) const override { return op == FILTER_EQ; }
+    size_t keyCount() const override { return this->keys; }
+
+    void build(const ColumnView<T>& elements) override;
+    void insert(const ColumnView<T>& elements, const size_t row) override;
+    void remove(const ColumnView<T>& elements, const size_t row) override;
+    void eraseRows(const ColumnView<T>& elements, const Bitmap& rows) override;
+    void lookup(const ColumnView<T>& elements, const FilterOperator op, const T& val, Bitmap& res) const override;
+    bool write(const fs::path& path, const uint64_t checkpoint_lsn) const override;
+    bool read(const fs::path& path, const size_t rows, const uint64_t checkpoint_lsn) override;
+};
+
+/** B+tree index over fixed width keys. Entries (key, row) are ordered by key, CHAR keys by
+ *  their upper case form like the ordering operators, and ties by row number. Nodes are 256
+ *  bytes (four cache lines) with the keys first, so a node search reads as few lines as possible.
+ *  Nodes live in two vectors and refer to each other by position, so the tree is written and
+ *  read as is. Deleting entries leaves nodes underfull, eraseRows rebuilds the tree packed. */
+template <class T>
+class BTreeIndex : public ColumnIndex<T>
+{
+private:
+    static const size_t NODE_BYTES = 256;
+    static const size_t LEAF_SLOTS = (NODE_BYTES - 12) / (sizeof(T) + sizeof(uint32_t));
+    static const size_t INNER_SLOTS = (NODE_BYTES - 12) / (sizeof(T) + 2 * sizeof(uint32_t));
+
+    typedef struct alignas(64) Leaf {
+        T keys[LEAF_SLOTS];
+        uint32_t rows[LEAF_SLOTS];
+        uint32_t next;                          // Next leaf in key order, INDEX_NO_ROW after the last
+        uint32_t count;                         // Entries
+    } Leaf;
+
+    typedef struct alignas(64) Inner {
+        T keys[INNER_SLOTS];                    // Separator i is the smallest entry under child i + 1
+        uint32_t rows[INNER_SLOTS];
+        uint32_t children[INNER_SLOTS + 1];     // Inner nodes, or leaves on the lowest inner level
+        uint32_t count;                         // Separators
+    } Inner;
+
+    static_assert(sizeof(Leaf) == NODE_BYTES && sizeof(Inner) == NODE_BYTES, "B+tree nodes must be 256 bytes");
+
+    // Position of the root and the first leaf, stored after the file header
+    typedef struct Meta {
+        uint32_t root;                          // A leaf while height is 0
+        uint32_t height;                        // Inner levels above the leaves
+        uint32_t first;                         // Leftmost leaf
+        uint32_t leaf_count;
+        uint32_t inner_count;
+        uint32_t reserved;
+    } Meta;
+
+    std::vector<Leaf> leaves;
+    std::vector<Inner> inners;
+    uint32_t root;
+    uint32_t height;
+    uint32_t first;
+    size_t entries;
+
+    /** Leaf the entry (key, row) belongs in. 'path' receives the inner nodes and child positions passed. */
+    uint32_t findLeaf(const T& key, const uint32_t row, std::vector<std::pair<uint32_t, uint32_t>>* path) const;
+
+    /** First position of a leaf whose entry is not less than (key, row) */
+    size_t leafPosition(const Leaf& leaf, const T& key, const uint32_t row) const;
+
+    /** Inserts the separator (key, row) of a new node 'child' above the nodes in 'path' */
+    void insertSeparator(std::vector<std::pair<uint32_t, uint32_t>>& path, T key, uint32_t row, uint32_t child);
+
+    /** Replaces the tree with sorted entries, leaves are filled completely */
+    void bulkLoad(const std::vector<std::pair<T, uint32_t>>& sorted);
+
+public:
+    BTreeIndex(const std::string& name) : ColumnIndex<T>(name), root(0), height(0), first(0), entries(0) {}
+
+    IndexType getType() const override { return INDEX_BTREE; }
+    bool supports(const FilterOperator op) const override { return op == FILTER_EQ || op == FILTER_LT || op == FILTER_LE || op == FILTER_GT || op == FILTER_GE; }
+    size_t keyCount() const override { return this->entries; }
+    bool sortedRows(std::vector<size_t>& rows) const override;
+
+    void build(const ColumnView<T>& elements) override;
+    void insert(const ColumnView<T>& elements, const size_t row) override;
+    void remove(const ColumnView<T>& elements, const size_t row) override;
+    void eraseRows(const ColumnView<T>& elements, const Bitmap& rows) override;
+    void lookup(const ColumnView<T>& elements, const FilterOperator op, const T& val, Bitmap& res) const override;
+    bool write(const fs::path& path, const uint64_t checkpoint_lsn) const override;
+    bool read(const fs::path& path, const size_t rows, const uint64_t checkpoint_lsn) override;
+};
+
+/** Adaptive radix tree over VARCHAR keys. Keys are the upper case form of the elements, the
+ *  order of the ordering operators, followed by a 0 byte so no key is a prefix of another.
+ *  Inner nodes hold the compressed path below their parent and grow from 4 to 16, 48 and 256
+ *  children. A leaf holds one key and the rows whose element has that upper case form, so
+ *  '=' and the equal part of '<=' and '>=' compare those elements exactly. Memory grows with
+ *  the number of distinct keys. The index file lists the leaves in key order. */
+class ArtIndex : public ColumnIndex<std::string>
+{
+private:
+    enum NodeType { ART_LEAF = 0, ART_NODE4, ART_NODE16, ART_NODE48, ART_NODE256 };
+
+    struct Node {
+        NodeType type;
+        uint16_t count;                         // Children
+        std::string prefix;                     // Compressed path (inner nodes)
+        Node(const NodeType type) : type(type), count(0) {}
+        virtual ~Node() {}
+    };
+
+    struct Leaf : Node {
+        std::string key;                        // Upper case key and its 0 byte
+        std::vector<uint32_t> rows;             // Ascending
+        Leaf() : Node(ART_LEAF) {}
+    };
+
+    struct Node4 : Node {
+        uint8_t keys[4];                        // Ascending
+        std::unique_ptr<Node> children[4];
+        Node4() : Node(ART_NODE4) {}
+    };
+
+    struct Node16 : Node {
+        uint8_t keys[16];                       // Ascending
+        std::unique_ptr<Node> children[16];
+        Node16() : Node(ART_NODE16) {}
+    };
+
+    struct Node48 : Node {
+        uint8_t index[256] = {};                // Child slot + 1 of every byte, 0 if there is none
+        std::unique_ptr<Node> children[48];
+        Node48() : Node(ART_NODE48) {}
+    };
+
+    struct Node256 : Node {
+        std::unique_ptr<Node> children[256];
+        Node256() : Node(ART_NODE256) {}
+    };
+
+    std::unique_ptr<Node> root;
+    size_t leaves;                              // Distinct keys
+    size_t row_count;                           // Rows in the leaves
+
+    /** Key of an element in the tree */
+    static std::string toKey(const std::string& element);
+
+    /** Child for 'byte', nullptr if there is none */
+    static std::unique_ptr<Node>* findChild(Node* node, const uint8_t byte);
+
+    /** Adds a child, growing the node held by 'ref' when it is full */
+    static void addChild(std::unique_ptr<Node>& ref, const uint8_t byte, std::unique_ptr<Node> child);
+
+    /** Removes the (empty) child for 'byte', a node left with one child is merged into it */
+    static void removeChild(std::unique_ptr<Node>& ref, const uint8_t byte);
+
+    /** Calls fn(byte, child) for every child in byte order */
+    template <class Fn> static void forEachChild(const Node* node, Fn fn);
+
+    // Call fn(leaf) for the leaves under 'node': every leaf, the leaves with a key not less
+    // than 'bound', less than 'bound', or starting with 'prefix'. 'depth' bytes are matched.
+    template <class Fn> static void walk(const Node* node, Fn& fn);
+    template <class Fn> static void walkFrom(const Node* node, size_t depth, const std::string& bound, Fn& fn);
+    template <class Fn> static void walkBelow(const Node* node, size_t depth, const std::string& bound, Fn& fn);
+    template <class Fn> static void walkPrefix(const Node* node, size_t depth, const std::string& prefix, Fn& fn);
+
+    /** Leaf of a key, nullptr if the key is not in the tree */
+    Leaf* findLeaf(const std::string& key) const;
+
+    /** Inserts a leaf whose key is not in the tree below 'ref' */
+    void insertLeaf(std::unique_ptr<Node>& ref, std::unique_ptr<Leaf> leaf, size_t depth);
+
+    /** Removes the leaf of a key below 'ref', returns false if there is none */
+    bool eraseLeaf(std::unique_ptr<Node>& ref, const std::string& key, size_t depth);
+
+    /** Adds a row under a key */
+    void insertKey(const std::string& key, const uint32_t row);
+
+public:
+    ArtIndex(const std::string& name) : ColumnIndex<std::string>(name), leaves(0), row_count(0) {}
+
+    IndexType getType() const override { return INDEX_ART; }
+    bool supports(const FilterOperator op) const override { return op != FILTER_NE && op != FILTER_INVALID; }
+    size_t keyCount() const override { return this->leaves; }
+
+    void build(const ColumnView<std::string>& elements) override;
+    void insert(const ColumnView<std::string>& elements, const size_t row) override;
+    void remove(const ColumnView<std::string>& elements, const size_t row) override;
+    void eraseRows(const ColumnView<std::string>& elements, const Bitmap& rows) override;
+    void lookup(const ColumnView<std::string>& elements, const FilterOperator op, const std::string& val, Bitmap& res) const override;
+    bool write(const fs::path& path, const uint64_t checkpoint_lsn) const override;
+    bool read(const fs::path& path, const size_t rows, const uint64_t checkpoint_lsn) override;
+};
+
+/** Creates an empty index of 'type' over a column of T, nullptr if the type cannot index T */
+template <class T>
+std::shared_ptr<ColumnIndex<T>> makeIndex(const std::string& name, const IndexType type);
+
+/** Converts HASH, BTREE or ART to an index type, returns false if unknown */
+bool indexType(const std::string& name, IndexType& type);
+
+/** Name of an index type */
+const char* indexTypeName(const IndexType type);
+
+#endif // INDEX_H_
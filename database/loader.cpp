@@ -0,0 +1,293 @@
+/**
+ * File: loader.cpp
+ * Author: Mark Minkoff
+ * Functionality: Function definitions for file loader.h
+ *
+ * */
+
+#include "loader.h"
+#include "csv.h"
+
+// Converts a field to the element type of its column like Table::columnValue, false if it is invalid
+static bool _fieldValue(std::string_view field, const size_t, int& value)
+{
+    const auto res = std::from_chars(field.data(), field.data() + field.size(), value);
+    return res.ec == std::errc() && res.ptr == field.data() + field.size();
+}
+
+static bool _fieldValue(std::string_view field, const size_t, float& value)
+{
+    const auto res = std::from_chars(field.data(), field.data() + field.size(), value);
+    if (res.ec != std::errc() || res.ptr != field.data() + field.size()) return false;
+
+    // Round to the decimals written
+    const size_t dec = field.find('.');
+    if (dec != std::string_view::npos && dec + 1 < field.size()) value = _roundFloat(value, field.size() - dec - 1);
+    return true;
+}
+
+static bool _fieldValue(std::string_view field, const size_t, char& value)
+{
+    value = field.empty() ? '\0' : field[0];
+    return true;
+}
+
+static bool _fieldValue(std::string_view field, const size_t size, std::string& value)
+{
+    // Only keep the characters that fit in the column
+    value.assign(field.substr(0, size));
+    return true;
+}
+
+// Offset after the last line break outside quoted values, npos if there is none
+static size_t _lastLineEnd(const std::string& text)
+{
+    // The quotes after a line break tell whether it is inside a quoted value
+    bool quoted = std::count(text.begin(), text.end(), '"') & 1;
+    for (size_t i = text.size(); i-- > 0;)
+    {
+        if (text[i] == '"') quoted = !quoted;
+        else if (text[i] == '\n' && !quoted) return i + 1;
+    }
+    return std::string::npos;
+}
+
+CSVLoader::CSVLoader(std::shared_ptr<Table> table) : table(table), buffers(table->columnBuffers()), finished(false)
+{
+    // The workers read the sizes of the VARCHAR columns from here, not from the columns being appended to
+    for (auto& column : table->getMetaData())
+    {
+        std::shared_ptr<Column<std::string>> varchar = table->selectColumnString(column.first);
+        this->sizes.push_back(varchar ? varchar->getCharMax() : 0);
+    }
+}
+
+bool CSVLoader::load(const fs::path& path, const bool header, const bool write, CopyStats& stats)
+{
+    std::ifstream file(path, std::ifstream::in | std::ifstream::binary);
+    if (!file) return false;
+
+    // Map the column files if the table is cold, the chunks are appended to the columns
+    if (!this->table->load()) return false;
+
+    const size_t workers = std::max<size_t>(1, std::min<size_t>(COPY_MAX_WORKERS, std::thread::hardware_concurrency()));
+    this->finished = false;
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < workers; ++i) threads.emplace_back(&CSVLoader::parseLoop, this);
+
+    // Chunks in file order, the reader stays at most two chunks per worker ahead of the appends
+    std::deque<std::shared_ptr<Chunk>> chunks;
+    std::string carry;
+    size_t line = 0;            // Lines before the next chunk to append
+    bool more = true;
+    bool first = true;
+    bool success = true;
+
+    while (true)
+    {
+        while (more && chunks.size() < 2 * workers)
+        {
+            std::shared_ptr<Chunk> chunk = std::make_shared<Chunk>();
+            more = this->readChunk(file, carry, chunk->text, stats.bytes);
+            if (!more) break;
+
+            // Do nothing with the first line if it holds the headers
+            if (first && header)
+            {
+                const size_t end = chunk->text.find('\n');
+                chunk->text.erase(0, end == std::string::npos ? end : end + 1);
+                line = 1;
+            }
+            first = false;
+
+            chunks.push_back(chunk);
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                this->pending.push_back(chunk);
+            }
+            this->queued.notify_one();
+        }
+        if (chunks.empty()) break;
+
+        // Append the next chunk in file order once it is parsed
+        std::shared_ptr<Chunk> chunk = chunks.front();
+        chunks.pop_front();
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->parsed.wait(lock, [&chunk] { return chunk->parsed; });
+        }
+
+        // Stop reading if the table cannot take the rows, the chunks in flight are only waited for
+        if (success && !this->table->appendColumns(chunk->columns, chunk->rows, write)) success = more = false;
+        if (!success) continue;
+
+        stats.rows += chunk->rows;
+        if (chunk->rejected)
+        {
+            if (!stats.rejected) stats.first_rejected = line + chunk->first_rejected;
+            stats.rejected += chunk->rejected;
+        }
+        line += chunk->lines;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->finished = true;
+    }
+    this->queued.notify_all();
+    for (auto& thread : threads) thread.join();
+
+    return success;
+}
+
+bool CSVLoader::readChunk(std::ifstream& file, std::string& carry, std::string& text, uint64_t& bytes)
+{
+    text.swap(carry);
+    carry.clear();
+
+    while (file)
+    {
+        const size_t size = text.size();
+        text.resize(size + COPY_CHUNK_SIZE);
+        file.read(&text[size], COPY_CHUNK_SIZE);
+
+        const size_t count = file.gcount();
+        text.resize(size + count);
+        bytes += count;
+
+        // Cut after the last whole line, the rest starts the next chunk
+        const size_t end = _lastLineEnd(text);
+        if (file && end != std::string::npos)
+        {
+            carry.assign(text, end, std::string::npos);
+            text.resize(end);
+            return true;
+        }
+    }
+
+    // The end of the file ends the last line
+    return !text.empty();
+}
+
+void CSVLoader::parseLoop()
+{
+    // Reused for every chunk parsed by this worker
+    std::vector<uint32_t> separators;
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (true)
+    {
+        this->queued.wait(lock, [this] { return !this->pending.empty() || this->finished; });
+        if (this->pending.empty()) return;
+
+        std::shared_ptr<Chunk> chunk = this->pending.front();
+        this->pending.pop_front();
+
+        lock.unlock();
+        this->parseChunk(*chunk, separators);
+        lock.lock();
+
+        chunk->parsed = true;
+        this->parsed.notify_all();
+    }
+}
+
+void CSVLoader::parseChunk(Chunk& chunk, std::vector<uint32_t>& separators)
+{
+    const size_t column_count = this->buffers.size();
+    const std::string_view text(chunk.text);
+
+    // Records a rejected line of the chunk
+    auto reject = [&chunk](const size_t line) {
+        if (!chunk.rejected || line < chunk.first_rejected) chunk.first_rejected = line;
+        ++chunk.rejected;
+    };
+
+    // Find the commas and line breaks outside quoted values with the tokenizer (see csv.h). The
+    // end of the text ends the last line if it has no line break (or an unterminated quoted value).
+    separators.clear();
+    csvSeparators(text, separators);
+    if (!text.empty() && (text.back() != '\n' || separators.empty() || separators.back() != text.size() - 1)) separators.push_back((uint32_t)text.size());
+
+    // Field i ends at separator i, a line break may follow a carriage return
+    auto field = [&](const size_t i) -> std::string_view {
+        const size_t begin = i ? separators[i - 1] + 1 : 0;
+        size_t end = separators[i];
+        if (end > begin && text[end - 1] == '\r' && (end == text.size() || text[end] == '\n')) --end;
+        return text.substr(begin, end - begin);
+    };
+
+    // First field of every accepted row
+    std::vector<size_t> starts;
+    std::vector<size_t> lines;              // Line of every accepted row
+
+    size_t first = 0;
+    for (size_t i = 0; i < separators.size(); ++i)
+    {
+        if (separators[i] != text.size() && text[separators[i]] != '\n') continue;
+        ++chunk.lines;
+
+        // Empty lines are skipped, lines of the legacy csv tables end with a comma
+        size_t count = i - first + 1;
+        if (count == 1 && field(i).empty()) { first = i + 1; continue; }
+        if (count == column_count + 1 && field(i).empty()) --count;
+
+        if (count != column_count) reject(chunk.lines);
+        else
+        {
+            starts.push_back(first);
+            lines.push_back(chunk.lines);
+        }
+        first = i + 1;
+    }
+
+    /*  Convert the fields one column at a time into
+        buffers reserved for the chunk. A row with a
+        value that does not convert is rejected. **/
+    const size_t rows = lines.size();
+    std::vector<char> invalid(rows, 0);
+    bool any_invalid = false;
+
+    chunk.columns = this->buffers;
+    for (size_t col_index = 0; col_index < column_count; ++col_index)
+    {
+        std::visit([&](auto& elements) {
+            typedef typename std::decay_t<decltype(elements)>::value_type T;
+            std::string scratch;
+            elements.reserve(rows);
+            for (size_t row = 0; row < rows; ++row)
+            {
+                T value{};
+                if (!_fieldValue(csvUnquote(field(starts[row] + col_index), scratch), this->sizes[col_index], value)) invalid[row] = any_invalid = true;
+                elements.push_back(std::move(value));
+            }
+        }, chunk.columns[col_index]);
+    }
+
+    // Remove the rejected rows from every buffer
+    chunk.rows = rows;
+    if (any_invalid)
+    {
+        for (size_t row = 0; row < rows; ++row) {
+            if (invalid[row]) reject(lines[row]);
+        }
+        for (auto& column : chunk.columns)
+        {
+            std::visit([&](auto& elements) {
+                size_t kept = 0;
+                for (size_t row = 0; row < rows; ++row)
+                {
+                    if (invalid[row]) continue;
+                    if (kept != row) elements[kept] = std::move(elements[row]);
+                    ++kept;
+                }
+                elements.resize(kept);
+            }, column);
+        }
+        chunk.rows = rows - std::count(invalid.begin(), invalid.end(), 1);
+    }
+
+    // The text is not needed once the values are converted
+    std::string().swap(chunk.text);
+}
@@ -0,0 +1,85 @@
+/**
+ * File: loader.h
+ * Author: Mark Minkoff
+ * Functionality: Function declarations for file loader.cpp
+ * Streaming csv import (COPY t FROM 'file.csv', and the legacy csv tables). The file is read in
+ * chunks of COPY_CHUNK_SIZE bytes cut at line boundaries, and a pool of worker threads parses
+ * the chunks: the lines are split into fields, then the fields are converted a column at a time
+ * into buffers of the column types (std::from_chars for INT and FLOAT). The parsed chunks are
+ * appended to the table in file order, every column once per chunk, so the memory used by the
+ * import is bounded by the chunks in flight whatever the size of the file.
+ *
+ * Lines are split into values by the vectorized tokenizer of csv.h, a value in double quotes
+ * may hold commas. A line may end with a comma like the lines of the legacy csv tables.
+ * Empty lines are skipped, lines with a wrong number of values or a value that does not
+ * convert to its column are rejected and counted.
+ *
+ * */
+
+#ifndef LOADER_H_
+#define LOADER_H_
+
+#include "include.h"
+#include "table.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+const size_t COPY_CHUNK_SIZE = 1 << 20;     // Bytes read from the file per chunk
+const size_t COPY_MAX_WORKERS = 8;          // Parser threads, at most one per hardware thread
+
+typedef struct CopyStats {
+    size_t rows = 0;                // Rows appended to the table
+    size_t rejected = 0;            // Lines that were not appended
+    size_t first_rejected = 0;      // Line number of the first rejected line, counted from 1
+    uint64_t bytes = 0;             // Bytes read from the file
+} CopyStats;
+
+class CSVLoader
+{
+private:
+    // Whole lines of the file and the rows parsed from them
+    typedef struct Chunk {
+        std::string text;
+        std::vector<ColumnValues> columns;  // Accepted rows converted to the column types
+        size_t rows = 0;
+        size_t lines = 0;                   // Lines in the text
+        size_t rejected = 0;
+        size_t first_rejected = 0;          // Line of the first rejected line in the text, counted from 1
+        bool parsed = false;
+    } Chunk;
+
+    std::shared_ptr<Table> table;
+    std::vector<ColumnValues> buffers;      // Empty buffers of the column types (see Table::columnBuffers)
+    std::vector<size_t> sizes;              // Size of every VARCHAR column
+
+    std::mutex mutex;                       // Guards everything below
+    std::condition_variable queued;         // Wakes the workers
+    std::condition_variable parsed;         // Wakes the reader
+    std::deque<std::shared_ptr<Chunk>> pending;     // Chunks waiting for a worker
+    bool finished;                                  // The file has been read, the workers exit
+
+    /** Worker thread: parses the pending chunks */
+    void parseLoop();
+
+    /** Splits the lines of a chunk into fields and converts them a column at a time, 'separators' is a buffer of the worker */
+    void parseChunk(Chunk& chunk, std::vector<uint32_t>& separators);
+
+    /** Reads the next chunk of whole lines, 'carry' holds the start of a line cut by the previous read */
+    bool readChunk(std::ifstream& file, std::string& carry, std::string& text, uint64_t& bytes);
+
+public:
+    CSVLoader(std::shared_ptr<Table> table);
+
+    CSVLoader(const CSVLoader&) = delete;
+    CSVLoader& operator=(const CSVLoader&) = delete;
+
+    /** Appends the lines of a csv file to the table, skipping the first one if it is a 'header'. The rows are
+     *  not logged, they are stored at the next checkpoint when 'write' is set. False if the file cannot be read
+     *  or the table cannot be loaded. */
+    bool load(const fs::path& path, const bool header, const bool write, CopyStats& stats);
+};
+
+#endif // LOADER_H_
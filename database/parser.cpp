@@ -0,0 +1,729 @@
+/**
+ * File: parser.cpp
+ * Author: Mark Minkoff
+ * Functionality: Function definitions for file parser.h
+ *
+ * */
+
+#include "parser.h"
+
+// Characters that end a word
+static bool _endsWord(const char c)
+{
+    return isspace((unsigned char)c) || c == '(' || c == ')' || c == ',' || c == ';' || c == '*' ||
+           c == '\'' || c == '"' || c == '=' || c == '!' || c == '<' || c == '>';
+}
+
+bool tokenize(std::string_view text, std::vector<Token>& tokens, std::string& error)
+{
+    // Depth of the open parenthesis, negative once a ) closes nothing
+    long depth = 0;
+    bool balanced = true;
+
+    size_t i = 0;
+    while (i < text.size())
+    {
+        const char c = text[i];
+        if (isspace((unsigned char)c)) { ++i; continue; }
+
+        if (c == '\'' || c == '"')
+        {
+            const size_t end = text.find(c, i + 1);
+            if (end == std::string_view::npos) { error = "-- !Unterminated string " + std::string(text.substr(i)); return false; }
+            tokens.push_back({ TOKEN_STRING, text.substr(i + 1, end - i - 1) });
+            i = end + 1;
+        }
+        else if (c == '(' || c == ')' || c == ',' || c == ';' || c == '*')
+        {
+            if (c == '(') ++depth;
+            else if (c == ')' && --depth < 0) balanced = false;
+            tokens.push_back({ TOKEN_SYMBOL, text.substr(i, 1) });
+            ++i;
+        }
+        else if (c == '=' || c == '!' || c == '<' || c == '>')
+        {
+            // Two character operators: != <> <= >=
+            size_t length = 1;
+            if (i + 1 < text.size() && (text[i + 1] == '=' || (c == '<' && text[i + 1] == '>'))) length = 2;
+            if (c == '!' && length == 1) { error = "-- !Unknown operator !"; return false; }
+            tokens.push_back({ TOKEN_SYMBOL, text.substr(i, length) });
+            i += length;
+        }
+        else
+        {
+            size_t end = i;
+            while (end < text.size() && !_endsWord(text[end])) ++end;
+            tokens.push_back({ TOKEN_WORD, text.substr(i, end - i) });
+            i = end;
+        }
+    }
+
+    if (!balanced || depth) { error = "-- !Parenthsis are not balanced in input: " + std::string(text); return false; }
+    return true;
+}
+
+// Upper case copy of a token
+static std::string _upper(std::string_view text)
+{
+    std::string up(text);
+    for (auto& c : up) c = _toUpper(c);
+    return up;
+}
+
+// A word is the keyword 'word' (upper case), compared without an upper case copy
+static bool _isKeyword(std::string_view text, const char* word)
+{
+    const size_t length = strlen(word);
+    if (text.size() != length) return false;
+    for (size_t i = 0; i < length; ++i) {
+        if (_toUpper(text[i]) != word[i]) return false;
+    }
+    return true;
+}
+
+// Recursive descent parser over the tokens of one statement
+class StatementParser
+{
+private:
+    const std::vector<Token>& tokens;
+    size_t position;
+    size_t* parameters;     // Number of placeholders read, nullptr if they are not accepted
+
+    /** Records the first error, always false */
+    bool fail(const std::string& message)
+    {
+        if (this->error.empty()) this->error = message;
+        return false;
+    }
+
+    /** The current token is the keyword 'word' (upper case) */
+    bool keyword(const char* word) const
+    {
+        if (this->done() || this->tokens[this->position].type != TOKEN_WORD) return false;
+        return _isKeyword(this->tokens[this->position].text, word);
+    }
+
+    /** The current token is the symbol 'text' */
+    bool symbol(const char* text) const
+    {
+        return !this->done() && this->tokens[this->position].type == TOKEN_SYMBOL && this->tokens[this->position].text == text;
+    }
+
+    bool acceptKeyword(const char* word)
+    {
+        if (!this->keyword(word)) return false;
+        ++this->position;
+        return true;
+    }
+
+    bool acceptSymbol(const char* text)
+    {
+        if (!this->symbol(text)) return false;
+        ++this->position;
+        return true;
+    }
+
+    /** Text of the current token, empty at the end of the statement */
+    std::string current() const
+    {
+        return this->done() ? std::string() : std::string(this->tokens[this->position].text);
+    }
+
+    /** Reads a name (an unquoted word) */
+    bool name(std::string& res)
+    {
+        if (this->done() || this->tokens[this->position].type != TOKEN_WORD) return false;
+        res = std::string(this->tokens[this->position++].text);
+        return true;
+    }
+
+    /** Reads a value (a word or a quoted string) */
+    bool value(std::string& res)
+    {
+        if (this->done() || this->tokens[this->position].type == TOKEN_SYMBOL) return false;
+        res = std::string(this->tokens[this->position++].text);
+        return true;
+    }
+
+    /** Reads a placeholder (an unquoted ?) if they are accepted, 'res' is its number */
+    bool placeholder(int& res)
+    {
+        if (!this->parameters || this->done() || this->tokens[this->position].type != TOKEN_WORD || this->tokens[this->position].text != "?") return false;
+        res = (int)(*this->parameters)++;
+        ++this->position;
+        return true;
+    }
+
+    /** Fails with the remaining tokens unless the statement ends here */
+    bool end(const std::string& command)
+    {
+        if (this->done()) return true;
+
+        std::string message = "-- [CMD-" + command + " - ERROR] -> Unknown Argument(s): {";
+        for (size_t i = this->position; i < this->tokens.size(); ++i)
+        {
+            if (i > this->position) message += ", ";
+            message += this->tokens[i].text;
+        }
+        return this->fail(message + "}");
+    }
+
+    /** Reads a column type: a word with an optional size, e.g. int or varchar(10) */
+    bool type(std::string& res)
+    {
+        if (!this->name(res)) return false;
+        if (!this->symbol("(")) return true;
+
+        std::string size;
+        ++this->position;
+        if (!this->value(size) || !this->acceptSymbol(")")) return false;
+        res += "(" + size + ")";
+        return true;
+    }
+
+    /** Reads (name type, name type, ...), or a single name type when 'bare' is true */
+    bool columnList(std::vector<std::pair<std::string, std::string>>& columns, const bool bare)
+    {
+        if (bare && !this->symbol("("))
+        {
+            std::string column, column_type;
+            if (!this->name(column) || !this->type(column_type)) return this->fail("-- !Column arguments are not a name followed by a type");
+            columns.emplace_back(column, column_type);
+            return true;
+        }
+
+        if (!this->acceptSymbol("(")) return this->fail("-- !Column arguments for CREATE TABLE are not wrapped with ()");
+
+        while (true)
+        {
+            std::string column, column_type;
+            if (!this->name(column) || !this->type(column_type)) return this->fail("-- !Column arguments for CREATE TABLE are not a name followed by a type");
+            columns.emplace_back(column, column_type);
+
+            if (this->acceptSymbol(")")) return true;
+            if (!this->acceptSymbol(",")) return this->fail("-- !CREATE table error: Missing ',' after datatype " + column_type + ".");
+        }
+    }
+
+    /** Parses a condition, the errors start with 'context' */
+    std::shared_ptr<Predicate> condition(const std::string& context)
+    {
+        std::shared_ptr<Predicate> predicate = this->expression();
+        if (predicate && !this->done()) { predicate = nullptr; this->error = "Unexpected " + this->current() + " in condition"; }
+        if (!predicate) this->error = context + this->error;
+        return predicate;
+    }
+
+    /** Joins the operands of a chain of one operator, a single operand is returned as is */
+    static std::shared_ptr<Predicate> chain(const PredicateType type, std::vector<std::shared_ptr<Predicate>>&& operands)
+    {
+        if (operands.size() == 1) return operands[0];
+
+        auto predicate = std::make_shared<Predicate>();
+        predicate->type = type;
+        predicate->children = std::move(operands);
+        return predicate;
+    }
+
+    std::shared_ptr<Predicate> expression()
+    {
+        std::vector<std::shared_ptr<Predicate>> operands;
+        do {
+            auto operand = this->term();
+            if (!operand) return nullptr;
+            operands.push_back(operand);
+        } while (this->acceptKeyword("OR"));
+
+        return chain(PREDICATE_OR, std::move(operands));
+    }
+
+    std::shared_ptr<Predicate> term()
+    {
+        std::vector<std::shared_ptr<Predicate>> operands;
+        do {
+            auto operand = this->factor();
+            if (!operand) return nullptr;
+            operands.push_back(operand);
+        } while (this->acceptKeyword("AND"));
+
+        return chain(PREDICATE_AND, std::move(operands));
+    }
+
+    std::shared_ptr<Predicate> factor()
+    {
+        if (this->done()) { this->fail("Incomplete condition"); return nullptr; }
+
+        if (this->acceptKeyword("NOT"))
+        {
+            auto operand = this->factor();
+            if (!operand) return nullptr;
+
+            auto predicate = std::make_shared<Predicate>();
+            predicate->type = PREDICATE_NOT;
+            predicate->children.push_back(operand);
+            return predicate;
+        }
+
+        if (this->acceptSymbol("("))
+        {
+            auto inner = this->expression();
+            if (!inner) return nullptr;
+            if (!this->acceptSymbol(")")) { this->fail("Missing ) in condition"); return nullptr; }
+            return inner;
+        }
+
+        // column operator value
+        if (this->position + 3 > this->tokens.size()) { this->fail("Incomplete comparison starting at " + this->current()); return nullptr; }
+
+        const Token& column = this->tokens[this->position];
+        const Token& op = this->tokens[this->position + 1];
+        const Token& value = this->tokens[this->position + 2];
+
+        if (column.type != TOKEN_WORD) { this->fail("Expected a column name, found " + std::string(column.text)); return nullptr; }
+
+        std::string opr = op.type == TOKEN_STRING ? std::string() : std::string(op.text);
+        if (op.type == TOKEN_WORD) opr = _upper(opr);
+        if (opr == "<>") opr = "!=";
+        if (!_isValidOperator(opr)) { this->fail("The operator " + std::string(op.text) + " is not supported"); return nullptr; }
+
+        if (value.type == TOKEN_SYMBOL) { this->fail("Expected a value after " + std::string(column.text) + " " + std::string(op.text)); return nullptr; }
+
+        this->position += 2;
+        int parameter = -1;
+        if (this->placeholder(parameter))
+        {
+            auto predicate = makeComparison(std::string(column.text), opr, std::string());
+            predicate->parameter = parameter;
+            return predicate;
+        }
+
+        ++this->position;
+        return makeComparison(std::string(column.text), opr, std::string(value.text));
+    }
+
+    bool create(Statement& statement)
+    {
+        if (this->acceptKeyword("DATABASE"))
+        {
+            CreateDatabaseStatement create;
+            if (!this->name(create.database_name)) return this->fail("-- [CMD - CREATE - ERROR] -> Supplied argument count (" + std::to_string(this->tokens.size()) + ") does not match required argument count (3)");
+            statement = std::move(create);
+            return this->end("CREATE");
+        }
+
+        if (this->acceptKeyword("TABLE"))
+        {
+            CreateTableStatement create;
+            if (!this->name(create.table_name)) return this->fail("-- !Missing table name after CREATE TABLE");
+            if (!this->done() && !this->columnList(create.columns, false)) return false;
+            statement = std::move(create);
+            return this->end("CREATE");
+        }
+
+        if (this->acceptKeyword("INDEX"))
+        {
+            CreateIndexStatement create;
+            if (!this->name(create.index_name) || !this->acceptKeyword("ON") || !this->name(create.table_name)) {
+                return this->fail("-- !Invalid CREATE INDEX command. Correct format is CREATE INDEX index_name ON table_name(column) [USING HASH|BTREE|ART]");
+            }
+            if (!this->acceptSymbol("(") || !this->name(create.column_name) || !this->acceptSymbol(")")) {
+                return this->fail("-- !Column of index " + create.index_name + " is not wrapped with ()");
+            }
+
+            // Indexes are hash indexes unless USING names another type
+            if (!this->done() && (!this->acceptKeyword("USING") || !this->name(create.index_type) || !this->done())) {
+                return this->fail("-- !Unknown index type. Use USING HASH, USING BTREE or USING ART");
+            }
+            statement = std::move(create);
+            return true;
+        }
+
+        if (this->done()) return this->fail("-- !Missing argument for command CREATE. Did you mean CREATE DATABASE, CREATE TABLE or CREATE INDEX?");
+        return this->fail(_upper(this->current()) + " is not a valid argument of command CREATE.");
+    }
+
+    bool drop(Statement& statement)
+    {
+        if (this->acceptKeyword("DATABASE"))
+        {
+            DropDatabaseStatement drop;
+            if (!this->name(drop.database_name)) return this->fail("-- [CMD - DROP - ERROR] -> Supplied argument count (" + std::to_string(this->tokens.size()) + ") does not match required argument count (3)");
+            statement = std::move(drop);
+            return this->end("DROP");
+        }
+
+        if (this->acceptKeyword("TABLE"))
+        {
+            DropTableStatement drop;
+            if (!this->name(drop.table_name)) return this->fail("-- !Missing table name after DROP TABLE");
+            statement = std::move(drop);
+            return this->end("DROP");
+        }
+
+        if (this->acceptKeyword("INDEX"))
+        {
+            DropIndexStatement drop;
+            if (!this->name(drop.index_name) || !this->done()) return this->fail("-- !Invalid DROP INDEX command. Correct format is DROP INDEX index_name");
+            statement = std::move(drop);
+            return true;
+        }
+
+        if (this->done()) return this->fail("-- !Missing argument for command DROP. Did you mean DROP DATABASE, DROP TABLE or DROP INDEX?");
+        return this->fail(_upper(this->current()) + " is not a valid argument of command DROP.");
+    }
+
+    bool use(Statement& statement)
+    {
+        UseStatement use;
+        if (!this->name(use.database_name)) return this->fail("-- !SQL::useDatabase provided empty database_name.");
+        statement = std::move(use);
+        return this->end("USE");
+    }
+
+    bool alter(Statement& statement)
+    {
+        AlterTableStatement alter;
+        if (!this->acceptKeyword("TABLE") || !this->name(alter.table_name) || !this->name(alter.action)) {
+            return this->fail("-- !Invalid ALTER TABLE command. Correct format is ALTER TABLE table_name action (column type, ...)");
+        }
+        if (!this->columnList(alter.columns, true)) return false;
+        statement = std::move(alter);
+        return this->end("ALTER");
+    }
+
+    bool compact(Statement& statement)
+    {
+        CompactTableStatement compact;
+        if (!this->acceptKeyword("TABLE") || !this->name(compact.table_name)) {
+            return this->fail("-- !Invalid COMPACT TABLE command. Correct format is COMPACT TABLE table_name");
+        }
+        statement = std::move(compact);
+        return this->end("COMPACT");
+    }
+
+    bool copy(Statement& statement)
+    {
+        const std::string usage = "-- !Invalid COPY command. Correct format is COPY table_name FROM 'file.csv' [HEADER] or COPY table_name TO 'file' [FORMAT CSV|BINARY|JSONL] [HEADER] [WHERE condition]";
+
+        std::string table_name;
+        if (!this->name(table_name)) return this->fail(usage);
+
+        if (this->acceptKeyword("TO")) return this->copyTo(statement, table_name, usage);
+
+        CopyFromStatement copy;
+        copy.table_name = table_name;
+        if (!this->acceptKeyword("FROM") || !this->value(copy.path)) return this->fail(usage);
+        copy.header = this->acceptKeyword("HEADER");
+        statement = std::move(copy);
+        return this->end("COPY");
+    }
+
+    bool copyTo(Statement& statement, const std::string& table_name, const std::string& usage)
+    {
+        CopyToStatement copy;
+        copy.table_name = table_name;
+        if (!this->value(copy.path)) return this->fail(usage);
+
+        // Files are csv files unless FORMAT names another format
+        if (this->acceptKeyword("FORMAT") && !this->name(copy.format)) return this->fail("-- !Unknown file format. Use FORMAT CSV, FORMAT BINARY or FORMAT JSONL");
+        copy.header = this->acceptKeyword("HEADER");
+
+        if (this->acceptKeyword("WHERE"))
+        {
+            copy.where = this->condition("-- !Failed to copy table " + table_name + ". ");
+            if (!copy.where) return false;
+        }
+
+        statement = std::move(copy);
+        return this->end("COPY");
+    }
+
+    bool select(Statement& statement)
+    {
+        if (this->acceptSymbol("*"))
+        {
+            if (!this->acceptKeyword("FROM")) return this->fail("-- !Unknown argument from command SELECT *: " + _upper(this->current()) + ". Did you mean FROM?");
+
+            std::string table_name;
+            if (!this->name(table_name)) return this->fail("-- !Invalid number of arguments for command SELECT");
+
+            // SELECT * FROM {{ table_name }}
+            if (this->done())
+            {
+                SelectStatement select;
+                select.table_name = table_name;
+                statement = std::move(select);
+                return true;
+            }
+
+            return this->join(statement, table_name);
+        }
+
+        SelectStatement select;
+        while (!this->done() && !this->keyword("FROM"))
+        {
+            std::string column;
+            if (!this->name(column)) return this->fail("-- !Failed to query any tables. Invalid column name " + this->current());
+            select.columns.push_back(column);
+            this->acceptSymbol(",");
+        }
+
+        if (select.columns.empty()) return this->fail("-- !Failed to query any tables. Did you for get the add column names after the SELECT statement?");
+        if (!this->acceptKeyword("FROM") || !this->name(select.table_name)) return this->fail("-- !Invalid number of arguments for command SELECT");
+
+        if (this->done()) return this->fail("-- !Invalid number of arguments for command SELECT");
+        if (!this->acceptKeyword("WHERE")) return this->fail("--!Failed to query table " + select.table_name + ". Unknown argument " + _upper(this->current()) + ". Did you mean 'WHERE'?");
+
+        select.where = this->condition("-- !Failed to query table " + select.table_name + ". ");
+        if (!select.where) return false;
+
+        statement = std::move(select);
+        return true;
+    }
+
+    bool join(Statement& statement, const std::string& table_name)
+    {
+        JoinStatement join;
+        join.table1.first = table_name;
+        join.left = true; join.right = false; join.inner = true;
+
+        if (!this->name(join.table1.second)) return this->fail("== !Incorrect table clause for SELECT * FROM");
+
+        // t1 a, t2 b or t1 a [INNER|LEFT|RIGHT|FULL] [OUTER] JOIN t2 b
+        if (!this->acceptSymbol(","))
+        {
+            if (this->acceptKeyword("RIGHT")) { join.left = false; join.right = true; }
+            else if (this->acceptKeyword("FULL")) join.right = true;
+            else if (!this->acceptKeyword("LEFT")) this->acceptKeyword("INNER");
+
+            if (this->acceptKeyword("OUTER")) join.inner = false;
+            if (!this->acceptKeyword("JOIN")) return this->fail("== !Incorrect table clause for SELECT * FROM");
+        }
+
+        if (!this->name(join.table2.first) || !this->name(join.table2.second)) return this->fail("== !Incorrect table clause for SELECT * FROM");
+
+        if (this->keyword("WHERE") || this->keyword("ON")) join.keyword = _upper(this->tokens[this->position++].text);
+        else return this->fail("-- !Query failed. Missing 'WHERE' or 'ON' token");
+
+        // alias.column operator alias.column
+        if (!this->name(join.column1) || this->done() || this->tokens[this->position].type != TOKEN_SYMBOL) return this->fail("-- !Failed query. Invalid query statement");
+        join.op = this->current();
+        ++this->position;
+        if (!this->name(join.column2) || !this->done()) return this->fail("-- !Failed query. Invalid query statement");
+
+        if (!_isValidOperator(join.op)) return this->fail("-- !Failed to query tables. Invalid operator " + join.op + "Did you mean '='?");
+
+        statement = std::move(join);
+        return true;
+    }
+
+    bool insert(Statement& statement)
+    {
+        InsertStatement insert;
+        if (!this->acceptKeyword("INTO")) return this->fail("-- Invalid insert specifier: " + _upper(this->current()));
+        if (!this->name(insert.table_name)) return this->fail("-- !Missing table name after INSERT INTO");
+
+        if (!this->acceptKeyword("VALUES") || !this->acceptSymbol("(")) {
+            return this->fail("-- INSERT INTO parameters not formatted correctly. Correct format is VALUES(x, y, z, ...)");
+        }
+
+        // VALUES(...), (...), ... holds the rows one after the other
+        size_t row_size = 0;
+        while (true)
+        {
+            do {
+                std::string value;
+                int parameter = -1;
+                if (!this->placeholder(parameter) && !this->value(value)) return this->fail("-- INSERT INTO parameters not formatted correctly. Correct format is VALUES(x, y, z, ...)");
+                insert.values.push_back(std::move(value));
+                insert.parameters.push_back(parameter);
+            } while (this->acceptSymbol(","));
+
+            if (!this->acceptSymbol(")")) return this->fail("-- INSERT INTO parameters not formatted correctly. Correct format is VALUES(x, y, z, ...)");
+
+            // Every row has as many values as the first one
+            if (!row_size) row_size = insert.values.size();
+            else if (insert.values.size() != row_size * insert.row_count) return this->fail("-- INSERT INTO rows must all have the same number of values");
+
+            if (!this->acceptSymbol(",")) break;
+            if (!this->acceptSymbol("(")) return this->fail("-- INSERT INTO parameters not formatted correctly. Correct format is VALUES(x, y, z, ...), (x, y, z, ...)");
+            ++insert.row_count;
+        }
+
+        if (!this->done()) return this->fail("-- INSERT INTO parameters not formatted correctly. Correct format is VALUES(x, y, z, ...)");
+
+        statement = std::move(insert);
+        return true;
+    }
+
+    bool update(Statement& statement)
+    {
+        UpdateStatement update;
+        if (!this->name(update.table_name)) return this->fail("-- !Missing table name after UPDATE");
+        if (!this->acceptKeyword("SET")) return this->fail("-- Unknown command " + _upper(this->current()) + ". Did you mean SET?");
+        if (!this->name(update.column_name)) return this->fail("-- !Missing column name after SET");
+
+        if (!this->acceptSymbol("=")) return this->fail("-- !Failed to update table " + update.table_name + " because the first operator " + this->current() + " is not supported. Did you mean '='?");
+        if (!this->placeholder(update.parameter) && !this->value(update.value)) return this->fail("-- !Missing value after SET " + update.column_name + " =");
+
+        if (!this->acceptKeyword("WHERE")) return this->fail("--!Failed to update table " + update.table_name + ". Unknown argument " + _upper(this->current()) + ". Did you mean 'WHERE'?");
+
+        update.where = this->condition("-- !Failed to update table " + update.table_name + ". ");
+        if (!update.where) return false;
+
+        statement = std::move(update);
+        return true;
+    }
+
+    bool remove(Statement& statement)
+    {
+        DeleteStatement remove;
+        if (!this->acceptKeyword("FROM")) return this->fail("-- Unknown command " + _upper(this->current()) + ". Did you mean FROM?");
+        if (!this->name(remove.table_name)) return this->fail("-- !Missing table name after DELETE FROM");
+        if (!this->acceptKeyword("WHERE")) return this->fail("-- Unknown command " + _upper(this->current()) + ". Did you mean WHERE?");
+
+        remove.where = this->condition("-- !Failed to delete from table " + remove.table_name + ". ");
+        if (!remove.where) return false;
+
+        statement = std::move(remove);
+        return true;
+    }
+
+    bool show(Statement& statement)
+    {
+        ShowStatement show;
+        if (this->done()) return this->fail("-- !Missing argument for command SHOW. Did you mean SHOW TABLES, SHOW INDEXES or SHOW STATS?");
+        show.what = _upper(this->tokens[this->position++].text);
+        statement = std::move(show);
+        return this->end("SHOW");
+    }
+
+    bool set(Statement& statement)
+    {
+        // SET {{ setting }} [=] {{ value }}
+        SetStatement set;
+        if (!this->name(set.setting)) return this->fail("-- !Invalid number of arguments for command SET. Correct format is SET setting value");
+        set.setting = _upper(set.setting);
+        this->acceptSymbol("=");
+        if (!this->value(set.value) || !this->done()) return this->fail("-- !Invalid number of arguments for command SET. Correct format is SET setting value");
+
+        statement = std::move(set);
+        return true;
+    }
+
+public:
+    std::string error;
+
+    StatementParser(const std::vector<Token>& tokens, size_t* parameters = nullptr) : tokens(tokens), position(0), parameters(parameters) {}
+
+    bool done() const { return this->position >= this->tokens.size(); }
+
+    bool statement(Statement& statement)
+    {
+        if (this->done()) return false;
+
+        if (this->acceptKeyword("CREATE")) return this->create(statement);
+        if (this->acceptKeyword("DROP")) return this->drop(statement);
+        if (this->acceptKeyword("USE")) return this->use(statement);
+        if (this->acceptKeyword("ALTER")) return this->alter(statement);
+        if (this->acceptKeyword("COMPACT")) return this->compact(statement);
+        if (this->acceptKeyword("SELECT")) return this->select(statement);
+        if (this->acceptKeyword("INSERT")) return this->insert(statement);
+        if (this->acceptKeyword("UPDATE")) return this->update(statement);
+        if (this->acceptKeyword("DELETE")) return this->remove(statement);
+        if (this->acceptKeyword("COPY")) return this->copy(statement);
+        if (this->acceptKeyword("SHOW")) return this->show(statement);
+        if (this->acceptKeyword("SET")) return this->set(statement);
+
+        if (this->acceptKeyword("BEGIN"))
+        {
+            if (this->done()) return this->fail("-- !Missing argument for command BEGIN. Did you mean BEGIN TRANSACTION?");
+            if (!this->acceptKeyword("TRANSACTION")) return this->fail("-- !Unknown argument " + _upper(this->current()) + ". Did you mean BEGIN TRANSACTION?");
+            statement = BeginStatement();
+            return this->end("BEGIN TRANSACTION");
+        }
+        if (this->acceptKeyword("COMMIT")) { statement = CommitStatement(); return this->end("COMMIT"); }
+        if (this->acceptKeyword("CLEAR")) { statement = ClearStatement(); return this->end("CLEAR"); }
+
+        return this->fail("-- Command " + _upper(this->current()) + " does not exist.");
+    }
+
+    std::shared_ptr<Predicate> predicate()
+    {
+        return this->condition("");
+    }
+};
+
+bool parseStatement(std::string_view text, Statement& statement, std::string& error, size_t* parameters)
+{
+    std::vector<Token> tokens;
+    if (!tokenize(text, tokens, error)) return false;
+
+    if (parameters) *parameters = 0;
+    StatementParser parser(tokens, parameters);
+    if (parser.statement(statement)) return true;
+
+    error = parser.error;
+    return false;
+}
+
+bool normalizeStatement(std::string_view text, std::string& normalized, std::vector<std::string>& values)
+{
+    std::vector<Token> tokens;
+    std::string error;
+    if (!tokenize(text, tokens, error) || tokens.empty() || tokens[0].type != TOKEN_WORD) return false;
+
+    // Only statements on the rows of a table have values
+    const std::string_view command = tokens[0].text;
+    if (!_isKeyword(command, "INSERT") && !_isKeyword(command, "SELECT") && !_isKeyword(command, "UPDATE") && !_isKeyword(command, "DELETE")) return false;
+
+    normalized.clear();
+    values.clear();
+
+    bool after_values = false;  // Past VALUES, every row (...) holds values
+    bool in_values = false;     // Inside VALUES(...)
+    for (size_t i = 0; i < tokens.size(); ++i)
+    {
+        const Token& token = tokens[i];
+
+        bool value = token.type == TOKEN_STRING;
+        if (token.type == TOKEN_WORD && i > 0)
+        {
+            const Token& previous = tokens[i - 1];
+            if (previous.type == TOKEN_SYMBOL)
+            {
+                const char c = previous.text[0];
+                value = c == '=' || c == '!' || c == '<' || c == '>' || (in_values && (c == '(' || c == ','));
+            }
+            else value = previous.type == TOKEN_WORD && _isKeyword(previous.text, "LIKE");
+        }
+
+        if (token.type == TOKEN_SYMBOL)
+        {
+            if (token.text == "(" && i > 0 && tokens[i - 1].type == TOKEN_WORD && _isKeyword(tokens[i - 1].text, "VALUES")) after_values = in_values = true;
+            else if (token.text == "(" && after_values) in_values = true;
+            else if (token.text == ")") in_values = false;
+        }
+
+        if (i) normalized += ' ';
+        if (value)
+        {
+            normalized += '?';
+            values.emplace_back(token.text);
+        }
+        else normalized += token.text;
+    }
+    return true;
+}
+
+std::shared_ptr<Predicate> parsePredicate(const std::string& text, std::string& error)
+{
+    std::vector<Token> tokens;
+    if (!tokenize(text, tokens, error)) return nullptr;
+    if (tokens.empty()) { error = "Missing condition after WHERE"; return nullptr; }
+
+    StatementParser parser(tokens);
+    std::shared_ptr<Predicate> predicate = parser.predicate();
+    if (!predicate) error = parser.error;
+    return predicate;
+}
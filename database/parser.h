@@ -0,0 +1,183 @@
+/**
+ * File: parser.h
+ * Author: Mark Minkoff
+ * Functionality: Function declarations for file parser.cpp
+ * Lexer and recursive descent parser of the SQL statements. A statement is split into
+ * tokens once; tokens are views into the statement text, so no string is copied until the
+ * parser stores a name or a value in the statement it builds.
+ *
+ *   CREATE DATABASE db                         DROP DATABASE db
+ *   CREATE TABLE t (column type, ...)          DROP TABLE t
+ *   CREATE INDEX i ON t(column) [USING type]   DROP INDEX i
+ *   ALTER TABLE t action (column type, ...)    USE db
+ *   COMPACT TABLE t
+ *   SELECT * FROM t
+ *   SELECT * FROM t1 a, t2 b WHERE a.x op b.y
+ *   SELECT * FROM t1 a [INNER|LEFT|RIGHT|FULL] [OUTER] JOIN t2 b ON a.x op b.y
+ *   SELECT column, ... FROM t WHERE condition
+ *   INSERT INTO t VALUES(value, ...)[, (value, ...) ...]
+ *   UPDATE t SET column = value WHERE condition
+ *   DELETE FROM t WHERE condition
+ *   COPY t FROM 'file.csv' [HEADER]
+ *   COPY t TO 'file' [FORMAT CSV|BINARY|JSONL] [HEADER] [WHERE condition]
+ *   BEGIN TRANSACTION    COMMIT    CLEAR    SHOW what    SET setting [=] value
+ *
+ * Keywords are case-insensitive, values are numbers, words or quoted strings ('' or "").
+ * Conditions are predicates (see predicate.h). In prepared statements (see prepared.h) a ?
+ * placeholder can stand for a value of INSERT, of SET or of a comparison. Placeholders are
+ * numbered from 0 in the order they are written.
+ *
+ * */
+
+#ifndef PARSER_H_
+#define PARSER_H_
+
+#include "include.h"
+#include "predicate.h"
+
+#include <string_view>
+
+enum TokenType
+{
+    TOKEN_WORD = 0,     // Keyword, name or unquoted value
+    TOKEN_STRING,       // Quoted string, the view excludes the quotes
+    TOKEN_SYMBOL,       // ( ) , * or a comparison operator (= != <> < <= > >=)
+};
+
+typedef struct Token {
+    TokenType type;
+    std::string_view text;  // View into the statement text
+} Token;
+
+/** Splits a statement into tokens, returns false and sets 'error' if a string is not terminated
+ *  or the parenthesis are not balanced */
+bool tokenize(std::string_view text, std::vector<Token>& tokens, std::string& error);
+
+typedef struct CreateDatabaseStatement {
+    std::string database_name;
+} CreateDatabaseStatement;
+
+typedef struct DropDatabaseStatement {
+    std::string database_name;
+} DropDatabaseStatement;
+
+typedef struct UseStatement {
+    std::string database_name;
+} UseStatement;
+
+typedef struct CreateTableStatement {
+    std::string table_name;
+    std::vector<std::pair<std::string, std::string>> columns;   // (name, type) as written, e.g. (name, varchar(10))
+} CreateTableStatement;
+
+typedef struct DropTableStatement {
+    std::string table_name;
+} DropTableStatement;
+
+typedef struct AlterTableStatement {
+    std::string table_name;
+    std::string action;
+    std::vector<std::pair<std::string, std::string>> columns;
+} AlterTableStatement;
+
+typedef struct CompactTableStatement {
+    std::string table_name;
+} CompactTableStatement;
+
+typedef struct CreateIndexStatement {
+    std::string index_name;
+    std::string table_name;
+    std::string column_name;
+    std::string index_type;     // Name after USING, empty for the default (hash)
+} CreateIndexStatement;
+
+typedef struct DropIndexStatement {
+    std::string index_name;
+} DropIndexStatement;
+
+typedef struct SelectStatement {
+    std::string table_name;
+    std::vector<std::string> columns;   // Empty for SELECT *
+    std::shared_ptr<Predicate> where;   // nullptr for SELECT * FROM t
+} SelectStatement;
+
+typedef struct JoinStatement {
+    std::pair<std::string, std::string> table1;     // (table name, alias)
+    std::pair<std::string, std::string> table2;
+    bool left;                          // Unmatched rows of table1 are kept (outer joins)
+    bool right;                         // Unmatched rows of table2 are kept (outer joins)
+    bool inner;                         // False for OUTER joins
+    std::string keyword;                // WHERE or ON
+    std::string column1;                // alias.column
+    std::string op;
+    std::string column2;
+} JoinStatement;
+
+typedef struct InsertStatement {
+    std::string table_name;
+    std::vector<std::string> values;    // Values without their quotes, the rows one after the other
+    std::vector<int> parameters;        // Placeholder of every value, -1 for a literal
+    size_t row_count = 1;               // Rows of VALUES(...), (...), ...
+} InsertStatement;
+
+typedef struct UpdateStatement {
+    std::string table_name;
+    std::string column_name;
+    std::string value;
+    int parameter = -1;                 // Placeholder of the value, -1 for a literal
+    std::shared_ptr<Predicate> where;
+} UpdateStatement;
+
+typedef struct DeleteStatement {
+    std::string table_name;
+    std::shared_ptr<Predicate> where;
+} DeleteStatement;
+
+typedef struct CopyFromStatement {
+    std::string table_name;
+    std::string path;
+    bool header = false;                // The first line of the file holds the column names
+} CopyFromStatement;
+
+typedef struct CopyToStatement {
+    std::string table_name;
+    std::string path;
+    std::string format;                 // Name after FORMAT, empty for the default (csv)
+    bool header = false;                // The first line of the file holds the column names
+    std::shared_ptr<Predicate> where;   // nullptr to copy every row
+} CopyToStatement;
+
+typedef struct BeginStatement {} BeginStatement;
+typedef struct CommitStatement {} CommitStatement;
+typedef struct ClearStatement {} ClearStatement;
+
+typedef struct ShowStatement {
+    std::string what;                   // TABLES, INDEXES or STATS (upper case)
+} ShowStatement;
+
+typedef struct SetStatement {
+    std::string setting;                // Upper case
+    std::string value;
+} SetStatement;
+
+typedef std::variant<
+    CreateDatabaseStatement, DropDatabaseStatement, UseStatement,
+    CreateTableStatement, DropTableStatement, AlterTableStatement, CompactTableStatement,
+    CreateIndexStatement, DropIndexStatement,
+    SelectStatement, JoinStatement, InsertStatement, UpdateStatement, DeleteStatement, CopyFromStatement, CopyToStatement,
+    BeginStatement, CommitStatement, ClearStatement, ShowStatement, SetStatement
+> Statement;
+
+/** Parses a statement (without its ';'), returns false and sets 'error' to the message to print if it is invalid.
+ *  Placeholders are only accepted with 'parameters', which is set to their number. */
+bool parseStatement(std::string_view text, Statement& statement, std::string& error, size_t* parameters = nullptr);
+
+/** Replaces the values of an INSERT, SELECT, UPDATE or DELETE statement by ? placeholders: quoted strings, the
+ *  values of INSERT and the words after a comparison operator or LIKE. 'normalized' is the statement with single
+ *  spaces between its tokens, 'values' the replaced values in order. False for other statements. */
+bool normalizeStatement(std::string_view text, std::string& normalized, std::vector<std::string>& values);
+
+/** Parses a condition (the text after WHERE), returns nullptr and sets 'error' if it is invalid */
+std::shared_ptr<Predicate> parsePredicate(const std::string& text, std::string& error);
+
+#endif // PARSER_H_
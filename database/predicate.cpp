@@ -0,0 +1,45 @@
+/**
+ * File: predicate.cpp
+ * Author: Mark Minkoff
+ * Functionality: Function definitions for file predicate.h
+ *
+ * */
+
+#include "predicate.h"
+
+std::shared_ptr<Predicate> makeComparison(const std::string& column, const std::string& op, const std::string& value)
+{
+    auto predicate = std::make_shared<Predicate>();
+    predicate->type = PREDICATE_COMPARE;
+    predicate->column = column;
+    predicate->op = op;
+    predicate->value = value;
+    return predicate;
+}
+
+std::string quoteValue(const std::string& value)
+{
+    // Values are quoted with the quote character they do not contain
+    const char quote = value.find('\'') == std::string::npos ? '\'' : '"';
+    return quote + value + quote;
+}
+
+std::string predicateText(const Predicate& predicate)
+{
+    switch (predicate.type)
+    {
+        case PREDICATE_COMPARE:
+            return predicate.column + " " + predicate.op + " " + quoteValue(predicate.value);
+        case PREDICATE_NOT:
+            return "NOT (" + predicateText(*predicate.children[0]) + ")";
+        default: {
+            std::string text = "(";
+            for (size_t i = 0; i < predicate.children.size(); ++i)
+            {
+                if (i) text += predicate.type == PREDICATE_AND ? " AND " : " OR ";
+                text += predicateText(*predicate.children[i]);
+            }
+            return text + ")";
+        }
+    }
+}
@@ -0,0 +1,58 @@
+/**
+ * File: predicate.h
+ * Author: Mark Minkoff
+ * Functionality: Function declarations for file predicate.cpp
+ * WHERE clauses of SELECT, UPDATE and DELETE: boolean trees of comparisons
+ *
+ *   expression := term { OR term }
+ *   term       := factor { AND factor }
+ *   factor     := NOT factor | ( expression ) | column operator value
+ *
+ * where operator is =, !=, <>, <, <=, >, >= or LIKE and value is a number, a word or a quoted
+ * string. AND binds tighter than OR, keywords are case-insensitive. The parser (parser.h)
+ * builds the trees, Table::filterRows evaluates a tree as bitmap operations over the filter
+ * results of its columns.
+ *
+ * */
+
+#ifndef PREDICATE_H_
+#define PREDICATE_H_
+
+#include "include.h"
+#include "filter.h"
+
+enum PredicateType
+{
+    PREDICATE_COMPARE = 0,  // column op value
+    PREDICATE_AND,          // Every child holds
+    PREDICATE_OR,           // Any child holds
+    PREDICATE_NOT           // The only child does not hold
+};
+
+// Value converted to the element type of a column, in the order of the column types of a table
+typedef std::variant<int, float, char, std::string> Value;
+
+typedef struct Predicate {
+    PredicateType type;
+    std::string column;                                 // Compared column (PREDICATE_COMPARE)
+    std::string op;                                     // Comparison operator, LIKE in upper case
+    std::string value;                                  // Compared value without its quotes
+    std::vector<std::shared_ptr<Predicate>> children;   // Operands of AND, OR and NOT
+    int parameter = -1;                                 // Placeholder (?) of a prepared statement giving the value, -1 for a literal
+
+    // Set by Table::resolvePredicate, the comparisons of a tree are resolved before it is evaluated
+    size_t ordinal = 0;                                 // Ordinal of the compared column
+    FilterOperator filter_op = FILTER_INVALID;          // Operator of the filter kernels
+    Value operand;                                      // 'value' converted to the element type of the column
+} Predicate;
+
+/** Creates a comparison */
+std::shared_ptr<Predicate> makeComparison(const std::string& column, const std::string& op, const std::string& value);
+
+/** A value quoted so the parser reads it back unchanged */
+std::string quoteValue(const std::string& value);
+
+/** Text of a predicate that parsePredicate (parser.h) reads back into the same tree (used by the write ahead log) */
+std::string predicateText(const Predicate& predicate);
+
+#endif // PREDICATE_H_
@@ -0,0 +1,247 @@
+/**
+ * File: prepared.cpp
+ * Author: Mark Minkoff
+ * Functionality: Function definitions for file prepared.h
+ *
+ * */
+
+#include "prepared.h"
+#include "SQL.h"
+
+PreparedStatement::PreparedStatement(SQL* sql, const std::string& text, Statement&& statement, const size_t parameter_count) :
+    sql(sql),
+    text(text),
+    statement(std::move(statement)),
+    parameters(parameter_count, Parameter{ nullptr, 0, std::string(), false }),
+    resolved(false),
+    schema_version(0)
+{
+    // Tables are looked up in the database selected now
+    if (sql->dbSelected()) this->database_name = sql->getSelectedDatabase()->getDatabaseName();
+
+    if (auto s = std::get_if<InsertStatement>(&this->statement)) this->table_name = s->table_name;
+    else if (auto s = std::get_if<SelectStatement>(&this->statement)) this->table_name = s->table_name;
+    else if (auto s = std::get_if<UpdateStatement>(&this->statement)) this->table_name = s->table_name;
+    else if (auto s = std::get_if<DeleteStatement>(&this->statement)) this->table_name = s->table_name;
+}
+
+std::shared_ptr<Predicate> PreparedStatement::where()
+{
+    if (auto s = std::get_if<SelectStatement>(&this->statement)) return s->where;
+    if (auto s = std::get_if<UpdateStatement>(&this->statement)) return s->where;
+    if (auto s = std::get_if<DeleteStatement>(&this->statement)) return s->where;
+    return nullptr;
+}
+
+// Collects the comparisons of a tree that hold a placeholder
+static void _placeholders(Predicate& predicate, std::vector<Parameter>& parameters)
+{
+    if (predicate.type == PREDICATE_COMPARE)
+    {
+        if (predicate.parameter >= 0) parameters[predicate.parameter].comparison = &predicate;
+        return;
+    }
+    for (auto& child : predicate.children) _placeholders(*child, parameters);
+}
+
+bool PreparedStatement::resolve()
+{
+    this->resolved = false;
+    this->table = nullptr;
+    this->ordinals.clear();
+    this->row.clear();
+    this->row_text.clear();
+
+    // Every other statement is handled by the client when it runs
+    const std::string& table_name = this->table_name;
+    if (table_name.empty())
+    {
+        this->schema_version = this->sql->getSchemaVersion();
+        this->resolved = true;
+        return true;
+    }
+
+    // Resolve the table in the database the statement was prepared in
+    if (this->database_name.empty()) { std::cout << "-- Database not selected\n"; return false; }
+
+    this->database = this->sql->getDatabase(this->database_name);
+    if (!this->database) { std::cout << "-- !Database " << this->database_name << " does not exist.\n"; return false; }
+
+    if (!this->database->tableExists(table_name))
+    {
+        std::cout << "-- Table " << table_name << " does not exist in database " << this->database_name << "\n";
+        return false;
+    }
+    this->table = this->database->getTable(table_name);
+
+    // Resolve the columns and convert the values written in the statement
+    if (auto s = std::get_if<InsertStatement>(&this->statement))
+    {
+        // The rows of VALUES(...), (...), ... are held one after the other
+        const size_t columns = this->table->columnCount();
+        if (s->values.size() != s->row_count * columns)
+        {
+            std::cout << "-- INSERT INTO parameter count (" << s->values.size() / s->row_count << ") does not equal the number of columns (" << columns << ") in table " << table_name << "\n";
+            return false;
+        }
+
+        this->row.resize(s->values.size());
+        this->row_text = s->values;
+        for (size_t i = 0; i < s->values.size(); ++i)
+        {
+            if (s->parameters[i] >= 0) this->parameters[s->parameters[i]].value = i;
+            else if (!this->convert(i % columns, s->values[i], this->row[i])) return false;
+        }
+    }
+    else if (auto s = std::get_if<SelectStatement>(&this->statement))
+    {
+        if (!this->table->resolveColumns(s->columns, this->ordinals)) return false;
+    }
+    else if (auto s = std::get_if<UpdateStatement>(&this->statement))
+    {
+        const long int ordinal = this->table->columnIndexFromName(s->column_name);
+        if (ordinal == (long int)-1) { std::cout << "-- !Failed to update table " << table_name << " because column " << s->column_name << " does not exist.\n"; return false; }
+
+        this->ordinals.push_back(ordinal);
+        this->row.resize(1);
+        this->row_text.push_back(s->value);
+        if (s->parameter >= 0) this->parameters[s->parameter].value = 0;
+        else if (!this->convert(ordinal, s->value, this->row[0])) return false;
+    }
+
+    // Resolve the comparisons, the placeholders get their values when they are bound
+    if (std::shared_ptr<Predicate> where = this->where())
+    {
+        if (!this->table->resolvePredicate(*where)) return false;
+        _placeholders(*where, this->parameters);
+    }
+
+    // Values bound before the catalog changed are converted again
+    for (auto& parameter : this->parameters) {
+        if (parameter.bound && !this->apply(parameter)) return false;
+    }
+
+    this->schema_version = this->sql->getSchemaVersion();
+    this->resolved = true;
+    return true;
+}
+
+bool PreparedStatement::convert(const size_t ordinal, const std::string& text, Value& value, const bool report)
+{
+    try {
+        value = this->table->columnValue(ordinal, text);
+    }
+    catch(const std::exception& e) {
+        if (report) std::cout << "-- !Invalid value " << text << " for column " << this->table->getMetaData()[ordinal].first << " of table " << this->table->getTable() << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool PreparedStatement::apply(Parameter& parameter, const bool report)
+{
+    if (parameter.comparison) return this->table->bindComparison(*parameter.comparison, parameter.text, report);
+
+    // A value of INSERT, or the value of SET
+    const size_t ordinal = std::get_if<InsertStatement>(&this->statement) ? parameter.value % this->table->columnCount() : this->ordinals[0];
+    if (!this->convert(ordinal, parameter.text, this->row[parameter.value], report)) return false;
+    this->row_text[parameter.value] = parameter.text;
+    return true;
+}
+
+bool PreparedStatement::bind(const size_t parameter, const std::string& value, const bool report)
+{
+    if (parameter >= this->parameters.size())
+    {
+        if (report) std::cout << "-- !Parameter " << parameter << " does not exist, the statement has " << this->parameters.size() << " parameter(s).\n";
+        return false;
+    }
+
+    Parameter& bound = this->parameters[parameter];
+    bound.text = value;
+    bound.bound = true;
+
+    // The value is converted when the statement is resolved again, the columns may have changed since
+    if (!this->resolved || !this->table || this->schema_version != this->sql->getSchemaVersion()) return true;
+
+    if (this->apply(bound, report)) return true;
+
+    bound.bound = false;
+    return false;
+}
+
+bool PreparedStatement::bind(const size_t parameter, const int value)
+{
+    return this->bind(parameter, std::to_string(value));
+}
+
+bool PreparedStatement::bind(const size_t parameter, const float value)
+{
+    // Shortest text that reads back as the same float
+    char buffer[32];
+    const auto res = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    return this->bind(parameter, std::string(buffer, res.ptr));
+}
+
+bool PreparedStatement::execute()
+{
+    // Tables are only compacted in the background between statements
+    std::unique_lock<std::recursive_mutex> statement_lock = this->sql->lockStatements();
+
+    try {
+        // Resolve the statement again if the catalog changed, here or in another process
+        if (this->sql->catalogChanged()) this->sql->readFilesystem();
+        if (!this->resolved || this->schema_version != this->sql->getSchemaVersion()) {
+            if (!this->resolve()) return false;
+        }
+
+        // The table is read again if another process checkpointed it
+        if (this->table && !this->table->refresh()) return false;
+
+        for (size_t i = 0; i < this->parameters.size(); ++i)
+        {
+            if (!this->parameters[i].bound) {
+                std::cout << "-- !Parameter " << i << " of the prepared statement is not bound.\n";
+                return false;
+            }
+        }
+
+        if (auto s = std::get_if<InsertStatement>(&this->statement))
+        {
+            if (!this->table->insertValues(this->row, this->row_text, true)) return false;
+            if (s->row_count == 1) std::cout << "-- 1 new record inserted.\n";
+            else std::cout << "-- " << s->row_count << " new records inserted.\n";
+        }
+        else if (auto s = std::get_if<SelectStatement>(&this->statement))
+        {
+            if (!s->where) return this->table->printAll();
+            return this->table->selectWhere(this->ordinals, *s->where);
+        }
+        else if (auto s = std::get_if<UpdateStatement>(&this->statement))
+        {
+            // Transactions lock the table and defer the update to COMMIT, the client handles them
+            if (this->database->getTransaction())
+            {
+                UpdateStatement update = *s;
+                update.value = this->row_text[0];
+                return this->sql->updateTable(update);
+            }
+            if (!this->table->updateWhere(this->ordinals[0], this->row[0], this->row_text[0], *s->where)) return false;
+        }
+        else if (auto s = std::get_if<DeleteStatement>(&this->statement))
+        {
+            if (!this->table->deleteWhere(*s->where)) return false;
+            this->sql->autoCompact(this->database, this->table);
+        }
+        else return this->sql->HANDLE_CMD(this->statement);
+
+        this->database->autoCheckpoint();
+        return true;
+    }
+    catch(const std::exception& e)
+    {
+        std::cerr << e.what() << "\n";
+    }
+
+    return false;
+}
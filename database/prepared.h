@@ -0,0 +1,95 @@
+/**
+ * File: prepared.h
+ * Author: Mark Minkoff
+ * Functionality: Function declarations for file prepared.cpp
+ * Prepared statements of the C++ API. SQL::prepare parses a statement once and resolves its
+ * table, the ordinals and types of its columns and the operators of its comparisons. Values
+ * written as ? are bound afterwards and converted to the type of their column when they are
+ * bound, so execute calls the table directly:
+ *
+ *   std::shared_ptr<PreparedStatement> insert = sql.prepare("INSERT INTO t VALUES(?, ?)");
+ *   insert->bind(0, 1);
+ *   insert->bind(1, "a");
+ *   insert->execute();
+ *
+ * Bound values are kept between executions. A statement is resolved again when the catalog
+ * changed since it was resolved (CREATE, DROP, ALTER or another process). Its table is looked
+ * up in the database selected when it was prepared. Statements other than INSERT, SELECT,
+ * UPDATE and DELETE are run by SQL::HANDLE_CMD.
+ *
+ * */
+
+#ifndef PREPARED_H_
+#define PREPARED_H_
+
+#include "include.h"
+#include "parser.h"
+
+class SQL;
+class Database;
+class Table;
+
+// Where the value of a placeholder goes
+typedef struct Parameter {
+    Predicate* comparison;      // Comparison of the WHERE clause, nullptr for a value of INSERT or SET
+    size_t value;               // Index of the value in the row (INSERT) or 0 (SET)
+    std::string text;           // Bound value
+    bool bound;                 // A value was bound
+} Parameter;
+
+class PreparedStatement
+{
+private:
+    SQL* sql;                                   // Client that prepared the statement, it outlives the statement
+    std::string text;                           // Statement as prepared
+    Statement statement;                        // Syntax tree, holds the comparisons of the WHERE clause
+    std::string database_name;                  // Database selected when the statement was prepared
+    std::string table_name;                     // Table of INSERT, SELECT, UPDATE and DELETE
+    std::vector<Parameter> parameters;          // Placeholders in the order they are written
+
+    // Resolved against the catalog
+    bool resolved;
+    uint64_t schema_version;                    // Catalog version the statement was resolved against
+    std::shared_ptr<Database> database;
+    std::shared_ptr<Table> table;
+    std::vector<size_t> ordinals;               // Selected columns (SELECT) or the updated column (UPDATE)
+    std::vector<Value> row;                     // Values of INSERT, or the value of SET, converted to their column types
+    std::vector<std::string> row_text;          // Text of the values (logged)
+
+    /** Converts the bound value of a placeholder, false (printed if 'report' is set) if it is invalid for its column */
+    bool apply(Parameter& parameter, const bool report = true);
+
+    /** Converts a value of INSERT or SET for column 'ordinal', false (printed if 'report' is set) if it is invalid */
+    bool convert(const size_t ordinal, const std::string& text, Value& value, const bool report = true);
+
+    /** WHERE clause of the statement, nullptr if it has none */
+    std::shared_ptr<Predicate> where();
+
+public:
+    PreparedStatement(SQL* sql, const std::string& text, Statement&& statement, const size_t parameter_count);
+
+    /** Resolves the statement against the catalog, false (with the error printed) if its table or
+     *  a column does not exist or a value is invalid */
+    bool resolve();
+
+    /** Binds the value of placeholder 'parameter' (numbered from 0), false if it is out of range or
+     *  the value does not convert to the type of its column (printed if 'report' is set) */
+    bool bind(const size_t parameter, const std::string& value, const bool report = true);
+    bool bind(const size_t parameter, const char* value) { return this->bind(parameter, std::string(value)); }
+    bool bind(const size_t parameter, const int value);
+    bool bind(const size_t parameter, const float value);
+
+    /** Runs the statement with the bound values, false if it failed or a placeholder is not bound */
+    bool execute();
+
+    /** True for INSERT, SELECT, UPDATE and DELETE, the statements that call their table directly */
+    bool isDirect() const { return !this->table_name.empty(); }
+
+    // Getters
+    const std::string& getText() const { return this->text; }
+    const std::string& getDatabaseName() const { return this->database_name; }
+    const std::string& getTableName() const { return this->table_name; }
+    size_t parameterCount() const { return this->parameters.size(); }
+};
+
+#endif // PREPARED_H_
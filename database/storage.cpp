@@ -0,0 +1,409 @@
+/**
+ * File: storage.cpp
+ * Author: Mark Minkoff
+ * Functionality: Function definitions for file storage.h
+ *
+ * */
+
+#include "storage.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char TABLE_MAGIC[8]  = {'S', 'Q', 'L', 'T', 'A', 'B', 'L', 'E'};
+static const char COLUMN_MAGIC[8] = {'S', 'Q', 'L', 'C', 'O', 'L', 'M', 'N'};
+
+// Whole files are written next to their destination and renamed over it,
+// so a reader never sees a half written file
+static fs::path _tempPath(const fs::path& path)
+{
+    fs::path tmp = path; tmp += ".tmp";
+    return tmp;
+}
+
+fs::path processTempPath(const fs::path& path)
+{
+    fs::path tmp = path; tmp += "." + std::to_string(::getpid()) + ".tmp";
+    return tmp;
+}
+
+bool replaceFile(const fs::path& tmp, const fs::path& path)
+{
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec) { std::cout << "-- !Failed to write " << path.string() << ": " << ec.message() << "\n"; return false; }
+    return true;
+}
+
+static ColumnFileHeader _columnHeader(const uint32_t data_type, const uint32_t width, const uint32_t char_max)
+{
+    ColumnFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, COLUMN_MAGIC, sizeof(header.magic));
+    header.version = STORAGE_VERSION;
+    header.data_type = data_type;
+    header.width = width;
+    header.char_max = char_max;
+    return header;
+}
+
+// Cuts a file back to 'size' bytes, dropping a partially appended row. Fails if the file is shorter.
+static bool _truncateTo(const fs::path& path, const uintmax_t size)
+{
+    std::error_code ec;
+    const uintmax_t current = fs::file_size(path, ec);
+    if (ec || current < size) { std::cout << "-- !Column file " << path.string() << " is missing rows\n"; return false; }
+    if (current > size) fs::resize_file(path, size, ec);
+    return !ec;
+}
+
+FileLock::FileLock(const fs::path& path)
+{
+    this->fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (this->fd < 0) { std::cout << "-- !Failed to open lock file " << path.string() << "\n"; return; }
+
+    int res;
+    while ((res = ::flock(this->fd, LOCK_EX)) != 0 && errno == EINTR);
+    if (res != 0) {
+        std::cout << "-- !Failed to lock " << path.string() << "\n";
+        ::close(this->fd);
+        this->fd = -1;
+    }
+}
+
+FileLock::~FileLock()
+{
+    // Closing the descriptor releases the lock
+    if (this->fd >= 0) ::close(this->fd);
+}
+
+MappedFile::~MappedFile()
+{
+    if (this->address) munmap(this->address, this->length);
+}
+
+std::shared_ptr<MappedFile> MappedFile::open(const fs::path& path)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) { close(fd); return nullptr; }
+
+    // Empty files cannot be mapped, they are represented by an empty mapping
+    void* address = nullptr;
+    const size_t length = (size_t)st.st_size;
+    if (length) {
+        address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED) { close(fd); return nullptr; }
+    }
+
+    // The mapping stays valid after the descriptor is closed
+    close(fd);
+    return std::shared_ptr<MappedFile>(new MappedFile(address, length));
+}
+
+// Validates the header of a mapped column file holding 'rows' elements of 'width' bytes
+static bool _checkColumnMapping(const MappedFile& file, const fs::path& path, const uint32_t width, const size_t rows)
+{
+    ColumnFileHeader header;
+    if (file.size() < sizeof(header)) { std::cout << "-- !" << path.string() << " is not a column file\n"; return false; }
+
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (std::memcmp(header.magic, COLUMN_MAGIC, sizeof(header.magic)) != 0) { std::cout << "-- !" << path.string() << " is not a column file\n"; return false; }
+    if (header.version != STORAGE_VERSION) { std::cout << "-- !Unsupported column file version " << header.version << " in " << path.string() << "\n"; return false; }
+    if (header.width != width) { std::cout << "-- !Unexpected element width " << header.width << " in " << path.string() << "\n"; return false; }
+    if (file.size() < sizeof(header) + rows * width) { std::cout << "-- !Column file " << path.string() << " is missing rows\n"; return false; }
+    return true;
+}
+
+bool writeTableFile(const fs::path& path, const std::vector<ColumnDescriptor>& columns, const std::vector<IndexDescriptor>& indexes, const TableCommit& commit)
+{
+    const fs::path tmp = _tempPath(path);
+    std::ofstream file(tmp, std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+    if (!file.is_open()) { std::cout << "-- !Failed to open " << tmp.string() << "\n"; return false; }
+
+    TableFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, TABLE_MAGIC, sizeof(header.magic));
+    header.version = STORAGE_VERSION;
+    header.column_count = (uint32_t)columns.size();
+    header.row_count = commit.row_count;
+    header.checkpoint_lsn = commit.checkpoint_lsn;
+    header.index_count = (uint32_t)indexes.size();
+    header.generation = commit.generation;
+    header.checkpoint_log = commit.checkpoint_log;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // Column descriptors: type, VARCHAR limit, name length, name
+    for (auto& column : columns)
+    {
+        const uint32_t name_length = (uint32_t)column.name.size();
+        file.write(reinterpret_cast<const char*>(&column.data_type), sizeof(column.data_type));
+        file.write(reinterpret_cast<const char*>(&column.char_max), sizeof(column.char_max));
+        file.write(reinterpret_cast<const char*>(&name_length), sizeof(name_length));
+        file.write(column.name.data(), name_length);
+    }
+
+    // Index descriptors: type, column, name length, name
+    for (auto& index : indexes)
+    {
+        const uint32_t name_length = (uint32_t)index.name.size();
+        file.write(reinterpret_cast<const char*>(&index.type), sizeof(index.type));
+        file.write(reinterpret_cast<const char*>(&index.column), sizeof(index.column));
+        file.write(reinterpret_cast<const char*>(&name_length), sizeof(name_length));
+        file.write(index.name.data(), name_length);
+    }
+
+    file.close();
+    if (!file) { std::cout << "-- !Failed to write " << tmp.string() << "\n"; return false; }
+
+    return replaceFile(tmp, path);
+}
+
+// Reads and validates the header of a table file
+static bool _readTableHeader(std::ifstream& file, const fs::path& path, TableFileHeader& header)
+{
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, TABLE_MAGIC, sizeof(header.magic)) != 0)
+    {
+        std::cout << "-- !" << path.string() << " is not a table file\n";
+        return false;
+    }
+    if (header.version != STORAGE_VERSION) { std::cout << "-- !Unsupported table file version " << header.version << " in " << path.string() << "\n"; return false; }
+    return true;
+}
+
+bool readTableFile(const fs::path& path, std::vector<ColumnDescriptor>& columns, std::vector<IndexDescriptor>& indexes, TableCommit& commit)
+{
+    std::ifstream file(path, std::ifstream::in | std::ifstream::binary);
+    if (!file.is_open()) return false;
+
+    TableFileHeader header;
+    if (!_readTableHeader(file, path, header)) return false;
+
+    columns.clear();
+    columns.reserve(header.column_count);
+    for (uint32_t i = 0; i < header.column_count; ++i)
+    {
+        ColumnDescriptor column;
+        uint32_t name_length = 0;
+        file.read(reinterpret_cast<char*>(&column.data_type), sizeof(column.data_type));
+        file.read(reinterpret_cast<char*>(&column.char_max), sizeof(column.char_max));
+        file.read(reinterpret_cast<char*>(&name_length), sizeof(name_length));
+        if (!file) break;
+
+        column.name.resize(name_length);
+        file.read(&column.name[0], name_length);
+        columns.emplace_back(std::move(column));
+    }
+
+    indexes.clear();
+    for (uint32_t i = 0; i < header.index_count && file; ++i)
+    {
+        IndexDescriptor index;
+        uint32_t name_length = 0;
+        file.read(reinterpret_cast<char*>(&index.type), sizeof(index.type));
+        file.read(reinterpret_cast<char*>(&index.column), sizeof(index.column));
+        file.read(reinterpret_cast<char*>(&name_length), sizeof(name_length));
+        if (!file) break;
+
+        index.name.resize(name_length);
+        file.read(&index.name[0], name_length);
+        indexes.emplace_back(std::move(index));
+    }
+    if (!file) { std::cout << "-- !Table file " << path.string() << " is truncated\n"; return false; }
+
+    commit.row_count = header.row_count;
+    commit.checkpoint_lsn = header.checkpoint_lsn;
+    commit.generation = header.generation;
+    commit.checkpoint_log = header.checkpoint_log;
+    return true;
+}
+
+bool readTableCommit(const fs::path& path, TableCommit& commit)
+{
+    std::ifstream file(path, std::ifstream::in | std::ifstream::binary);
+    if (!file.is_open()) return false;
+
+    TableFileHeader header;
+    if (!_readTableHeader(file, path, header)) return false;
+
+    commit.row_count = header.row_count;
+    commit.checkpoint_lsn = header.checkpoint_lsn;
+    commit.generation = header.generation;
+    commit.checkpoint_log = header.checkpoint_log;
+    return true;
+}
+
+bool writeTableCommit(const fs::path& path, const TableCommit& commit)
+{
+    std::fstream file(path, std::fstream::in | std::fstream::out | std::fstream::binary);
+    if (!file.is_open()) { std::cout << "-- !Failed to open " << path.string() << "\n"; return false; }
+
+    TableFileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) { std::cout << "-- !Failed to read " << path.string() << "\n"; return false; }
+
+    // The whole header is written back with one write
+    header.row_count = commit.row_count;
+    header.checkpoint_lsn = commit.checkpoint_lsn;
+    header.generation = commit.generation;
+    header.checkpoint_log = commit.checkpoint_log;
+    file.seekp(0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.close();
+
+    return !file.fail();
+}
+
+bool syncFile(const fs::path& path)
+{
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    const bool success = ::fsync(fd) == 0;
+    ::close(fd);
+    return success;
+}
+
+template <typename T>
+bool writeColumnFile(const fs::path& path, const ColumnView<T>& elements, const uint32_t data_type)
+{
+    const fs::path tmp = _tempPath(path);
+    std::ofstream file(tmp, std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+    if (!file.is_open()) { std::cout << "-- !Failed to open " << tmp.string() << "\n"; return false; }
+
+    const ColumnFileHeader header = _columnHeader(data_type, sizeof(T), 0);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(elements.data()), elements.size() * sizeof(T));
+
+    file.close();
+    if (!file) { std::cout << "-- !Failed to write " << tmp.string() << "\n"; return false; }
+
+    return replaceFile(tmp, path);
+}
+
+template <typename T>
+bool appendColumnFile(const fs::path& path, const ColumnView<T>& elements, const size_t from, const size_t rows)
+{
+    if (!_truncateTo(path, sizeof(ColumnFileHeader) + rows * sizeof(T))) return false;
+
+    std::ofstream file(path, std::ofstream::out | std::ofstream::app | std::ofstream::binary);
+    if (!file.is_open()) { std::cout << "-- !Failed to open " << path.string() << "\n"; return false; }
+
+    file.write(reinterpret_cast<const char*>(elements.data() + from), (elements.size() - from) * sizeof(T));
+    file.close();
+
+    return !file.fail();
+}
+
+template <typename T>
+std::shared_ptr<MappedFile> mapColumnFile(const fs::path& path, const size_t rows, const T*& first)
+{
+    std::shared_ptr<MappedFile> file = MappedFile::open(path);
+    if (!file) { std::cout << "-- !Missing column file " << path.string() << "\n"; return nullptr; }
+    if (!_checkColumnMapping(*file, path, sizeof(T), rows)) return nullptr;
+
+    // Elements are stored exactly as they are laid out in memory
+    first = reinterpret_cast<const T*>(file->data() + sizeof(ColumnFileHeader));
+    return file;
+}
+
+template bool writeColumnFile<int>(const fs::path&, const ColumnView<int>&, const uint32_t);
+template bool writeColumnFile<float>(const fs::path&, const ColumnView<float>&, const uint32_t);
+template bool writeColumnFile<char>(const fs::path&, const ColumnView<char>&, const uint32_t);
+template bool appendColumnFile<int>(const fs::path&, const ColumnView<int>&, const size_t, const size_t);
+template bool appendColumnFile<float>(const fs::path&, const ColumnView<float>&, const size_t, const size_t);
+template bool appendColumnFile<char>(const fs::path&, const ColumnView<char>&, const size_t, const size_t);
+template std::shared_ptr<MappedFile> mapColumnFile<int>(const fs::path&, const size_t, const int*&);
+template std::shared_ptr<MappedFile> mapColumnFile<float>(const fs::path&, const size_t, const float*&);
+template std::shared_ptr<MappedFile> mapColumnFile<char>(const fs::path&, const size_t, const char*&);
+
+bool writeStringColumnFile(const fs::path& path, const fs::path& data_path, const ColumnView<std::string>& elements, const uint32_t char_max)
+{
+    const fs::path tmp = _tempPath(path), data_tmp = _tempPath(data_path);
+    std::ofstream file(tmp, std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+    std::ofstream data_file(data_tmp, std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+    if (!file.is_open() || !data_file.is_open()) { std::cout << "-- !Failed to open " << tmp.string() << "\n"; return false; }
+
+    const ColumnFileHeader header = _columnHeader(STORAGE_VARCHAR, sizeof(uint64_t), char_max);
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // Offsets are the end of every row in the data file
+    std::vector<uint64_t> offsets;
+    offsets.reserve(elements.size());
+    uint64_t end = 0;
+    for (auto& element : elements)
+    {
+        data_file.write(element.data(), element.size());
+        end += element.size();
+        offsets.emplace_back(end);
+    }
+    file.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+
+    file.close();
+    data_file.close();
+    if (!file || !data_file) { std::cout << "-- !Failed to write " << tmp.string() << "\n"; return false; }
+
+    // The data file goes first so the offsets never point past its end
+    return replaceFile(data_tmp, data_path) && replaceFile(tmp, path);
+}
+
+bool appendStringColumnFile(const fs::path& path, const fs::path& data_path, const ColumnView<std::string>& elements, const size_t from, const size_t rows)
+{
+    if (!_truncateTo(path, sizeof(ColumnFileHeader) + rows * sizeof(uint64_t))) return false;
+
+    // The end offset of the last committed row is where the new data starts
+    uint64_t end = 0;
+    if (rows)
+    {
+        std::ifstream file(path, std::ifstream::in | std::ifstream::binary);
+        file.seekg(sizeof(ColumnFileHeader) + (rows - 1) * sizeof(uint64_t));
+        if (!file.read(reinterpret_cast<char*>(&end), sizeof(end))) { std::cout << "-- !Failed to read " << path.string() << "\n"; return false; }
+    }
+    if (!_truncateTo(data_path, end)) return false;
+
+    std::ofstream file(path, std::ofstream::out | std::ofstream::app | std::ofstream::binary);
+    std::ofstream data_file(data_path, std::ofstream::out | std::ofstream::app | std::ofstream::binary);
+    if (!file.is_open() || !data_file.is_open()) { std::cout << "-- !Failed to open " << path.string() << "\n"; return false; }
+
+    for (size_t row = from; row < elements.size(); ++row)
+    {
+        data_file.write(elements[row].data(), elements[row].size());
+        end += elements[row].size();
+        file.write(reinterpret_cast<const char*>(&end), sizeof(end));
+    }
+
+    file.close();
+    data_file.close();
+
+    return !file.fail() && !data_file.fail();
+}
+
+bool readStringColumnFile(const fs::path& path, const fs::path& data_path, std::vector<std::string>& elements, const size_t rows)
+{
+    std::shared_ptr<MappedFile> file = MappedFile::open(path);
+    if (!file) { std::cout << "-- !Missing column file " << path.string() << "\n"; return false; }
+    if (!_checkColumnMapping(*file, path, sizeof(uint64_t), rows)) return false;
+
+    std::shared_ptr<MappedFile> data_file = MappedFile::open(data_path);
+    if (!data_file) { std::cout << "-- !Missing column data file " << data_path.string() << "\n"; return false; }
+
+    const uint64_t* offsets = reinterpret_cast<const uint64_t*>(file->data() + sizeof(ColumnFileHeader));
+    if (rows && offsets[rows - 1] > data_file->size()) { std::cout << "-- !Column data file " << data_path.string() << " is missing rows\n"; return false; }
+
+    // Cut the mapped data file into rows
+    elements.clear();
+    elements.reserve(rows);
+    uint64_t begin = 0;
+    for (size_t row = 0; row < rows; ++row)
+    {
+        elements.emplace_back(data_file->data() + begin, offsets[row] - begin);
+        begin = offsets[row];
+    }
+    return true;
+}
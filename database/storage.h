@@ -0,0 +1,177 @@
+/**
+ * File: storage.h
+ * Author: Mark Minkoff
+ * Functionality: Function declarations for file storage.cpp
+ * Binary columnar on-disk table format. A table directory holds:
+ *
+ *   <table>.tbl        table header (TableFileHeader) followed by one descriptor per column
+ *   <table>.<i>.col    column i: ColumnFileHeader followed by the raw elements
+ *                      (INT, FLOAT and CHAR store fixed width elements, VARCHAR stores the
+ *                      uint64 end offset of every row into the data file)
+ *   <table>.<i>.dat    VARCHAR column i: the bytes of every row back to back
+ *   <table>.<i>.zmp    zone map of INT, FLOAT or CHAR column i (see zonemap.h)
+ *   <table>.<name>.idx index 'name' (see index.h), listed after the column descriptors
+ *
+ * Column files are opened with MappedFile, so the elements of INT, FLOAT and CHAR columns are
+ * used in place (the 64 byte header keeps them aligned).
+ *
+ * The row count in the table header is the number of committed rows, the checkpoint log and
+ * LSN the last write ahead log record (see wal.h) the files contain. Column files may hold
+ * a partially appended row after a crash, so readers only trust the first row_count rows and
+ * appends first cut the files back to that length.
+ *
+ * Several processes may use the same database. The files of its tables are only written while
+ * the database lock (FileLock) is held, and every commit increments the generation in the table
+ * header so the other processes know the rows they hold are stale.
+ *
+ * */
+
+#ifndef STORAGE_H_
+#define STORAGE_H_
+
+#include "include.h"
+#include "column.h"
+
+// Format version written to every file header
+const uint32_t STORAGE_VERSION = 1;
+
+// Element types as stored in the column files (matches Column<T>::getDataType)
+enum StorageType
+{
+    STORAGE_INT = 0,
+    STORAGE_FLOAT,
+    STORAGE_CHAR,
+    STORAGE_VARCHAR
+};
+
+typedef struct TableFileHeader {
+    char magic[8];              // "SQLTABLE"
+    uint32_t version;           // STORAGE_VERSION
+    uint32_t column_count;      // Number of column descriptors following the header
+    uint64_t row_count;         // Number of committed rows
+    uint64_t checkpoint_lsn;    // Last write ahead log record contained in the files
+    uint32_t index_count;       // Number of index descriptors following the column descriptors
+    uint32_t reserved0;
+    uint64_t generation;        // Incremented by every commit of the files
+    uint64_t checkpoint_log;    // Id of the log the checkpoint LSN belongs to
+    uint64_t reserved[1];
+} TableFileHeader;
+
+typedef struct ColumnFileHeader {
+    char magic[8];              // "SQLCOLMN"
+    uint32_t version;           // STORAGE_VERSION
+    uint32_t data_type;         // StorageType
+    uint32_t width;             // Bytes per element (8 for the VARCHAR offsets)
+    uint32_t char_max;          // VARCHAR(n) limit, 0 otherwise
+    uint64_t reserved[5];
+} ColumnFileHeader;
+
+static_assert(sizeof(TableFileHeader) == 64, "TableFileHeader must be 64 bytes");
+static_assert(sizeof(ColumnFileHeader) == 64, "ColumnFileHeader must be 64 bytes");
+
+// Committed state of the table files (see TableFileHeader)
+typedef struct TableCommit {
+    uint64_t row_count = 0;
+    uint64_t checkpoint_lsn = 0;
+    uint64_t generation = 0;
+    uint64_t checkpoint_log = 0;
+} TableCommit;
+
+// Column description stored after the table header
+typedef struct ColumnDescriptor {
+    std::string name;
+    uint32_t data_type;
+    uint32_t char_max;
+} ColumnDescriptor;
+
+// Index description stored after the column descriptors
+typedef struct IndexDescriptor {
+    std::string name;
+    uint32_t column;            // Ordinal of the indexed column
+    uint32_t type;              // IndexType
+} IndexDescriptor;
+
+/** Read-only mapping of a whole file. Pages are faulted in on first access and,
+ *  being clean file pages, can be dropped by the kernel under memory pressure. */
+class MappedFile
+{
+private:
+    void* address;
+    size_t length;
+
+    MappedFile(void* address, const size_t length) : address(address), length(length) {}
+
+public:
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /** Maps 'path', returns nullptr if it cannot be opened */
+    static std::shared_ptr<MappedFile> open(const fs::path& path);
+
+    const char* data() const { return static_cast<const char*>(this->address); }
+    size_t size() const { return this->length; }
+};
+
+/** Exclusive advisory lock (flock) of a lock file, held until it is destroyed. Blocks while another
+ *  process (or another descriptor of this one) holds it. */
+class FileLock
+{
+private:
+    int fd;
+
+public:
+    FileLock(const fs::path& path);
+    ~FileLock();
+
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+
+    bool isLocked() const { return this->fd >= 0; }
+};
+
+/** Writes the table header, column descriptors and index descriptors */
+bool writeTableFile(const fs::path& path, const std::vector<ColumnDescriptor>& columns, const std::vector<IndexDescriptor>& indexes, const TableCommit& commit);
+
+/** Reads the table header, column descriptors and index descriptors (false if the file is missing or not a table file) */
+bool readTableFile(const fs::path& path, std::vector<ColumnDescriptor>& columns, std::vector<IndexDescriptor>& indexes, TableCommit& commit);
+
+/** Reads only the committed state of a table file */
+bool readTableCommit(const fs::path& path, TableCommit& commit);
+
+/** Overwrites the committed state of an existing table file with one write */
+bool writeTableCommit(const fs::path& path, const TableCommit& commit);
+
+/** Path next to 'path' that only this process writes, metadata files written by several processes
+ *  at once are written there and renamed over 'path' */
+fs::path processTempPath(const fs::path& path);
+
+/** Renames a file written next to its destination over it, a reader sees the old or the new file */
+bool replaceFile(const fs::path& tmp, const fs::path& path);
+
+/** Forces a file (or directory) to disk with fsync */
+bool syncFile(const fs::path& path);
+
+/** Writes a fixed width (INT, FLOAT, CHAR) column file */
+template <typename T>
+bool writeColumnFile(const fs::path& path, const ColumnView<T>& elements, const uint32_t data_type);
+
+/** Appends elements [from, elements.size()) to a fixed width column file holding 'rows' rows */
+template <typename T>
+bool appendColumnFile(const fs::path& path, const ColumnView<T>& elements, const size_t from, const size_t rows);
+
+/** Maps a fixed width column file holding at least 'rows' elements, 'first' is set to its first element */
+template <typename T>
+std::shared_ptr<MappedFile> mapColumnFile(const fs::path& path, const size_t rows, const T*& first);
+
+/** Writes a VARCHAR column as an offsets file and a data file */
+bool writeStringColumnFile(const fs::path& path, const fs::path& data_path, const ColumnView<std::string>& elements, const uint32_t char_max);
+
+/** Appends elements [from, elements.size()) to a VARCHAR column holding 'rows' rows */
+bool appendStringColumnFile(const fs::path& path, const fs::path& data_path, const ColumnView<std::string>& elements, const size_t from, const size_t rows);
+
+/** Reads the first 'rows' elements of a VARCHAR column (decoded from a mapping of its files) */
+bool readStringColumnFile(const fs::path& path, const fs::path& data_path, std::vector<std::string>& elements, const size_t rows);
+
+#endif // STORAGE_H_
@@ -6,10 +6,12 @@
  * */
 
 #include "table.h"
+#include "parser.h"
 
 // Constructor
 Table::Table(std::string table, std::vector<std::pair<std::string, std::string>> column_meta_data, fs::path path, fs::path path_metadata) : 
-    table_name(table), column_count(0), row_count(0), column_meta_data(column_meta_data), path(path), locked("false"), path_metadata(path_metadata)
+    table_name(table), column_count(0), row_count(0), column_meta_data(column_meta_data), path(path), locked("false"), state(TABLE_HOT),
+    checkpoint_lsn(0), checkpoint_log(0), persisted_rows(0), generation(0), dirty(false), rewrite(false), adaptive(false), deleted_rows(0), path_metadata(path_metadata)
     {
         for (auto& col: column_meta_data)
         {
@@ -43,6 +45,12 @@ Table::Table(std::string table, std::vector<std::pair<std::string, std::string>>
             }
         }
 
+        // Index the column names once so lookups do not scan and upper-case every name
+        this->column_index.reserve(this->column_meta_data.size());
+        for (size_t i = 0; i < this->column_meta_data.size(); ++i) {
+            this->column_index.emplace(std::get<0>(this->column_meta_data[i]), i);
+        }
+
         this->writeMetadata();
     }
 
@@ -54,7 +62,9 @@ bool Table::createIntColumn(std::string column)
 
     try
     {
-        data = std::make_shared<Column<int>>(column, std::vector<int>());
+        std::shared_ptr<Column<int>> created = std::make_shared<Column<int>>(column, std::vector<int>());
+        created->setAdaptive(this->adaptive);
+        data = created;
 
         this->columns.emplace_back(data);
 
@@ -74,7 +84,9 @@ bool Table::createFloatColumn(std::string column)
 
     try
     {
-        data = std::make_shared<Column<float>>(column, std::vector<float>());
+        std::shared_ptr<Column<float>> created = std::make_shared<Column<float>>(column, std::vector<float>());
+        created->setAdaptive(this->adaptive);
+        data = created;
 
         this->columns.emplace_back(data);
 
@@ -129,9 +141,60 @@ bool Table::createVarCharColumn(std::string column, size_t max)
     return true;
 }
 
+// Converts the text of a value to the element type of a column as it is stored (see Table::columnValue)
+static int _columnValue(Column<int>&, const std::string& var)
+{
+    // Convert value to integer
+    return std::stoi(var);
+}
+
+static float _columnValue(Column<float>&, const std::string& var)
+{
+    // Initialize the amount of significant figures to round to
+    unsigned int sig_figs = 0;
+
+    size_t dec = var.find_first_of('.');
+
+    // Check if decimal found in string
+    if (dec != std::string::npos) 
+    {
+        // Decimal found, so count sig figs
+        for (dec++; dec < var.size(); dec++) sig_figs++;
+    }
+    
+    // Convert value to float
+    float val = std::stof(var);
+
+    if (sig_figs) {
+        val = _roundFloat(val, sig_figs);
+    }
+
+    return val;
+}
+
+static char _columnValue(Column<char>&, const std::string& var)
+{
+    // Convert value to char
+    return var[0];
+}
+
+static std::string _columnValue(Column<std::string>& column, const std::string& var)
+{
+    // If the size of the string is greater than the max char count, then only keep a range of var
+    if (var.size() > column.getCharMax()) return std::string(var.begin(), var.begin() + column.getCharMax());
+
+    return var;
+}
+
+Value Table::columnValue(const size_t ordinal, const std::string& var)
+{
+    return std::visit([&](auto& column) -> Value { return _columnValue(*column, var); }, this->columns[ordinal]);
+}
+
 bool Table::insertRow(const std::vector<std::string>& row, bool write)
 {
-    size_t col_index = 0;
+    // Map the column files if the table is cold, the modified columns are copied into memory
+    if (!this->load()) return false;
 
     const unsigned int argn = row.size();
     
@@ -141,102 +204,158 @@ bool Table::insertRow(const std::vector<std::string>& row, bool write)
         return false;
     }
 
-    // Open the table file and set pointer to end of the file
-    std::ofstream table_file(this->path, std::ofstream::out | std::ofstream::app);
-
     /*  For every variable in the row, check if
         the variable can be converted to the type
-        required by the column. **/
-    for (auto& var : row)
-    {
-        if (write) table_file << var << ',';
-        if (auto col = std::get_if<std::shared_ptr<Column<int>>>(&(this->columns[col_index])))              // INT Type   
-        {
-            // Get a pointer to the column
-            std::shared_ptr<Column<int>> column = *col;
-            
-            // Convert value to integer
-            int val = std::stoi(var);
+        required by the column. Nothing is inserted
+        unless every variable converts. **/
+    std::vector<Value> values;
+    values.reserve(argn);
+    for (size_t col_index = 0; col_index < argn; ++col_index) {
+        values.emplace_back(this->columnValue(col_index, row[col_index]));
+    }
 
-            // Insert value into column
-            column->insertElement(val);
-        }
-        else if (auto col = std::get_if<std::shared_ptr<Column<float>>>(&(this->columns[col_index])))       // FLOAT Type
-        {
-            // Get a pointer to the column
-            std::shared_ptr<Column<float>> column = *col;
+    return this->insertValues(values, row, write);
+}
 
-            // Initialize the amount of significant figures to round to
-            unsigned int sig_figs = 0;
+bool Table::insertValues(const std::vector<Value>& values, const std::vector<std::string>& row, const bool write)
+{
+    // Map the column files if the table is cold, the modified columns are copied into memory
+    if (!this->load()) return false;
+    this->state = TABLE_HOT;
 
-            size_t dec = var.find_first_of('.');
+    const size_t rows = values.size() / this->column_count;
 
-            // Check if decimal found in string
-            if (dec != std::string::npos) 
-            {
-                // Decimal found, so count sig figs
-                for (dec++; dec < var.size(); dec++) sig_figs++;
+    // Insert every value into its column, the values hold the element types of the columns
+    for (size_t col_index = 0; col_index < this->column_count; ++col_index)
+    {
+        std::visit([&](auto& column) {
+            typedef typename std::decay_t<decltype(*column)>::value_type T;
+            if (rows == 1) {
+                column->insertElement(std::get<T>(values[col_index]));
+                return;
             }
-            
-            // Convert value to float
-            float val = std::stof(var);
 
-            if (sig_figs) {
-                val = _roundFloat(val, sig_figs);
-            }
+            // Several rows are appended to the column as one batch
+            std::vector<T> elements;
+            elements.reserve(rows);
+            for (size_t row_index = 0; row_index < rows; ++row_index) elements.emplace_back(std::get<T>(values[row_index * this->column_count + col_index]));
+            column->insertElements(std::move(elements));
+        }, this->columns[col_index]);
+    }
 
-            // Insert value into column
-            column->insertElement(val);
-        }
-        else if (auto col = std::get_if<std::shared_ptr<Column<char>>>(&(this->columns[col_index])))        // CHAR Type
-        {
-            // Get a pointer to the column
-            std::shared_ptr<Column<char>> column = *col;
-            
-            // Convert value to char
-            char val = var[0];
+    // Increment row count
+    this->row_count = this->getRowCount();
+
+    // Log the rows, they reach the column files at the next checkpoint (rows loaded from disk are already stored)
+    if (write) {
+        this->dirty = true;
+        if (rows == 1) return this->logStatement(WAL_INSERT, row);
+
+        std::vector<std::string> record;
+        record.reserve(row.size() + 1);
+        record.emplace_back(std::to_string(rows));
+        record.insert(record.end(), row.begin(), row.end());
+        return this->logStatement(WAL_INSERT_ROWS, record);
+    }
 
-            // Insert value into column
-            column->insertElement(val);
-        }
-        else if (auto col = std::get_if<std::shared_ptr<Column<std::string>>>(&(this->columns[col_index]))) // VARCHAR Type
-        {
-            // Get a pointer to the column
-            std::shared_ptr<Column<std::string>> column = *col;
+    return true;
+}
 
-            size_t max = column->getCharMax();
+bool Table::insertRows(const std::vector<std::string>& values, const size_t rows, const bool write)
+{
+    // Map the column files if the table is cold, the modified columns are copied into memory
+    if (!this->load()) return false;
 
-            // If the size of the string is greater than the max char count, then only insert a range of var
-            if (var.size() > max) {
-                std::string val = std::string(var.begin(), var.begin() + column->getCharMax());
-                column->insertElement(val);
-            }
+    if (!rows || values.size() != rows * this->column_count) 
+    {
+        std::cout << "-- INSERT INTO parameter count (" << (rows ? values.size() / rows : 0) << ") does not equal the number of columns (" << column_count << ") in table " << table_name << "\n";
+        return false;
+    }
 
-            // Insert value into column
-            column->insertElement(var);
-        }
-        else {
-            std::cout << "-- Programmer error in Table::insertRow\n";
-        }
-        ++col_index;
+    /*  Convert the values one column at a time into
+        storage reserved for the whole batch. Nothing
+        is inserted unless every value converts. **/
+    std::vector<ColumnValues> batch;
+    batch.reserve(this->column_count);
+    for (size_t col_index = 0; col_index < this->column_count; ++col_index)
+    {
+        std::visit([&](auto& column) {
+            typedef typename std::decay_t<decltype(*column)>::value_type T;
+            std::vector<T> elements;
+            elements.reserve(rows);
+            for (size_t row_index = 0; row_index < rows; ++row_index) elements.emplace_back(_columnValue(*column, values[row_index * this->column_count + col_index]));
+            batch.emplace_back(std::move(elements));
+        }, this->columns[col_index]);
     }
-    // Insert new line
-    if (write) table_file << '\n';
 
-    // Close the file
-    if (table_file.is_open()) table_file.close();
+    if (!this->appendColumns(batch, rows, write)) return false;
 
-    // Increment row count
-    this->row_count = ((std::get<0>(this->columns[0]))->getElements()).size();
+    // One log record holds the batch, the rows reach the column files at the next checkpoint
+    if (write) {
+        std::vector<std::string> record;
+        record.reserve(values.size() + 1);
+        record.emplace_back(std::to_string(rows));
+        record.insert(record.end(), values.begin(), values.end());
+
+        return this->logStatement(WAL_INSERT_ROWS, record);
+    }
+
+    return true;
+}
+
+bool Table::appendColumns(std::vector<ColumnValues>& batch, const size_t rows, const bool write)
+{
+    // Map the column files if the table is cold, the modified columns are copied into memory
+    if (!this->load()) return false;
+    if (!rows) return true;
 
-    // Update metadata
-    this->writeMetadata();
+    // Append every column once
+    this->state = TABLE_HOT;
+    for (size_t col_index = 0; col_index < this->column_count; ++col_index)
+    {
+        std::visit([&](auto& column) {
+            typedef typename std::decay_t<decltype(*column)>::value_type T;
+            column->insertElements(std::move(std::get<std::vector<T>>(batch[col_index])));
+        }, this->columns[col_index]);
+    }
 
+    this->row_count = this->getRowCount();
+    if (write) this->dirty = true;
     return true;
 }
 
+std::vector<ColumnValues> Table::columnBuffers()
+{
+    std::vector<ColumnValues> buffers;
+    buffers.reserve(this->column_count);
+    for (auto& column : this->columns)
+    {
+        std::visit([&](auto& column) {
+            typedef typename std::decay_t<decltype(*column)>::value_type T;
+            buffers.emplace_back(std::vector<T>());
+        }, column);
+    }
+    return buffers;
+}
+
+std::vector<ColumnElements> Table::columnViews()
+{
+    std::vector<ColumnElements> views;
+    views.reserve(this->column_count);
+    for (auto& column : this->columns)
+    {
+        std::visit([&](auto& column) {
+            views.emplace_back(column->getElements());
+        }, column);
+    }
+    return views;
+}
+
 bool Table::printAll()
 {
+    // Map the column files if the table is cold
+    if (!this->load()) return false;
+
     // Print column meta data
     std::cout << "-- ";
     for (size_t i = 0; i < this->column_meta_data.size(); i++)
@@ -253,6 +372,9 @@ bool Table::printAll()
 
     for (; row_index < this->row_count; ++row_index, col_index=0)
     {
+        // Deleted rows stay in the columns until the table is compacted
+        if (this->isDeleted(row_index)) continue;
+
         for (; col_index < this->column_count; ++col_index)
         {
             std::string to_print;
@@ -261,28 +383,28 @@ bool Table::printAll()
                 // Get a pointer to the column
                 std::shared_ptr<Column<int>> column = *col;
 
-                to_print = std::to_string(column->getElements()[row_index]);
+                to_print = std::to_string(column->getElement(row_index));
             }
             else if (auto col = std::get_if<std::shared_ptr<Column<float>>>(&(this->columns[col_index])))
             {
                 // Get a pointer to the column
                 std::shared_ptr<Column<float>> column = *col;
 
-                to_print = std::to_string(column->getElements()[row_index]);
+                to_print = std::to_string(column->getElement(row_index));
             }
             else if (auto col = std::get_if<std::shared_ptr<Column<char>>>(&(this->columns[col_index])))
             {
                 // Get a pointer to the column
                 std::shared_ptr<Column<char>> column = *col;
 
-                to_print = column->getElements()[row_index];
+                to_print = column->getElement(row_index);
             }
             else if (auto col = std::get_if<std::shared_ptr<Column<std::string>>>(&(this->columns[col_index])))
             {
                 // Get a pointer to the column
                 std::shared_ptr<Column<std::string>> column = *col;
 
-                to_print = column->getElements()[row_index];
+                to_print = column->getElement(row_index);
             }
             
             if (col_index == 0) std::cout << "-- ";
@@ -296,66 +418,40 @@ bool Table::printAll()
 
 long int Table::columnIndexFromName(const std::string& column_name)
 {
-    long int index = 0;
-    for (auto& col_data : this->column_meta_data) {
-        std::string name = std::get<0>(this->column_meta_data[index]);
-        if (_toUpper(name) == _toUpper(column_name)) return index;
-        index++;
-    }
-    return (long int) -1;
+    auto found = this->column_index.find(column_name);
+    if (found == this->column_index.end()) return (long int) -1;
+
+    return (long int) found->second;
 }
 
 bool Table::updateColumnSet(
     const std::string& column_to_update,
-    const std::string& column_to_search,
     const std::string& value_to_update,
-    const std::string& value_to_search,
-    const std::string& op,
+    Predicate& where,
     const bool mode
 )
 {
+    // Map the column files if the table is cold, the modified columns are copied into memory
+    if (!this->load()) return false;
+    this->state = TABLE_HOT;
+
     long int update_colum_index = columnIndexFromName(column_to_update);
     if (update_colum_index == (long int)-1) { std::cout << "-- !Failed to update table " << table_name << " because column " << column_to_update << " does not exist.\n"; return false; }
 
-    long int search_colum_index = (column_to_update == column_to_search) ? update_colum_index : columnIndexFromName(column_to_search);
-    if (search_colum_index == (long int)-1) { std::cout << "-- !Failed to update table " << table_name << " because column " << search_colum_index << " does not exist.\n"; return false; }
+    if (!this->resolvePredicate(where)) return false;
 
-    size_t rows_affected = 0;
-
-    // initialize container for the indicies we want to update in 'column_to_update'
-    std::unordered_set<size_t> elements_to_update;
+    // Transactions only count the rows, the statement runs again at COMMIT
+    if (mode == false) {
+        Bitmap elements_to_update;
+        if (!this->filterRows(where, elements_to_update)) return false;
+        std::cout << "-- " << elements_to_update.count() << " records modified.\n";
+        return true;
+    }
 
-    try
+    Value value;
+    try 
     {
-        if (auto col = std::get_if<std::shared_ptr<Column<int>>>(&(this->columns[search_colum_index])))
-        {
-            // Get a pointer to the column
-            std::shared_ptr<Column<int>> column = *col;
-
-            // Search column 
-            elements_to_update = column->filterElements(op, std::stoi(value_to_search));
-        }
-        else if (auto col = std::get_if<std::shared_ptr<Column<float>>>(&(this->columns[search_colum_index])))
-        {
-            // Get a pointer to the column
-            std::shared_ptr<Column<float>> column = *col;
-
-            elements_to_update = column->filterElements(op, std::stof(value_to_search));
-        }
-        else if (auto col = std::get_if<std::shared_ptr<Column<char>>>(&(this->columns[search_colum_index])))
-        {
-            // Get a pointer to the column
-            std::shared_ptr<Column<char>> column = *col;
-
-            elements_to_update = column->filterElements(op, value_to_search[0]);
-        }
-        else if (auto col = std::get_if<std::shared_ptr<Column<std::string>>>(&(this->columns[search_colum_index])))
-        {
-            // Get a pointer to the column
-            std::shared_ptr<Column<std::string>> column = *col;
-
-            elements_to_update = column->filterElements(op, value_to_search);
-        }
+        value = this->columnValue(update_colum_index, value_to_update);
     }
     catch(const std::exception& e)
     {
@@ -363,54 +459,35 @@ bool Table::updateColumnSet(
         return false;
     }
 
-    if (mode == false) {
-        std::cout << "-- " << elements_to_update.size() << " records modified.\n";
-        return true;
-    }
-
-    try 
-    {
-        if (!elements_to_update.empty()) 
-        {
-            if (auto col = std::get_if<std::shared_ptr<Column<int>>>(&(this->columns[update_colum_index]))) {
-                // Get a pointer to the column
-                std::shared_ptr<Column<int>> column = *col;
+    return this->updateWhere(update_colum_index, value, value_to_update, where);
+}
 
-                // Update the column based on provided indicies
-                rows_affected = column->updateElementsOnIndex(elements_to_update, std::stoi(value_to_update));
-            }
-            else if (auto col = std::get_if<std::shared_ptr<Column<float>>>(&(this->columns[update_colum_index]))) {
-                // Get a pointer to the column
-                std::shared_ptr<Column<float>> column = *col;
+bool Table::updateWhere(const size_t ordinal, const Value& value, const std::string& text, const Predicate& where)
+{
+    // Map the column files if the table is cold, the modified columns are copied into memory
+    if (!this->load()) return false;
+    this->state = TABLE_HOT;
 
-                // Update the column based on provided indicies
-                rows_affected = column->updateElementsOnIndex(elements_to_update, std::stof(value_to_update));            
-            }
-            else if (auto col = std::get_if<std::shared_ptr<Column<char>>>(&(this->columns[update_colum_index])))
-            {
-                // Get a pointer to the column
-                std::shared_ptr<Column<char>> column = *col;
+    size_t rows_affected = 0;
 
-                // Update the column based on provided indicies
-                rows_affected = column->updateElementsOnIndex(elements_to_update, value_to_update[0]);
-            }
-            else if (auto col = std::get_if<std::shared_ptr<Column<std::string>>>(&(this->columns[update_colum_index])))
-            {
-                // Get a pointer to the column
-                std::shared_ptr<Column<std::string>> column = *col;
+    // initialize container for the indicies we want to update in column 'ordinal'
+    Bitmap elements_to_update;
+    if (!this->filterRows(where, elements_to_update)) return false;
 
-                // Update the column based on provided indicies
-                rows_affected = column->updateElementsOnIndex(elements_to_update, value_to_update);   
-            }
-        }
-    }
-    catch(const std::exception& e)
+    // Update the column based on provided indicies
+    if (elements_to_update.any())
     {
-        std::cerr << e.what() << "\n";
-        return false;
+        rows_affected = std::visit([&](auto& column) {
+            typedef typename std::decay_t<decltype(*column)>::value_type T;
+            return column->updateElementsOnIndex(elements_to_update, std::get<T>(value));
+        }, this->columns[ordinal]);
     }
 
-    std::cout << "-- " << rows_affected << " records modified.\n";
+    // Log the statement, the column files are rewritten at the next checkpoint
+    this->dirty = this->rewrite = true;
+    if (!this->logStatement(WAL_UPDATE, { this->column_meta_data[ordinal].first, text, predicateText(where) })) return false;
+
+    if (!this->isReplaying()) std::cout << "-- " << rows_affected << " records modified.\n";
 
     return true;
 }
@@ -467,120 +544,122 @@ bool Table::deleteRow(const size_t row)
     return true;
 }
 
-bool Table::deleteFromTable(const std::string& column_to_search, const std::string& value_to_search, const std::string& opr)
+size_t Table::deleteRows(const Bitmap& rows)
 {
-    long int search_column_index = columnIndexFromName(column_to_search);
-    if (search_column_index == (long int)-1) { std::cout << "-- !Failed to delete from table " << this->table_name << " because column " << column_to_search << " does not exist.\n"; return false; }
+    size_t count = 0;
 
-    std::unordered_set<size_t> indicies_to_delete;
+    for (auto& column : this->columns) {
+        count = std::visit([&](auto& col) { return col->deleteElements(rows); }, column);
+    }
 
-    if (auto col = std::get_if<std::shared_ptr<Column<int>>>(&(this->columns[search_column_index])))
-    {
-        // Get a pointer to the column
-        std::shared_ptr<Column<int>> column = *col;
+    this->row_count = this->getRowCount();
 
-        // Get the indicies of the rows we want to delete  
-        indicies_to_delete = column->filterElements(opr, std::stoi(value_to_search));
-    }
-    else if (auto col = std::get_if<std::shared_ptr<Column<float>>>(&(this->columns[search_column_index])))
-    {
-        // Get a pointer to the column
-        std::shared_ptr<Column<float>> column = *col;
+    return count;
+}
 
-        // Get the indicies of the rows we want to delete  
-        indicies_to_delete = column->filterElements(opr, std::stof(value_to_search));
+void Table::clearRows()
+{
+    for (auto& column : this->columns) {
+        std::visit([](auto& col) { col->clearElements(); }, column);
     }
-    else if (auto col = std::get_if<std::shared_ptr<Column<char>>>(&(this->columns[search_column_index])))
-    {
-        // Get a pointer to the column
-        std::shared_ptr<Column<char>> column = *col;
+    this->row_count = 0;
+    this->deleted = Bitmap();
+    this->deleted_rows = 0;
+    this->state = TABLE_HOT;
+}
 
-        // Get the indicies of the rows we want to delete  
-        indicies_to_delete = column->filterElements(opr, value_to_search[0]);
-    }
-    else if (auto col = std::get_if<std::shared_ptr<Column<std::string>>>(&(this->columns[search_column_index])))
-    {
-        // Get a pointer to the column
-        std::shared_ptr<Column<std::string>> column = *col;
+size_t Table::compact()
+{
+    if (!this->deleted_rows) return 0;
 
-        // Get the indicies of the rows we want to delete  
-        indicies_to_delete = column->filterElements(opr, value_to_search);
-    }
+    // Every column is rewritten once, its indexes and zone maps drop the rows with it
+    const size_t count = this->deleteRows(this->deleted);
+    this->deleted = Bitmap();
+    this->deleted_rows = 0;
+    this->state = TABLE_HOT;
 
-    // Initialize the number of rows deleted
-    size_t count = 0;
+    // The column files still hold the rows, they are rewritten at the next checkpoint
+    this->dirty = this->rewrite = true;
+
+    return count;
+}
+
+bool Table::deleteFromTable(Predicate& where)
+{
+    // Map the column files if the table is cold
+    if (!this->load()) return false;
 
-    // Check if there are rows to delete
-    if (!indicies_to_delete.empty())
+    if (!this->resolvePredicate(where)) return false;
+
+    return this->deleteWhere(where);
+}
+
+bool Table::deleteWhere(const Predicate& where)
+{
+    // Map the column files if the table is cold, the columns are not modified
+    if (!this->load()) return false;
+
+    Bitmap indicies_to_delete;
+    if (!this->filterRows(where, indicies_to_delete)) return false;
+
+    // Initialize the number of rows deleted, rows already deleted do not satisfy the predicate
+    const size_t count = indicies_to_delete.count();
+
+    // Mark the rows as deleted, they are removed from the columns when the table is compacted
+    if (count)
     {
-        // For every row index, delete the row and increment the count
-        for (auto& index : indicies_to_delete)
-        {
-            if (this->deleteRow(index)) ++count;
-        }
+        this->deleted.resize(this->getRowCount());
+        this->deleted |= indicies_to_delete;
+        this->deleted_rows += count;
     }
 
-    std::cout << "-- " << count << " records deleted.\n";
+    // Log the statement, the column files are rewritten at the next checkpoint
+    this->dirty = this->rewrite = true;
+    if (!this->logStatement(WAL_DELETE, { predicateText(where) })) return false;
+
+    if (!this->isReplaying()) std::cout << "-- " << count << " records deleted.\n";
 
     return true; 
 }
 
 
-bool Table::selectColumns(
-        const std::vector<std::string>& columns,
-        const std::string& column_to_query,
-        const std::string& value_to_query, 
-        const std::string& opr
-    ) 
+bool Table::selectColumns(const std::vector<std::string>& columns, Predicate& where) 
 {
-    std::vector<size_t> column_indicies;
+    // Map the column files if the table is cold
+    if (!this->load()) return false;
 
     // Ensure that each column exists in this table
-    for (auto col : columns)
-    {
-        column_indicies.emplace_back(columnIndexFromName(col));
-        if (!this->columnExists(col)) {
-            std::cout << "-- !Failed to query table " << this->table_name << " because column " << col << "does not exist.\n";
-            return false;
-        }
-    }
-
-    std::unordered_set<size_t> indicies_to_select;
+    std::vector<size_t> column_indicies;
+    if (!this->resolveColumns(columns, column_indicies)) return false;
 
-    long int query_column_index = columnIndexFromName(column_to_query);
-    if (query_column_index == (long int)-1) { std::cout << "-- !Failed to query from table " << this->table_name << " because column " << query_column_index << " does not exist.\n"; return false; }
+    if (!this->resolvePredicate(where)) return false;
 
-    auto variant_col = &(this->columns[query_column_index]);
-    if (auto col = std::get_if<std::shared_ptr<Column<int>>>(variant_col))
-    {
-        // Get a pointer to the column
-        std::shared_ptr<Column<int>> column = *col;
+    return this->selectWhere(column_indicies, where);
+}
 
-        indicies_to_select = column->filterElements(opr, std::stoi(value_to_query));
-    }
-    else if (auto col = std::get_if<std::shared_ptr<Column<float>>>(variant_col))
+bool Table::resolveColumns(const std::vector<std::string>& columns, std::vector<size_t>& ordinals)
+{
+    for (auto& col : columns)
     {
-        // Get a pointer to the column
-        std::shared_ptr<Column<float>> column = *col;
-
-        indicies_to_select = column->filterElements(opr, std::stof(value_to_query));
+        const long int index = columnIndexFromName(col);
+        if (index == (long int)-1) {
+            std::cout << "-- !Failed to query table " << this->table_name << " because column " << col << "does not exist.\n";
+            return false;
+        }
+        ordinals.emplace_back(index);
     }
-    else if (auto col = std::get_if<std::shared_ptr<Column<char>>>(variant_col))
-    {
-        // Get a pointer to the column
-        std::shared_ptr<Column<char>> column = *col;
+    return true;
+}
 
-        indicies_to_select = column->filterElements(opr, value_to_query[0]);
-    }
-    else if (auto col = std::get_if<std::shared_ptr<Column<std::string>>>(variant_col))
-    {
-        // Get a pointer to the column
-        std::shared_ptr<Column<std::string>> column = *col;
+bool Table::selectWhere(const std::vector<size_t>& column_indicies, const Predicate& where)
+{
+    // Map the column files if the table is cold
+    if (!this->load()) return false;
 
-        indicies_to_select = column->filterElements(opr, value_to_query);
-    }
+    Bitmap indicies_to_select;
+    if (!this->filterRows(where, indicies_to_select)) return false;
 
-    if (!indicies_to_select.empty()) 
+    if (indicies_to_select.any()) 
     {
         // Print column meta data
         std::cout << "-- ";
@@ -595,7 +674,8 @@ bool Table::selectColumns(
         }
         std::cout << "\n";
 
-        for (size_t row_index : indicies_to_select)
+        // Print the selected rows in table order
+        indicies_to_select.forEach([&](size_t row_index)
         {
             std::cout << "-- ";
             for (size_t col_index : column_indicies)
@@ -605,7 +685,7 @@ bool Table::selectColumns(
                     // Get a pointer to the column
                     std::shared_ptr<Column<int>> column = *col;
 
-                    std::cout << column->getElements()[row_index];
+                    std::cout << column->getElement(row_index);
                     std::cout << " | ";
                 }
                 else if (auto col = std::get_if<std::shared_ptr<Column<float>>>(&(this->columns[col_index])))
@@ -613,7 +693,7 @@ bool Table::selectColumns(
                     // Get a pointer to the column
                     std::shared_ptr<Column<float>> column = *col;
 
-                    std::cout << column->getElements()[row_index];
+                    std::cout << column->getElement(row_index);
                     std::cout << " | ";
                 }
                 else if (auto col = std::get_if<std::shared_ptr<Column<char>>>(&(this->columns[col_index])))
@@ -621,7 +701,7 @@ bool Table::selectColumns(
                     // Get a pointer to the column
                     std::shared_ptr<Column<char>> column = *col;
 
-                    std::cout << column->getElements()[row_index];
+                    std::cout << column->getElement(row_index);
                     std::cout << " | ";
                 }
                 else if (auto col = std::get_if<std::shared_ptr<Column<std::string>>>(&(this->columns[col_index])))
@@ -629,12 +709,12 @@ bool Table::selectColumns(
                     // Get a pointer to the column
                     std::shared_ptr<Column<std::string>> column = *col;
 
-                    std::cout << column->getElements()[row_index];
+                    std::cout << column->getElement(row_index);
                     std::cout << " | ";
                 } 
             }
             std::cout << "\n";
-        }
+        });
     }
 
     return true;
@@ -642,11 +722,7 @@ bool Table::selectColumns(
 
 bool Table::columnExists(const std::string& column_name)
 {
-    for (auto& col : this->column_meta_data) {
-        if (_toUpper(column_name) == _toUpper(std::get<0>(col))) return true;
-    }
-
-    return false;
+    return this->column_index.count(column_name);
 }
 
 size_t Table::getColumnType(const std::string& column_name)
@@ -693,11 +769,11 @@ std::shared_ptr<Column<int>> Table::selectColumnInt(const std::string& column_na
 {
     std::shared_ptr<Column<int>> column;
 
+    if (!this->load()) return column;
+
     size_t index = this->columnIndexFromName(column_name);
 
-    if (index == -1 || this->getColumnType(column_name) != (size_t)0) {
-        return column;
-    }
+    if (index == -1) return column;
 
     if (auto col = std::get_if<std::shared_ptr<Column<int>>>(&(this->columns[index])))
     {
@@ -711,9 +787,11 @@ std::shared_ptr<Column<float>> Table::selectColumnFloat(const std::string& colum
 {
     std::shared_ptr<Column<float>> column;
 
+    if (!this->load()) return column;
+
     size_t index = this->columnIndexFromName(column_name);
 
-    if (index == -1 || this->getColumnType(column_name) != (size_t)1) return column;
+    if (index == -1) return column;
 
     if (auto col = std::get_if<std::shared_ptr<Column<float>>>(&(this->columns[index])))
     {
@@ -727,9 +805,11 @@ std::shared_ptr<Column<char>> Table::selectColumnChar(const std::string& column_
 {
     std::shared_ptr<Column<char>> column;
 
+    if (!this->load()) return column;
+
     size_t index = this->columnIndexFromName(column_name);
 
-    if (index == -1 || this->getColumnType(column_name) != (size_t)2) return column;
+    if (index == -1) return column;
 
     if (auto col = std::get_if<std::shared_ptr<Column<char>>>(&(this->columns[index])))
     {
@@ -743,9 +823,11 @@ std::shared_ptr<Column<std::string>> Table::selectColumnString(const std::string
 {
     std::shared_ptr<Column<std::string>> column;
 
+    if (!this->load()) return column;
+
     size_t index = this->columnIndexFromName(column_name);
 
-    if (index == -1 || this->getColumnType(column_name) != (size_t)3) return column;
+    if (index == -1) return column;
 
     if (auto col = std::get_if<std::shared_ptr<Column<std::string>>>(&(this->columns[index])))
     {
@@ -756,6 +838,9 @@ std::shared_ptr<Column<std::string>> Table::selectColumnString(const std::string
 }
 
 bool Table::printRow(const size_t row) {
+    // Map the column files if the table is cold
+    if (!this->load()) return false;
+
     if (row >= this->row_count) return false;
 
     size_t counter = 0;
@@ -768,28 +853,28 @@ bool Table::printRow(const size_t row) {
                 std::shared_ptr<Column<int>> column = *col;
                 
                 // Print the value
-                std::cout << column->getElements()[row];
+                std::cout << column->getElement(row);
             }
             else if (auto col = std::get_if<std::shared_ptr<Column<float>>>(&(this->columns[i]))) {
                 // Get a pointer to the column
                 std::shared_ptr<Column<float>> column = *col;
                 
                 // Print the value
-                std::cout << column->getElements()[row];
+                std::cout << column->getElement(row);
             }
             else if (auto col = std::get_if<std::shared_ptr<Column<char>>>(&(this->columns[i]))) {
                 // Get a pointer to the column
                 std::shared_ptr<Column<char>> column = *col;
                 
                 // Print the value
-                std::cout << column->getElements()[row];
+                std::cout << column->getElement(row);
             }
             else if (auto col = std::get_if<std::shared_ptr<Column<std::string>>>(&(this->columns[i]))) {
                 // Get a pointer to the column
                 std::shared_ptr<Column<std::string>> column = *col;
                 
                 // Print the value
-                std::cout << column->getElements()[row];
+                std::cout << column->getElement(row);
             }
 
             if (counter != (this->columnCount() - 1)) std::cout << " | ";
@@ -807,7 +892,9 @@ bool Table::writeMetadata()
 {
     const fs::path path = this->getPathMetadata();
 
-    std::ofstream metadata_file(path, std::ofstream::out | std::ofstream::trunc);
+    // Other processes read the file while it is written, they see the old or the new one
+    const fs::path tmp = processTempPath(path);
+    std::ofstream metadata_file(tmp, std::ofstream::out | std::ofstream::trunc);
     try {
         metadata_file << "table_name: " << this->getTable() << "\n";
 
@@ -839,7 +926,7 @@ bool Table::writeMetadata()
         metadata_file.close();
     }
 
-    return true;
+    return replaceFile(tmp, path);
 }
 
 void Table::applyMetadata(const TableMetadata& md )
@@ -848,59 +935,671 @@ void Table::applyMetadata(const TableMetadata& md )
     this->setLocked(md.locked);
 }
 
-bool Table::writeCSV()
+fs::path Table::columnPath(const size_t index, const std::string& extension)
+{
+    // <table directory>/<table>.<index>.<extension>
+    fs::path path = this->path;
+    path.replace_extension();
+    path += "." + std::to_string(index) + "." + extension;
+    return path;
+}
+
+bool Table::writeBinary()
 {
-    std::ofstream file(this->getPath(), std::ofstream::out | std::ofstream::trunc);
+    // Map the column files if the table is cold
+    if (!this->load()) return false;
+
+    bool success = true;
+
+    // Rewrite every column file
+    for (size_t i = 0; i < this->column_count; ++i)
+    {
+        if (auto col = std::get_if<std::shared_ptr<Column<int>>>(&(this->columns[i]))) {
+            // Get a pointer to the column
+            std::shared_ptr<Column<int>> column = *col;
 
-    auto headers = this->getMetaData();
-    for (auto& col : headers) {
-        file << col.first << " " << col.second << ",";
+            success = writeColumnFile(this->columnPath(i, "col"), column->getElements(), STORAGE_INT) && success;
+        }
+        else if (auto col = std::get_if<std::shared_ptr<Column<float>>>(&(this->columns[i]))) {
+            // Get a pointer to the column
+            std::shared_ptr<Column<float>> column = *col;
+
+            success = writeColumnFile(this->columnPath(i, "col"), column->getElements(), STORAGE_FLOAT) && success;
+        }
+        else if (auto col = std::get_if<std::shared_ptr<Column<char>>>(&(this->columns[i]))) {
+            // Get a pointer to the column
+            std::shared_ptr<Column<char>> column = *col;
+
+            success = writeColumnFile(this->columnPath(i, "col"), column->getElements(), STORAGE_CHAR) && success;
+        }
+        else if (auto col = std::get_if<std::shared_ptr<Column<std::string>>>(&(this->columns[i]))) {
+            // Get a pointer to the column
+            std::shared_ptr<Column<std::string>> column = *col;
+
+            success = writeStringColumnFile(this->columnPath(i, "col"), this->columnPath(i, "dat"), column->getElements(), (uint32_t)column->getCharMax()) && success;
+        }
     }
-    file << "\n";
 
-    size_t rows = this->getRowCount();
+    // The table file is written last, it commits the new row count
+    const TableCommit commit{ this->getRowCount(), this->checkpoint_lsn, this->generation + 1, this->checkpoint_log };
+    if (!success || !writeTableFile(this->path, this->columnDescriptors(), this->indexes, commit)) return false;
 
-    try {
-        for (size_t row = 0; row < rows; row++)
-        {
-            // Iterate over every column
-            for (size_t i = 0; i < this->column_count; ++i) {
-                if (auto col = std::get_if<std::shared_ptr<Column<int>>>(&(this->columns[i]))) {
-                    // Get a pointer to the column
-                    std::shared_ptr<Column<int>> column = *col;
-                    
-                    // Print the value
-                    file << column->getElements()[row] << ",";
-                }
-                else if (auto col = std::get_if<std::shared_ptr<Column<float>>>(&(this->columns[i]))) {
-                    // Get a pointer to the column
-                    std::shared_ptr<Column<float>> column = *col;
-                    
-                    // Print the value
-                    file << column->getElements()[row] << ",";
-                }
-                else if (auto col = std::get_if<std::shared_ptr<Column<char>>>(&(this->columns[i]))) {
-                    // Get a pointer to the column
-                    std::shared_ptr<Column<char>> column = *col;
-                    
-                    // Print the value
-                    file << column->getElements()[row] << ",";
-                }
-                else if (auto col = std::get_if<std::shared_ptr<Column<std::string>>>(&(this->columns[i]))) {
-                    // Get a pointer to the column
-                    std::shared_ptr<Column<std::string>> column = *col;
-                    
-                    // Print the value
-                    file << column->getElements()[row] << ",";
-                }
-            }
-            file << "\n";
+    this->persisted_rows = commit.row_count;
+    this->generation = commit.generation;
+    return true;
+}
+
+bool Table::appendBinary(const size_t from, const size_t rows)
+{
+    bool success = true;
+
+    // Append the new rows to every column file
+    for (size_t i = 0; i < this->column_count; ++i)
+    {
+        if (auto col = std::get_if<std::shared_ptr<Column<int>>>(&(this->columns[i]))) {
+            success = success && appendColumnFile(this->columnPath(i, "col"), (*col)->getElements(), from, rows);
+        }
+        else if (auto col = std::get_if<std::shared_ptr<Column<float>>>(&(this->columns[i]))) {
+            success = success && appendColumnFile(this->columnPath(i, "col"), (*col)->getElements(), from, rows);
+        }
+        else if (auto col = std::get_if<std::shared_ptr<Column<char>>>(&(this->columns[i]))) {
+            success = success && appendColumnFile(this->columnPath(i, "col"), (*col)->getElements(), from, rows);
+        }
+        else if (auto col = std::get_if<std::shared_ptr<Column<std::string>>>(&(this->columns[i]))) {
+            success = success && appendStringColumnFile(this->columnPath(i, "col"), this->columnPath(i, "dat"), (*col)->getElements(), from, rows);
         }
     }
-    catch(const std::exception& e)
+
+    // Only commit the new row count once every column holds the rows
+    if (!success) { std::cout << "-- !Failed to write rows to table " << this->table_name << "\n"; return false; }
+    const TableCommit commit{ rows + this->getRowCount() - from, this->checkpoint_lsn, this->generation + 1, this->checkpoint_log };
+    if (!writeTableCommit(this->path, commit)) return false;
+
+    this->persisted_rows = commit.row_count;
+    this->generation = commit.generation;
+    return true;
+}
+
+bool Table::readBinary()
+{
+    std::vector<ColumnDescriptor> descriptors;
+    std::vector<IndexDescriptor> index_descriptors;
+    TableCommit commit;
+
+    if (!readTableFile(this->path, descriptors, index_descriptors, commit)) return false;
+
+    const uint64_t rows = commit.row_count, lsn = commit.checkpoint_lsn;
+
+    // The column files must match the columns of the table
+    if (descriptors.size() != this->column_count) {
+        std::cout << "-- !Table file of " << this->table_name << " has " << descriptors.size() << " columns, expected " << this->column_count << "\n";
+        return false;
+    }
+
+    for (size_t i = 0; i < this->column_count; ++i)
+    {
+        const uint32_t data_type = std::visit([](auto& column) { return column->getDataType(); }, this->columns[i]);
+        if (descriptors[i].data_type != data_type) {
+            std::cout << "-- !Column " << descriptors[i].name << " of table " << this->table_name << " has an unexpected type on disk\n";
+            return false;
+        }
+    }
+
+    bool success = true;
+
+    // Map every fixed width column file in place, VARCHAR rows are decoded into memory
+    for (size_t i = 0; i < this->column_count && success; ++i)
     {
+        if (auto col = std::get_if<std::shared_ptr<Column<int>>>(&(this->columns[i]))) {
+            const int* first = nullptr;
+            std::shared_ptr<MappedFile> mapping = mapColumnFile(this->columnPath(i, "col"), rows, first);
+            if ((success = mapping != nullptr)) (*col)->mapElements(mapping, first, rows);
+        }
+        else if (auto col = std::get_if<std::shared_ptr<Column<float>>>(&(this->columns[i]))) {
+            const float* first = nullptr;
+            std::shared_ptr<MappedFile> mapping = mapColumnFile(this->columnPath(i, "col"), rows, first);
+            if ((success = mapping != nullptr)) (*col)->mapElements(mapping, first, rows);
+        }
+        else if (auto col = std::get_if<std::shared_ptr<Column<char>>>(&(this->columns[i]))) {
+            const char* first = nullptr;
+            std::shared_ptr<MappedFile> mapping = mapColumnFile(this->columnPath(i, "col"), rows, first);
+            if ((success = mapping != nullptr)) (*col)->mapElements(mapping, first, rows);
+        }
+        else if (auto col = std::get_if<std::shared_ptr<Column<std::string>>>(&(this->columns[i]))) {
+            std::vector<std::string> elements;
+            success = readStringColumnFile(this->columnPath(i, "col"), this->columnPath(i, "dat"), elements, rows);
+            (*col)->setElements(std::move(elements));
+        }
+    }
+
+    // Never keep a partially loaded table, it stays cold and refuses to be used
+    if (!success) {
+        this->clearRows();
+        this->state = TABLE_COLD;
+        return false;
+    }
+
+    this->state = TABLE_MAPPED;
+    this->row_count = this->getRowCount();
+    this->deleted = Bitmap();
+    this->deleted_rows = 0;
+    this->checkpoint_lsn = lsn;
+    this->checkpoint_log = commit.checkpoint_log;
+    this->persisted_rows = rows;
+    this->generation = commit.generation;
+    this->dirty = this->rewrite = false;
+
+    // Use the zone map files that match the table files, the others are rebuilt by the first filter
+    for (size_t i = 0; i < this->column_count; ++i)
+    {
+        std::visit([&](auto& column) {
+            typedef typename std::decay_t<decltype(*column)>::value_type T;
+            if constexpr (Column<T>::zoned) {
+                auto zones = std::make_shared<ZoneMap<T>>();
+                if (zones->read(this->columnPath(i, "zmp"), column->getDataType(), rows, lsn)) column->setZoneMap(zones);
+            }
+        }, this->columns[i]);
+    }
+
+    // Attach the indexes, read from their files when they match the table files
+    this->indexes.clear();
+    for (auto& descriptor : index_descriptors)
+    {
+        if (this->attachIndex(descriptor, true, rows, lsn)) this->indexes.push_back(descriptor);
+        else std::cout << "-- !Ignoring index " << descriptor.name << " of table " << this->table_name << "\n";
+    }
+
+    return true;
+}
+
+bool Table::open()
+{
+    std::vector<ColumnDescriptor> descriptors;
+    TableCommit commit;
+
+    if (!readTableFile(this->path, descriptors, this->indexes, commit)) return false;
+
+    // Drop anything held in memory, the rows are mapped on first access
+    this->clearRows();
+    this->row_count = (unsigned int)commit.row_count;
+    this->state = TABLE_COLD;
+    this->checkpoint_lsn = commit.checkpoint_lsn;
+    this->checkpoint_log = commit.checkpoint_log;
+    this->persisted_rows = commit.row_count;
+    this->generation = commit.generation;
+    this->dirty = this->rewrite = false;
+    this->logged.clear();
+
+    return true;
+}
+
+bool Table::load()
+{
+    if (this->state != TABLE_COLD) return true;
+
+    if (!this->readBinary()) {
+        std::cout << "-- !Failed to load table " << this->table_name << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool Table::checkpoint(const uint64_t log_id, const uint64_t lsn, const bool sync)
+{
+    if (!this->dirty) return true;
+
+    // Another process may have committed the files since the rows were read
+    TableCommit committed;
+    if (!readTableCommit(this->path, committed)) {
+        std::cout << "-- !Failed to checkpoint table " << this->table_name << "\n";
+        return false;
+    }
+    const bool changed = committed.generation != this->generation;
+
+    // Updates and deletes were made on stale rows, they are made again on the committed ones
+    if (changed && this->rewrite && !this->reapplyStatements()) {
+        std::cout << "-- !Failed to checkpoint table " << this->table_name << "\n";
+        return false;
+    }
+
+    const uint64_t previous_lsn = this->checkpoint_lsn, previous_log = this->checkpoint_log;
+    this->setCheckpoint(log_id, lsn);
+
+    // The table files never hold deleted rows, the files are rewritten anyway
+    this->compact();
+
+    // Rows that were only appended are appended to the column files, anything else rewrites them.
+    // Rows appended after another process committed go after its rows, which are read afterwards.
+    bool success;
+    if (this->rewrite) success = this->writeBinary();
+    else if (!changed) success = this->appendBinary(this->persisted_rows, this->persisted_rows);
+    else {
+        this->generation = committed.generation;
+        success = this->appendBinary(this->persisted_rows, committed.row_count) && this->readBinary();
+    }
+
+    // The index and zone map files are written after the table file, a crash in between
+    // leaves them at the previous checkpoint and they are rebuilt
+    if (success) success = this->writeIndexes();
+    if (success) success = this->writeZoneMaps();
+    if (success && sync) success = this->syncFiles();
+
+    if (!success) {
+        this->setCheckpoint(previous_log, previous_lsn);
+        std::cout << "-- !Failed to checkpoint table " << this->table_name << "\n";
+        return false;
+    }
+
+    this->dirty = this->rewrite = false;
+    this->row_count = this->getRowCount();
+    this->logged.clear();
+    return this->writeMetadata();
+}
+
+bool Table::refresh()
+{
+    if (this->dirty) return true;
+
+    TableCommit committed;
+    if (!readTableCommit(this->path, committed)) {
+        std::cout << "-- !Failed to read table " << this->table_name << "\n";
+        return false;
+    }
+
+    // The rows are mapped again on first access
+    if (committed.generation == this->generation) return true;
+    return this->open();
+}
+
+bool Table::reapplyStatements()
+{
+    std::vector<WalRecord> statements;
+    statements.swap(this->logged);
+
+    // The statements stay in the log if the committed rows cannot be read
+    if (!this->readBinary()) {
+        this->logged.swap(statements);
+        return false;
+    }
+
+    // Replayed statements are not logged a second time
+    const bool replaying = this->isReplaying();
+    if (this->wal) this->wal->setReplaying(true);
+    for (auto& record : statements) this->replayRecord(record);
+    if (this->wal) this->wal->setReplaying(replaying);
+
+    // The files are rewritten even if only rows were appended
+    this->dirty = this->rewrite = true;
+    return true;
+}
+
+bool Table::replayRecord(const WalRecord& record)
+{
+    const std::vector<std::string>& f = record.fields;
+    bool success = false;
+
+    try {
+        if (record.type == WAL_INSERT) {
+            success = this->insertRow(std::vector<std::string>(f.begin() + 1, f.end()), true);
+        }
+        else if (record.type == WAL_INSERT_ROWS && f.size() > 2) {
+            success = this->insertRows(std::vector<std::string>(f.begin() + 2, f.end()), std::stoul(f[1]), true);
+        }
+        else if (record.type == WAL_UPDATE && f.size() == 4) {
+            std::string error;
+            std::shared_ptr<Predicate> where = parsePredicate(f[3], error);
+            success = where && this->updateColumnSet(f[1], f[2], *where, true);
+        }
+        else if (record.type == WAL_DELETE && f.size() == 2) {
+            std::string error;
+            std::shared_ptr<Predicate> where = parsePredicate(f[1], error);
+            success = where && this->deleteFromTable(*where);
+        }
+    }
+    catch(const std::exception& e) {
         std::cerr << e.what() << "\n";
+    }
+
+    // The statement is only held in memory until the next checkpoint
+    if (success) this->logged.push_back(record);
+    return success;
+}
+
+bool Table::syncFiles()
+{
+    bool success = true;
+    for (size_t i = 0; i < this->column_count; ++i)
+    {
+        success = syncFile(this->columnPath(i, "col")) && success;
+        if (std::holds_alternative<std::shared_ptr<Column<std::string>>>(this->columns[i])) success = syncFile(this->columnPath(i, "dat")) && success;
+        else success = syncFile(this->columnPath(i, "zmp")) && success;
+    }
+
+    for (auto& index : this->indexes) success = syncFile(this->indexPath(index.name)) && success;
+
+    // The table file and the directory holding the renamed files go last
+    success = syncFile(this->path) && success;
+    return syncFile(this->path.parent_path()) && success;
+}
+
+bool Table::logStatement(const WalRecordType type, const std::vector<std::string>& fields)
+{
+    if (!this->wal || this->wal->isReplaying()) return true;
+
+    std::vector<std::string> record;
+    record.reserve(fields.size() + 1);
+    record.emplace_back(this->table_name);
+    record.insert(record.end(), fields.begin(), fields.end());
+
+    // Under WAL_SYNC FULL the statement only returns once its record is durable
+    const uint64_t lsn = this->wal->append(type, record);
+    if (!lsn || !this->wal->commit(lsn)) {
+        std::cout << "-- !Failed to log statement on table " << this->table_name << "\n";
         return false;
     }
+
+    // Kept to be applied again if another process commits the table files before the next checkpoint
+    this->logged.push_back({ lsn, (uint32_t)type, std::move(record) });
     return true;
-}
\ No newline at end of file
+}
+
+std::vector<ColumnDescriptor> Table::columnDescriptors()
+{
+    std::vector<ColumnDescriptor> descriptors;
+    descriptors.reserve(this->column_count);
+
+    for (auto& column : this->columns)
+    {
+        std::visit([&](auto& col) {
+            // Only VARCHAR columns have a maximum length
+            const uint32_t char_max = col->getDataType() == STORAGE_VARCHAR ? (uint32_t)col->getCharMax() : 0;
+            descriptors.push_back({ col->getName(), col->getDataType(), char_max });
+        }, column);
+    }
+    return descriptors;
+}
+
+fs::path Table::indexPath(const std::string& index_name)
+{
+    // <table directory>/<table>.<index name>.idx
+    fs::path path = this->path;
+    path.replace_extension();
+    path += "." + index_name + ".idx";
+    return path;
+}
+
+bool Table::hasIndex(const std::string& index_name)
+{
+    for (auto& index : this->indexes) {
+        if (_NameEqual()(index.name, index_name)) return true;
+    }
+    return false;
+}
+
+bool Table::attachIndex(const IndexDescriptor& descriptor, const bool reuse, const uint64_t rows, const uint64_t checkpoint_lsn)
+{
+    if (descriptor.column >= this->column_count) return false;
+
+    const fs::path path = this->indexPath(descriptor.name);
+
+    return std::visit([&](auto& column) {
+        auto index = makeIndex<typename std::decay_t<decltype(*column)>::value_type>(descriptor.name, (IndexType)descriptor.type);
+        if (!index) return false;
+
+        // A stale or missing index file is rebuilt from the column
+        if (!reuse || !index->read(path, rows, checkpoint_lsn)) index->build(column->getElements());
+
+        column->addIndex(index);
+        return true;
+    }, this->columns[descriptor.column]);
+}
+
+bool Table::createIndex(const std::string& index_name, const std::string& column_name, const IndexType type)
+{
+    if (!this->load()) return false;
+
+    // Check if the column exists
+    auto it = this->column_index.find(column_name);
+    if (it == this->column_index.end()) {
+        std::cout << "-- !Column " << column_name << " does not exist in table " << this->table_name << "\n";
+        return false;
+    }
+
+    IndexDescriptor descriptor{ index_name, (uint32_t)it->second, (uint32_t)type };
+    if (!this->attachIndex(descriptor, false, 0, 0)) {
+        std::cout << "-- !Column " << column_name << " cannot have a " << indexTypeName(type) << " index.\n";
+        return false;
+    }
+    this->indexes.push_back(descriptor);
+
+    // The index covers the rows in the table files, the table file lists it
+    const TableCommit commit{ this->persisted_rows, this->checkpoint_lsn, this->generation + 1, this->checkpoint_log };
+    if (!this->writeIndexes() || !writeTableFile(this->path, this->columnDescriptors(), this->indexes, commit)) {
+        this->dropIndex(index_name);
+        return false;
+    }
+    this->generation = commit.generation;
+    return true;
+}
+
+bool Table::dropIndex(const std::string& index_name)
+{
+    for (auto it = this->indexes.begin(); it != this->indexes.end(); ++it)
+    {
+        if (!_NameEqual()(it->name, index_name)) continue;
+
+        // Detach the index from its column (a cold table has none attached)
+        const IndexDescriptor descriptor = *it;
+        std::visit([&](auto& column) { column->dropIndex(descriptor.name); }, this->columns[descriptor.column]);
+        this->indexes.erase(it);
+
+        std::error_code ec;
+        fs::remove(this->indexPath(descriptor.name), ec);
+
+        const TableCommit commit{ this->persisted_rows, this->checkpoint_lsn, this->generation + 1, this->checkpoint_log };
+        if (!writeTableFile(this->path, this->columnDescriptors(), this->indexes, commit)) return false;
+
+        this->generation = commit.generation;
+        return true;
+    }
+    return false;
+}
+
+bool Table::writeIndexes()
+{
+    // A cold table has no index in memory, its index files are still current
+    if (this->state == TABLE_COLD) return true;
+
+    bool success = true;
+    for (auto& descriptor : this->indexes)
+    {
+        success = std::visit([&](auto& column) {
+            auto index = column->getIndex(descriptor.name);
+            return index && index->write(this->indexPath(descriptor.name), this->checkpoint_lsn);
+        }, this->columns[descriptor.column]) && success;
+    }
+    return success;
+}
+
+bool Table::writeZoneMaps()
+{
+    // A cold table has no zone map in memory, its zone map files are still current
+    if (this->state == TABLE_COLD) return true;
+
+    bool success = true;
+    for (size_t i = 0; i < this->column_count; ++i)
+    {
+        success = std::visit([&](auto& column) {
+            typedef typename std::decay_t<decltype(*column)>::value_type T;
+            if constexpr (Column<T>::zoned) return column->zoneMap()->write(this->columnPath(i, "zmp"), column->getDataType(), this->checkpoint_lsn);
+            return true;
+        }, this->columns[i]) && success;
+    }
+    return success;
+}
+
+void Table::setAdaptiveIndexing(const bool adaptive)
+{
+    this->adaptive = adaptive;
+    for (auto& column : this->columns) {
+        std::visit([&](auto& col) { if (col->crackable) col->setAdaptive(adaptive); }, column);
+    }
+}
+
+std::vector<ColumnStats> Table::columnStats()
+{
+    std::vector<ColumnStats> stats;
+    for (auto& column : this->columns) {
+        stats.emplace_back(std::visit([](auto& col) { return col->getStats(); }, column));
+    }
+    return stats;
+}
+
+// Value of a comparison converted to the element type of the compared column
+template <class T> static T _predicateValue(const std::string& value);
+template <> int _predicateValue<int>(const std::string& value) { return std::stoi(value); }
+template <> float _predicateValue<float>(const std::string& value) { return std::stof(value); }
+template <> char _predicateValue<char>(const std::string& value) { return value[0]; }
+template <> std::string _predicateValue<std::string>(const std::string& value) { return value; }
+
+bool Table::filterRows(const Predicate& where, Bitmap& rows)
+{
+    // Map the column files if the table is cold
+    if (!this->load()) return false;
+
+    this->evaluatePredicate(where, nullptr, rows);
+
+    // Deleted rows stay in the columns until the table is compacted
+    if (this->deleted_rows) rows -= this->deleted;
+    return true;
+}
+
+void Table::liveRows(Bitmap& rows)
+{
+    rows = Bitmap(this->getRowCount(), true);
+    if (this->deleted_rows) rows -= this->deleted;
+}
+
+bool Table::resolvePredicate(Predicate& predicate)
+{
+    // Every column and value is checked before any column is filtered
+    if (predicate.type != PREDICATE_COMPARE)
+    {
+        for (auto& child : predicate.children) {
+            if (!this->resolvePredicate(*child)) return false;
+        }
+        return true;
+    }
+
+    auto it = this->column_index.find(predicate.column);
+    if (it == this->column_index.end()) {
+        std::cout << "-- !Failed to query table " << this->table_name << " because column " << predicate.column << " does not exist.\n";
+        return false;
+    }
+
+    predicate.ordinal = it->second;
+    predicate.filter_op = filterOperator(predicate.op);
+
+    // The value of a placeholder is bound later
+    if (predicate.parameter >= 0) return true;
+
+    return this->bindComparison(predicate, predicate.value);
+}
+
+bool Table::bindComparison(Predicate& comparison, const std::string& value, const bool report)
+{
+    try {
+        comparison.operand = std::visit([&](auto& column) -> Value {
+            return _predicateValue<typename std::decay_t<decltype(*column)>::value_type>(value);
+        }, this->columns[comparison.ordinal]);
+    }
+    catch(const std::exception& e) {
+        if (report) std::cout << "-- !Invalid value " << value << " for column " << comparison.column << " of table " << this->table_name << "\n";
+        return false;
+    }
+
+    comparison.value = value;
+    return true;
+}
+
+void Table::estimatePredicate(const Predicate& predicate, double& selectivity, double& cost)
+{
+    switch (predicate.type)
+    {
+        case PREDICATE_COMPARE:
+            std::visit([&](auto& column) {
+                typedef typename std::decay_t<decltype(*column)>::value_type T;
+                column->estimateFilter(predicate.filter_op, std::get<T>(predicate.operand), selectivity, cost);
+            }, this->columns[predicate.ordinal]);
+            break;
+
+        case PREDICATE_NOT:
+            this->estimatePredicate(*predicate.children[0], selectivity, cost);
+            selectivity = 1 - selectivity;
+            break;
+
+        default:
+        {
+            // Children are taken as independent, every child may have to be evaluated
+            double keep = 1.0;
+            cost = 0;
+            for (auto& child : predicate.children)
+            {
+                double child_selectivity, child_cost;
+                this->estimatePredicate(*child, child_selectivity, child_cost);
+                keep *= predicate.type == PREDICATE_AND ? child_selectivity : 1 - child_selectivity;
+                cost += child_cost;
+            }
+            selectivity = predicate.type == PREDICATE_AND ? keep : 1 - keep;
+            break;
+        }
+    }
+}
+
+void Table::evaluatePredicate(const Predicate& predicate, const Bitmap* candidates, Bitmap& res)
+{
+    if (predicate.type == PREDICATE_COMPARE)
+    {
+        std::visit([&](auto& column) {
+            typedef typename std::decay_t<decltype(*column)>::value_type T;
+            res = column->filterElements(predicate.filter_op, std::get<T>(predicate.operand), candidates);
+        }, this->columns[predicate.ordinal]);
+        return;
+    }
+
+    if (predicate.type == PREDICATE_NOT)
+    {
+        this->evaluatePredicate(*predicate.children[0], candidates, res);
+        res.flip();
+        return;
+    }
+
+    // Order the children so the cheapest child removing the most rows runs first: a child
+    // of an AND ranks by cost / (1 - selectivity), a child of an OR by cost / selectivity
+    const bool conjunction = predicate.type == PREDICATE_AND;
+    std::vector<std::pair<double, const Predicate*>> order;
+    for (auto& child : predicate.children)
+    {
+        double selectivity, cost;
+        this->estimatePredicate(*child, selectivity, cost);
+        const double removed = conjunction ? 1 - selectivity : selectivity;
+        order.emplace_back(cost / std::max(removed, 1e-9), child.get());
+    }
+    std::stable_sort(order.begin(), order.end(), [](auto& a, auto& b) { return a.first < b.first; });
+
+    // The rows still undecided are the candidates of the next child: the rows every child of
+    // an AND kept so far, the rows no child of an OR matched yet
+    this->evaluatePredicate(*order[0].second, candidates, res);
+    for (size_t i = 1; i < order.size(); ++i)
+    {
+        Bitmap undecided = res;
+        if (!conjunction) undecided.flip();
+        if (candidates) undecided &= *candidates;
+        if (undecided.none()) break;
+
+        Bitmap child;
+        this->evaluatePredicate(*order[i].second, &undecided, child);
+        if (conjunction) res &= child;
+        else res |= child;
+    }
+}
@@ -10,17 +10,54 @@
 
 #include "include.h"
 #include "column.h"
+#include "storage.h"
+#include "index.h"
+#include "zonemap.h"
+#include "predicate.h"
+#include "wal.h"
+
+// A table is compacted once this many of its rows are deleted and they are this fraction of its rows
+const size_t COMPACTION_MIN_ROWS = 1024;
+const double COMPACTION_RATIO = 0.25;
+
+// Values of a batch of rows converted to the element type of one column
+typedef std::variant<std::vector<int>, std::vector<float>, std::vector<char>, std::vector<std::string>> ColumnValues;
+
+// Read-only elements of one column, in the order of StorageType (see storage.h)
+typedef std::variant<ColumnView<int>, ColumnView<float>, ColumnView<char>, ColumnView<std::string>> ColumnElements;
+
+// Residency of the rows of a table
+enum TableState
+{
+    TABLE_COLD = 0,     // Only the table file header has been read
+    TABLE_MAPPED,       // Fixed width columns are read-only mappings of the column files
+    TABLE_HOT           // Every column is held in memory (the table has been modified)
+};
 
 class Table
 {
 private:
     std::string table_name;                                            // Table name
     std::vector<std::pair<std::string, std::string>> column_meta_data; // Vector of pairs of column_name and column types
+    std::unordered_map<std::string, size_t, _NameHash, _NameEqual> column_index; // Ordinal of every column by case-insensitive name
     unsigned int column_count;                                         // Number of columns
     unsigned int row_count;                                            // number of rows
-    fs::path path;                                                     // The path to the table file
+    fs::path path;                                                     // The path to the table file (<table>.tbl)
     fs::path path_metadata;
     std::string locked;                                                // Determines if changes can be made to the table
+    TableState state;                                                  // Whether the rows are on disk, mapped or in memory
+    std::shared_ptr<WriteAheadLog> wal;                                // Log of the database the table belongs to
+    uint64_t checkpoint_lsn;                                           // Last log record contained in the table files
+    uint64_t checkpoint_log;                                           // Id of the log holding that record
+    size_t persisted_rows;                                             // Rows in the table files
+    uint64_t generation;                                               // Generation of the table files the rows were read from (see storage.h)
+    std::vector<WalRecord> logged;                                     // Statements logged since the last checkpoint
+    bool dirty;                                                        // Rows changed since the last checkpoint
+    bool rewrite;                                                      // Rows were updated or deleted, not just appended
+    std::vector<IndexDescriptor> indexes;                              // Secondary indexes (CREATE INDEX), listed in the table file
+    bool adaptive;                                                     // INT and FLOAT columns are cracked by range filters
+    Bitmap deleted;                                                    // Tombstones of the deleted rows, they stay in the columns until compaction
+    size_t deleted_rows;                                               // Number of rows set in 'deleted'
 
     // Storage container for each column
     std::vector<std::variant<std::shared_ptr<Column<int>>, std::shared_ptr<Column<float>>, std::shared_ptr<Column<char>>, std::shared_ptr<Column<std::string>>>> columns;
@@ -59,18 +96,60 @@ public:
     // ---- Table Update Functions
     // ---------------------------
 
-    /** Handels the UPDATE {{ table_name }} SET Command */
-    bool updateColumnSet(const std::string&, const std::string&, const std::string&, const std::string&, const std::string&, const bool);
+    /** Handels the UPDATE {{ table_name }} SET {{ column }} = {{ value }} WHERE Command */
+    bool updateColumnSet(const std::string& column_to_update, const std::string& value_to_update, Predicate& where, const bool mode);
+
+    /** Sets column 'ordinal' to 'value' (converted from 'text' by columnValue) in the rows satisfying a resolved predicate */
+    bool updateWhere(const size_t ordinal, const Value& value, const std::string& text, const Predicate& where);
 
-    /** Handles the DELETE FROM {{ table_anme }} */
-    bool deleteFromTable(const std::string&, const std::string&, const std::string&);
+    /** Handles the DELETE FROM {{ table_anme }} WHERE Command */
+    bool deleteFromTable(Predicate& where);
+
+    /** Deletes the rows satisfying a resolved predicate */
+    bool deleteWhere(const Predicate& where);
 
     /** Handles the INSERT INTO {{ table_name }} VALUES(x, y, z, ...) Command */
     bool insertRow(const std::vector<std::string>&, bool);
 
+    /** Appends rows of values converted by columnValue, one row after the other, 'row' is their text (logged when 'write' is set) */
+    bool insertValues(const std::vector<Value>& values, const std::vector<std::string>& row, const bool write);
+
+    /** Handles INSERT INTO {{ table_name }} VALUES(...), (...), ... : 'values' holds 'rows' rows one after the other.
+     *  The values are converted a column at a time and every column is appended once, the batch is logged as one record. */
+    bool insertRows(const std::vector<std::string>& values, const size_t rows, const bool write);
+
+    /** Appends 'rows' rows converted a column at a time (one buffer of columnBuffers per column), every column
+     *  once. The buffers are moved from, the rows are stored at the next checkpoint when 'write' is set. */
+    bool appendColumns(std::vector<ColumnValues>& batch, const size_t rows, const bool write);
+
+    /** Empty buffers of the element types of the columns, filled by bulk loads and passed to appendColumns */
+    std::vector<ColumnValues> columnBuffers();
+
+    /** Converts the text of a value to the element type of column 'ordinal' as it is stored: FLOAT values are
+     *  rounded to the decimals written, VARCHAR values cut to the column size. Throws if the text is invalid. */
+    Value columnValue(const size_t ordinal, const std::string& text);
+
     /**  Deletes a row from the table based on index*/
     bool deleteRow(const size_t);
 
+    /**  Deletes every row set in the bitmap with one pass over each column, returns the number deleted */
+    size_t deleteRows(const Bitmap& rows);
+
+    /**  Deletes every row from the table (in memory only) */
+    void clearRows();
+
+    /**  Removes the deleted rows from every column with one pass over each column, returns the number removed */
+    size_t compact();
+
+    /**  True once enough rows are deleted that compaction pays for itself (COMPACTION_MIN_ROWS and COMPACTION_RATIO) */
+    bool needsCompaction() { return this->deleted_rows >= COMPACTION_MIN_ROWS && this->deleted_rows >= COMPACTION_RATIO * this->getRowCount(); }
+
+    /**  Checks if a row was deleted and not compacted yet */
+    bool isDeleted(const size_t row) { return this->deleted_rows && row < this->deleted.size() && this->deleted.test(row); }
+
+    /**  Sets every row that is not deleted in 'rows' */
+    void liveRows(Bitmap& rows);
+
     bool writeMetadata();
 
     // ---------------------------
@@ -78,12 +157,28 @@ public:
     // ---------------------------
 
     /** Handles the SELECT {{ col1, col2, ... }} FROM {{ table_name }} WHERE command */
-    bool selectColumns(
-        const std::vector<std::string>& columns,
-        const std::string& column_to_query,
-        const std::string& value_to_query, 
-        const std::string& opr
-    );
+    bool selectColumns(const std::vector<std::string>& columns, Predicate& where);
+
+    /** Prints the columns 'ordinals' of the rows satisfying a resolved predicate */
+    bool selectWhere(const std::vector<size_t>& ordinals, const Predicate& where);
+
+    /** Sets the rows satisfying a resolved predicate in 'rows', deleted rows never do */
+    bool filterRows(const Predicate& where, Bitmap& rows);
+
+    /** Read-only views of the elements of every column (mapped columns are not copied), in column order.
+     *  The table must be loaded, the views are invalidated by any change of the table. */
+    std::vector<ColumnElements> columnViews();
+
+    /** Resolves the comparisons of a predicate: the ordinal of the compared column, the filter operator and the
+     *  value converted to the column type (placeholders are left to bindComparison). False if it names an unknown
+     *  column or holds an invalid value. */
+    bool resolvePredicate(Predicate& predicate);
+
+    /** Sets the value of a resolved comparison, false (printed if 'report' is set) if it does not convert to the type of the column */
+    bool bindComparison(Predicate& comparison, const std::string& value, const bool report = true);
+
+    /** Ordinals of the named columns, false if a column does not exist */
+    bool resolveColumns(const std::vector<std::string>& columns, std::vector<size_t>& ordinals);
 
     std::shared_ptr<Column<int>>         selectColumnInt   (const std::string& column_name);
     std::shared_ptr<Column<float>>       selectColumnFloat (const std::string& column_name);
@@ -105,7 +200,74 @@ public:
 
     bool printRow(const size_t row);
 
-    bool writeCSV();
+    /** Writes the table file and every column file (see storage.h) */
+    bool writeBinary();
+
+    /** Appends rows [from, row count) to column files holding 'rows' committed rows and commits the new row count */
+    bool appendBinary(const size_t from, const size_t rows);
+
+    /** Replaces the rows in memory with the column files. INT, FLOAT and CHAR columns
+     *  are mapped read-only and copied into memory only when they are modified. */
+    bool readBinary();
+
+    /** Writes the changes since the last checkpoint to the table files, which then contain
+     *  log 'log_id' up to 'lsn'. Appended rows are appended, anything else rewrites the files.
+     *  Called with the database lock held. If another process committed the files since the rows
+     *  were read, appended rows go after its rows and other statements are applied again on them. */
+    bool checkpoint(const uint64_t log_id, const uint64_t lsn, const bool sync);
+
+    /** Opens the table files again if another process committed them since they were read (the
+     *  generation in the table header changed). A table with statements that are not checkpointed
+     *  yet is kept, they are applied again on the committed rows at the checkpoint. */
+    bool refresh();
+
+    /** Applies a logged statement (the table name is its first field) without logging it again */
+    bool replayRecord(const WalRecord& record);
+
+    /** Forces the table and column files to disk */
+    bool syncFiles();
+
+    /** Logs a statement on this table (the table name is added as the first field) */
+    bool logStatement(const WalRecordType type, const std::vector<std::string>& fields);
+
+    /** Opens a table stored on disk without reading its rows (the table starts cold) */
+    bool open();
+
+    /** Maps the column files of a cold table, called before the rows are first accessed */
+    bool load();
+
+    /** Path of the file 'extension' (col or dat) of column 'index' */
+    fs::path columnPath(const size_t index, const std::string& extension);
+
+    // ---------------------------
+    // ---- Index Functions
+    // ---------------------------
+
+    /** Builds index 'index_name' of 'type' over a column and writes it with the table file */
+    bool createIndex(const std::string& index_name, const std::string& column_name, const IndexType type);
+
+    /** Drops an index and deletes its file */
+    bool dropIndex(const std::string& index_name);
+
+    /** Checks if the table has an index of that name */
+    bool hasIndex(const std::string& index_name);
+
+    /** Path of the file of an index */
+    fs::path indexPath(const std::string& index_name);
+
+    /** Writes every index file, they cover the table files at the current checkpoint */
+    bool writeIndexes();
+
+    /** Writes the zone map file (<table>.<i>.zmp) of every INT, FLOAT and CHAR column */
+    bool writeZoneMaps();
+
+    const std::vector<IndexDescriptor>& getIndexes() { return this->indexes; }
+
+    /** Turns adaptive indexing (database cracking, see cracker.h) of the INT and FLOAT columns on or off */
+    void setAdaptiveIndexing(const bool adaptive);
+
+    /** Statistics of every column, in column order */
+    std::vector<ColumnStats> columnStats();
 
     // Getters
     std::string getTable() { return this->table_name; }
@@ -115,9 +277,19 @@ public:
     const fs::path getPathMetadata() { return this->path_metadata; }
     std::vector<std::pair<std::string, std::string>> getMetaData() { return this->column_meta_data; }
     std::string getLocked() { return this->locked; }
+    TableState getState() { return this->state; }
+    uint64_t getCheckpointLsn() { return this->checkpoint_lsn; }
+    uint64_t getCheckpointLog() { return this->checkpoint_log; }
+    uint64_t getGeneration() { return this->generation; }
+    bool isDirty() { return this->dirty; }
+    bool isReplaying() { return this->wal && this->wal->isReplaying(); }
     unsigned int getRowCount() { 
-        return (unsigned int)((std::get<0>(this->columns[0]))->getElements().size()); 
+        if (this->state == TABLE_COLD) return this->row_count;
+        if (this->columns.empty()) return 0;
+        return (unsigned int)std::visit([](auto& column) { return column->size(); }, this->columns[0]);
     }
+    unsigned int liveRowCount() { return this->getRowCount() - (unsigned int)this->deleted_rows; }
+    size_t deletedRowCount() { return this->deleted_rows; }
     
     // Setters
     void setTableName(const std::string& name) { this->table_name = name; }
@@ -126,9 +298,31 @@ public:
     void incrementRowCount() { this->row_count++; }
     void decrementRowCount() { this->row_count--; }
     void setLocked(std::string val) { this->locked = val; }
+    void setWal(std::shared_ptr<WriteAheadLog> wal) { this->wal = wal; }
+    void setCheckpoint(const uint64_t log_id, const uint64_t lsn) { this->checkpoint_log = log_id; this->checkpoint_lsn = lsn; }
 
     // Set private variables in memory to table metadata
     void applyMetadata(const TableMetadata& md );
+
+private:
+    /** Reads the rows committed by another process and applies the statements logged since the last
+     *  checkpoint on them, the table files are then rewritten */
+    bool reapplyStatements();
+
+    /** Descriptions of the columns as stored in the table file */
+    std::vector<ColumnDescriptor> columnDescriptors();
+
+    /** Estimates the fraction of rows satisfying a predicate and the cost of evaluating it from
+     *  the statistics of its columns (see Column::estimateFilter) */
+    void estimatePredicate(const Predicate& predicate, double& selectivity, double& cost);
+
+    /** Evaluates a resolved predicate as bitmap operations. Only the rows set in 'candidates'
+     *  (every row if nullptr) are decided, the bits of the other rows are undefined. */
+    void evaluatePredicate(const Predicate& predicate, const Bitmap* candidates, Bitmap& res);
+
+    /** Creates an index on its column, read from the index file when 'reuse' is set and the
+     *  file covers 'rows' rows at 'checkpoint_lsn', otherwise built from the column */
+    bool attachIndex(const IndexDescriptor& descriptor, const bool reuse, const uint64_t rows, const uint64_t checkpoint_lsn);
 };
 
 #endif //TABLE_H_
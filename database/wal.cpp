@@ -0,0 +1,454 @@
+/**
+ * File: wal.cpp
+ * Author: Mark Minkoff
+ * Functionality: Function definitions for file wal.h
+ *
+ * */
+
+#include "wal.h"
+
+#include <cerrno>
+#include <chrono>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+static const char WAL_MAGIC[8] = {'S', 'Q', 'L', 'W', 'A', 'L', 'O', 'G'};
+static const uint32_t WAL_VERSION = 1;
+
+// length + crc in front of every record
+static const size_t WAL_RECORD_PREFIX = 2 * sizeof(uint32_t);
+
+// Default log size that triggers a checkpoint
+static const uint64_t WAL_CHECKPOINT_SIZE = 8 * 1024 * 1024;
+
+// Default group commit window in microseconds (0 batches only the records queued during a sync)
+static const uint64_t WAL_COMMIT_WINDOW = 0;
+
+// CRC-32C (Castagnoli) over a byte range
+static uint32_t _crc32c(const char* data, const size_t n)
+{
+    static const std::vector<uint32_t> table = []
+    {
+        std::vector<uint32_t> res(256);
+        for (uint32_t i = 0; i < 256; ++i)
+        {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) crc = (crc >> 1) ^ (0x82F63B78 & (0 - (crc & 1)));
+            res[i] = crc;
+        }
+        return res;
+    }();
+
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < n; ++i) crc = table[(crc ^ (uint8_t)data[i]) & 0xFF] ^ (crc >> 8);
+    return crc ^ 0xFFFFFFFF;
+}
+
+template <typename T>
+static void _put(std::string& buffer, const T& val)
+{
+    buffer.append(reinterpret_cast<const char*>(&val), sizeof(val));
+}
+
+// Reads a T at 'offset' if it fits before 'end'
+template <typename T>
+static bool _get(const std::string& buffer, size_t& offset, const size_t end, T& val)
+{
+    if (offset + sizeof(val) > end) return false;
+    std::memcpy(&val, buffer.data() + offset, sizeof(val));
+    offset += sizeof(val);
+    return true;
+}
+
+// Writes all of 'data', retrying short writes
+static bool _writeAll(const int fd, const char* data, size_t n)
+{
+    while (n)
+    {
+        const ssize_t written = ::write(fd, data, n);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        data += written;
+        n -= (size_t)written;
+    }
+    return true;
+}
+
+WriteAheadLog::WriteAheadLog(const fs::path& path, const uint64_t log_id) :
+    path(path), log_id(log_id), fd(-1), next_lsn(1), bytes(0), replaying(false),
+    sync_policy(WAL_SYNC_NORMAL), checkpoint_size(WAL_CHECKPOINT_SIZE),
+    stopping(false), flush_failed(false), pending_lsn(0), durable_lsn(0), commit_window(WAL_COMMIT_WINDOW)
+{}
+
+WriteAheadLog::~WriteAheadLog()
+{
+    // Let the flusher write what is still queued
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->queued.notify_all();
+    if (this->flusher.joinable()) this->flusher.join();
+
+    if (this->fd < 0) return;
+
+    // A log emptied by the last checkpoint is deleted, closing the descriptor releases the lock
+    if (this->bytes == sizeof(WalFileHeader) && !this->flush_failed) ::unlink(this->path.c_str());
+    ::close(this->fd);
+}
+
+std::shared_ptr<WriteAheadLog> WriteAheadLog::create(const fs::path& directory)
+{
+    std::random_device device;
+    std::mt19937_64 gen(((uint64_t)device() << 32) ^ device() ^ (uint64_t)::getpid());
+
+    uint64_t log_id = 0;
+    while (!log_id) log_id = gen();
+
+    char name[32];
+    snprintf(name, sizeof(name), "wal.%016llx.log", (unsigned long long)log_id);
+    return std::make_shared<WriteAheadLog>(directory / name, log_id);
+}
+
+std::shared_ptr<WriteAheadLog> WriteAheadLog::claim(const fs::path& path)
+{
+    const int fd = ::open(path.c_str(), O_WRONLY | O_APPEND);
+    if (fd < 0) return nullptr;
+
+    // The process writing the log holds the lock until it exits
+    if (::flock(fd, LOCK_EX | LOCK_NB) != 0) { ::close(fd); return nullptr; }
+
+    std::shared_ptr<WriteAheadLog> log = std::make_shared<WriteAheadLog>(path, 0);
+    log->fd = fd;
+    return log;
+}
+
+std::vector<fs::path> WriteAheadLog::logPaths(const fs::path& directory)
+{
+    // wal.<log id>.log, logs being created are named wal.<log id>.log.tmp
+    std::vector<fs::path> paths;
+    std::error_code ec;
+    for (const auto& entry : fs::directory_iterator(directory, ec))
+    {
+        const std::string name = entry.path().filename().string();
+        if (name.size() > 8 && name.compare(0, 4, "wal.") == 0 && name.compare(name.size() - 4, 4, ".log") == 0) paths.push_back(entry.path());
+    }
+    std::sort(paths.begin(), paths.end());
+    return paths;
+}
+
+bool WriteAheadLog::writeHeader(const uint64_t start_lsn)
+{
+    WalFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, WAL_MAGIC, sizeof(header.magic));
+    header.version = WAL_VERSION;
+    header.start_lsn = start_lsn;
+    header.log_id = this->log_id;
+
+    // The descriptor appends, so the header goes to the start of the emptied file
+    bool success = ::ftruncate(this->fd, 0) == 0 && _writeAll(this->fd, reinterpret_cast<const char*>(&header), sizeof(header));
+    if (success && this->sync_policy != WAL_SYNC_OFF) success = ::fsync(this->fd) == 0;
+
+    if (!success) { std::cout << "-- !Failed to write write ahead log " << this->path.string() << "\n"; return false; }
+
+    this->bytes = sizeof(header);
+    return true;
+}
+
+bool WriteAheadLog::open()
+{
+    if (this->fd >= 0) return true;
+
+    // Other processes only look at logs with their final name, and that one is already locked
+    fs::path tmp = this->path; tmp += ".tmp";
+    this->fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (this->fd < 0) { std::cout << "-- !Failed to open write ahead log " << this->path.string() << "\n"; return false; }
+
+    if (::flock(this->fd, LOCK_EX) != 0 || !this->writeHeader(this->next_lsn) || ::rename(tmp.c_str(), this->path.c_str()) != 0)
+    {
+        std::cout << "-- !Failed to create write ahead log " << this->path.string() << "\n";
+        ::close(this->fd);
+        ::unlink(tmp.c_str());
+        this->fd = -1;
+        return false;
+    }
+    return true;
+}
+
+uint64_t WriteAheadLog::append(const WalRecordType type, const std::vector<std::string>& fields)
+{
+    if (this->replaying) return 0;
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    // Direct writes go after anything still queued so the log stays in LSN order
+    const bool queue = this->sync_policy == WAL_SYNC_FULL;
+    if (!queue) this->drain(lock);
+
+    if (this->flush_failed || !this->open()) return 0;
+
+    const uint64_t lsn = this->next_lsn;
+
+    // Build the whole record so it reaches the file with a single write
+    std::string& buffer = queue ? this->pending : this->buffer;
+    if (!queue) buffer.clear();
+    const size_t start = buffer.size();
+
+    buffer.append(WAL_RECORD_PREFIX, '\0');
+    _put(buffer, lsn);
+    _put(buffer, (uint32_t)type);
+    _put(buffer, (uint32_t)fields.size());
+    for (auto& field : fields)
+    {
+        _put(buffer, (uint32_t)field.size());
+        buffer.append(field);
+    }
+
+    const uint32_t length = (uint32_t)(buffer.size() - start - WAL_RECORD_PREFIX);
+    const uint32_t crc = _crc32c(buffer.data() + start + WAL_RECORD_PREFIX, length);
+    std::memcpy(&buffer[start], &length, sizeof(length));
+    std::memcpy(&buffer[start + sizeof(length)], &crc, sizeof(crc));
+
+    if (queue) {
+        // Hand the record to the flusher, commit() waits for it
+        this->pending_lsn = lsn;
+        if (!this->flusher.joinable()) this->flusher = std::thread(&WriteAheadLog::flushLoop, this);
+        this->queued.notify_one();
+    }
+    else if (!_writeAll(this->fd, buffer.data(), buffer.size())) {
+        std::cout << "-- !Failed to write to write ahead log " << this->path.string() << "\n";
+        return 0;
+    }
+
+    this->bytes += buffer.size() - start;
+    this->next_lsn++;
+
+    return lsn;
+}
+
+bool WriteAheadLog::commit(const uint64_t lsn)
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+
+    // Records above pending_lsn were written directly and never queued
+    this->flushed.wait(lock, [&] { return lsn > this->pending_lsn || this->durable_lsn >= lsn || this->flush_failed; });
+
+    if (lsn > this->pending_lsn || this->durable_lsn >= lsn) return true;
+
+    std::cout << "-- !Write ahead log record " << lsn << " was not made durable\n";
+    return false;
+}
+
+void WriteAheadLog::flushLoop()
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while (true)
+    {
+        this->queued.wait(lock, [this] { return !this->pending.empty() || this->stopping; });
+        if (this->pending.empty()) return;
+
+        // Give other writers the commit window to join this batch
+        if (this->commit_window && !this->stopping)
+            this->queued.wait_for(lock, std::chrono::microseconds(this->commit_window), [this] { return this->stopping; });
+
+        this->flushing.swap(this->pending);
+        const uint64_t batch_lsn = this->pending_lsn;
+
+        // Write and sync without the lock so writers can queue the next batch meanwhile.
+        // After a failure the rest of the log is unreachable, so nothing more is written.
+        bool success = false;
+        if (!this->flush_failed) {
+            lock.unlock();
+            success = _writeAll(this->fd, this->flushing.data(), this->flushing.size()) && ::fdatasync(this->fd) == 0;
+            lock.lock();
+        }
+
+        if (success) this->durable_lsn = batch_lsn;
+        else if (!this->flush_failed) {
+            std::cout << "-- !Failed to write to write ahead log " << this->path.string() << "\n";
+            this->flush_failed = true;
+        }
+
+        this->flushing.clear();
+        this->flushed.notify_all();
+    }
+}
+
+bool WriteAheadLog::drain(std::unique_lock<std::mutex>& lock)
+{
+    this->flushed.wait(lock, [this] { return this->pending.empty() && this->flushing.empty(); });
+    return !this->flush_failed;
+}
+
+bool WriteAheadLog::readRecords(std::vector<WalRecord>& records)
+{
+    records.clear();
+    this->bytes = 0;
+
+    if (!fs::exists(this->path)) return true;
+
+    // Read the whole log
+    std::ifstream file(this->path, std::ifstream::in | std::ifstream::binary);
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+
+    WalFileHeader header;
+    if (data.size() < sizeof(header)) return true;
+
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (std::memcmp(header.magic, WAL_MAGIC, sizeof(header.magic)) != 0 || header.version != WAL_VERSION) {
+        std::cout << "-- !Ignoring unreadable write ahead log " << this->path.string() << "\n";
+        return true;
+    }
+    this->next_lsn = std::max(this->next_lsn, header.start_lsn);
+    this->log_id = header.log_id;
+
+    // Read records up to the first one that is torn, corrupt or out of order
+    size_t offset = sizeof(header);
+    while (offset + WAL_RECORD_PREFIX <= data.size())
+    {
+        uint32_t length = 0, crc = 0;
+        size_t pos = offset;
+        _get(data, pos, data.size(), length);
+        _get(data, pos, data.size(), crc);
+
+        const size_t end = pos + length;
+        if (end > data.size() || _crc32c(data.data() + pos, length) != crc) break;
+
+        WalRecord record;
+        uint32_t field_count = 0;
+        if (!_get(data, pos, end, record.lsn) || !_get(data, pos, end, record.type) || !_get(data, pos, end, field_count)) break;
+        if (record.lsn < this->next_lsn) break;
+
+        bool valid = true;
+        for (uint32_t i = 0; i < field_count && valid; ++i)
+        {
+            uint32_t size = 0;
+            valid = _get(data, pos, end, size) && pos + size <= end;
+            if (valid) {
+                record.fields.emplace_back(data, pos, size);
+                pos += size;
+            }
+        }
+        if (!valid) break;
+
+        this->next_lsn = record.lsn + 1;
+        records.emplace_back(std::move(record));
+        offset = end;
+    }
+
+    // Cut off the torn tail so new records follow the last valid one
+    if (offset < data.size())
+    {
+        std::cout << "-- Discarding " << (data.size() - offset) << " bytes of torn write ahead log in " << this->path.string() << "\n";
+        std::error_code ec;
+        fs::resize_file(this->path, offset, ec);
+        if (ec) { std::cout << "-- !Failed to truncate write ahead log: " << ec.message() << "\n"; return false; }
+    }
+
+    this->bytes = offset;
+    return true;
+}
+
+bool WriteAheadLog::sync()
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    if (!this->drain(lock)) return false;
+
+    if (this->fd < 0 || this->sync_policy == WAL_SYNC_OFF) return true;
+    return ::fdatasync(this->fd) == 0;
+}
+
+bool WriteAheadLog::reset()
+{
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->drain(lock);
+
+    // Nothing to empty if the log was never written
+    if (this->fd < 0) return true;
+
+    if (!this->writeHeader(this->next_lsn)) return false;
+
+    // The checkpoint covers every record, including the ones a failed batch lost
+    this->flush_failed = false;
+    return true;
+}
+
+bool WriteAheadLog::remove()
+{
+    std::error_code ec;
+    fs::remove(this->path, ec);
+    if (ec) { std::cout << "-- !Failed to delete write ahead log " << this->path.string() << ": " << ec.message() << "\n"; return false; }
+
+    // The descriptor of the deleted file is not written anymore
+    this->bytes = 0;
+    return true;
+}
+
+uint64_t WriteAheadLog::lastLsn() const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->next_lsn - 1;
+}
+
+uint64_t WriteAheadLog::size() const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->bytes;
+}
+
+WalSyncPolicy WriteAheadLog::getSyncPolicy() const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->sync_policy;
+}
+
+uint64_t WriteAheadLog::getCheckpointSize() const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->checkpoint_size;
+}
+
+uint64_t WriteAheadLog::getCommitWindow() const
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    return this->commit_window;
+}
+
+void WriteAheadLog::setSyncPolicy(const WalSyncPolicy policy)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->sync_policy = policy;
+}
+
+void WriteAheadLog::setCheckpointSize(const uint64_t size)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->checkpoint_size = size;
+}
+
+void WriteAheadLog::setCommitWindow(const uint64_t microseconds)
+{
+    std::lock_guard<std::mutex> lock(this->mutex);
+    this->commit_window = microseconds;
+}
+
+bool walSyncPolicy(const std::string& name, WalSyncPolicy& policy)
+{
+    const std::string upper = _toUpper(name);
+    if (upper == "OFF")         policy = WAL_SYNC_OFF;
+    else if (upper == "NORMAL") policy = WAL_SYNC_NORMAL;
+    else if (upper == "FULL")   policy = WAL_SYNC_FULL;
+    else return false;
+    return true;
+}
+
+const char* walSyncPolicyName(const WalSyncPolicy policy)
+{
+    static const char* names[] = { "OFF", "NORMAL", "FULL" };
+    return names[policy];
+}
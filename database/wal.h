@@ -0,0 +1,167 @@
+/**
+ * File: wal.h
+ * Author: Mark Minkoff
+ * Functionality: Function declarations for file wal.cpp
+ * Append-only write ahead log of the INSERT, UPDATE and DELETE statements a process runs on a
+ * database (<db>/wal.<log id>.log, one log per process). Every statement is logged as one
+ * logical record with a single write and applied in memory; the table files are only written
+ * at checkpoints, which store the log id and LSN they cover in the table header and empty the
+ * log.
+ *
+ * A process holds an flock on its log until it exits, a log that can be locked (claim) was
+ * left behind by a process that exited without a checkpoint. The next checkpoint of the
+ * database replays its records newer than a table's checkpoint and deletes it.
+ *
+ *   file    WalFileHeader (64 bytes) followed by records
+ *   record  uint32 length | uint32 crc32c | uint64 lsn | uint32 type | uint32 field count | fields
+ *           (length and crc cover everything after the crc, a field is uint32 size + bytes)
+ *
+ * A torn or corrupt record ends the log, it and everything after it is cut off on open.
+ *
+ * Under WAL_SYNC FULL records are group committed: append() only queues the record and
+ * commit() waits until a flusher thread has written and synced it. The flusher waits up to
+ * the commit window for more records after the first one arrives, then writes everything
+ * queued with one write and one fdatasync, so concurrent writers share the sync.
+ *
+ * */
+
+#ifndef WAL_H_
+#define WAL_H_
+
+#include "include.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+enum WalRecordType
+{
+    WAL_INSERT = 1,     // table, value 1, value 2, ...
+    WAL_UPDATE,         // table, column to update, value to update, WHERE clause (see predicateText)
+    WAL_DELETE,         // table, WHERE clause (see predicateText)
+    WAL_INSERT_ROWS     // table, row count, values of every row one after the other
+};
+
+// When the log is forced to disk with fsync
+enum WalSyncPolicy
+{
+    WAL_SYNC_OFF = 0,   // Never, records reach the disk when the OS writes them back
+    WAL_SYNC_NORMAL,    // At COMMIT and at checkpoints
+    WAL_SYNC_FULL       // Before every statement returns (group committed)
+};
+
+typedef struct WalFileHeader {
+    char magic[8];              // "SQLWALOG"
+    uint32_t version;
+    uint32_t reserved0;
+    uint64_t start_lsn;         // LSN of the first record in the file
+    uint64_t log_id;            // Random id of the log, in the table headers of its checkpoints
+    uint64_t reserved[4];
+} WalFileHeader;
+
+static_assert(sizeof(WalFileHeader) == 64, "WalFileHeader must be 64 bytes");
+
+typedef struct WalRecord {
+    uint64_t lsn;
+    uint32_t type;
+    std::vector<std::string> fields;
+} WalRecord;
+
+class WriteAheadLog
+{
+private:
+    fs::path path;                  // <db>/wal.<log id>.log
+    uint64_t log_id;
+    int fd;                         // Locked append descriptor, the log is created on first use
+    uint64_t next_lsn;              // LSN given to the next record
+    uint64_t bytes;                 // Size of the log file, queued records included
+    bool replaying;                 // Records are being replayed, nothing is logged
+    WalSyncPolicy sync_policy;
+    uint64_t checkpoint_size;       // Log size that triggers a checkpoint
+    std::string buffer;             // Reused record buffer
+
+    // Group commit
+    mutable std::mutex mutex;           // Guards everything above and below
+    std::condition_variable queued;     // Wakes the flusher
+    std::condition_variable flushed;    // Wakes writers waiting in commit()
+    std::thread flusher;                // Started on the first queued record
+    bool stopping;                      // The flusher drains the queue and exits
+    bool flush_failed;                  // A batch could not be written, commits fail
+    std::string pending;                // Records queued for the flusher
+    std::string flushing;               // Batch being written (swapped with pending)
+    uint64_t pending_lsn;               // Last queued LSN
+    uint64_t durable_lsn;               // Last LSN written and synced by the flusher
+    uint64_t commit_window;             // Microseconds the flusher waits for a batch to grow
+
+    /** Creates the log file, locked before it is visible to other processes */
+    bool open();
+
+    /** Empties the log file down to a fresh header, the log starts at 'start_lsn' */
+    bool writeHeader(const uint64_t start_lsn);
+
+    /** Flusher thread: writes and syncs queued records in batches */
+    void flushLoop();
+
+    /** Waits (with the lock held by 'lock') until nothing is queued or being written,
+     *  returns false if a batch failed */
+    bool drain(std::unique_lock<std::mutex>& lock);
+
+public:
+    WriteAheadLog(const fs::path& path, const uint64_t log_id);
+    ~WriteAheadLog();
+
+    /** New log of this process in a database directory (the file is created by the first record) */
+    static std::shared_ptr<WriteAheadLog> create(const fs::path& directory);
+
+    /** Locks the log of another process, nullptr if that process still runs */
+    static std::shared_ptr<WriteAheadLog> claim(const fs::path& path);
+
+    /** Paths of the logs in a database directory */
+    static std::vector<fs::path> logPaths(const fs::path& directory);
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+
+    /** Adds a record to the log, returns its LSN (0 on failure or while replaying). Records
+     *  are written with one write, under FULL they are queued for the flusher instead. */
+    uint64_t append(const WalRecordType type, const std::vector<std::string>& fields);
+
+    /** Waits until record 'lsn' is durable when it was queued, returns false if its batch failed */
+    bool commit(const uint64_t lsn);
+
+    /** Reads every valid record of a claimed log and cuts off a torn tail */
+    bool readRecords(std::vector<WalRecord>& records);
+
+    /** Deletes a claimed log once its records are in the table files */
+    bool remove();
+
+    /** Forces the log to disk unless the sync policy is OFF */
+    bool sync();
+
+    /** Empties the log after a checkpoint, LSNs keep increasing */
+    bool reset();
+
+    // Getters
+    const fs::path& getPath() const { return this->path; }
+    uint64_t getLogId() const { return this->log_id; }
+    uint64_t lastLsn() const;
+    uint64_t size() const;
+    bool isReplaying() const { return this->replaying; }
+    WalSyncPolicy getSyncPolicy() const;
+    uint64_t getCheckpointSize() const;
+    uint64_t getCommitWindow() const;
+
+    // Setters
+    void setReplaying(const bool val) { this->replaying = val; }
+    void setSyncPolicy(const WalSyncPolicy policy);
+    void setCheckpointSize(const uint64_t size);
+    void setCommitWindow(const uint64_t microseconds);
+};
+
+/** Converts OFF, NORMAL or FULL to a sync policy, returns false if unknown */
+bool walSyncPolicy(const std::string& name, WalSyncPolicy& policy);
+
+/** Name of a sync policy */
+const char* walSyncPolicyName(const WalSyncPolicy policy);
+
+#endif // WAL_H_
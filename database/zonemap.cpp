@@ -0,0 +1,153 @@
+/**
+ * File: zonemap.cpp
+ * Author: Mark Minkoff
+ * Functionality: Function definitions for file zonemap.h
+ *
+ * */
+
+#include "zonemap.h"
+
+static const char ZONEMAP_MAGIC[8] = {'S', 'Q', 'L', 'Z', 'O', 'N', 'E', 'S'};
+static const uint32_t ZONEMAP_VERSION = 1;
+
+// Key of an element in the zone ranges
+static int _zoneKey(const int& e) { return e; }
+static float _zoneKey(const float& e) { return e; }
+static char _zoneKey(const char& e) { return _toUpper(e); }
+
+template <class T>
+void ZoneMap<T>::summarize(const ColumnView<T>& elements, const size_t block)
+{
+    const size_t begin = block * ZONE_BLOCK_ROWS;
+    const size_t end = std::min(elements.size(), begin + ZONE_BLOCK_ROWS);
+
+    Zone zone = { T(), T(), 0 };
+    for (size_t row = begin; row < end; ++row)
+    {
+        const T key = _zoneKey(elements[row]);
+        if (key != key) continue;
+
+        if (!zone.count || key < zone.min) zone.min = key;
+        if (!zone.count || key > zone.max) zone.max = key;
+        zone.count++;
+    }
+    this->zones[block] = zone;
+}
+
+template <class T>
+void ZoneMap<T>::build(const ColumnView<T>& elements)
+{
+    this->zones.clear();
+    this->rows = 0;
+    this->append(elements);
+}
+
+template <class T>
+void ZoneMap<T>::append(const ColumnView<T>& elements)
+{
+    if (elements.size() <= this->rows) return;
+
+    // The last block may have been partial, it is summarized again with the new rows
+    const size_t first = this->rows / ZONE_BLOCK_ROWS;
+    this->zones.resize((elements.size() + ZONE_BLOCK_ROWS - 1) / ZONE_BLOCK_ROWS);
+    for (size_t block = first; block < this->zones.size(); ++block) this->summarize(elements, block);
+
+    this->rows = elements.size();
+}
+
+template <class T>
+void ZoneMap<T>::refresh(const ColumnView<T>& elements, const Bitmap& rows)
+{
+    // Every block spans ZONE_BLOCK_ROWS / 64 bitmap words
+    const size_t words = ZONE_BLOCK_ROWS / 64;
+    for (size_t block = 0; block < this->zones.size(); ++block)
+    {
+        const size_t begin = block * words;
+        const size_t end = std::min(rows.wordCount(), begin + words);
+        for (size_t w = begin; w < end; ++w)
+        {
+            if (rows.data()[w]) { this->summarize(elements, block); break; }
+        }
+    }
+}
+
+template <class T>
+void ZoneMap<T>::truncate(const size_t row)
+{
+    if (row >= this->rows) return;
+
+    // The block holding 'row' is partial now
+    this->zones.resize(row / ZONE_BLOCK_ROWS);
+    this->rows = this->zones.size() * ZONE_BLOCK_ROWS;
+}
+
+template <class T>
+bool ZoneMap<T>::mayMatch(const size_t block, const FilterOperator op, const T& val) const
+{
+    const Zone& zone = this->zones[block];
+    const T key = _zoneKey(val);
+
+    switch (op)
+    {
+        case FILTER_EQ: return zone.count && !(key < zone.min) && !(zone.max < key);
+        case FILTER_LT: return zone.count && zone.min < key;
+        case FILTER_LE: return zone.count && zone.min <= key;
+        case FILTER_GT: return zone.count && zone.max > key;
+        case FILTER_GE: return zone.count && zone.max >= key;
+        default: return true;
+    }
+}
+
+template <class T>
+bool ZoneMap<T>::write(const fs::path& path, const uint32_t data_type, const uint64_t checkpoint_lsn) const
+{
+    fs::path tmp = path; tmp += ".tmp";
+    std::ofstream file(tmp, std::ofstream::out | std::ofstream::trunc | std::ofstream::binary);
+    if (!file.is_open()) { std::cout << "-- !Failed to open " << tmp.string() << "\n"; return false; }
+
+    ZoneMapFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, ZONEMAP_MAGIC, sizeof(header.magic));
+    header.version = ZONEMAP_VERSION;
+    header.data_type = data_type;
+    header.row_count = this->rows;
+    header.checkpoint_lsn = checkpoint_lsn;
+    header.zone_count = this->zones.size();
+
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(this->zones.data()), this->zones.size() * sizeof(Zone));
+
+    file.close();
+    if (!file) { std::cout << "-- !Failed to write " << tmp.string() << "\n"; return false; }
+
+    std::error_code ec;
+    fs::rename(tmp, path, ec);
+    if (ec) { std::cout << "-- !Failed to replace " << path.string() << ": " << ec.message() << "\n"; return false; }
+    return true;
+}
+
+template <class T>
+bool ZoneMap<T>::read(const fs::path& path, const uint32_t data_type, const size_t rows, const uint64_t checkpoint_lsn)
+{
+    std::ifstream file(path, std::ifstream::in | std::ifstream::binary);
+    if (!file.is_open()) return false;
+
+    // Only a zone map written at the checkpoint of the table files can be used
+    ZoneMapFileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))) return false;
+    if (std::memcmp(header.magic, ZONEMAP_MAGIC, sizeof(header.magic)) != 0 || header.version != ZONEMAP_VERSION ||
+        header.data_type != data_type || header.row_count != rows || header.checkpoint_lsn != checkpoint_lsn) return false;
+
+    if (header.zone_count != (rows + ZONE_BLOCK_ROWS - 1) / ZONE_BLOCK_ROWS) return false;
+
+    std::vector<Zone> zones(header.zone_count);
+    if (!file.read(reinterpret_cast<char*>(zones.data()), zones.size() * sizeof(Zone))) return false;
+
+    this->zones = std::move(zones);
+    this->rows = rows;
+    return true;
+}
+
+template class ZoneMap<int>;
+template class ZoneMap<float>;
+template class ZoneMap<char>;
@@ -0,0 +1,89 @@
+/**
+ * File: zonemap.h
+ * Author: Mark Minkoff
+ * Functionality: Function declarations for file zonemap.cpp
+ * Zone maps of INT, FLOAT and CHAR columns: the minimum and maximum key of every block of
+ * ZONE_BLOCK_ROWS rows. Column<T>::filterElements only runs the filter kernels over blocks
+ * whose range can hold a match, so scans of tables appended in roughly key order touch a
+ * fraction of the column.
+ *
+ * CHAR keys are the upper case characters, like the ordering operators compare them. FLOAT
+ * NaN is left out of the ranges, it never satisfies =, <, <=, > or >=.
+ *
+ * The zone map of column i is written to <table>.<i>.zmp at checkpoints:
+ *
+ *   ZoneMapFileHeader (64 bytes) followed by one Zone per block
+ *
+ * and is only used when its row count and checkpoint LSN match the table file, otherwise
+ * it is rebuilt by the first filter on the column.
+ *
+ * */
+
+#ifndef ZONEMAP_H_
+#define ZONEMAP_H_
+
+#include "include.h"
+#include "bitmap.h"
+#include "column.h"
+#include "filter.h"
+
+// Rows summarized by one zone, a multiple of 64 so a block covers whole bitmap words
+const size_t ZONE_BLOCK_ROWS = 4096;
+
+typedef struct ZoneMapFileHeader {
+    char magic[8];              // "SQLZONES"
+    uint32_t version;
+    uint32_t data_type;         // StorageType of the column
+    uint64_t row_count;         // Rows covered by the zone map
+    uint64_t checkpoint_lsn;    // Checkpoint of the table the zone map was written at
+    uint64_t zone_count;        // Blocks following the header
+    uint64_t reserved[3];
+} ZoneMapFileHeader;
+
+static_assert(sizeof(ZoneMapFileHeader) == 64, "ZoneMapFileHeader must be 64 bytes");
+
+template <class T>
+class ZoneMap
+{
+private:
+    typedef struct Zone {
+        T min;                  // Smallest key of the block
+        T max;                  // Largest key of the block
+        uint32_t count;         // Keys in the range (NaN is not counted), 0 if no key can match
+    } Zone;
+
+    std::vector<Zone> zones;    // One zone per block, the last block may be partial
+    size_t rows;                // Rows covered
+
+    /** Recomputes the zone of block 'block' */
+    void summarize(const ColumnView<T>& elements, const size_t block);
+
+public:
+    ZoneMap() : rows(0) {}
+
+    /** Replaces the zones with a summary of every row of 'elements' */
+    void build(const ColumnView<T>& elements);
+
+    /** Extends the zones over the rows appended to 'elements' since they were last summarized */
+    void append(const ColumnView<T>& elements);
+
+    /** Recomputes the zone of every block holding a row set in 'rows' (after those rows were updated) */
+    void refresh(const ColumnView<T>& elements, const Bitmap& rows);
+
+    /** Drops the zones of the rows from 'row' on, call append() to summarize them again */
+    void truncate(const size_t row);
+
+    /** False if no row of block 'block' can satisfy 'element op val' */
+    bool mayMatch(const size_t block, const FilterOperator op, const T& val) const;
+
+    size_t blockCount() const { return this->zones.size(); }
+    size_t rowCount() const { return this->rows; }
+
+    /** Writes the zone map file */
+    bool write(const fs::path& path, const uint32_t data_type, const uint64_t checkpoint_lsn) const;
+
+    /** Reads the zone map file, false if it is missing or does not cover 'rows' rows at 'checkpoint_lsn' */
+    bool read(const fs::path& path, const uint32_t data_type, const size_t rows, const uint64_t checkpoint_lsn);
+};
+
+#endif // ZONEMAP_H_
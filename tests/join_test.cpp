@@ -0,0 +1,147 @@
+/**
+ * File: join_test.cpp
+ * Author: Mark Minkoff
+ * Functionality: Regression test of the range joins (see Database::bandJoin)
+ * Joins two FLOAT tables holding ties and NaN values on <, <=, > and >= as INNER, LEFT, RIGHT and
+ * FULL joins, with and without B+tree indexes, and compares the printed rows with a nested loop.
+ * NaN compares false with everything, so its rows only show up as rows without a match.
+ *
+ *   join_test      (runs in a temporary directory, exits 0 if every join matches)
+ *
+ * */
+
+#include "SQL.h"
+
+#include <unistd.h>
+
+static const float NAN_VALUE = std::numeric_limits<float>::quiet_NaN();
+static const std::vector<float> A = { 1, NAN_VALUE, 3, NAN_VALUE, 0.5f, 2 };
+static const std::vector<float> B = { 2, NAN_VALUE, 0.7f, 4, 3 };
+
+static const char* OPERATORS[] = { "<", "<=", ">", ">=" };
+static const char* JOINS[] = { "INNER", "LEFT OUTER", "RIGHT OUTER", "FULL OUTER" };
+
+/** Runs a statement and returns the rows it printed, sorted */
+static std::vector<std::string> _rows(SQL& sql, const std::string& statement)
+{
+    std::ostringstream out;
+    std::streambuf* console = std::cout.rdbuf(out.rdbuf());
+    sql.execute(statement);
+    std::cout.rdbuf(console);
+
+    // Everything but the algorithm and the column header
+    std::vector<std::string> rows;
+    std::istringstream lines(out.str());
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (line.compare(0, 3, "-- ") != 0 || line.find("Join algorithm") != std::string::npos || line.find(" FLOAT") != std::string::npos) continue;
+        rows.push_back(line);
+    }
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+static std::string _text(const float value)
+{
+    std::ostringstream out;
+    out << value;
+    return out.str();
+}
+
+static bool _compare(const float x, const float y, const std::string& op)
+{
+    if (op == "<") return x < y;
+    if (op == "<=") return x <= y;
+    if (op == ">") return x > y;
+    return x >= y;
+}
+
+/** Operator with the same meaning when its operands are swapped */
+static std::string _flip(const std::string& op)
+{
+    std::string flipped = op;
+    flipped[0] = op[0] == '<' ? '>' : '<';
+    return flipped;
+}
+
+/** Rows of 'left' JOIN 'right' by a nested loop, 'outer' adds the rows of 'left' without a match */
+static void _nestedLoop(const std::vector<float>& left, const std::vector<float>& right, const std::string& op, const bool outer, std::vector<std::string>& rows)
+{
+    for (float x : left)
+    {
+        bool found = false;
+        for (float y : right) {
+            if (!_compare(x, y, op)) continue;
+            rows.push_back("-- " + _text(x) + _text(y));
+            found = true;
+        }
+        if (!found && outer) rows.push_back("-- " + _text(x));
+    }
+}
+
+/** The rows a join must print, a RIGHT join prints the second table first */
+static std::vector<std::string> _expected(const std::string& join, const std::string& op)
+{
+    std::vector<std::string> rows;
+    if (join == "RIGHT OUTER") _nestedLoop(B, A, _flip(op), true, rows);
+    else _nestedLoop(A, B, op, join != "INNER", rows);
+
+    // A FULL join adds the rows of the second table without a match
+    if (join == "FULL OUTER") {
+        for (float y : B) {
+            if (std::none_of(A.begin(), A.end(), [&](float x) { return _compare(x, y, op); })) rows.push_back("-- " + _text(y));
+        }
+    }
+
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+int main()
+{
+    char directory[] = "/tmp/join_test.XXXXXX";
+    if (!::mkdtemp(directory)) { std::perror("mkdtemp"); return 1; }
+    fs::current_path(directory);
+
+    bool success = true;
+    {
+        SQL sql(CLIENT_EMBEDDED);
+        _rows(sql, "CREATE DATABASE d");
+        _rows(sql, "USE d");
+        _rows(sql, "CREATE TABLE a (x FLOAT)");
+        _rows(sql, "CREATE TABLE b (y FLOAT)");
+        for (float x : A) _rows(sql, "INSERT INTO a VALUES (" + _text(x) + ")");
+        for (float y : B) _rows(sql, "INSERT INTO b VALUES (" + _text(y) + ")");
+
+        // The second pass reads the sorted rows from the indexes
+        for (const bool indexed : { false, true })
+        {
+            if (indexed) {
+                _rows(sql, "CREATE INDEX ia ON a(x) USING BTREE");
+                _rows(sql, "CREATE INDEX ib ON b(y) USING BTREE");
+            }
+
+            for (const char* join : JOINS) {
+                for (const char* op : OPERATORS)
+                {
+                    const std::string statement = std::string("SELECT * FROM a p ") + join + " JOIN b q ON p.x " + op + " q.y";
+                    const std::vector<std::string> rows = _rows(sql, statement), expected = _expected(join, op);
+                    if (rows == expected) continue;
+
+                    success = false;
+                    std::cerr << "FAIL " << statement << (indexed ? " (B+tree indexes)" : "") << ":";
+                    for (auto& row : rows) std::cerr << " [" << row.substr(3) << "]";
+                    std::cerr << ", expected";
+                    for (auto& row : expected) std::cerr << " [" << row.substr(3) << "]";
+                    std::cerr << "\n";
+                }
+            }
+        }
+    }
+
+    if (success) std::cerr << "PASS range joins with NaN\n";
+
+    fs::current_path("/");
+    fs::remove_all(directory);
+    return success ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+/**
+ * File: prepared_test.cpp
+ * Author: Mark Minkoff
+ * Functionality: Test of the prepared statements of the C++ API (see prepared.h)
+ * Prepares INSERT, SELECT, UPDATE and DELETE statements with ? placeholders, binds and runs
+ * them, and checks the rows of the table after every step. Also checks that a statement with an
+ * unbound placeholder, a bind out of range and a bind of a value that does not convert to its
+ * column fail, and that the statements are resolved again after the table is dropped and
+ * created again with its columns in another order.
+ *
+ *   prepared_test      (runs in a temporary directory, exits 0 if every check passes)
+ *
+ * */
+
+#include "SQL.h"
+
+#include <unistd.h>
+
+static bool success = true;
+
+static void _check(const std::string& name, const bool passed)
+{
+    std::cerr << (passed ? "PASS " : "FAIL ") << name << "\n";
+    success = success && passed;
+}
+
+/** Runs 'run' and returns what it printed */
+template <typename Run>
+static std::string _output(Run run)
+{
+    std::ostringstream out;
+    std::streambuf* console = std::cout.rdbuf(out.rdbuf());
+    run();
+    std::cout.rdbuf(console);
+    return out.str();
+}
+
+/** Rows of table t as csv lines, sorted */
+static std::vector<std::string> _rows(SQL& sql)
+{
+    const fs::path out = fs::current_path() / "rows.csv";
+    fs::remove(out);
+    _output([&]() { sql.execute("COPY t TO '" + out.string() + "'"); });
+
+    std::vector<std::string> rows;
+    std::ifstream file(out);
+    std::string line;
+    while (std::getline(file, line)) if (!line.empty()) rows.push_back(line);
+    std::sort(rows.begin(), rows.end());
+    return rows;
+}
+
+int main()
+{
+    char directory[] = "/tmp/prepared_test.XXXXXX";
+    if (!::mkdtemp(directory)) { std::perror("mkdtemp"); return 1; }
+    fs::current_path(directory);
+
+    {
+        SQL sql(CLIENT_EMBEDDED);
+        _output([&]() {
+            sql.execute("CREATE DATABASE d");
+            sql.execute("USE d");
+            sql.execute("CREATE TABLE t (id INT, name VARCHAR(10), price FLOAT)");
+        });
+
+        std::shared_ptr<PreparedStatement> insert = sql.prepare("INSERT INTO t VALUES (?, ?, ?)");
+        std::shared_ptr<PreparedStatement> select = sql.prepare("SELECT name FROM t WHERE id = ?");
+        std::shared_ptr<PreparedStatement> update = sql.prepare("UPDATE t SET price = ? WHERE id = ?");
+        std::shared_ptr<PreparedStatement> remove = sql.prepare("DELETE FROM t WHERE id = ?");
+        _check("prepare", insert && select && update && remove);
+        if (!insert || !select || !update || !remove) return 1;
+        _check("parameter counts", insert->parameterCount() == 3 && select->parameterCount() == 1 && update->parameterCount() == 2 && remove->parameterCount() == 1);
+
+        // INSERT
+        bool executed = true;
+        std::string printed = _output([&]() { executed = insert->execute(); });
+        _check("unbound parameter", !executed && printed.find("not bound") != std::string::npos && _rows(sql).empty());
+
+        _output([&]() { executed = insert->bind(0, 1) && insert->bind(1, "a") && insert->bind(2, 1.5f) && insert->execute(); });
+        _output([&]() { executed = insert->bind(0, 2) && insert->bind(1, "b") && insert->execute() && executed; });
+        _check("insert", executed && _rows(sql) == std::vector<std::string>({ "1,a,1.5", "2,b,1.5" }));
+
+        _output([&]() { executed = insert->bind(3, 3); });
+        _check("bind out of range", !executed);
+
+        _output([&]() { executed = insert->bind(0, "abc"); });
+        bool rerun = true;
+        _output([&]() { rerun = insert->execute(); });
+        _check("bind that does not convert", !executed && !rerun && _rows(sql).size() == 2);
+
+        // SELECT
+        _output([&]() { executed = select->bind(0, 2); });
+        printed = _output([&]() { executed = select->execute() && executed; });
+        _check("select", executed && printed.find("-- b") != std::string::npos && printed.find("-- a") == std::string::npos);
+
+        // UPDATE
+        _output([&]() { executed = update->bind(0, 9.5f) && update->bind(1, 1) && update->execute(); });
+        _check("update", executed && _rows(sql) == std::vector<std::string>({ "1,a,9.5", "2,b,1.5" }));
+
+        _output([&]() { executed = update->bind(0, "cheap"); });
+        _check("bind that does not convert (SET)", !executed);
+
+        // DELETE
+        _output([&]() { executed = remove->bind(0, 2) && remove->execute(); });
+        _check("delete", executed && _rows(sql) == std::vector<std::string>({ "1,a,9.5" }));
+
+        // The statements are resolved against the new table, its columns are in another order
+        _output([&]() { sql.execute("DROP TABLE t"); });
+        _output([&]() { executed = select->execute(); });
+        _check("execute after DROP TABLE", !executed);
+
+        _output([&]() {
+            sql.execute("CREATE TABLE t (price FLOAT, id INT, name VARCHAR(10))");
+            sql.execute("INSERT INTO t VALUES (7.5, 3, 'c')");
+        });
+
+        _output([&]() { executed = select->bind(0, 3); });
+        printed = _output([&]() { executed = select->execute() && executed; });
+        _check("select after CREATE TABLE", executed && printed.find("-- c") != std::string::npos);
+
+        _output([&]() { executed = update->bind(0, 2.5f) && update->bind(1, 3) && update->execute(); });
+        _check("update after CREATE TABLE", executed && _rows(sql) == std::vector<std::string>({ "2.5,3,c" }));
+
+        _output([&]() { executed = insert->bind(0, 4.5f) && insert->bind(1, 4) && insert->bind(2, "d") && insert->execute(); });
+        _check("insert after CREATE TABLE", executed && _rows(sql) == std::vector<std::string>({ "2.5,3,c", "4.5,4,d" }));
+
+        _output([&]() { executed = remove->bind(0, 3) && remove->execute(); });
+        _check("delete after CREATE TABLE", executed && _rows(sql) == std::vector<std::string>({ "4.5,4,d" }));
+
+        _output([&]() { sql.execute("DROP DATABASE d"); });
+    }
+
+    fs::current_path("/");
+    fs::remove_all(directory);
+    return success ? 0 : 1;
+}
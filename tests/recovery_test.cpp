@@ -0,0 +1,216 @@
+/**
+ * File: recovery_test.cpp
+ * Author: Mark Minkoff
+ * Functionality: Two-process recovery test of the write ahead log (see wal.h)
+ * Forks clients that write to the same table at the same time, some of them exit without a
+ * checkpoint as if they crashed, and checks that the next checkpoint of another process puts
+ * every statement they logged in the table files exactly once, and that a client reads the rows
+ * another one checkpointed.
+ *
+ *   recovery_test      (runs in a temporary directory, exits 0 if every scenario passes)
+ *
+ * */
+
+#include "SQL.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+// A forked client, the parent writes a statement line to it and reads one byte back once it ran
+typedef struct Client {
+    pid_t pid;
+    int statements;
+    int done;
+} Client;
+
+// Pipe ends of the running clients held by the parent, a forked client closes the ones it inherits
+static std::vector<int> parent_fds;
+
+/** Forks a client that runs every line written to it, an empty line makes it exit without a
+ *  checkpoint (a crash), the end of the pipe makes it exit normally */
+static Client _fork()
+{
+    int statements[2], done[2];
+    if (::pipe(statements) != 0 || ::pipe(done) != 0) { std::perror("pipe"); std::exit(1); }
+
+    std::cout.flush();
+    const pid_t pid = ::fork();
+    if (pid < 0) { std::perror("fork"); std::exit(1); }
+
+    if (pid == 0)
+    {
+        for (int fd : parent_fds) ::close(fd);
+        ::close(statements[1]);
+        ::close(done[0]);
+        FILE* in = ::fdopen(statements[0], "r");
+        {
+            SQL sql(CLIENT_EMBEDDED);
+
+            char line[256];
+            while (std::fgets(line, sizeof(line), in))
+            {
+                std::string statement(line);
+                while (!statement.empty() && statement.back() == '\n') statement.pop_back();
+
+                // Exit without the checkpoint of the destructor, the log stays behind
+                if (statement.empty()) { std::cout.flush(); ::_exit(0); }
+
+                sql.execute(statement);
+                std::cout.flush();
+                if (::write(done[1], "", 1) != 1) ::_exit(1);
+            }
+        }
+        std::cout.flush();
+        ::_exit(0);
+    }
+
+    ::close(statements[0]);
+    ::close(done[1]);
+    parent_fds.push_back(statements[1]);
+    parent_fds.push_back(done[0]);
+    return { pid, statements[1], done[0] };
+}
+
+/** Runs one statement on a client, returns once it ran (and its log record is written) */
+static void _run(const Client& client, const std::string& statement)
+{
+    const std::string line = statement + "\n";
+    char ran;
+    if (::write(client.statements, line.data(), line.size()) != (ssize_t)line.size() || ::read(client.done, &ran, 1) != 1) {
+        std::cerr << "Client " << client.pid << " exited before " << statement << "\n";
+        std::exit(1);
+    }
+}
+
+/** Ends a client, 'crash' leaves its log without a checkpoint */
+static void _finish(const Client& client, const bool crash)
+{
+    if (crash && ::write(client.statements, "\n", 1) != 1) { std::perror("write"); std::exit(1); }
+    ::close(client.statements);
+
+    int status = 0;
+    ::waitpid(client.pid, &status, 0);
+    ::close(client.done);
+    parent_fds.erase(std::remove_if(parent_fds.begin(), parent_fds.end(), [&](int fd) { return fd == client.statements || fd == client.done; }), parent_fds.end());
+}
+
+/** Values of the table as a client sees them, sorted */
+static std::vector<int> _copy(const Client& client)
+{
+    const fs::path out = fs::current_path() / "values.csv";
+    fs::remove(out);
+    _run(client, "COPY t TO '" + out.string() + "'");
+
+    std::vector<int> values;
+    std::ifstream file(out);
+    std::string line;
+    while (std::getline(file, line)) if (!line.empty()) values.push_back(std::stoi(line));
+    std::sort(values.begin(), values.end());
+    return values;
+}
+
+/** Values of the table as another process sees them after loading the database, sorted */
+static std::vector<int> _values()
+{
+    Client reader = _fork();
+    _run(reader, "USE d");
+    const std::vector<int> values = _copy(reader);
+    _finish(reader, false);
+    return values;
+}
+
+/** Number of logs left in the database directory */
+static size_t _logs()
+{
+    return WriteAheadLog::logPaths(fs::current_path() / "storage" / "d").size();
+}
+
+static bool _check(const char* scenario, const std::vector<int>& expected)
+{
+    const std::vector<int> values = _values();
+    const size_t logs = _logs();
+    const bool success = values == expected && !logs;
+
+    std::cerr << (success ? "PASS " : "FAIL ") << scenario << ":";
+    for (int value : values) std::cerr << " " << value;
+    if (logs) std::cerr << " (" << logs << " logs left)";
+    std::cerr << "\n";
+    return success;
+}
+
+int main()
+{
+    char directory[] = "/tmp/recovery_test.XXXXXX";
+    if (!::mkdtemp(directory)) { std::perror("mkdtemp"); return 1; }
+    fs::current_path(directory);
+
+    bool success = true;
+    {
+        Client setup = _fork();
+        _run(setup, "CREATE DATABASE d");
+        _run(setup, "USE d");
+        _run(setup, "CREATE TABLE t (a INT)");
+        _run(setup, "INSERT INTO t VALUES (1)");
+        _finish(setup, false);
+    }
+
+    // A crashes while B runs, the checkpoint of B at its exit replays the log of A
+    {
+        Client a = _fork(), b = _fork();
+        _run(a, "USE d");
+        _run(b, "USE d");
+        _run(a, "INSERT INTO t VALUES (10)");
+        _run(b, "INSERT INTO t VALUES (20)");
+        _run(a, "UPDATE t SET a = 11 WHERE a = 1");
+        _finish(a, true);
+        _run(b, "INSERT INTO t VALUES (21)");
+        _finish(b, false);
+        success = _check("crashed writer, live writer", { 10, 11, 20, 21 }) && success;
+    }
+
+    // Both crash, the next process to load the database replays both logs
+    {
+        Client a = _fork(), b = _fork();
+        _run(a, "USE d");
+        _run(b, "USE d");
+        _run(a, "INSERT INTO t VALUES (30)");
+        _run(b, "DELETE FROM t WHERE a = 20");
+        _run(a, "INSERT INTO t VALUES (31)");
+        _finish(a, true);
+        _finish(b, true);
+        success = _check("two crashed writers", { 10, 11, 21, 30, 31 }) && success;
+    }
+
+    // A checkpoints (CREATE INDEX writes the table files) and crashes, only its later statements are replayed
+    {
+        Client a = _fork();
+        _run(a, "USE d");
+        _run(a, "INSERT INTO t VALUES (40)");
+        _run(a, "CREATE INDEX t_a ON t(a)");
+        _run(a, "INSERT INTO t VALUES (41)");
+        _finish(a, true);
+        success = _check("crash after a checkpoint", { 10, 11, 21, 30, 31, 40, 41 }) && success;
+    }
+
+    // A client that loaded the table before another one checkpointed it reads the committed rows
+    {
+        Client reader = _fork(), a = _fork();
+        _run(reader, "USE d");
+        _run(reader, "SELECT * FROM t");
+        _run(a, "USE d");
+        _run(a, "DELETE FROM t WHERE a = 10");
+        _run(a, "INSERT INTO t VALUES (50)");
+        _finish(a, false);
+
+        const std::vector<int> values = _copy(reader), expected = { 11, 21, 30, 31, 40, 41, 50 };
+        _finish(reader, false);
+        std::cerr << (values == expected ? "PASS " : "FAIL ") << "reader after a checkpoint:";
+        for (int value : values) std::cerr << " " << value;
+        std::cerr << "\n";
+        success = values == expected && success;
+    }
+
+    fs::current_path("/");
+    fs::remove_all(directory);
+    return success ? 0 : 1;
+}